@@ -0,0 +1,26 @@
+# SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: CC0-1.0
+"""Shared fixtures of the host tests: pure-C modules from main/ built with the host C compiler."""
+
+import ctypes
+import shutil
+import subprocess
+from collections.abc import Callable
+from pathlib import Path
+
+import pytest
+
+
+@pytest.fixture(scope='session')
+def build_host_lib(tmp_path_factory: pytest.TempPathFactory) -> Callable[[Path], ctypes.CDLL]:
+    """Return a function that compiles one C source into a shared library and loads it via ctypes."""
+    cc = shutil.which('cc') or shutil.which('gcc')
+
+    def build(src: Path) -> ctypes.CDLL:
+        if cc is None:
+            pytest.skip('no host C compiler')
+        so = tmp_path_factory.mktemp(src.stem) / f'lib{src.stem}.so'
+        subprocess.run([cc, '-std=c11', '-Wall', '-Werror', '-shared', '-fPIC', '-o', str(so), str(src)], check=True)
+        return ctypes.CDLL(str(so))
+
+    return build
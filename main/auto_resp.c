@@ -0,0 +1,418 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "auto_resp.h"
+#include "can_tx.h"
+
+static const char *TAG = "auto_resp";
+
+#define MAX_ENTRIES     CONFIG_CAN_BRIDGE_AUTO_RESP_MAX
+
+// TX-done argument: generation of the table (23 bits), table index (1 bit), rule index (8 bits)
+#define CB_ARG(gen, table, rule)    (((uintptr_t)(gen) & 0x7FFFFF) << 9 | (uintptr_t)(table) << 8 | (rule))
+#define CB_ARG_GEN(arg)             ((uint32_t)((arg) >> 9))
+#define CB_ARG_TABLE(arg)           ((uint32_t)((arg) >> 8) & 1)
+#define CB_ARG_RULE(arg)            ((uint32_t)(arg) & 0xFF)
+
+/**
+ * @brief Rule table with per-rule runtime state
+ */
+typedef struct {
+    atomic_int users;                   // ISR and TX-done callbacks currently using the table
+    uint32_t gen;                       // Commit that built the table
+    uint32_t count;
+    auto_resp_entry_t entries[MAX_ENTRIES];
+    auto_resp_stats_t stats[MAX_ENTRIES];
+    uint8_t counter[MAX_ENTRIES];
+    int64_t last_rx_us[MAX_ENTRIES];    // Request time of the response in flight
+} resp_table_t;
+
+// Two tables: the active one (read by the ISR) and the one rebuilt on commit
+static resp_table_t s_tables[2];
+static _Atomic(resp_table_t *) s_active = NULL;
+
+// Commits so far; tells the tables built from the same slot apart
+static uint32_t s_gen = 0;
+
+// Staging table, filled by the host
+static struct {
+    uint32_t count;
+    auto_resp_entry_t entries[MAX_ENTRIES];
+} s_stage;
+
+/** @brief Command line arguments for resp command */
+static struct {
+    struct arg_str *action;
+    struct arg_str *request;
+    struct arg_str *response;
+    struct arg_end *end;
+} resp_args;
+
+/**
+ * @brief Start using a table; fails if it is no longer the active one
+ *
+ * A commit only rebuilds the inactive table once its users are gone, and a
+ * reader that got there after the check sees the table is no longer active.
+ */
+static IRAM_ATTR bool table_enter(resp_table_t *t)
+{
+    atomic_fetch_add(&t->users, 1);
+    if (atomic_load(&s_active) != t) {
+        atomic_fetch_sub(&t->users, 1);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Response sent: record the latency from request reception
+ */
+static IRAM_ATTR void resp_tx_done(void *arg, int64_t done_us, bool ok)
+{
+    uintptr_t cb_arg = (uintptr_t)arg;
+    resp_table_t *t = &s_tables[CB_ARG_TABLE(cb_arg)];
+    uint32_t i = CB_ARG_RULE(cb_arg);
+    if (!table_enter(t)) {
+        return;
+    }
+    
+    // Ignore responses sent from a table that has been rebuilt since
+    if ((t->gen & 0x7FFFFF) == CB_ARG_GEN(cb_arg) && i < t->count) {
+        auto_resp_stats_t *st = &t->stats[i];
+        if (!ok) {
+            st->tx_failed++;
+        } else {
+            uint32_t us = (uint32_t)(done_us - t->last_rx_us[i]);
+            if (st->latency_count == 0 || us < st->latency_min_us) {
+                st->latency_min_us = us;
+            }
+            if (us > st->latency_max_us) {
+                st->latency_max_us = us;
+            }
+            st->latency_sum_us += us;
+            st->latency_count++;
+        }
+    }
+    atomic_fetch_sub(&t->users, 1);
+}
+
+IRAM_ATTR void auto_resp_on_rx_from_isr(const twai_frame_t *frame, int64_t rx_us)
+{
+    resp_table_t *t = atomic_load(&s_active);
+    if (t == NULL || frame->header.rtr || !table_enter(t)) {
+        return;
+    }
+    
+    uint32_t key = frame->header.id | (frame->header.ide ? AUTO_RESP_KEY_EXT : 0);
+    uint8_t len = (uint8_t)twaifd_dlc2len(frame->header.dlc);
+    
+    for (uint32_t i = 0; i < t->count; i++) {
+        const auto_resp_entry_t *e = &t->entries[i];
+        if (e->req_key != key || len < e->req_len) {
+            continue;
+        }
+        bool match = true;
+        for (uint8_t b = 0; b < e->req_len; b++) {
+            if ((frame->buffer[b] ^ e->req_data[b]) & e->req_mask[b]) {
+                match = false;
+                break;
+            }
+        }
+        if (!match) {
+            continue;
+        }
+        
+        // Build the response from the template
+        uint8_t data[8];
+        for (uint8_t b = 0; b < e->resp_len; b++) {
+            uint8_t src = e->resp_src[b];
+            if (src & AUTO_RESP_SRC_ECHO) {
+                uint8_t idx = src & 0x07;
+                data[b] = idx < len ? frame->buffer[idx] : 0;
+            } else if (src & AUTO_RESP_SRC_COUNTER) {
+                data[b] = e->resp_data[b] + t->counter[i];
+            } else {
+                data[b] = e->resp_data[b];
+            }
+        }
+        twai_frame_t resp = {
+            .header = {
+                .id = e->resp_key & ~AUTO_RESP_KEY_EXT,
+                .ide = (e->resp_key & AUTO_RESP_KEY_EXT) ? 1 : 0,
+                .dlc = e->resp_len,
+            },
+            .buffer = data,
+            .buffer_len = e->resp_len,
+        };
+        
+        t->stats[i].hits++;
+        t->counter[i]++;
+        t->last_rx_us[i] = rx_us;
+        uintptr_t cb_arg = CB_ARG(t->gen, t - s_tables, i);
+        if (can_tx_send_with_callback(&resp, resp_tx_done, (void *)cb_arg) != ESP_OK) {
+            t->stats[i].tx_failed++;
+        }
+        break;
+    }
+    atomic_fetch_sub(&t->users, 1);
+}
+
+esp_err_t auto_resp_stage_add(const auto_resp_entry_t *entry)
+{
+    if (s_stage.count == MAX_ENTRIES) {
+        return ESP_ERR_NO_MEM;
+    }
+    s_stage.entries[s_stage.count++] = *entry;
+    return ESP_OK;
+}
+
+void auto_resp_stage_clear(void)
+{
+    s_stage.count = 0;
+}
+
+void auto_resp_commit(void)
+{
+    resp_table_t *active = atomic_load(&s_active);
+    resp_table_t *next = (active == &s_tables[0]) ? &s_tables[1] : &s_tables[0];
+    
+    // The previous swap may have left a reader on the table rebuilt now (an ISR, so not for long)
+    while (atomic_load(&next->users) != 0) {
+        vTaskDelay(1);
+    }
+    
+    // users stays: a reader turned away by table_enter() may still be decrementing it
+    memset((uint8_t *)next + offsetof(resp_table_t, gen), 0, sizeof(*next) - offsetof(resp_table_t, gen));
+    next->gen = ++s_gen;
+    next->count = s_stage.count;
+    memcpy(next->entries, s_stage.entries, s_stage.count * sizeof(auto_resp_entry_t));
+    atomic_store(&s_active, next->count > 0 ? next : NULL);
+    
+    ESP_LOGI(TAG, "%lu rules active", (unsigned long)next->count);
+}
+
+bool auto_resp_get(uint32_t index, auto_resp_entry_t *entry, auto_resp_stats_t *stats)
+{
+    resp_table_t *t = atomic_load(&s_active);
+    if (t == NULL || index >= t->count) {
+        return false;
+    }
+    if (entry) {
+        *entry = t->entries[index];
+    }
+    if (stats) {
+        *stats = t->stats[index];
+    }
+    return true;
+}
+
+/**
+ * @brief Hex digit value, -1 if not a hex digit
+ */
+static int hex_nibble(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+/**
+ * @brief Parse "ID#", returning the key and the position after '#'
+ */
+static const char *parse_key(const char *text, uint32_t *key)
+{
+    const char *hash = strchr(text, '#');
+    size_t digits = hash ? (size_t)(hash - text) : 0;
+    if (digits != 3 && digits != 8) {
+        return NULL;
+    }
+    
+    uint32_t id = 0;
+    for (size_t i = 0; i < digits; i++) {
+        int n = hex_nibble(text[i]);
+        if (n < 0) {
+            return NULL;
+        }
+        id = (id << 4) | (uint32_t)n;
+    }
+    if (id > (digits == 8 ? TWAI_EXT_ID_MASK : TWAI_STD_ID_MASK)) {
+        return NULL;
+    }
+    *key = id | (digits == 8 ? AUTO_RESP_KEY_EXT : 0);
+    return hash + 1;
+}
+
+esp_err_t auto_resp_parse_request(const char *text, auto_resp_entry_t *entry)
+{
+    const char *p = parse_key(text, &entry->req_key);
+    if (p == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    size_t n = strlen(p);
+    if (n % 2 != 0 || n / 2 > sizeof(entry->req_data)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    entry->req_len = (uint8_t)(n / 2);
+    for (uint8_t b = 0; b < entry->req_len; b++) {
+        uint8_t data = 0, mask = 0;
+        for (int half = 0; half < 2; half++) {
+            char c = p[b * 2 + half];
+            int v = hex_nibble(c);
+            data <<= 4;
+            mask <<= 4;
+            if (v >= 0) {
+                data |= (uint8_t)v;
+                mask |= 0x0F;
+            } else if (c != '?' && c != '.') {
+                return ESP_ERR_INVALID_ARG;
+            }
+        }
+        entry->req_data[b] = data;
+        entry->req_mask[b] = mask;
+    }
+    return ESP_OK;
+}
+
+esp_err_t auto_resp_parse_response(const char *text, auto_resp_entry_t *entry)
+{
+    const char *p = parse_key(text, &entry->resp_key);
+    if (p == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    size_t n = strlen(p);
+    if (n % 2 != 0 || n / 2 > sizeof(entry->resp_data)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    entry->resp_len = (uint8_t)(n / 2);
+    for (uint8_t b = 0; b < entry->resp_len; b++) {
+        const char *tok = &p[b * 2];
+        entry->resp_data[b] = 0;
+        if (tok[0] == '$' && tok[1] >= '0' && tok[1] <= '7') {
+            entry->resp_src[b] = AUTO_RESP_SRC_ECHO | (uint8_t)(tok[1] - '0');
+        } else if (tok[0] == '+' && tok[1] == '+') {
+            entry->resp_src[b] = AUTO_RESP_SRC_COUNTER;
+        } else {
+            int hi = hex_nibble(tok[0]);
+            int lo = hex_nibble(tok[1]);
+            if (hi < 0 || lo < 0) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            entry->resp_src[b] = AUTO_RESP_SRC_LITERAL;
+            entry->resp_data[b] = (uint8_t)((hi << 4) | lo);
+        }
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Print an identifier key in SLCAN notation
+ */
+static void print_key(uint32_t key)
+{
+    if (key & AUTO_RESP_KEY_EXT) {
+        printf("%08lX", (unsigned long)(key & ~AUTO_RESP_KEY_EXT));
+    } else {
+        printf("%03lX", (unsigned long)key);
+    }
+}
+
+/**
+ * @brief "resp" command handler
+ */
+static int resp_cmd_handler(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&resp_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, resp_args.end, argv[0]);
+        return 1;
+    }
+    
+    const char *action = resp_args.action->count ? resp_args.action->sval[0] : "show";
+    
+    if (strcmp(action, "add") == 0) {
+        auto_resp_entry_t entry = {0};
+        if (resp_args.request->count == 0 || resp_args.response->count == 0 ||
+            auto_resp_parse_request(resp_args.request->sval[0], &entry) != ESP_OK ||
+            auto_resp_parse_response(resp_args.response->sval[0], &entry) != ESP_OK) {
+            printf("resp add: need <ID#pattern> <ID#template>\n");
+            return 1;
+        }
+        if (auto_resp_stage_add(&entry) != ESP_OK) {
+            printf("resp add: staging table full (%d)\n", MAX_ENTRIES);
+            return 1;
+        }
+        printf("resp: %lu staged\n", (unsigned long)s_stage.count);
+        return 0;
+    } else if (strcmp(action, "clear") == 0) {
+        auto_resp_stage_clear();
+        return 0;
+    } else if (strcmp(action, "commit") == 0) {
+        auto_resp_commit();
+    } else if (strcmp(action, "off") == 0) {
+        auto_resp_stage_clear();
+        auto_resp_commit();
+    } else if (strcmp(action, "show") != 0) {
+        printf("resp: unknown action '%s'\n", action);
+        return 1;
+    }
+    
+    auto_resp_entry_t e;
+    auto_resp_stats_t st;
+    uint32_t n = 0;
+    while (auto_resp_get(n, &e, &st)) {
+        printf("  %lu ", (unsigned long)n);
+        print_key(e.req_key);
+        printf(" -> ");
+        print_key(e.resp_key);
+        printf(" hits %lu failed %lu", (unsigned long)st.hits, (unsigned long)st.tx_failed);
+        if (st.latency_count > 0) {
+            printf(" latency min %lu avg %lu max %lu us", (unsigned long)st.latency_min_us,
+                   (unsigned long)(st.latency_sum_us / st.latency_count), (unsigned long)st.latency_max_us);
+        }
+        printf("\n");
+        n++;
+    }
+    printf("resp: %lu active, %lu staged\n", (unsigned long)n, (unsigned long)s_stage.count);
+    return 0;
+}
+
+void auto_resp_register_commands(void)
+{
+    resp_args.action = arg_str0(NULL, NULL, "<add|clear|commit|off|show>", "Action (default: show)");
+    resp_args.request = arg_str0(NULL, NULL, "<ID#pattern>", "Request: hex bytes, '?' any nibble, '..' any byte");
+    resp_args.response = arg_str0(NULL, NULL, "<ID#template>", "Response: hex bytes, $n request byte n, ++ counter");
+    resp_args.end = arg_end(3);
+    
+    const esp_console_cmd_t resp_cmd = {
+        .command = "resp",
+        .help = "Auto-responder answering requests from the RX ISR\n"
+        "  resp add 7E0#0210.. 7E8#065001++0000   # stage a rule\n"
+        "  resp commit                            # activate the staged rules atomically\n"
+        "  resp clear | off | show",
+        .hint = NULL,
+        .func = &resp_cmd_handler,
+        .argtable = &resp_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&resp_cmd));
+}
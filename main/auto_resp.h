@@ -0,0 +1,137 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_twai.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Auto-responder: answers request frames from the RX ISR
+ *
+ * A table maps a request ID plus a masked payload pattern to a response
+ * frame. The RX ISR matches every received frame against the active table
+ * and queues the response straight away, so an emulated ECU answers within
+ * microseconds instead of a USB round trip.
+ *
+ * The host fills a staging table ('Xresp add ...') and publishes it with
+ * 'Xresp commit', which swaps the active table pointer in one atomic store;
+ * the ISR never sees a half-updated table.
+ *
+ * Response payload bytes are literals, copies of a request byte (echo) or a
+ * per-entry counter that increments with every hit.
+ */
+
+#ifndef CONFIG_CAN_BRIDGE_AUTO_RESP_MAX
+#define CONFIG_CAN_BRIDGE_AUTO_RESP_MAX 32
+#endif
+
+/** @brief Key flag: 29-bit identifier */
+#define AUTO_RESP_KEY_EXT           (1U << 31)
+
+/** @brief Response byte source: literal resp_data[i] */
+#define AUTO_RESP_SRC_LITERAL       0x00
+/** @brief Response byte source: request byte (low 3 bits: index) */
+#define AUTO_RESP_SRC_ECHO          0x10
+/** @brief Response byte source: resp_data[i] + hit counter */
+#define AUTO_RESP_SRC_COUNTER       0x20
+
+/**
+ * @brief One request/response rule
+ */
+typedef struct {
+    uint32_t req_key;           /**< Request identifier | AUTO_RESP_KEY_EXT */
+    uint8_t req_len;            /**< Minimum request payload length */
+    uint8_t req_data[8];        /**< Request pattern */
+    uint8_t req_mask[8];        /**< Pattern bits that must match */
+    uint32_t resp_key;          /**< Response identifier | AUTO_RESP_KEY_EXT */
+    uint8_t resp_len;           /**< Response payload length */
+    uint8_t resp_data[8];       /**< Literal bytes / counter base */
+    uint8_t resp_src[8];        /**< AUTO_RESP_SRC_* per byte */
+} auto_resp_entry_t;
+
+/**
+ * @brief Statistics of one rule (reset by auto_resp_commit())
+ */
+typedef struct {
+    uint32_t hits;              /**< Requests matched */
+    uint32_t tx_failed;         /**< Responses that could not be queued or sent */
+    uint32_t latency_count;     /**< Responses with a measured latency */
+    uint32_t latency_min_us;    /**< Request RX ISR to response sent, minimum */
+    uint32_t latency_max_us;    /**< ... maximum */
+    uint64_t latency_sum_us;    /**< ... sum */
+} auto_resp_stats_t;
+
+/**
+ * @brief Match a received frame and send the response
+ *
+ * @note Called from the RX ISR
+ *
+ * @param frame Received frame
+ * @param rx_us esp_timer time of reception
+ */
+void auto_resp_on_rx_from_isr(const twai_frame_t *frame, int64_t rx_us);
+
+/**
+ * @brief Add a rule to the staging table
+ *
+ * @param entry Rule
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the staging table is full
+ */
+esp_err_t auto_resp_stage_add(const auto_resp_entry_t *entry);
+
+/**
+ * @brief Clear the staging table
+ */
+void auto_resp_stage_clear(void);
+
+/**
+ * @brief Publish the staging table atomically; an empty table disables responding
+ */
+void auto_resp_commit(void);
+
+/**
+ * @brief Get a rule of the active table and its statistics
+ *
+ * @param index Rule index
+ * @param entry Output rule (may be NULL)
+ * @param stats Output statistics (may be NULL)
+ * @return true if the rule exists
+ */
+bool auto_resp_get(uint32_t index, auto_resp_entry_t *entry, auto_resp_stats_t *stats);
+
+/**
+ * @brief Parse a request pattern "ID#hh.." ('?' = any nibble, '..' = any byte)
+ *
+ * @param text Pattern
+ * @param entry Output: req_* fields
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if malformed
+ */
+esp_err_t auto_resp_parse_request(const char *text, auto_resp_entry_t *entry);
+
+/**
+ * @brief Parse a response template "ID#tt.." (tt: hex literal, $n echo request byte n, ++ counter)
+ *
+ * @param text Template
+ * @param entry Output: resp_* fields
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if malformed
+ */
+esp_err_t auto_resp_parse_response(const char *text, auto_resp_entry_t *entry);
+
+/**
+ * @brief Register the 'resp' extension command
+ */
+void auto_resp_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,307 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "bench.h"
+#include "host_link.h"
+#include "slcan_protocol.h"
+
+static const char *TAG = "bench";
+
+#if CONFIG_CAN_BRIDGE_PROTOCOL_DYNAMIC
+#define PROTOCOL_NAME           "dynamic"
+#else
+#define PROTOCOL_NAME           "slcan"
+#endif
+
+// Benchmark state: generator fields written by the bench task, the rest by the transport
+static struct {
+    volatile bool running;
+    bench_config_t cfg;
+    SemaphoreHandle_t done_sem;
+    uint32_t injected;
+    uint32_t pool_full;
+    int64_t first_us;
+    uint32_t forwarded;
+    uint32_t not_sent;
+    uint32_t lost;
+    uint32_t next_seq;
+    uint64_t bytes;
+    int64_t last_us;
+    uint32_t latency_min_us;
+    uint32_t latency_max_us;
+    uint64_t latency_sum_us;
+    uint64_t cycles_sum;
+    uint32_t cycles_max;
+} s_bench;
+
+static portMUX_TYPE s_bench_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/** @brief Command line arguments for bench command */
+static struct {
+    struct arg_str *action;
+    struct arg_int *rate;
+    struct arg_int *count;
+    struct arg_int *id;
+    struct arg_int *dlc;
+    struct arg_end *end;
+} bench_args;
+
+/**
+ * @brief Publish the next frame into the RX bus
+ *
+ * @return false if no pool buffer is free
+ */
+static bool inject_frame(void)
+{
+    rx_bus_frame_t *rx_frame = rx_bus_alloc();
+    if (rx_frame == NULL) {
+        return false;
+    }
+    
+    int64_t now = esp_timer_get_time();
+    uint32_t seq = s_bench.injected;
+    uint32_t t = (uint32_t)now;
+    rx_frame->frame.header.id = s_bench.cfg.id;
+    rx_frame->frame.header.dlc = s_bench.cfg.dlc;
+    for (int i = 0; i < 4; i++) {
+        rx_frame->data[i] = (uint8_t)(seq >> (8 * i));
+    }
+    for (int i = 4; i < s_bench.cfg.dlc; i++) {
+        rx_frame->data[i] = (uint8_t)(t >> (8 * (i - 4)));
+    }
+    rx_frame->timestamp_us = now;
+    rx_frame->injected = true;
+    
+    s_bench.injected++;
+    BaseType_t woken = pdFALSE;
+    rx_bus_publish(rx_frame, &woken);
+    return true;
+}
+
+/**
+ * @brief Generator task: paces the injection to the configured rate
+ */
+static void bench_task(void *arg)
+{
+    // The frames are meant for the host: nothing is injected before it opens the channel
+    while (s_bench.running && !slcan_is_open()) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    
+    int64_t start_us = esp_timer_get_time();
+    s_bench.first_us = start_us;
+    while (s_bench.running && s_bench.injected < s_bench.cfg.count) {
+        uint32_t due = s_bench.cfg.count;
+        if (s_bench.cfg.rate) {
+            uint64_t n = (uint64_t)(esp_timer_get_time() - start_us) * s_bench.cfg.rate / 1000000 + 1;
+            if (n < due) {
+                due = (uint32_t)n;
+            }
+        }
+        while (s_bench.running && s_bench.injected < due) {
+            if (!inject_frame()) {
+                // The transport frees buffers as it writes; retry on the next tick
+                s_bench.pool_full++;
+                break;
+            }
+        }
+        vTaskDelay(1);
+    }
+    
+    ESP_LOGI(TAG, "Injected %lu frames", (unsigned long)s_bench.injected);
+    s_bench.running = false;
+    xSemaphoreGive(s_bench.done_sem);
+    vTaskDelete(NULL);
+}
+
+esp_err_t bench_start(const bench_config_t *config)
+{
+    if (s_bench.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (config->id > TWAI_STD_ID_MASK || config->dlc < 4 || config->dlc > 8 || config->count == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_bench.done_sem == NULL) {
+        s_bench.done_sem = xSemaphoreCreateBinary();
+        if (s_bench.done_sem == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    xSemaphoreTake(s_bench.done_sem, 0);
+    
+    portENTER_CRITICAL(&s_bench_mux);
+    s_bench.cfg = *config;
+    s_bench.injected = 0;
+    s_bench.pool_full = 0;
+    s_bench.first_us = 0;
+    s_bench.forwarded = 0;
+    s_bench.not_sent = 0;
+    s_bench.lost = 0;
+    s_bench.next_seq = 0;
+    s_bench.bytes = 0;
+    s_bench.last_us = 0;
+    s_bench.latency_min_us = UINT32_MAX;
+    s_bench.latency_max_us = 0;
+    s_bench.latency_sum_us = 0;
+    s_bench.cycles_sum = 0;
+    s_bench.cycles_max = 0;
+    s_bench.running = true;
+    portEXIT_CRITICAL(&s_bench_mux);
+    
+    // Below the transport task, which must keep draining what is injected
+    if (xTaskCreate(bench_task, "bench", 3072, NULL, 5, NULL) != pdPASS) {
+        s_bench.running = false;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t bench_stop(void)
+{
+    if (!s_bench.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    s_bench.running = false;
+    if (xSemaphoreTake(s_bench.done_sem, pdMS_TO_TICKS(2000)) != pdTRUE) {
+        ESP_LOGE(TAG, "Bench task did not stop");
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+void bench_on_forwarded(const rx_bus_frame_t *frame, esp_err_t send_result, uint32_t cycles)
+{
+    int64_t now = esp_timer_get_time();
+    const uint8_t *d = frame->data;
+    uint32_t seq = d[0] | (d[1] << 8) | (d[2] << 16) | ((uint32_t)d[3] << 24);
+    uint32_t latency_us = (uint32_t)(now - frame->timestamp_us);
+    
+    portENTER_CRITICAL(&s_bench_mux);
+    // Gaps are frames dropped by a full transport ring
+    if (seq >= s_bench.next_seq) {
+        s_bench.lost += seq - s_bench.next_seq;
+        s_bench.next_seq = seq + 1;
+    }
+    if (send_result != ESP_OK) {
+        s_bench.not_sent++;
+    } else {
+        s_bench.forwarded++;
+        s_bench.bytes += slcan_frame_len(&frame->frame);
+        s_bench.last_us = now;
+        s_bench.latency_sum_us += latency_us;
+        if (latency_us < s_bench.latency_min_us) {
+            s_bench.latency_min_us = latency_us;
+        }
+        if (latency_us > s_bench.latency_max_us) {
+            s_bench.latency_max_us = latency_us;
+        }
+        s_bench.cycles_sum += cycles;
+        if (cycles > s_bench.cycles_max) {
+            s_bench.cycles_max = cycles;
+        }
+    }
+    portEXIT_CRITICAL(&s_bench_mux);
+}
+
+void bench_get_status(bench_status_t *out)
+{
+    portENTER_CRITICAL(&s_bench_mux);
+    out->running = s_bench.running;
+    out->injected = s_bench.injected;
+    out->pool_full = s_bench.pool_full;
+    out->forwarded = s_bench.forwarded;
+    out->not_sent = s_bench.not_sent;
+    out->lost = s_bench.lost;
+    int64_t elapsed_us = s_bench.last_us - s_bench.first_us;
+    out->frames_per_s = elapsed_us > 0 ? (uint32_t)((uint64_t)s_bench.forwarded * 1000000 / elapsed_us) : 0;
+    out->bytes_per_s = elapsed_us > 0 ? (uint32_t)(s_bench.bytes * 1000000 / elapsed_us) : 0;
+    out->latency_min_us = s_bench.forwarded ? s_bench.latency_min_us : 0;
+    out->latency_avg_us = s_bench.forwarded ? (uint32_t)(s_bench.latency_sum_us / s_bench.forwarded) : 0;
+    out->latency_max_us = s_bench.latency_max_us;
+    out->cycles_avg = s_bench.forwarded ? (uint32_t)(s_bench.cycles_sum / s_bench.forwarded) : 0;
+    out->cycles_max = s_bench.cycles_max;
+    portEXIT_CRITICAL(&s_bench_mux);
+}
+
+/**
+ * @brief "bench" command handler
+ */
+static int bench_cmd_handler(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&bench_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, bench_args.end, argv[0]);
+        return 1;
+    }
+    
+    const char *action = bench_args.action->count ? bench_args.action->sval[0] : "show";
+    
+    if (strcmp(action, "start") == 0) {
+        bench_config_t cfg = {
+            .id = bench_args.id->count ? bench_args.id->ival[0] : 0x7FF,
+            .dlc = bench_args.dlc->count ? bench_args.dlc->ival[0] : 8,
+            .rate = bench_args.rate->count ? bench_args.rate->ival[0] : 0,
+            .count = bench_args.count->count ? bench_args.count->ival[0] : 100000,
+        };
+        esp_err_t ret = bench_start(&cfg);
+        if (ret != ESP_OK) {
+            printf("bench start: %s\n", esp_err_to_name(ret));
+            return 1;
+        }
+    } else if (strcmp(action, "stop") == 0) {
+        if (bench_stop() != ESP_OK) {
+            printf("bench: not running\n");
+            return 1;
+        }
+    } else if (strcmp(action, "show") != 0) {
+        printf("bench: unknown action '%s'\n", action);
+        return 1;
+    }
+    
+    bench_status_t st;
+    bench_get_status(&st);
+    printf("bench: %s, %lu injected (%lu deferred), %lu forwarded, %lu not sent, %lu lost, %lu frames/s, "
+           "%lu bytes/s, latency %lu/%lu/%lu us (min/avg/max), %lu/%lu cycles/frame (avg/max), %s/%s\n",
+           st.running ? "running" : "idle",
+           (unsigned long)st.injected, (unsigned long)st.pool_full, (unsigned long)st.forwarded,
+           (unsigned long)st.not_sent, (unsigned long)st.lost, (unsigned long)st.frames_per_s,
+           (unsigned long)st.bytes_per_s, (unsigned long)st.latency_min_us, (unsigned long)st.latency_avg_us,
+           (unsigned long)st.latency_max_us, (unsigned long)st.cycles_avg, (unsigned long)st.cycles_max,
+           PROTOCOL_NAME, host_link_transport_name());
+    return 0;
+}
+
+void bench_register_commands(void)
+{
+    bench_args.action = arg_str0(NULL, NULL, "<start|stop|show>", "Action (default: show)");
+    bench_args.rate = arg_int0("r", "rate", "<fps>", "start: frames per second (default: 0, as fast as possible)");
+    bench_args.count = arg_int0("n", "count", "<n>", "start: frames to inject (default: 100000)");
+    bench_args.id = arg_int0("i", "id", "<id>", "start: 11-bit CAN ID (default: 0x7FF)");
+    bench_args.dlc = arg_int0("l", "dlc", "<4-8>", "start: data length (default: 8)");
+    bench_args.end = arg_end(6);
+    
+    const esp_console_cmd_t bench_cmd = {
+        .command = "bench",
+        .help = "Forwarding self-benchmark: synthetic frames through the RX bus, encoder and host link\n"
+        "  bench start -r 5000 -n 50000   # starts when the channel is opened\n"
+        "  bench                          # rate, drops and latency",
+        .hint = NULL,
+        .func = &bench_cmd_handler,
+        .argtable = &bench_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&bench_cmd));
+}
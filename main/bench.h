@@ -0,0 +1,106 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "rx_bus.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Forwarding self-benchmark
+ *
+ * Synthetic frames are published into the RX bus exactly like the RX ISR
+ * publishes received ones, so they go through the transport ring, SLCAN
+ * encoding and the host link like bus traffic, without needing a busy bus.
+ * The transport reports each benchmark frame back after sending it, which
+ * gives the sustained rate, the encoded bytes and the latency from
+ * injection to the end of the host write.
+ *
+ * Data bytes 0-3 of every frame carry a sequence number (little-endian,
+ * starting at 0) and bytes 4-7 the low 32 bits of the injection time in
+ * microseconds, so the host can check for lost, repeated or reordered
+ * frames. Injection starts once the SLCAN channel is open. Other RX bus
+ * subscribers (capture, profiling, ...) see the frames as well.
+ *
+ * The transport also reports the CPU cycles each frame took from the start
+ * of forwarding to the end of the host write (decoder checks, encoding and
+ * write), which together with the image size compares the build-time
+ * protocol and transport choices. With the dynamic protocol the frames go
+ * through the decoder checks like bus traffic, so the ID must not be one a
+ * running decoder claims.
+ */
+
+/**
+ * @brief Benchmark parameters
+ */
+typedef struct {
+    uint32_t id;                /**< CAN ID of the frames (11-bit) */
+    uint8_t dlc;                /**< Data length (4..8) */
+    uint32_t rate;              /**< Frames per second (0: as fast as the pool allows) */
+    uint32_t count;             /**< Frames to inject */
+} bench_config_t;
+
+/**
+ * @brief Benchmark results
+ */
+typedef struct {
+    bool running;               /**< Injecting */
+    uint32_t injected;          /**< Frames published */
+    uint32_t pool_full;         /**< Injections deferred for lack of a pool buffer */
+    uint32_t forwarded;         /**< Frames written to the host */
+    uint32_t not_sent;          /**< Frames the transport could not write (channel closed) */
+    uint32_t lost;              /**< Frames dropped between injection and the transport */
+    uint32_t frames_per_s;      /**< Sustained forwarding rate */
+    uint32_t bytes_per_s;       /**< Encoded bytes per second to the host */
+    uint32_t latency_min_us;    /**< Injection to end of write */
+    uint32_t latency_avg_us;
+    uint32_t latency_max_us;
+    uint32_t cycles_avg;        /**< CPU cycles per forwarded frame */
+    uint32_t cycles_max;
+} bench_status_t;
+
+/**
+ * @brief Start a benchmark run
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if running, ESP_ERR_INVALID_ARG, ESP_ERR_NO_MEM
+ */
+esp_err_t bench_start(const bench_config_t *config);
+
+/**
+ * @brief Stop injecting
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not running, ESP_ERR_TIMEOUT
+ */
+esp_err_t bench_stop(void);
+
+/**
+ * @brief Account for a benchmark frame handled by the transport
+ *
+ * @param frame Injected frame (frame->injected set)
+ * @param send_result Result of the SLCAN write
+ * @param cycles CPU cycles spent forwarding the frame
+ */
+void bench_on_forwarded(const rx_bus_frame_t *frame, esp_err_t send_result, uint32_t cycles);
+
+/**
+ * @brief Get the results of the current or last run
+ */
+void bench_get_status(bench_status_t *out);
+
+/**
+ * @brief Register the 'bench' extension command
+ */
+void bench_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
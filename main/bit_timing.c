@@ -0,0 +1,124 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stddef.h>
+#include "bit_timing.h"
+
+/**
+ * @brief Absolute value of a signed 64-bit difference
+ */
+static uint64_t abs_diff(int64_t v)
+{
+    return (uint64_t)(v < 0 ? -v : v);
+}
+
+int bit_timing_calc(uint32_t clk_hz, uint32_t bitrate, uint16_t sp_permill, uint8_t sjw,
+                    const bit_timing_limits_t *limits, bit_timing_t *out, int32_t *err_ppm)
+{
+    if (clk_hz == 0 || bitrate == 0 || limits == NULL || out == NULL || sp_permill >= 1000) {
+        return -1;
+    }
+    if (sp_permill == 0) {
+        sp_permill = BIT_TIMING_DEFAULT_SP;
+    }
+    
+    uint32_t tq_min = 1 + limits->tseg1_min + limits->tseg2_min;
+    uint32_t tq_max = 1 + limits->tseg1_max + limits->tseg2_max;
+    uint32_t step = limits->brp_step ? limits->brp_step : 1;
+    
+    bool found = false;
+    uint64_t best_rate_err = UINT64_MAX;
+    uint32_t best_sp_err = UINT32_MAX;
+    uint32_t best_tq = 0;
+    bit_timing_t best = {0};
+    
+    for (uint32_t brp = limits->brp_min; brp <= limits->brp_max; brp += step) {
+        // Quanta per bit closest to the target for this prescaler
+        uint64_t div = (uint64_t)brp * bitrate;
+        uint32_t tq = (uint32_t)((clk_hz + div / 2) / div);
+        if (tq < tq_min || tq > tq_max) {
+            continue;
+        }
+        
+        // Bitrate error scaled to avoid division: |clk - brp * tq * bitrate|
+        uint64_t rate_err = abs_diff((int64_t)clk_hz - (int64_t)((uint64_t)brp * tq * bitrate));
+        
+        // Place the sample point, then clamp both segments into range
+        int32_t tseg2 = (int32_t)((tq * (1000 - sp_permill) + 500) / 1000);
+        if (tseg2 < limits->tseg2_min) tseg2 = limits->tseg2_min;
+        if (tseg2 > limits->tseg2_max) tseg2 = limits->tseg2_max;
+        int32_t tseg1 = (int32_t)tq - 1 - tseg2;
+        if (tseg1 > limits->tseg1_max) {
+            tseg1 = limits->tseg1_max;
+            tseg2 = (int32_t)tq - 1 - tseg1;
+        }
+        if (tseg1 < limits->tseg1_min || tseg2 < limits->tseg2_min || tseg2 > limits->tseg2_max) {
+            continue;
+        }
+        
+        uint32_t sp = (uint32_t)((1 + tseg1) * 1000 / tq);
+        uint32_t sp_err = (uint32_t)abs_diff((int64_t)sp - sp_permill);
+        
+        // Compare bitrate errors relative to the clock (same clk for all candidates)
+        bool better = !found ||
+                      rate_err < best_rate_err ||
+                      (rate_err == best_rate_err && sp_err < best_sp_err) ||
+                      (rate_err == best_rate_err && sp_err == best_sp_err && tq > best_tq);
+        if (better) {
+            found = true;
+            best_rate_err = rate_err;
+            best_sp_err = sp_err;
+            best_tq = tq;
+            best.brp = brp;
+            best.tseg1 = (uint8_t)tseg1;
+            best.tseg2 = (uint8_t)tseg2;
+        }
+    }
+    
+    if (!found) {
+        return -1;
+    }
+    
+    uint8_t sjw_max = best.tseg2 < limits->sjw_max ? best.tseg2 : limits->sjw_max;
+    best.sjw = (sjw == 0 || sjw > sjw_max) ? sjw_max : sjw;
+    best.triple_sampling = false;
+    
+    uint32_t achieved = bit_timing_bitrate(clk_hz, &best);
+    int64_t ppm = ((int64_t)achieved - (int64_t)bitrate) * 1000000 / (int64_t)bitrate;
+    if (abs_diff(ppm) > BIT_TIMING_MAX_ERROR_PPM) {
+        return -1;
+    }
+    
+    *out = best;
+    if (err_ppm) {
+        *err_ppm = (int32_t)ppm;
+    }
+    return 0;
+}
+
+uint32_t bit_timing_bitrate(uint32_t clk_hz, const bit_timing_t *timing)
+{
+    uint64_t div = (uint64_t)timing->brp * (1 + timing->tseg1 + timing->tseg2);
+    if (div == 0) {
+        return 0;
+    }
+    return (uint32_t)((clk_hz + div / 2) / div);
+}
+
+uint16_t bit_timing_sample_point(const bit_timing_t *timing)
+{
+    uint32_t tq = 1 + timing->tseg1 + timing->tseg2;
+    return (uint16_t)((1 + timing->tseg1) * 1000 / tq);
+}
+
+void bit_timing_from_btr(uint8_t btr0, uint8_t btr1, bit_timing_t *out)
+{
+    out->brp = 2 * ((btr0 & 0x3F) + 1);
+    out->sjw = ((btr0 >> 6) & 0x03) + 1;
+    out->tseg1 = (btr1 & 0x0F) + 1;
+    out->tseg2 = ((btr1 >> 4) & 0x07) + 1;
+    out->triple_sampling = (btr1 & 0x80) != 0;
+}
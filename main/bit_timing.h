@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief CAN bit timing calculator
+ *
+ * Pure C (no ESP-IDF dependencies) so it can be built and tested on the host.
+ * A bit is 1 (sync) + tseg1 + tseg2 time quanta of brp controller clocks each;
+ * the sample point lies between tseg1 and tseg2.
+ */
+
+/** @brief Clock of the SJA1000 reference design assumed by SLCAN 'sxxyy' (Hz) */
+#define BIT_TIMING_SJA1000_CLK_HZ   16000000
+
+/** @brief Maximum accepted bitrate error of a calculated timing (ppm) */
+#define BIT_TIMING_MAX_ERROR_PPM    10000
+
+/** @brief Default sample point (permille) when none is requested */
+#define BIT_TIMING_DEFAULT_SP       875
+
+/**
+ * @brief Bit timing register values
+ */
+typedef struct {
+    uint32_t brp;           /**< Prescaler: controller clocks per time quantum */
+    uint8_t tseg1;          /**< Propagation + phase 1 segment (quanta) */
+    uint8_t tseg2;          /**< Phase 2 segment (quanta) */
+    uint8_t sjw;            /**< Synchronization jump width (quanta) */
+    bool triple_sampling;   /**< Sample three times (SJA1000 SAM bit) */
+} bit_timing_t;
+
+/**
+ * @brief Register ranges of a CAN controller
+ */
+typedef struct {
+    uint32_t brp_min;       /**< Minimum prescaler */
+    uint32_t brp_max;       /**< Maximum prescaler */
+    uint32_t brp_step;      /**< Prescaler granularity (e.g. 2 if only even values) */
+    uint8_t tseg1_min;      /**< Minimum tseg1 */
+    uint8_t tseg1_max;      /**< Maximum tseg1 */
+    uint8_t tseg2_min;      /**< Minimum tseg2 */
+    uint8_t tseg2_max;      /**< Maximum tseg2 */
+    uint8_t sjw_max;        /**< Maximum sjw */
+} bit_timing_limits_t;
+
+/**
+ * @brief Find the best timing for a bitrate and sample point
+ *
+ * Candidates are ranked by bitrate error, then sample point error, then by
+ * the number of quanta per bit (more is better).
+ *
+ * @param clk_hz Controller clock (Hz)
+ * @param bitrate Requested bitrate (bps)
+ * @param sp_permill Requested sample point (permille), 0 for the default
+ * @param sjw Requested sjw, 0 to use min(tseg2, limits->sjw_max)
+ * @param limits Controller register ranges
+ * @param out Output timing
+ * @param err_ppm Output: achieved bitrate error (ppm, signed), may be NULL
+ * @return 0 on success, -1 on invalid arguments or if no timing is within
+ *         BIT_TIMING_MAX_ERROR_PPM
+ */
+int bit_timing_calc(uint32_t clk_hz, uint32_t bitrate, uint16_t sp_permill, uint8_t sjw,
+                    const bit_timing_limits_t *limits, bit_timing_t *out, int32_t *err_ppm);
+
+/**
+ * @brief Bitrate produced by a timing
+ *
+ * @param clk_hz Controller clock (Hz)
+ * @param timing Timing
+ * @return Bitrate (bps), rounded to nearest
+ */
+uint32_t bit_timing_bitrate(uint32_t clk_hz, const bit_timing_t *timing);
+
+/**
+ * @brief Sample point of a timing
+ *
+ * @param timing Timing
+ * @return Sample point (permille)
+ */
+uint16_t bit_timing_sample_point(const bit_timing_t *timing);
+
+/**
+ * @brief Decode SJA1000 BTR0/BTR1 register values
+ *
+ * The prescaler is returned in SJA1000 clocks (2 * (BRP + 1)), so
+ * bit_timing_bitrate(BIT_TIMING_SJA1000_CLK_HZ, out) gives the bitrate.
+ *
+ * @param btr0 BTR0: SJW[7:6], BRP[5:0]
+ * @param btr1 BTR1: SAM[7], TSEG2[6:4], TSEG1[3:0]
+ * @param out Output timing
+ */
+void bit_timing_from_btr(uint8_t btr0, uint8_t btr1, bit_timing_t *out);
+
+#ifdef __cplusplus
+}
+#endif
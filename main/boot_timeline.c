@@ -0,0 +1,156 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_rtc_time.h"
+#include "bridge_config.h"
+#include "boot_timeline.h"
+
+static struct {
+    bool anchored;
+    int64_t reset_offset_us;    // Time since reset at esp_timer 0, -1 if unknown
+    uint32_t count;
+    const char *phase[BOOT_TIMELINE_MAX_PHASES];
+    int64_t time_us[BOOT_TIMELINE_MAX_PHASES];
+} s_tl;
+
+static portMUX_TYPE s_tl_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/** @brief Command line arguments for boot command */
+static struct {
+    struct arg_lit *forget;
+    struct arg_end *end;
+} boot_args;
+
+/**
+ * @brief Anchor esp_timer to the reset, if the RTC timer started at the reset
+ */
+static void boot_timeline_anchor(void)
+{
+    // The RTC timer keeps running across software and watchdog resets
+    if (esp_reset_reason() == ESP_RST_POWERON) {
+        s_tl.reset_offset_us = (int64_t)esp_rtc_get_time_us() - esp_timer_get_time();
+    } else {
+        s_tl.reset_offset_us = -1;
+    }
+    s_tl.anchored = true;
+}
+
+void boot_timeline_mark_at(const char *phase, int64_t time_us)
+{
+    if (!s_tl.anchored) {
+        boot_timeline_anchor();
+    }
+    
+    portENTER_CRITICAL(&s_tl_mux);
+    bool known = false;
+    for (uint32_t i = 0; i < s_tl.count; i++) {
+        if (strcmp(s_tl.phase[i], phase) == 0) {
+            known = true;
+            break;
+        }
+    }
+    if (!known && s_tl.count < BOOT_TIMELINE_MAX_PHASES) {
+        s_tl.phase[s_tl.count] = phase;
+        s_tl.time_us[s_tl.count] = time_us;
+        s_tl.count++;
+    }
+    portEXIT_CRITICAL(&s_tl_mux);
+}
+
+void boot_timeline_mark(const char *phase)
+{
+    boot_timeline_mark_at(phase, esp_timer_get_time());
+}
+
+/**
+ * @brief Boot command handler
+ */
+static int boot_cmd_handler(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&boot_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, boot_args.end, argv[0]);
+        return 1;
+    }
+    
+    if (boot_args.forget->count > 0) {
+        if (bridge_config_forget_bitrate() != ESP_OK) {
+            printf("boot: failed to forget bitrate\n");
+            return 1;
+        }
+        printf("boot: persisted bitrate cleared, next boot auto-detects\n");
+        return 0;
+    }
+    
+    uint32_t bitrate;
+    if (bridge_config_get_bitrate(&bitrate)) {
+        printf("boot: reset reason %d, persisted bitrate %lu\n", (int)esp_reset_reason(), bitrate);
+    } else {
+        printf("boot: reset reason %d, no persisted bitrate\n", (int)esp_reset_reason());
+    }
+    
+    // Copy the phases, the RX task may still add one
+    const char *phase[BOOT_TIMELINE_MAX_PHASES];
+    int64_t time_us[BOOT_TIMELINE_MAX_PHASES];
+    portENTER_CRITICAL(&s_tl_mux);
+    uint32_t count = s_tl.count;
+    memcpy(phase, s_tl.phase, sizeof(phase));
+    memcpy(time_us, s_tl.time_us, sizeof(time_us));
+    portEXIT_CRITICAL(&s_tl_mux);
+    
+    // Phases marked with a past time (first frame) may be out of order
+    for (uint32_t i = 1; i < count; i++) {
+        for (uint32_t j = i; j > 0 && time_us[j] < time_us[j - 1]; j--) {
+            const char *p = phase[j];
+            int64_t t = time_us[j];
+            phase[j] = phase[j - 1];
+            time_us[j] = time_us[j - 1];
+            phase[j - 1] = p;
+            time_us[j - 1] = t;
+        }
+    }
+    
+    int64_t base = 0;
+    int64_t prev = 0;
+    if (s_tl.reset_offset_us >= 0) {
+        base = s_tl.reset_offset_us;
+        printf("  %-14s %10s %10s\n", "phase", "since reset", "delta");
+        printf("  %-14s %10lld %10s\n", "reset", 0LL, "");
+    } else {
+        printf("  %-14s %10s %10s  (not a power-on reset, bootloader not included)\n",
+               "phase", "since start", "delta");
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        int64_t t = base + time_us[i];
+        printf("  %-14s %10lld %10lld us\n", phase[i], (long long)t, (long long)(t - prev));
+        prev = t;
+    }
+    return 0;
+}
+
+void boot_timeline_register_commands(void)
+{
+    boot_args.forget = arg_lit0("f", "forget", "Forget the persisted bitrate");
+    boot_args.end = arg_end(1);
+    
+    const esp_console_cmd_t boot_cmd = {
+        .command = "boot",
+        .help = "Boot timeline and persisted bitrate\n"
+        "  boot             # print the time of each startup phase\n"
+        "  boot -f          # forget the persisted bitrate",
+        .hint = NULL,
+        .func = &boot_cmd_handler,
+        .argtable = &boot_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&boot_cmd));
+}
@@ -0,0 +1,48 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Boot timeline: timestamps of the startup phases up to forwarding
+ *
+ * Each phase is recorded once, the first time it is marked. After a
+ * power-on reset the times are relative to the reset (RTC timer), so they
+ * include ROM and bootloader; otherwise they start at esp_timer init.
+ */
+
+// Maximum number of recorded phases
+#define BOOT_TIMELINE_MAX_PHASES 16
+
+/**
+ * @brief Record a phase at the current time
+ *
+ * @param phase Phase name (string literal, compared by content)
+ */
+void boot_timeline_mark(const char *phase);
+
+/**
+ * @brief Record a phase at a given esp_timer time
+ *
+ * @param phase Phase name (string literal, compared by content)
+ * @param time_us esp_timer_get_time() at which the phase happened
+ */
+void boot_timeline_mark_at(const char *phase, int64_t time_us);
+
+/**
+ * @brief Register the 'boot' extension command
+ */
+void boot_timeline_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,43 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include "bridge_cmd.h"
+#include "esp_console.h"
+#include "esp_log.h"
+
+static const char *TAG = "bridge_cmd";
+
+esp_err_t bridge_cmd_init(void)
+{
+    esp_console_config_t console_config = ESP_CONSOLE_CONFIG_DEFAULT();
+    
+    esp_err_t ret = esp_console_init(&console_config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize command interpreter: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    return esp_console_register_help_command();
+}
+
+esp_err_t bridge_cmd_run(const char *cmdline)
+{
+    int cmd_ret = 0;
+    esp_err_t ret = esp_console_run(cmdline, &cmd_ret);
+    
+    if (ret == ESP_ERR_NOT_FOUND) {
+        ESP_LOGW(TAG, "Unknown extension command: %s", cmdline);
+        return ret;
+    }
+    if (ret != ESP_OK) {
+        // Empty command line or argument parsing failure
+        return ret;
+    }
+    
+    fflush(stdout);
+    return (cmd_ret == 0) ? ESP_OK : ESP_FAIL;
+}
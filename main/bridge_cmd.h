@@ -0,0 +1,44 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Bridge extension commands
+ *
+ * SLCAN has no room for device-specific commands, so the bridge reserves the
+ * 'X' command letter: everything after it is handed to esp_console and
+ * dispatched to the commands registered by the bridge modules.
+ * Example: "Xpm_stats\r"
+ */
+
+/**
+ * @brief Initialize the extension command interpreter
+ *
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t bridge_cmd_init(void);
+
+/**
+ * @brief Run one extension command line
+ *
+ * Command output is written to stdout. The caller acknowledges the command
+ * on the SLCAN channel based on the returned status.
+ *
+ * @param cmdline Null-terminated command line (without the 'X' prefix)
+ * @return ESP_OK if the command ran and returned 0, error code otherwise
+ */
+esp_err_t bridge_cmd_run(const char *cmdline);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,86 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "esp_log.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+#include "bridge_config.h"
+
+static const char *TAG = "bridge_config";
+
+#define CONFIG_NAMESPACE    "can_bridge"
+#define KEY_BITRATE         "bitrate"
+
+static nvs_handle_t s_nvs = 0;
+
+esp_err_t bridge_config_init(void)
+{
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_LOGW(TAG, "NVS partition needs to be erased");
+        ret = nvs_flash_erase();
+        if (ret == ESP_OK) {
+            ret = nvs_flash_init();
+        }
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "NVS init failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    ret = nvs_open(CONFIG_NAMESPACE, NVS_READWRITE, &s_nvs);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS namespace: %s", esp_err_to_name(ret));
+        s_nvs = 0;
+    }
+    return ret;
+}
+
+bool bridge_config_get_bitrate(uint32_t *bitrate)
+{
+    if (s_nvs == 0) {
+        return false;
+    }
+    return nvs_get_u32(s_nvs, KEY_BITRATE, bitrate) == ESP_OK && *bitrate != 0;
+}
+
+esp_err_t bridge_config_set_bitrate(uint32_t bitrate)
+{
+    if (s_nvs == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    // Avoid a flash write on every boot with an unchanged bitrate
+    uint32_t stored;
+    if (nvs_get_u32(s_nvs, KEY_BITRATE, &stored) == ESP_OK && stored == bitrate) {
+        return ESP_OK;
+    }
+    
+    esp_err_t ret = nvs_set_u32(s_nvs, KEY_BITRATE, bitrate);
+    if (ret == ESP_OK) {
+        ret = nvs_commit(s_nvs);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to persist bitrate: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+esp_err_t bridge_config_forget_bitrate(void)
+{
+    if (s_nvs == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    esp_err_t ret = nvs_erase_key(s_nvs, KEY_BITRATE);
+    if (ret == ESP_ERR_NVS_NOT_FOUND) {
+        return ESP_OK;
+    }
+    if (ret == ESP_OK) {
+        ret = nvs_commit(s_nvs);
+    }
+    return ret;
+}
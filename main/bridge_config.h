@@ -0,0 +1,59 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Persistent bridge settings (NVS namespace "can_bridge")
+ *
+ * Stores the last bitrate the bridge ran at, so the fast start profile can
+ * bring up the bus without auto-detection.
+ */
+
+/**
+ * @brief Initialize NVS and open the settings namespace
+ *
+ * Erases and re-initializes the NVS partition if it is full or was written
+ * by a newer NVS version.
+ *
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t bridge_config_init(void);
+
+/**
+ * @brief Get the persisted bitrate
+ *
+ * @param bitrate Output: bitrate in bps
+ * @return true if a bitrate is stored
+ */
+bool bridge_config_get_bitrate(uint32_t *bitrate);
+
+/**
+ * @brief Persist the bitrate (written only if it changed)
+ *
+ * @param bitrate Bitrate in bps
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t bridge_config_set_bitrate(uint32_t bitrate);
+
+/**
+ * @brief Forget the persisted bitrate, so the next boot auto-detects again
+ *
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t bridge_config_forget_bitrate(void);
+
+#ifdef __cplusplus
+}
+#endif
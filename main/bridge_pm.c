@@ -0,0 +1,250 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_pm.h"
+#include "esp_timer.h"
+#include "bridge_pm.h"
+
+static const char *TAG = "bridge_pm";
+
+#ifndef CONFIG_CAN_BRIDGE_PM_IDLE_RELEASE_MS
+#define CONFIG_CAN_BRIDGE_PM_IDLE_RELEASE_MS 1000
+#endif
+
+// PM state shared between the RX ISR and the tasks
+static struct {
+    esp_pm_lock_handle_t cpu_lock;
+    esp_pm_lock_handle_t sleep_lock;
+    bool channel_open;
+    bridge_pm_state_t state;
+    int64_t last_rx_us;
+    uint32_t acquire_count;
+    bridge_pm_latency_t latency[BRIDGE_PM_STATE_COUNT];
+} s_pm = {
+    .state = BRIDGE_PM_STATE_RELEASED,
+};
+
+static portMUX_TYPE s_pm_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *state_names[BRIDGE_PM_STATE_COUNT] = {
+    [BRIDGE_PM_STATE_RELEASED] = "released",
+    [BRIDGE_PM_STATE_LOCKED] = "locked",
+};
+
+/** @brief Command line arguments for pm command */
+static struct {
+    struct arg_lit *reset;
+    struct arg_end *end;
+} pm_args;
+
+/**
+ * @brief Take both locks (caller holds s_pm_mux)
+ */
+static IRAM_ATTR void pm_lock_take(void)
+{
+    if (s_pm.state == BRIDGE_PM_STATE_LOCKED) {
+        return;
+    }
+    if (s_pm.cpu_lock) {
+        esp_pm_lock_acquire(s_pm.cpu_lock);
+    }
+    if (s_pm.sleep_lock) {
+        esp_pm_lock_acquire(s_pm.sleep_lock);
+    }
+    s_pm.state = BRIDGE_PM_STATE_LOCKED;
+    s_pm.acquire_count++;
+}
+
+/**
+ * @brief Give back both locks (caller holds s_pm_mux)
+ */
+static void pm_lock_give(void)
+{
+    if (s_pm.state == BRIDGE_PM_STATE_RELEASED) {
+        return;
+    }
+    if (s_pm.sleep_lock) {
+        esp_pm_lock_release(s_pm.sleep_lock);
+    }
+    if (s_pm.cpu_lock) {
+        esp_pm_lock_release(s_pm.cpu_lock);
+    }
+    s_pm.state = BRIDGE_PM_STATE_RELEASED;
+}
+
+esp_err_t bridge_pm_init(void)
+{
+    memset(s_pm.latency, 0, sizeof(s_pm.latency));
+    for (int i = 0; i < BRIDGE_PM_STATE_COUNT; i++) {
+        s_pm.latency[i].min_us = UINT32_MAX;
+    }
+
+#if CONFIG_PM_ENABLE
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_CAN_BRIDGE_PM_MIN_FREQ_MHZ,
+#if CONFIG_CAN_BRIDGE_PM_LIGHT_SLEEP
+        .light_sleep_enable = true,
+#else
+        .light_sleep_enable = false,
+#endif
+    };
+    esp_err_t ret = esp_pm_configure(&pm_config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure DFS: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "can_fwd_cpu", &s_pm.cpu_lock);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create CPU frequency lock: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    ret = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "can_fwd_sleep", &s_pm.sleep_lock);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create no-light-sleep lock: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "DFS %d-%d MHz, light sleep %s, idle release after %d ms",
+             pm_config.min_freq_mhz, pm_config.max_freq_mhz,
+             pm_config.light_sleep_enable ? "on" : "off", CONFIG_CAN_BRIDGE_PM_IDLE_RELEASE_MS);
+#else
+    ESP_LOGI(TAG, "Power management disabled, measuring latency only");
+#endif
+
+    return ESP_OK;
+}
+
+void bridge_pm_channel_open(void)
+{
+    portENTER_CRITICAL(&s_pm_mux);
+    s_pm.channel_open = true;
+    s_pm.last_rx_us = esp_timer_get_time();
+    pm_lock_take();
+    portEXIT_CRITICAL(&s_pm_mux);
+}
+
+void bridge_pm_channel_close(void)
+{
+    portENTER_CRITICAL(&s_pm_mux);
+    s_pm.channel_open = false;
+    pm_lock_give();
+    portEXIT_CRITICAL(&s_pm_mux);
+}
+
+IRAM_ATTR bridge_pm_state_t bridge_pm_rx_from_isr(void)
+{
+    portENTER_CRITICAL_ISR(&s_pm_mux);
+    // The frame was received in the current state; the lock only helps the next one
+    bridge_pm_state_t state = s_pm.state;
+    s_pm.last_rx_us = esp_timer_get_time();
+    if (s_pm.channel_open) {
+        pm_lock_take();
+    }
+    portEXIT_CRITICAL_ISR(&s_pm_mux);
+    return state;
+}
+
+void bridge_pm_check_idle(void)
+{
+#if CONFIG_CAN_BRIDGE_PM_IDLE_RELEASE_MS > 0
+    int64_t now = esp_timer_get_time();
+    
+    portENTER_CRITICAL(&s_pm_mux);
+    if (s_pm.state == BRIDGE_PM_STATE_LOCKED &&
+        (now - s_pm.last_rx_us) >= (int64_t)CONFIG_CAN_BRIDGE_PM_IDLE_RELEASE_MS * 1000) {
+        pm_lock_give();
+    }
+    portEXIT_CRITICAL(&s_pm_mux);
+#endif
+}
+
+void bridge_pm_record_latency(bridge_pm_state_t state, uint32_t latency_us)
+{
+    if (state >= BRIDGE_PM_STATE_COUNT) {
+        return;
+    }
+    
+    portENTER_CRITICAL(&s_pm_mux);
+    bridge_pm_latency_t *lat = &s_pm.latency[state];
+    lat->count++;
+    lat->sum_us += latency_us;
+    if (latency_us < lat->min_us) lat->min_us = latency_us;
+    if (latency_us > lat->max_us) lat->max_us = latency_us;
+    portEXIT_CRITICAL(&s_pm_mux);
+}
+
+void bridge_pm_get_latency(bridge_pm_state_t state, bridge_pm_latency_t *out)
+{
+    if (state >= BRIDGE_PM_STATE_COUNT || out == NULL) {
+        return;
+    }
+    
+    portENTER_CRITICAL(&s_pm_mux);
+    *out = s_pm.latency[state];
+    portEXIT_CRITICAL(&s_pm_mux);
+}
+
+/**
+ * @brief "pm" command handler - print PM state and latency per state
+ */
+static int pm_cmd_handler(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&pm_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, pm_args.end, argv[0]);
+        return 1;
+    }
+    
+    printf("pm: %s, channel %s, lock acquisitions %lu\n",
+           state_names[s_pm.state], s_pm.channel_open ? "open" : "closed",
+           (unsigned long)s_pm.acquire_count);
+    
+    for (int i = 0; i < BRIDGE_PM_STATE_COUNT; i++) {
+        bridge_pm_latency_t lat;
+        bridge_pm_get_latency(i, &lat);
+        if (lat.count == 0) {
+            printf("  %-8s: no frames\n", state_names[i]);
+            continue;
+        }
+        printf("  %-8s: n=%lu min=%luus avg=%luus max=%luus\n", state_names[i],
+               (unsigned long)lat.count, (unsigned long)lat.min_us,
+               (unsigned long)(lat.sum_us / lat.count), (unsigned long)lat.max_us);
+    }
+    
+    if (pm_args.reset->count > 0) {
+        portENTER_CRITICAL(&s_pm_mux);
+        memset(s_pm.latency, 0, sizeof(s_pm.latency));
+        for (int i = 0; i < BRIDGE_PM_STATE_COUNT; i++) {
+            s_pm.latency[i].min_us = UINT32_MAX;
+        }
+        portEXIT_CRITICAL(&s_pm_mux);
+    }
+    
+    return 0;
+}
+
+void bridge_pm_register_commands(void)
+{
+    pm_args.reset = arg_lit0("r", "reset", "Reset latency statistics after printing");
+    pm_args.end = arg_end(2);
+    
+    const esp_console_cmd_t pm_cmd = {
+        .command = "pm",
+        .help = "Show power management state and RX ISR-to-forwarder latency per state",
+        .hint = NULL,
+        .func = &pm_cmd_handler,
+        .argtable = &pm_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&pm_cmd));
+}
@@ -0,0 +1,105 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Power management for deterministic forwarding
+ *
+ * While the SLCAN channel is open and the bus is active, the bridge holds a
+ * CPU-frequency lock and a no-light-sleep lock so RX interrupt latency does
+ * not depend on the DFS state. The locks are released when the channel is
+ * closed or the bus has been idle for CONFIG_CAN_BRIDGE_PM_IDLE_RELEASE_MS,
+ * and re-acquired from the RX ISR on the next frame.
+ *
+ * Without CONFIG_PM_ENABLE the locks are no-ops, but latency statistics are
+ * still collected.
+ */
+
+/**
+ * @brief Power management state
+ */
+typedef enum {
+    BRIDGE_PM_STATE_RELEASED = 0,   /**< Locks released (channel closed or bus idle) */
+    BRIDGE_PM_STATE_LOCKED,         /**< Locks held (channel open, bus active) */
+    BRIDGE_PM_STATE_COUNT,
+} bridge_pm_state_t;
+
+/**
+ * @brief ISR-to-forwarder latency statistics for one power state
+ */
+typedef struct {
+    uint32_t count;     /**< Number of frames measured */
+    uint32_t min_us;    /**< Minimum latency (us) */
+    uint32_t max_us;    /**< Maximum latency (us) */
+    uint64_t sum_us;    /**< Sum of latencies, for the average (us) */
+} bridge_pm_latency_t;
+
+/**
+ * @brief Configure DFS/light sleep and create the PM locks
+ *
+ * @return ESP_OK on success (also when PM is not enabled), error code otherwise
+ */
+esp_err_t bridge_pm_init(void);
+
+/**
+ * @brief Acquire the locks when the channel is opened
+ */
+void bridge_pm_channel_open(void);
+
+/**
+ * @brief Release the locks when the channel is closed
+ */
+void bridge_pm_channel_close(void);
+
+/**
+ * @brief Note a received frame, re-acquiring the locks if released for idle
+ *
+ * @note Called from the TWAI RX ISR
+ *
+ * @return PM state the frame was received in
+ */
+bridge_pm_state_t bridge_pm_rx_from_isr(void);
+
+/**
+ * @brief Release the locks if the bus has been idle long enough
+ *
+ * Called periodically from the forwarding task.
+ */
+void bridge_pm_check_idle(void);
+
+/**
+ * @brief Record ISR-to-forwarder latency of one frame
+ *
+ * @param state PM state the frame was received in
+ * @param latency_us Time from RX ISR to dequeue in the forwarding task (us)
+ */
+void bridge_pm_record_latency(bridge_pm_state_t state, uint32_t latency_us);
+
+/**
+ * @brief Get a snapshot of the latency statistics
+ *
+ * @param state PM state to query
+ * @param out Output statistics
+ */
+void bridge_pm_get_latency(bridge_pm_state_t state, bridge_pm_latency_t *out);
+
+/**
+ * @brief Register the "pm" extension command
+ */
+void bridge_pm_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,270 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "bridge_state.h"
+#include "clock_sync.h"
+#include "host_hold.h"
+#include "host_link.h"
+#include "slcan_protocol.h"
+
+static const char *TAG = "bridge_state";
+
+#define ALL_STATE_BITS          (BRIDGE_STATE_BIT(BRIDGE_STATE_COUNT) - 1)
+
+static const char *const s_state_names[BRIDGE_STATE_COUNT] = {
+    "idle", "detecting", "armed", "open", "recovering",
+};
+
+// Lifecycle state: the event group mirrors 'state' for the waiting tasks
+static struct {
+    EventGroupHandle_t events;
+    bridge_state_t state;
+    int64_t since_us;
+    uint32_t transitions;
+    uint32_t opens;
+    uint32_t recoveries;
+    uint32_t open_us_last;
+    uint32_t open_us_max;
+    uint32_t close_us_last;
+    uint32_t close_us_max;
+    bridge_close_policy_t policy;
+    uint32_t forwarded;
+    uint32_t not_sent;
+    bridge_state_change_t history[BRIDGE_STATE_HISTORY];
+    uint32_t history_count;
+} s_state;
+
+static portMUX_TYPE s_state_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/** @brief Command line arguments for state command */
+static struct {
+    struct arg_str *action;
+    struct arg_str *policy;
+    struct arg_end *end;
+} state_args;
+
+esp_err_t bridge_state_init(void)
+{
+    s_state.events = xEventGroupCreate();
+    if (s_state.events == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    s_state.state = BRIDGE_STATE_IDLE;
+    s_state.since_us = esp_timer_get_time();
+    xEventGroupSetBits(s_state.events, BRIDGE_STATE_BIT(BRIDGE_STATE_IDLE));
+    return ESP_OK;
+}
+
+const char *bridge_state_name(bridge_state_t state)
+{
+    return (unsigned)state < BRIDGE_STATE_COUNT ? s_state_names[state] : "?";
+}
+
+void bridge_state_set(bridge_state_t state, const char *reason)
+{
+    int64_t now = esp_timer_get_time();
+    
+    portENTER_CRITICAL(&s_state_mux);
+    bridge_state_t from = s_state.state;
+    if (from == state) {
+        portEXIT_CRITICAL(&s_state_mux);
+        return;
+    }
+    s_state.state = state;
+    s_state.since_us = now;
+    s_state.transitions++;
+    if (state == BRIDGE_STATE_RECOVERING) {
+        s_state.recoveries++;
+    }
+    bridge_state_change_t *change = &s_state.history[s_state.history_count++ % BRIDGE_STATE_HISTORY];
+    change->time_us = now;
+    change->from = from;
+    change->to = state;
+    change->reason = reason;
+    portEXIT_CRITICAL(&s_state_mux);
+    
+    // Set the new bit before clearing the old one: a waiter for either never misses the change
+    xEventGroupSetBits(s_state.events, BRIDGE_STATE_BIT(state));
+    xEventGroupClearBits(s_state.events, ALL_STATE_BITS & ~BRIDGE_STATE_BIT(state));
+    
+    ESP_LOGI(TAG, "%s -> %s (%s)", s_state_names[from], s_state_names[state], reason);
+    if (slcan_is_open() && host_link_present()) {
+        char line[64];
+        int len = snprintf(line, sizeof(line) - 1, "Ls %lld %s %s", (long long)clock_sync_to_host(now),
+                           s_state_names[state], reason);
+        if (len < 0) {
+            return;
+        }
+        // snprintf() returns the untruncated length
+        if (len > (int)sizeof(line) - 2) {
+            len = sizeof(line) - 2;
+        }
+        line[len++] = '\r';
+        host_link_write(line, len);
+    }
+}
+
+void bridge_state_channel(bool open, int64_t start_us)
+{
+    portENTER_CRITICAL(&s_state_mux);
+    uint32_t us = (uint32_t)(esp_timer_get_time() - start_us);
+    if (open) {
+        s_state.opens++;
+        s_state.open_us_last = us;
+        if (us > s_state.open_us_max) {
+            s_state.open_us_max = us;
+        }
+        if (s_state.policy == BRIDGE_CLOSE_FLUSH) {
+            s_state.forwarded = 0;
+            s_state.not_sent = 0;
+        }
+    } else {
+        s_state.close_us_last = us;
+        if (us > s_state.close_us_max) {
+            s_state.close_us_max = us;
+        }
+    }
+    portEXIT_CRITICAL(&s_state_mux);
+    
+    bridge_state_set(open ? BRIDGE_STATE_OPEN : BRIDGE_STATE_ARMED, "host");
+}
+
+bridge_state_t bridge_state_get(void)
+{
+    return s_state.state;
+}
+
+bool bridge_state_wait(uint32_t state_bits, TickType_t timeout)
+{
+    EventBits_t bits = xEventGroupWaitBits(s_state.events, state_bits, pdFALSE, pdFALSE, timeout);
+    return (bits & state_bits) != 0;
+}
+
+void bridge_state_count_frame(bool sent)
+{
+    portENTER_CRITICAL(&s_state_mux);
+    if (sent) {
+        s_state.forwarded++;
+    } else {
+        s_state.not_sent++;
+    }
+    portEXIT_CRITICAL(&s_state_mux);
+}
+
+bridge_close_policy_t bridge_state_get_policy(void)
+{
+    return s_state.policy;
+}
+
+void bridge_state_get_status(bridge_state_status_t *out)
+{
+    portENTER_CRITICAL(&s_state_mux);
+    out->state = s_state.state;
+    out->since_us = s_state.since_us;
+    out->transitions = s_state.transitions;
+    out->opens = s_state.opens;
+    out->recoveries = s_state.recoveries;
+    out->open_us_last = s_state.open_us_last;
+    out->open_us_max = s_state.open_us_max;
+    out->close_us_last = s_state.close_us_last;
+    out->close_us_max = s_state.close_us_max;
+    out->policy = s_state.policy;
+    out->forwarded = s_state.forwarded;
+    out->not_sent = s_state.not_sent;
+    portEXIT_CRITICAL(&s_state_mux);
+}
+
+bool bridge_state_get_change(uint32_t index, bridge_state_change_t *out)
+{
+    bool found = false;
+    portENTER_CRITICAL(&s_state_mux);
+    if (index < s_state.history_count && index < BRIDGE_STATE_HISTORY) {
+        *out = s_state.history[(s_state.history_count - 1 - index) % BRIDGE_STATE_HISTORY];
+        found = true;
+    }
+    portEXIT_CRITICAL(&s_state_mux);
+    return found;
+}
+
+/**
+ * @brief "state" command handler
+ */
+static int state_cmd_handler(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&state_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, state_args.end, argv[0]);
+        return 1;
+    }
+    
+    const char *action = state_args.action->count ? state_args.action->sval[0] : "show";
+    
+    if (strcmp(action, "policy") == 0) {
+        const char *policy = state_args.policy->count ? state_args.policy->sval[0] : "";
+        if (strcmp(policy, "flush") == 0) {
+            s_state.policy = BRIDGE_CLOSE_FLUSH;
+        } else if (strcmp(policy, "keep") == 0) {
+            s_state.policy = BRIDGE_CLOSE_KEEP;
+        } else {
+            printf("state policy: flush or keep\n");
+            return 1;
+        }
+    } else if (strcmp(action, "show") != 0) {
+        printf("state: unknown action '%s'\n", action);
+        return 1;
+    }
+    
+    bridge_state_status_t st;
+    bridge_state_get_status(&st);
+    int64_t now = esp_timer_get_time();
+    printf("state: %s for %lld ms, %lu transitions, %lu opens, %lu recoveries, open %lu/%lu us, "
+           "close %lu/%lu us (last/max), policy %s, %lu forwarded, %lu not sent\n",
+           bridge_state_name(st.state), (long long)((now - st.since_us) / 1000), (unsigned long)st.transitions,
+           (unsigned long)st.opens, (unsigned long)st.recoveries, (unsigned long)st.open_us_last,
+           (unsigned long)st.open_us_max, (unsigned long)st.close_us_last, (unsigned long)st.close_us_max,
+           st.policy == BRIDGE_CLOSE_KEEP ? "keep" : "flush", (unsigned long)st.forwarded,
+           (unsigned long)st.not_sent);
+    bridge_state_change_t change;
+    for (uint32_t i = 0; bridge_state_get_change(i, &change); i++) {
+        printf("  -%lld ms: %s -> %s (%s)\n", (long long)((now - change.time_us) / 1000),
+               bridge_state_name(change.from), bridge_state_name(change.to), change.reason);
+    }
+    
+    host_link_status_t link;
+    host_hold_status_t hold;
+    host_link_get_status(&link);
+    host_hold_get_status(&hold);
+    printf("host: %s for %lld ms, %lu absences, %lu stalled writes; held %lu/%lu, %lu sent, %lu lost\n",
+           link.present ? "present" : "absent", (long long)((now - link.since_us) / 1000),
+           (unsigned long)link.absences, (unsigned long)link.stalls, (unsigned long)hold.count,
+           (unsigned long)hold.capacity, (unsigned long)hold.flushed, (unsigned long)hold.lost);
+    return 0;
+}
+
+void bridge_state_register_commands(void)
+{
+    state_args.action = arg_str0(NULL, NULL, "<show|policy>", "Action (default: show)");
+    state_args.policy = arg_str0(NULL, NULL, "<flush|keep>", "policy: frames received while the channel is closed");
+    state_args.end = arg_end(3);
+    
+    const esp_console_cmd_t state_cmd = {
+        .command = "state",
+        .help = "Bridge lifecycle state, open/close times and the latest transitions\n"
+        "  state policy keep    # hold frames received while closed until the next open",
+        .hint = NULL,
+        .func = &state_cmd_handler,
+        .argtable = &state_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&state_cmd));
+}
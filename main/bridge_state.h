@@ -0,0 +1,173 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Bridge lifecycle state machine
+ *
+ *   IDLE -> DETECTING -> ARMED <-> OPEN
+ *              ^           |        |
+ *              |           v        v
+ *              +------ RECOVERING <-+
+ *
+ * DETECTING runs the bitrate detection and brings the controller up; a
+ * failure goes to RECOVERING and detection is retried. ARMED receives with
+ * the SLCAN channel closed, OPEN forwards to the host. A bus-off goes to
+ * RECOVERING and back to ARMED or OPEN once the controller is error-active
+ * again. The current state is mirrored in an event group (one bit per
+ * state), so tasks block on the states they run in instead of polling.
+ *
+ * Every transition is logged, kept in a short history and, while the
+ * channel is open, sent to the host as a record:
+ *
+ *   Ls <time_us> <state> <reason>
+ *
+ * The close policy decides what frames received while the channel is
+ * closed become: with flush they are dropped as they arrive and the session
+ * counters restart at every open; with keep they wait in the transport ring
+ * (up to its depth) and are sent right after the next open, and the
+ * counters run on across sessions.
+ */
+
+/** @brief Transitions kept in the history */
+#define BRIDGE_STATE_HISTORY        8
+
+/**
+ * @brief Lifecycle states
+ */
+typedef enum {
+    BRIDGE_STATE_IDLE = 0,          /**< Not started */
+    BRIDGE_STATE_DETECTING,         /**< Bitrate detection and controller start */
+    BRIDGE_STATE_ARMED,             /**< Receiving, channel closed */
+    BRIDGE_STATE_OPEN,              /**< Forwarding to the host */
+    BRIDGE_STATE_RECOVERING,        /**< Start failed or bus-off, retrying */
+    BRIDGE_STATE_COUNT,
+} bridge_state_t;
+
+/** @brief Event group bit of a state */
+#define BRIDGE_STATE_BIT(state)     (1u << (state))
+
+/** @brief States in which the controller receives */
+#define BRIDGE_STATE_RUNNING_BITS   (BRIDGE_STATE_BIT(BRIDGE_STATE_ARMED) | BRIDGE_STATE_BIT(BRIDGE_STATE_OPEN))
+
+/**
+ * @brief What happens to frames received while the channel is closed
+ */
+typedef enum {
+    BRIDGE_CLOSE_FLUSH = 0,         /**< Dropped; counters restart at each open */
+    BRIDGE_CLOSE_KEEP,              /**< Held in the transport ring; counters preserved */
+} bridge_close_policy_t;
+
+/**
+ * @brief One transition
+ */
+typedef struct {
+    int64_t time_us;
+    bridge_state_t from;
+    bridge_state_t to;
+    const char *reason;             /**< String literal */
+} bridge_state_change_t;
+
+/**
+ * @brief Lifecycle status
+ */
+typedef struct {
+    bridge_state_t state;
+    int64_t since_us;               /**< Time of the last transition */
+    uint32_t transitions;
+    uint32_t opens;
+    uint32_t recoveries;            /**< Entries into RECOVERING */
+    uint32_t open_us_last;          /**< Duration of the last channel open */
+    uint32_t open_us_max;
+    uint32_t close_us_last;         /**< Duration of the last channel close */
+    uint32_t close_us_max;
+    bridge_close_policy_t policy;
+    uint32_t forwarded;             /**< Frames sent to the host (session) */
+    uint32_t not_sent;              /**< Frames dropped with the channel closed (session) */
+} bridge_state_status_t;
+
+/**
+ * @brief Create the event group; the state is IDLE
+ */
+esp_err_t bridge_state_init(void);
+
+/**
+ * @brief Change state
+ *
+ * @param state New state
+ * @param reason Why (string literal), logged and reported
+ */
+void bridge_state_set(bridge_state_t state, const char *reason);
+
+/**
+ * @brief Channel open/close done: OPEN or ARMED, with the time it took and the close policy applied
+ *
+ * @param open Channel opened
+ * @param start_us esp_timer_get_time() when the command was received
+ */
+void bridge_state_channel(bool open, int64_t start_us);
+
+/**
+ * @brief Current state
+ */
+bridge_state_t bridge_state_get(void);
+
+/**
+ * @brief Block until the state is one of a set
+ *
+ * @param state_bits BRIDGE_STATE_BIT() of the states to wait for
+ * @return true if in one of the states, false on timeout
+ */
+bool bridge_state_wait(uint32_t state_bits, TickType_t timeout);
+
+/**
+ * @brief Account for a frame handled by the transport
+ *
+ * @param sent Written to the host (otherwise dropped, channel closed)
+ */
+void bridge_state_count_frame(bool sent);
+
+/**
+ * @brief Get the close policy
+ */
+bridge_close_policy_t bridge_state_get_policy(void);
+
+/**
+ * @brief Get the lifecycle status
+ */
+void bridge_state_get_status(bridge_state_status_t *out);
+
+/**
+ * @brief Get a past transition
+ *
+ * @param index 0 for the latest
+ * @return false if there is no such transition
+ */
+bool bridge_state_get_change(uint32_t index, bridge_state_change_t *out);
+
+/**
+ * @brief Short name of a state ("idle", "detecting", ...)
+ */
+const char *bridge_state_name(bridge_state_t state);
+
+/**
+ * @brief Register the 'state' extension command
+ */
+void bridge_state_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
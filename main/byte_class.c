@@ -0,0 +1,324 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "byte_class.h"
+
+// Polynomials of the CRC-8 candidates, in byte_class_csum_t order after SUM
+static const uint8_t crc8_poly[2] = {0x1D, 0x2F};
+static uint8_t crc8_table[2][256];
+static bool crc8_ready = false;
+
+/**
+ * @brief Build the CRC-8 lookup tables
+ */
+static void crc8_init(void)
+{
+    for (int t = 0; t < 2; t++) {
+        for (int v = 0; v < 256; v++) {
+            uint8_t crc = (uint8_t)v;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ crc8_poly[t]) : (uint8_t)(crc << 1);
+            }
+            crc8_table[t][v] = crc;
+        }
+    }
+    crc8_ready = true;
+}
+
+/**
+ * @brief True if at least 15/16 of the samples agree
+ */
+static bool mostly(uint16_t hits, uint16_t samples)
+{
+    return (uint32_t)hits * 16 >= (uint32_t)samples * 15;
+}
+
+/**
+ * @brief Update a counter candidate with the masked previous and current value
+ */
+static void counter_update(byte_class_counter_t *ctr, uint8_t prev, uint8_t cur, uint8_t mask, bool first)
+{
+    uint8_t d = (uint8_t)(cur - prev) & mask;
+    
+    if (first) {
+        ctr->lo = prev < cur ? prev : cur;
+        ctr->hi = prev > cur ? prev : cur;
+    } else {
+        if (cur < ctr->lo) ctr->lo = cur;
+        if (cur > ctr->hi) ctr->hi = cur;
+    }
+    
+    if (ctr->step == 0) {
+        // First change defines the step; counters only ever move forward a little
+        if (d != 0 && d <= mask / 4) {
+            ctr->step = d;
+            ctr->hits++;
+        }
+    } else if (d == ctr->step) {
+        ctr->hits++;
+    } else if (cur < prev && cur == ctr->lo) {
+        // Wrap of a counter whose period is not a power of two
+        ctr->hits++;
+    }
+}
+
+/**
+ * @brief Halve all counts before the sample counter overflows
+ */
+static void byte_class_decay(byte_class_state_t *st)
+{
+    st->samples >>= 1;
+    for (int i = 0; i < BYTE_CLASS_MAX_LEN; i++) {
+        byte_class_byte_t *b = &st->byte[i];
+        b->changes >>= 1;
+        b->smooth >>= 1;
+        b->counter[0].hits >>= 1;
+        b->counter[1].hits >>= 1;
+        for (int k = 0; k < BYTE_CLASS_CSUM_COUNT; k++) {
+            b->csum_hits[k] >>= 1;
+        }
+    }
+}
+
+void byte_class_reset(byte_class_state_t *st)
+{
+    memset(st, 0, sizeof(*st));
+}
+
+/**
+ * @brief Start over with a new payload length
+ */
+static void byte_class_start(byte_class_state_t *st, const uint8_t *data, uint8_t len)
+{
+    uint16_t restarts = st->restarts + (st->started ? 1 : 0);
+    
+    memset(st, 0, sizeof(*st));
+    st->started = true;
+    st->restarts = restarts;
+    st->len = len;
+    memcpy(st->prev, data, len);
+    for (uint8_t i = 0; i < len; i++) {
+        byte_class_byte_t *b = &st->byte[i];
+        b->first = b->lo = b->hi = data[i];
+        b->values[0] = data[i];
+        b->n_values = 1;
+    }
+}
+
+void byte_class_update(byte_class_state_t *st, const uint8_t *data, uint8_t len)
+{
+    if (len > BYTE_CLASS_MAX_LEN) {
+        len = BYTE_CLASS_MAX_LEN;
+    }
+    if (!st->started || len != st->len) {
+        byte_class_start(st, data, len);
+        return;
+    }
+    if (!crc8_ready) {
+        crc8_init();
+    }
+    if (st->samples == UINT16_MAX) {
+        byte_class_decay(st);
+    }
+    bool first = (st->samples == 0);
+    st->samples++;
+    
+    // Whole-payload terms; the "other bytes" terms are derived per byte
+    uint8_t xor_all = 0;
+    uint8_t sum_all = 0;
+    uint8_t crc_prefix[2][BYTE_CLASS_MAX_LEN + 1] = {{0}};
+    for (uint8_t i = 0; i < len; i++) {
+        xor_all ^= data[i];
+        sum_all += data[i];
+        for (int t = 0; t < 2; t++) {
+            crc_prefix[t][i + 1] = crc8_table[t][crc_prefix[t][i] ^ data[i]];
+        }
+    }
+    
+    for (uint8_t i = 0; i < len; i++) {
+        byte_class_byte_t *b = &st->byte[i];
+        uint8_t cur = data[i];
+        uint8_t prev = st->prev[i];
+        
+        if (cur != prev) {
+            b->changes++;
+        }
+        int delta = (int)cur - (int)prev;
+        if (delta >= -16 && delta <= 16) {
+            b->smooth++;
+        }
+        if (cur < b->lo) b->lo = cur;
+        if (cur > b->hi) b->hi = cur;
+        
+        if (b->n_values <= BYTE_CLASS_MAX_VALUES) {
+            bool known = false;
+            for (uint8_t v = 0; v < b->n_values; v++) {
+                if (b->values[v] == cur) {
+                    known = true;
+                    break;
+                }
+            }
+            if (!known) {
+                if (b->n_values < BYTE_CLASS_MAX_VALUES) {
+                    b->values[b->n_values] = cur;
+                }
+                b->n_values++;
+            }
+        }
+        
+        counter_update(&b->counter[0], prev, cur, 0xFF, first);
+        counter_update(&b->counter[1], prev & 0x0F, cur & 0x0F, 0x0F, first);
+        
+        // byte ^ f(others) (byte - sum for SUM) is constant if byte is that checksum
+        uint8_t k[BYTE_CLASS_CSUM_COUNT];
+        k[BYTE_CLASS_CSUM_XOR] = cur ^ (uint8_t)(xor_all ^ cur);
+        k[BYTE_CLASS_CSUM_SUM] = (uint8_t)(cur - (uint8_t)(sum_all - cur));
+        for (int t = 0; t < 2; t++) {
+            uint8_t crc = crc_prefix[t][i];
+            for (uint8_t j = i + 1; j < len; j++) {
+                crc = crc8_table[t][crc ^ data[j]];
+            }
+            k[BYTE_CLASS_CSUM_CRC8_1D + t] = cur ^ crc;
+        }
+        for (int c = 0; c < BYTE_CLASS_CSUM_COUNT; c++) {
+            if (k[c] == b->csum_k[c]) {
+                b->csum_hits[c]++;
+            } else {
+                b->csum_k[c] = k[c];
+            }
+        }
+    }
+    
+    memcpy(st->prev, data, len);
+}
+
+/**
+ * @brief Best matching checksum kind of a byte, or -1
+ */
+static int checksum_kind(const byte_class_state_t *st, uint8_t index)
+{
+    const byte_class_byte_t *b = &st->byte[index];
+    if (b->changes < BYTE_CLASS_MIN_CSUM_CHANGES) {
+        return -1;
+    }
+    
+    int best = -1;
+    for (int c = 0; c < BYTE_CLASS_CSUM_COUNT; c++) {
+        if (mostly(b->csum_hits[c], st->samples) && (best < 0 || b->csum_hits[c] > b->csum_hits[best])) {
+            best = c;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Counter verdict of a byte, or NULL
+ */
+static const byte_class_counter_t *counter_kind(const byte_class_state_t *st, uint8_t index, uint8_t *mask)
+{
+    const byte_class_byte_t *b = &st->byte[index];
+    for (int n = 0; n < 2; n++) {
+        const byte_class_counter_t *ctr = &b->counter[n];
+        // At least three values, so a toggling flag is not taken for a counter
+        if (ctr->step != 0 && ctr->hi - ctr->lo >= 2 * ctr->step && mostly(ctr->hits, st->samples)) {
+            *mask = n == 0 ? 0xFF : 0x0F;
+            return ctr;
+        }
+    }
+    return NULL;
+}
+
+void byte_class_classify(const byte_class_state_t *st, uint8_t index, byte_class_result_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (index >= st->len) {
+        return;
+    }
+    
+    const byte_class_byte_t *b = &st->byte[index];
+    out->lo = b->lo;
+    out->hi = b->hi;
+    if (st->samples < BYTE_CLASS_MIN_SAMPLES) {
+        out->cls = BYTE_CLASS_UNKNOWN;
+        return;
+    }
+    
+    if (b->changes == 0) {
+        out->cls = BYTE_CLASS_CONSTANT;
+        out->value = b->first;
+        out->confidence = 100;
+        return;
+    }
+    
+    uint8_t mask;
+    const byte_class_counter_t *ctr = counter_kind(st, index, &mask);
+    if (ctr != NULL) {
+        out->cls = BYTE_CLASS_COUNTER;
+        out->mask = mask;
+        out->step = ctr->step;
+        out->period = (ctr->hi - ctr->lo) / ctr->step + 1;
+        out->lo = ctr->lo;
+        out->hi = ctr->hi;
+        out->confidence = (uint8_t)((uint32_t)ctr->hits * 100 / st->samples);
+        return;
+    }
+    
+    int csum = checksum_kind(st, index);
+    if (csum == BYTE_CLASS_CSUM_XOR) {
+        // A constant XOR over the whole payload fits every changing byte;
+        // attribute it to the last such byte that is not a counter
+        for (uint8_t j = index + 1; j < st->len; j++) {
+            uint8_t m;
+            if (checksum_kind(st, j) == BYTE_CLASS_CSUM_XOR && counter_kind(st, j, &m) == NULL) {
+                csum = -1;
+                break;
+            }
+        }
+    }
+    if (csum >= 0) {
+        out->cls = BYTE_CLASS_CHECKSUM;
+        out->csum = (uint8_t)csum;
+        out->value = b->csum_k[csum];
+        out->confidence = (uint8_t)((uint32_t)b->csum_hits[csum] * 100 / st->samples);
+        return;
+    }
+    
+    if (b->n_values <= BYTE_CLASS_MAX_VALUES) {
+        out->cls = BYTE_CLASS_ENUM;
+        out->n_values = b->n_values;
+        out->confidence = 100;
+        return;
+    }
+    
+    out->confidence = (uint8_t)((uint32_t)b->smooth * 100 / st->samples);
+    out->cls = (b->smooth * 10 >= (uint32_t)st->samples * 9) ? BYTE_CLASS_CONTINUOUS : BYTE_CLASS_RANDOM;
+}
+
+const char *byte_class_name(byte_class_t cls)
+{
+    switch (cls) {
+    case BYTE_CLASS_CONSTANT:   return "const";
+    case BYTE_CLASS_COUNTER:    return "counter";
+    case BYTE_CLASS_CHECKSUM:   return "checksum";
+    case BYTE_CLASS_ENUM:       return "enum";
+    case BYTE_CLASS_CONTINUOUS: return "continuous";
+    case BYTE_CLASS_RANDOM:     return "random";
+    default:                    return "unknown";
+    }
+}
+
+const char *byte_class_csum_name(byte_class_csum_t csum)
+{
+    switch (csum) {
+    case BYTE_CLASS_CSUM_XOR:       return "xor";
+    case BYTE_CLASS_CSUM_SUM:       return "sum";
+    case BYTE_CLASS_CSUM_CRC8_1D:   return "crc8-1d";
+    case BYTE_CLASS_CSUM_CRC8_2F:   return "crc8-2f";
+    default:                        return "?";
+    }
+}
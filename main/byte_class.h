@@ -0,0 +1,160 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Streaming classification of the payload bytes of one CAN ID
+ *
+ * Pure C (no ESP-IDF dependencies) so it can be built and tested on the host.
+ * Each frame updates a fixed set of counters per byte (O(1) per frame for a
+ * given payload length); byte_class_classify() turns them into a verdict:
+ * constant, rolling counter (full byte or low nibble, with step and period),
+ * checksum, enumeration, continuous value or random.
+ *
+ * Checksums are checked as affine relations over the other payload bytes:
+ * XOR, SUM (mod 256) and CRC-8 with polynomials 0x1D (SAE J1850) and 0x2F
+ * (AUTOSAR). A byte is a checksum of a kind if byte ^ f(others) (byte - sum
+ * for SUM) is the same constant in (nearly) every frame; this also covers an
+ * unknown CRC init value, final XOR or data ID, which all fold into that
+ * constant for a fixed payload length.
+ */
+
+/** @brief Maximum classified payload bytes */
+#define BYTE_CLASS_MAX_LEN          8
+
+/** @brief Distinct values tracked per byte; more makes a byte non-enumerated */
+#define BYTE_CLASS_MAX_VALUES       8
+
+/** @brief Frames needed before bytes are classified */
+#define BYTE_CLASS_MIN_SAMPLES      32
+
+/** @brief Changes of a byte needed before it can be classified as a checksum */
+#define BYTE_CLASS_MIN_CSUM_CHANGES 8
+
+/**
+ * @brief Byte classes
+ */
+typedef enum {
+    BYTE_CLASS_UNKNOWN = 0,     /**< Not enough frames yet */
+    BYTE_CLASS_CONSTANT,        /**< Never changed */
+    BYTE_CLASS_COUNTER,         /**< Rolling counter */
+    BYTE_CLASS_CHECKSUM,        /**< Checksum over the other bytes */
+    BYTE_CLASS_ENUM,            /**< Few distinct values */
+    BYTE_CLASS_CONTINUOUS,      /**< Many values, small steps */
+    BYTE_CLASS_RANDOM,          /**< Many values, large steps (e.g. low byte of a wider signal) */
+} byte_class_t;
+
+/**
+ * @brief Checksum kinds
+ */
+typedef enum {
+    BYTE_CLASS_CSUM_XOR = 0,    /**< XOR of the other bytes */
+    BYTE_CLASS_CSUM_SUM,        /**< Sum of the other bytes mod 256 */
+    BYTE_CLASS_CSUM_CRC8_1D,    /**< CRC-8, polynomial 0x1D (SAE J1850) */
+    BYTE_CLASS_CSUM_CRC8_2F,    /**< CRC-8, polynomial 0x2F (AUTOSAR) */
+    BYTE_CLASS_CSUM_COUNT,
+} byte_class_csum_t;
+
+/**
+ * @brief Counter candidate (full byte or low nibble)
+ */
+typedef struct {
+    uint8_t step;               /**< Increment between frames, 0 = not seen yet */
+    uint8_t lo;                 /**< Smallest value seen */
+    uint8_t hi;                 /**< Largest value seen */
+    uint16_t hits;              /**< Frames consistent with the counter */
+} byte_class_counter_t;
+
+/**
+ * @brief Per-byte statistics
+ */
+typedef struct {
+    uint8_t first;              /**< Value in the first frame */
+    uint8_t lo;                 /**< Smallest value seen */
+    uint8_t hi;                 /**< Largest value seen */
+    uint8_t n_values;           /**< Distinct values, BYTE_CLASS_MAX_VALUES + 1 = more */
+    uint8_t values[BYTE_CLASS_MAX_VALUES];
+    uint16_t changes;           /**< Frames in which the byte changed */
+    uint16_t smooth;            /**< Frames with a change of at most +-16 */
+    byte_class_counter_t counter[2];            /**< [0] full byte, [1] low nibble */
+    uint8_t csum_k[BYTE_CLASS_CSUM_COUNT];      /**< Current constant per checksum kind */
+    uint16_t csum_hits[BYTE_CLASS_CSUM_COUNT];  /**< Frames matching that constant */
+} byte_class_byte_t;
+
+/**
+ * @brief Classifier state of one ID
+ */
+typedef struct {
+    bool started;               /**< First frame seen */
+    uint16_t samples;           /**< Frames compared with their predecessor */
+    uint8_t len;                /**< Payload length; a change restarts classification */
+    uint8_t prev[BYTE_CLASS_MAX_LEN];
+    uint16_t restarts;          /**< Restarts caused by payload length changes */
+    byte_class_byte_t byte[BYTE_CLASS_MAX_LEN];
+} byte_class_state_t;
+
+/**
+ * @brief Classification result of one byte
+ */
+typedef struct {
+    byte_class_t cls;           /**< Class */
+    uint8_t value;              /**< CONSTANT: the value; CHECKSUM: the constant */
+    uint8_t mask;               /**< COUNTER: 0xFF full byte, 0x0F low nibble */
+    uint8_t step;               /**< COUNTER: increment per frame */
+    uint16_t period;            /**< COUNTER: frames per wrap */
+    uint8_t csum;               /**< CHECKSUM: byte_class_csum_t */
+    uint8_t n_values;           /**< ENUM: number of distinct values */
+    uint8_t lo;                 /**< Smallest value seen */
+    uint8_t hi;                 /**< Largest value seen */
+    uint8_t confidence;         /**< Percent of frames consistent with the class */
+} byte_class_result_t;
+
+/**
+ * @brief Clear the state
+ *
+ * @param st State
+ */
+void byte_class_reset(byte_class_state_t *st);
+
+/**
+ * @brief Feed one payload
+ *
+ * @param st State
+ * @param data Payload
+ * @param len Payload length (bytes beyond BYTE_CLASS_MAX_LEN are ignored)
+ */
+void byte_class_update(byte_class_state_t *st, const uint8_t *data, uint8_t len);
+
+/**
+ * @brief Classify one byte from the collected statistics
+ *
+ * @param st State
+ * @param index Byte index
+ * @param out Output result
+ */
+void byte_class_classify(const byte_class_state_t *st, uint8_t index, byte_class_result_t *out);
+
+/**
+ * @brief Short name of a class
+ */
+const char *byte_class_name(byte_class_t cls);
+
+/**
+ * @brief Short name of a checksum kind
+ */
+const char *byte_class_csum_name(byte_class_csum_t csum);
+
+#ifdef __cplusplus
+}
+#endif
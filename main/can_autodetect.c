@@ -9,6 +9,9 @@
 #include "esp_twai.h"
 #include "esp_twai_onchip.h"
 #include "esp_timer.h"
+#include "esp_clk_tree.h"
+#include "soc/clk_tree_defs.h"
+#include "soc/soc_caps.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
@@ -26,6 +29,18 @@ static const uint32_t bitrate_list[] = {
 
 #define BITRATE_COUNT (sizeof(bitrate_list) / sizeof(bitrate_list[0]))
 
+// SJA1000-compatible timing register ranges (even prescalers are valid on all targets)
+static const bit_timing_limits_t twai_timing_limits = {
+    .brp_min = SOC_TWAI_BRP_MIN,
+    .brp_max = SOC_TWAI_BRP_MAX,
+    .brp_step = 2,
+    .tseg1_min = 1,
+    .tseg1_max = 16,
+    .tseg2_min = 1,
+    .tseg2_max = 8,
+    .sjw_max = CAN_BRIDGE_SJW_MAX,
+};
+
 // Frame queue for detection
 static volatile bool frame_received = false;
 
@@ -155,10 +170,22 @@ esp_err_t can_autodetect_bitrate(int tx_gpio, int rx_gpio, uint32_t *detected_bi
     return ESP_ERR_TIMEOUT;
 }
 
-esp_err_t can_bridge_init(int tx_gpio, int rx_gpio, uint32_t bitrate, twai_node_handle_t *node_handle)
+esp_err_t can_autodetect_probe(int tx_gpio, int rx_gpio, uint32_t bitrate, uint32_t timeout_ms)
+{
+    return try_bitrate(tx_gpio, rx_gpio, bitrate, timeout_ms);
+}
+
+esp_err_t can_bridge_init(int tx_gpio, int rx_gpio, uint32_t bitrate, twai_node_handle_t *node_handle,
+                          bit_timing_t *timing)
 {
     ESP_LOGI(TAG, "Initializing CAN bridge at %lu bps", bitrate);
     
+    // Same register values as an 'S'/'s' request for this bitrate, so the host's request matches them
+    esp_err_t ret = can_bridge_calc_timing(bitrate, 0, 0, timing, NULL);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
     // Configure TWAI driver for normal operation
     twai_onchip_node_config_t node_config = {
         .io_cfg = {
@@ -173,12 +200,29 @@ esp_err_t can_bridge_init(int tx_gpio, int rx_gpio, uint32_t bitrate, twai_node_
         .tx_queue_depth = 10,  // Required: minimum 1, use 10 for bridge operation
     };
     
-    esp_err_t ret = twai_new_node_onchip(&node_config, node_handle);
+    ret = twai_new_node_onchip(&node_config, node_handle);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to create CAN node: %s", esp_err_to_name(ret));
         return ret;
     }
     
+    // The node is not enabled yet, so the timing can be replaced directly
+    twai_timing_advanced_config_t timing_config = {
+        .brp = timing->brp,
+        .prop_seg = 0,
+        .tseg_1 = timing->tseg1,
+        .tseg_2 = timing->tseg2,
+        .sjw = timing->sjw,
+        .triple_sampling = timing->triple_sampling,
+    };
+    ret = twai_node_reconfig_timing(*node_handle, &timing_config, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to apply bit timing: %s", esp_err_to_name(ret));
+        twai_node_delete(*node_handle);
+        *node_handle = NULL;
+        return ret;
+    }
+    
     ESP_LOGI(TAG, "CAN bridge initialized successfully");
     return ESP_OK;
 }
@@ -198,3 +242,55 @@ esp_err_t can_bridge_deinit(twai_node_handle_t node_handle)
     ESP_LOGI(TAG, "CAN bridge deinitialized");
     return ESP_OK;
 }
+
+uint32_t can_bridge_get_clock_hz(void)
+{
+    uint32_t clk_hz = 0;
+    esp_clk_tree_src_get_freq_hz((soc_module_clk_t)TWAI_CLK_SRC_DEFAULT,
+                                 ESP_CLK_TREE_SRC_FREQ_PRECISION_CACHED, &clk_hz);
+    return clk_hz;
+}
+
+esp_err_t can_bridge_calc_timing(uint32_t bitrate, uint16_t sp_permill, uint8_t sjw,
+                                 bit_timing_t *timing, int32_t *err_ppm)
+{
+    uint32_t clk_hz = can_bridge_get_clock_hz();
+    
+    if (bit_timing_calc(clk_hz, bitrate, sp_permill, sjw, &twai_timing_limits, timing, err_ppm) != 0) {
+        ESP_LOGW(TAG, "No bit timing within %d ppm for %lu bps at %lu Hz",
+                 BIT_TIMING_MAX_ERROR_PPM, bitrate, clk_hz);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return ESP_OK;
+}
+
+esp_err_t can_bridge_set_timing(twai_node_handle_t node_handle, const bit_timing_t *timing)
+{
+    twai_timing_advanced_config_t timing_config = {
+        .brp = timing->brp,
+        .prop_seg = 0,
+        .tseg_1 = timing->tseg1,
+        .tseg_2 = timing->tseg2,
+        .sjw = timing->sjw,
+        .triple_sampling = timing->triple_sampling,
+    };
+    
+    esp_err_t ret = twai_node_disable(node_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to disable node for timing change: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    ret = twai_node_reconfig_timing(node_handle, &timing_config, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to apply bit timing: %s", esp_err_to_name(ret));
+    } else {
+        ESP_LOGI(TAG, "Bit timing: %lu bps, sample point %u/1000 (brp %lu, tseg1 %u, tseg2 %u, sjw %u)",
+                 bit_timing_bitrate(can_bridge_get_clock_hz(), timing), bit_timing_sample_point(timing),
+                 timing->brp, timing->tseg1, timing->tseg2, timing->sjw);
+    }
+    
+    // Re-enable even on failure so the previous timing keeps working
+    esp_err_t en_ret = twai_node_enable(node_handle);
+    return (ret != ESP_OK) ? ret : en_ret;
+}
@@ -8,11 +8,15 @@
 
 #include "esp_err.h"
 #include "esp_twai.h"
+#include "bit_timing.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/** @brief Largest synchronization jump width of the TWAI controller */
+#define CAN_BRIDGE_SJW_MAX 4
+
 /**
  * @brief CAN bitrate auto-detection
  */
@@ -39,6 +43,21 @@ extern "C" {
  */
 esp_err_t can_autodetect_bitrate(int tx_gpio, int rx_gpio, uint32_t *detected_bitrate, uint32_t timeout_per_rate_ms);
 
+/**
+ * @brief Check a known bitrate without touching the bus
+ *
+ * Listens at the bitrate in listen-only mode (no acknowledge, no error
+ * frames) until a valid frame arrives.
+ *
+ * @param tx_gpio TX GPIO pin number
+ * @param rx_gpio RX GPIO pin number
+ * @param bitrate Bitrate in bps
+ * @param timeout_ms Time to wait for a frame (ms)
+ *
+ * @return ESP_OK if a frame was received, ESP_ERR_TIMEOUT if not, error code otherwise
+ */
+esp_err_t can_autodetect_probe(int tx_gpio, int rx_gpio, uint32_t bitrate, uint32_t timeout_ms);
+
 /**
  * @brief Initialize CAN bridge
  * 
@@ -46,10 +65,12 @@ esp_err_t can_autodetect_bitrate(int tx_gpio, int rx_gpio, uint32_t *detected_bi
  * @param rx_gpio RX GPIO pin number
  * @param bitrate Bitrate in bps
  * @param node_handle Output: TWAI node handle
+ * @param timing Output: register values the node runs with (can_bridge_calc_timing() with the defaults)
  * 
  * @return ESP_OK on success, error code otherwise
  */
-esp_err_t can_bridge_init(int tx_gpio, int rx_gpio, uint32_t bitrate, twai_node_handle_t *node_handle);
+esp_err_t can_bridge_init(int tx_gpio, int rx_gpio, uint32_t bitrate, twai_node_handle_t *node_handle,
+                          bit_timing_t *timing);
 
 /**
  * @brief Deinitialize CAN bridge
@@ -60,6 +81,39 @@ esp_err_t can_bridge_init(int tx_gpio, int rx_gpio, uint32_t bitrate, twai_node_
  */
 esp_err_t can_bridge_deinit(twai_node_handle_t node_handle);
 
+/**
+ * @brief Calculate TWAI bit timing for the controller clock of this target
+ * 
+ * @param bitrate Requested bitrate in bps
+ * @param sp_permill Requested sample point in permille (0 = default 87.5%)
+ * @param sjw Requested synchronization jump width (0 = automatic)
+ * @param timing Output: register values
+ * @param err_ppm Output: achieved bitrate error in ppm (may be NULL)
+ * 
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if no timing is within 1% of the bitrate
+ */
+esp_err_t can_bridge_calc_timing(uint32_t bitrate, uint16_t sp_permill, uint8_t sjw,
+                                 bit_timing_t *timing, int32_t *err_ppm);
+
+/**
+ * @brief Get the TWAI controller clock
+ * 
+ * @return Clock frequency in Hz
+ */
+uint32_t can_bridge_get_clock_hz(void);
+
+/**
+ * @brief Apply bit timing to a running CAN bridge node
+ * 
+ * The node is disabled, reconfigured and enabled again.
+ * 
+ * @param node_handle TWAI node handle
+ * @param timing Register values from can_bridge_calc_timing()
+ * 
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t can_bridge_set_timing(twai_node_handle_t node_handle, const bit_timing_t *timing);
+
 #ifdef __cplusplus
 }
 #endif
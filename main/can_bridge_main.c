@@ -8,13 +8,42 @@
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
 #include "esp_err.h"
 #include "esp_log.h"
 #include "esp_twai.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
 #include "driver/gpio.h"
 #include "can_autodetect.h"
 #include "slcan_protocol.h"
+#include "bridge_cmd.h"
+#include "bridge_pm.h"
+#include "rx_bus.h"
+#include "clock_sync.h"
+#include "host_link.h"
+#include "host_hold.h"
+#include "flash_capture.h"
+#include "capture_export.h"
+#include "bridge_config.h"
+#include "boot_timeline.h"
+#include "id_profile.h"
+#include "can_tx.h"
+#include "auto_resp.h"
+#include "obd_sim.h"
+#include "ecu_scan.h"
+#include "isotp_send.h"
+#include "uds_flash.h"
+#include "fuzz.h"
+#include "bench.h"
+#include "scope.h"
+#include "bridge_state.h"
+#if CONFIG_CAN_BRIDGE_PROTOCOL_DYNAMIC
+#include "id_discovery.h"
+#include "delta_stream.h"
+#include "xcp_master.h"
+#include "canopen.h"
+#include "n2k.h"
+#endif
 
 static const char *TAG = "can_bridge";
 
@@ -30,16 +59,38 @@ static const char *TAG = "can_bridge";
 // Auto-detection timeout per bitrate attempt (ms)
 #define AUTODETECT_TIMEOUT_MS 2000
 
+// Depth of the transport subscriber ring (frames)
+#define TRANSPORT_RING_DEPTH 64
+
+// Delay before retrying a failed start (detection or controller)
+#define START_RETRY_MS 5000
+
+// Bus-off recovery: time allowed for the controller to become error-active again
+#define RECOVER_TIMEOUT_MS 1000
+
+// Fast start: listen-only check of the persisted bitrate, and the time after the start
+// in which a bus-off means that it does not fit the bus
+#define FAST_START_PROBE_MS 500
+#define FAST_START_CHECK_MS 5000
+
+// Lifecycle task notification bits (from the TWAI state callback)
+#define NOTIFY_BUS_OFF          (1u << 0)
+#define NOTIFY_ERROR_ACTIVE     (1u << 1)
+
+#if CONFIG_CAN_BRIDGE_FAST_START
+_Static_assert(CONFIG_CAN_BRIDGE_FAST_START_BACKLOG < CONFIG_CAN_BRIDGE_RX_POOL_SIZE,
+               "the early frame backlog must leave RX pool buffers for new frames");
+#endif
+
 // Bridge state
 static twai_node_handle_t g_node_handle = NULL;
-static QueueHandle_t g_rx_queue = NULL;
-static bool g_bridge_running = false;
-
-// Frame structure for queue
-typedef struct {
-    twai_frame_t frame;
-    uint8_t data_buffer[64];
-} queued_frame_t;
+static rx_bus_sub_handle_t g_transport_sub = NULL;
+static TaskHandle_t g_lifecycle_task = NULL;
+static bit_timing_t g_applied_timing = {0};
+#if CONFIG_CAN_BRIDGE_FAST_START
+static bool g_fast_started = false;
+static int64_t g_started_us = 0;
+#endif
 
 /**
  * @brief CAN RX callback - called from ISR when frame received
@@ -49,42 +100,175 @@ static IRAM_ATTR bool can_rx_callback(twai_node_handle_t handle,
                                        void *user_ctx)
 {
     (void)event_data;
+    (void)user_ctx;
     
-    QueueHandle_t rx_queue = (QueueHandle_t)user_ctx;
     BaseType_t higher_priority_task_woken = pdFALSE;
     
-    // Receive frame directly in ISR
-    queued_frame_t queued_frame = {0};
-    queued_frame.frame.buffer = queued_frame.data_buffer;
-    queued_frame.frame.buffer_len = sizeof(queued_frame.data_buffer);
+    // Receive frame directly into a pooled buffer shared by all subscribers
+    rx_bus_frame_t *rx_frame = rx_bus_alloc();
+    if (rx_frame == NULL) {
+        // Pool exhausted: still drain the controller (and answer it), the frame is lost
+        uint8_t scratch[RX_BUS_FRAME_DATA_LEN];
+        twai_frame_t frame = {
+            .buffer = scratch,
+            .buffer_len = sizeof(scratch),
+        };
+        if (twai_node_receive_from_isr(handle, &frame) == ESP_OK) {
+            auto_resp_on_rx_from_isr(&frame, esp_timer_get_time());
+        }
+        return false;
+    }
     
-    if (twai_node_receive_from_isr(handle, &queued_frame.frame) == ESP_OK) {
-        // Send frame to queue
-        xQueueSendFromISR(rx_queue, &queued_frame, &higher_priority_task_woken);
+    if (twai_node_receive_from_isr(handle, &rx_frame->frame) == ESP_OK) {
+        rx_frame->timestamp_us = esp_timer_get_time();
+        auto_resp_on_rx_from_isr(&rx_frame->frame, rx_frame->timestamp_us);
+        rx_frame->pm_state = bridge_pm_rx_from_isr();
+        rx_bus_publish(rx_frame, &higher_priority_task_woken);
+    } else {
+        rx_bus_discard(rx_frame);
     }
     
     return (higher_priority_task_woken == pdTRUE);
 }
 
 /**
- * @brief Task to handle CAN RX and forward to USB
+ * @brief TWAI error state callback - called from ISR, hands bus-off and recovery to the lifecycle task
+ */
+static IRAM_ATTR bool can_state_callback(twai_node_handle_t handle,
+                                          const twai_state_change_event_data_t *event_data,
+                                          void *user_ctx)
+{
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    if (event_data->new_sta == TWAI_ERROR_BUS_OFF) {
+        xTaskNotifyFromISR(g_lifecycle_task, NOTIFY_BUS_OFF, eSetBits, &higher_priority_task_woken);
+    } else if (event_data->new_sta == TWAI_ERROR_ACTIVE) {
+        xTaskNotifyFromISR(g_lifecycle_task, NOTIFY_ERROR_ACTIVE, eSetBits, &higher_priority_task_woken);
+    }
+    return (higher_priority_task_woken == pdTRUE);
+}
+
+/**
+ * @brief Forward a frame to PC via SLCAN and release it
+ *
+ * Protocol and transport are fixed at build time: with plain SLCAN this is
+ * a direct call of the encoder, without the per-frame decoder checks.
+ */
+static inline void forward_frame(const rx_bus_frame_t *rx_frame)
+{
+    esp_cpu_cycle_count_t start_cycles = esp_cpu_get_cycle_count();
+    
+#if CONFIG_CAN_BRIDGE_PROTOCOL_DYNAMIC
+    // Decoders selected at run time; self-benchmark frames pay for the checks as well
+    if (id_discovery_is_active() && !rx_frame->injected) {
+        // Discovery mode: only first-seen IDs and rate summaries reach the host
+        id_discovery_process(rx_frame);
+        rx_bus_release(rx_frame);
+        return;
+    }
+    if (xcp_master_owns_frame(&rx_frame->frame) || canopen_owns_frame(&rx_frame->frame) ||
+        n2k_owns_frame(&rx_frame->frame)) {
+        // XCP responses and DAQ packets, CANopen and NMEA 2000 traffic: the host gets records instead
+        rx_bus_release(rx_frame);
+        return;
+    }
+#endif
+    
+    if (rx_frame->injected) {
+        // Self-benchmark frame: plain forwarding, accounted for by the benchmark with its cost
+        esp_err_t ret = slcan_send_frame(&rx_frame->frame, clock_sync_to_host(rx_frame->timestamp_us));
+        bench_on_forwarded(rx_frame, ret, esp_cpu_get_cycle_count() - start_cycles);
+    } else if (slcan_is_open() && !host_link_present()) {
+        // Nobody reads the open channel: keep the frame unformatted until the host is back
+        if (!host_hold_push(&rx_frame->frame, rx_frame->timestamp_us)) {
+            bridge_state_count_frame(false);
+        }
+    } else {
+        // Logging disabled to avoid interfering with SavvyCAN
+        bridge_state_count_frame(slcan_send_frame(&rx_frame->frame, clock_sync_to_host(rx_frame->timestamp_us)) == ESP_OK);
+    }
+    rx_bus_release(rx_frame);
+}
+
+/**
+ * @brief Task to handle CAN RX and forward to USB (the RX bus "transport" subscriber)
  */
 static void can_rx_task(void *arg)
 {
-    queued_frame_t queued_frame;
+    bool first_frame = true;
+#if CONFIG_CAN_BRIDGE_FAST_START
+    // Frames received before the host first opens the channel (bus wake-up,
+    // network management) are held and sent right after the open
+    const rx_bus_frame_t *backlog[CONFIG_CAN_BRIDGE_FAST_START_BACKLOG + 1];
+    uint32_t backlog_count = 0;
+    bool backlog_active = true;
+#endif
     
+    // The transport subscription exists once the controller has been started
+    bridge_state_wait(BRIDGE_STATE_RUNNING_BITS, portMAX_DELAY);
     ESP_LOGI(TAG, "CAN RX task started");
     
-    while (g_bridge_running) {
-        // Wait for frame from queue
-        if (xQueueReceive(g_rx_queue, &queued_frame, pdMS_TO_TICKS(100)) == pdTRUE) {
-            // Forward to PC via SLCAN (logging disabled to avoid interfering with SavvyCAN)
-            slcan_send_frame(&queued_frame.frame);
+    while (true) {
+        if (bridge_state_get_policy() == BRIDGE_CLOSE_KEEP && !slcan_is_open()) {
+            // Frames wait in the transport ring until the host opens the channel
+            if (!bridge_state_wait(BRIDGE_STATE_BIT(BRIDGE_STATE_OPEN), pdMS_TO_TICKS(100))) {
+                bridge_pm_check_idle();
+            } else if (!slcan_is_open()) {
+                // Woken between the state change and the end of the open command
+                vTaskDelay(1);
+            }
+            continue;
+        }
+        
+        // Wait for frame from the RX bus
+        const rx_bus_frame_t *rx_frame = rx_bus_receive(g_transport_sub, pdMS_TO_TICKS(100));
+        
+#if CONFIG_CAN_BRIDGE_FAST_START
+        if (backlog_active && slcan_is_open()) {
+            for (uint32_t i = 0; i < backlog_count; i++) {
+                forward_frame(backlog[i]);
+            }
+            backlog_count = 0;
+            backlog_active = false;
+        }
+#endif
+        
+        // Host back: frames held in its absence go out before any newer one
+        if (host_hold_count() > 0 && slcan_is_open() && host_link_present()) {
+            uint32_t sent = host_hold_flush();
+            while (sent-- > 0) {
+                bridge_state_count_frame(true);
+            }
         }
+        
+        if (rx_frame == NULL) {
+            bridge_pm_check_idle();
+#if CONFIG_CAN_BRIDGE_PROTOCOL_DYNAMIC
+            id_discovery_poll();
+#endif
+            continue;
+        }
+        
+        if (first_frame) {
+            boot_timeline_mark_at("first_frame", rx_frame->timestamp_us);
+            first_frame = false;
+        }
+        bridge_pm_record_latency(rx_frame->pm_state,
+                                 (uint32_t)(esp_timer_get_time() - rx_frame->timestamp_us));
+        
+#if CONFIG_CAN_BRIDGE_FAST_START
+        if (backlog_active) {
+            if (backlog_count < CONFIG_CAN_BRIDGE_FAST_START_BACKLOG) {
+                backlog[backlog_count++] = rx_frame;
+            } else {
+                // Backlog full: dropped, as any frame while the channel is closed
+                rx_bus_release(rx_frame);
+            }
+            continue;
+        }
+#endif
+        
+        forward_frame(rx_frame);
     }
-    
-    ESP_LOGI(TAG, "CAN RX task stopped");
-    vTaskDelete(NULL);
 }
 
 /**
@@ -97,14 +281,23 @@ static void usb_rx_task(void *arg)
     
     ESP_LOGI(TAG, "USB RX task started");
     
-    while (g_bridge_running) {
+    while (true) {
         // Read from stdin (USB CDC)
         int c = fgetc(stdin);
         
         if (c == EOF || c < 0) {
-            vTaskDelay(pdMS_TO_TICKS(10));
+            // Non-blocking console: sleep until input arrives, so the first byte of a
+            // line (a clock sync beacon) is stamped when it arrives, not at the next poll
+            clearerr(stdin);
+            host_link_wait_rx(100);
             continue;
         }
+        host_link_on_rx();
+        
+        // Arrival time of the line, used by clock sync beacons
+        if (pos == 0) {
+            clock_sync_mark_line_start(esp_timer_get_time());
+        }
         
         // Check for command terminator
         if (c == '\r' || c == '\n') {
@@ -127,9 +320,54 @@ static void usb_rx_task(void *arg)
             }
         }
     }
+}
+
+/**
+ * @brief SLCAN channel open/close hook
+ */
+static esp_err_t on_channel_change(bool open)
+{
+    int64_t start_us = esp_timer_get_time();
     
-    ESP_LOGI(TAG, "USB RX task stopped");
-    vTaskDelete(NULL);
+    if (open) {
+        // Only a running, error-free controller can be opened
+        if (bridge_state_get() != BRIDGE_STATE_ARMED) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        
+        // Apply a bitrate requested with 'S'/'s' if it differs from the running one
+        bit_timing_t timing;
+        if (slcan_get_bit_timing(&timing) &&
+            (timing.brp != g_applied_timing.brp || timing.tseg1 != g_applied_timing.tseg1 ||
+             timing.tseg2 != g_applied_timing.tseg2 || timing.sjw != g_applied_timing.sjw ||
+             timing.triple_sampling != g_applied_timing.triple_sampling)) {
+            esp_err_t ret = can_bridge_set_timing(g_node_handle, &timing);
+            if (ret != ESP_OK) {
+                return ret;
+            }
+            g_applied_timing = timing;
+            bridge_config_set_bitrate(bit_timing_bitrate(can_bridge_get_clock_hz(), &timing));
+        }
+        boot_timeline_mark("host_open");
+        bridge_pm_channel_open();
+        bridge_state_channel(true, start_us);
+    } else {
+        bridge_pm_channel_close();
+        // A close during bus-off recovery is picked up when the controller is back
+        if (bridge_state_get() == BRIDGE_STATE_OPEN) {
+            bridge_state_channel(false, start_us);
+        }
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Delete the controller, reclaiming the TX slots queued to it first
+ */
+static void stop_can_bridge(void)
+{
+    can_tx_reset();
+    can_bridge_deinit(g_node_handle);
 }
 
 /**
@@ -147,12 +385,28 @@ static esp_err_t init_can_bridge(void)
     ESP_LOGI(TAG, "RX GPIO: %d", CONFIG_CAN_RX_GPIO);
     ESP_LOGI(TAG, "");
     
-    // Auto-detect bitrate
-    ESP_LOGI(TAG, "Starting CAN bitrate auto-detection...");
-    ESP_LOGI(TAG, "This may take several seconds...");
-    
-    ret = can_autodetect_bitrate(CONFIG_CAN_TX_GPIO, CONFIG_CAN_RX_GPIO, 
-                                  &detected_bitrate, AUTODETECT_TIMEOUT_MS);
+#if CONFIG_CAN_BRIDGE_FAST_START
+    // Fast start: run at the bitrate of the last session, no auto-detection. It is
+    // checked in listen-only mode first, so a stale bitrate (or another bus) never
+    // sees our acknowledges or error frames
+    g_fast_started = false;
+    if (bridge_config_get_bitrate(&detected_bitrate) &&
+        can_autodetect_probe(CONFIG_CAN_TX_GPIO, CONFIG_CAN_RX_GPIO, detected_bitrate,
+                             FAST_START_PROBE_MS) == ESP_OK) {
+        ESP_LOGI(TAG, "Using persisted bitrate: %lu bps", detected_bitrate);
+        g_fast_started = true;
+        ret = ESP_OK;
+    } else
+#endif
+    {
+        // Auto-detect bitrate
+        ESP_LOGI(TAG, "Starting CAN bitrate auto-detection...");
+        ESP_LOGI(TAG, "This may take several seconds...");
+        
+        ret = can_autodetect_bitrate(CONFIG_CAN_TX_GPIO, CONFIG_CAN_RX_GPIO, 
+                                      &detected_bitrate, AUTODETECT_TIMEOUT_MS);
+        boot_timeline_mark("autodetect");
+    }
     
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to auto-detect bitrate!");
@@ -167,32 +421,44 @@ static esp_err_t init_can_bridge(void)
     ESP_LOGI(TAG, "");
     ESP_LOGI(TAG, "✓ CAN bitrate detected: %lu bps", detected_bitrate);
     ESP_LOGI(TAG, "");
+    bridge_config_set_bitrate(detected_bitrate);
     
     // Initialize CAN bridge
     ret = can_bridge_init(CONFIG_CAN_TX_GPIO, CONFIG_CAN_RX_GPIO, 
-                          detected_bitrate, &g_node_handle);
+                          detected_bitrate, &g_node_handle, &g_applied_timing);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize CAN bridge");
         return ret;
     }
     
-    // Create RX queue for ISR communication (must hold full frame data)
-    g_rx_queue = xQueueCreate(50, sizeof(queued_frame_t));
-    if (g_rx_queue == NULL) {
-        ESP_LOGE(TAG, "Failed to create RX queue");
-        can_bridge_deinit(g_node_handle);
-        return ESP_ERR_NO_MEM;
+    // Subscribe the USB transport to the RX bus (kept across controller restarts)
+    if (g_transport_sub == NULL) {
+        ret = rx_bus_subscribe("transport", TRANSPORT_RING_DEPTH, &g_transport_sub);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to subscribe transport to RX bus");
+            stop_can_bridge();
+            return ret;
+        }
     }
     
-    // Register RX callback
+    // Transmit path (SLCAN t/T/r/R and time-triggered frames)
+    ret = can_tx_init(g_node_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize CAN TX");
+        stop_can_bridge();
+        return ret;
+    }
+    
+    // Register RX, TX done and error state callbacks
     twai_event_callbacks_t callbacks = {
         .on_rx_done = can_rx_callback,
+        .on_tx_done = can_tx_on_done,
+        .on_state_change = can_state_callback,
     };
-    ret = twai_node_register_event_callbacks(g_node_handle, &callbacks, g_rx_queue);
+    ret = twai_node_register_event_callbacks(g_node_handle, &callbacks, NULL);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to register callbacks");
-        vQueueDelete(g_rx_queue);
-        can_bridge_deinit(g_node_handle);
+        stop_can_bridge();
         return ret;
     }
     
@@ -200,11 +466,15 @@ static esp_err_t init_can_bridge(void)
     ret = twai_node_enable(g_node_handle);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to enable TWAI node");
-        vQueueDelete(g_rx_queue);
-        can_bridge_deinit(g_node_handle);
+        stop_can_bridge();
         return ret;
     }
     
+    boot_timeline_mark("twai_enabled");
+#if CONFIG_CAN_BRIDGE_FAST_START
+    g_started_us = esp_timer_get_time();
+#endif
+    
     ESP_LOGI(TAG, "✓ CAN bridge initialized successfully");
     ESP_LOGI(TAG, "✓ TWAI node enabled and ready to receive");
     ESP_LOGI(TAG, "");
@@ -216,27 +486,127 @@ static esp_err_t init_can_bridge(void)
     return ESP_OK;
 }
 
+/**
+ * @brief Detect the bitrate and start the controller, retrying a failed start
+ */
+static void start_bridge(const char *reason)
+{
+    bridge_state_set(BRIDGE_STATE_DETECTING, reason);
+    while (init_can_bridge() != ESP_OK) {
+        bridge_state_set(BRIDGE_STATE_RECOVERING, "start failed");
+        vTaskDelay(pdMS_TO_TICKS(START_RETRY_MS));
+        bridge_state_set(BRIDGE_STATE_DETECTING, "retry");
+    }
+    bridge_state_set(slcan_is_open() ? BRIDGE_STATE_OPEN : BRIDGE_STATE_ARMED, "started");
+}
+
+/**
+ * @brief Lifecycle task: starts the controller and recovers from bus-off
+ */
+static void lifecycle_task(void *arg)
+{
+    start_bridge("start");
+    
+    while (true) {
+        uint32_t events = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &events, portMAX_DELAY);
+        if (!(events & NOTIFY_BUS_OFF)) {
+            continue;
+        }
+        
+#if CONFIG_CAN_BRIDGE_FAST_START
+        if (g_fast_started && esp_timer_get_time() - g_started_us < FAST_START_CHECK_MS * 1000LL) {
+            // Bus-off right after a fast start: the persisted bitrate does not fit, detect it instead
+            ESP_LOGW(TAG, "Bus-off after fast start, falling back to auto-detection");
+            bridge_config_forget_bitrate();
+            stop_can_bridge();
+            start_bridge("fast start bus-off");
+            continue;
+        }
+#endif
+        
+        bridge_state_set(BRIDGE_STATE_RECOVERING, "bus-off");
+        do {
+            // Recovery completes after 128 occurrences of 11 recessive bits on the bus
+            twai_node_recover(g_node_handle);
+            events = 0;
+            xTaskNotifyWait(0, UINT32_MAX, &events, pdMS_TO_TICKS(RECOVER_TIMEOUT_MS));
+        } while (!(events & NOTIFY_ERROR_ACTIVE));
+        bridge_state_set(slcan_is_open() ? BRIDGE_STATE_OPEN : BRIDGE_STATE_ARMED, "recovered");
+    }
+}
+
 /**
  * @brief Main application entry point
  */
 void app_main(void)
 {
+    boot_timeline_mark("app_main");
+    
+    // Forwarding path first: RX is live before the host interface is up
+    // (and, with the USB console, usually before the host has enumerated us)
+    if (bridge_config_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Settings unavailable, bitrate will not be persisted");
+    }
+    ESP_ERROR_CHECK(bridge_pm_init());
+    ESP_ERROR_CHECK(bridge_state_init());
+    
+    // Shared RX frame pool for all consumers
+    ESP_ERROR_CHECK(rx_bus_init());
+    clock_sync_reset();
+    boot_timeline_mark("rx_bus");
+    
+    // Detection and controller start run in the lifecycle task, above this
+    // one, so RX still comes up first; the transport waits for it
+    xTaskCreate(lifecycle_task, "lifecycle", 4096, NULL, 10, &g_lifecycle_task);
+    xTaskCreate(can_rx_task, "can_rx", 4096, NULL, 10, NULL);
+    
+    // Raw host link (binary exports share the console with SLCAN)
+    ESP_ERROR_CHECK(host_link_init());
+    
     // Initialize SLCAN protocol
     slcan_init();
+    slcan_set_channel_callback(on_channel_change);
     
-    // Initialize CAN bridge with auto-detection
-    esp_err_t ret = init_can_bridge();
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "CAN bridge initialization failed, halting...");
-        return;
+    // Extension commands ('X' prefix)
+    ESP_ERROR_CHECK(bridge_cmd_init());
+    bridge_pm_register_commands();
+    bridge_state_register_commands();
+    rx_bus_register_commands();
+    clock_sync_register_commands();
+    boot_timeline_register_commands();
+    id_profile_register_commands();
+    can_tx_register_commands();
+    auto_resp_register_commands();
+    obd_sim_register_commands();
+#if CONFIG_CAN_BRIDGE_PROTOCOL_DYNAMIC
+    id_discovery_register_commands();
+    delta_stream_register_commands();
+#endif
+    ecu_scan_register_commands();
+    isotp_send_register_commands();
+    fuzz_register_commands();
+#if CONFIG_CAN_BRIDGE_PROTOCOL_DYNAMIC
+    xcp_master_register_commands();
+    canopen_register_commands();
+    n2k_register_commands();
+#endif
+    bench_register_commands();
+    scope_register_commands();
+    
+    // Flash capture recorder and bulk export (optional partition)
+    if (flash_capture_init() == ESP_OK) {
+        flash_capture_register_commands();
+        capture_export_register_commands();
     }
     
-    // Start bridge
-    g_bridge_running = true;
+    // UDS download of a staged image (optional partition)
+    if (uds_flash_init() == ESP_OK) {
+        uds_flash_register_commands();
+    }
     
-    // Create tasks
-    xTaskCreate(can_rx_task, "can_rx", 4096, NULL, 10, NULL);
     xTaskCreate(usb_rx_task, "usb_rx", 4096, NULL, 10, NULL);
+    boot_timeline_mark("host_ready");
     
     // Main loop - keep running (logging disabled to prevent SLCAN interference)
     while (1) {
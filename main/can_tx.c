@@ -0,0 +1,571 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/gptimer.h"
+#include "can_tx.h"
+#include "clock_sync.h"
+#include "slcan_protocol.h"
+
+static const char *TAG = "can_tx";
+
+_Static_assert(CONFIG_CAN_BRIDGE_TX_SCHED_DEPTH < CONFIG_CAN_BRIDGE_TX_POOL_SIZE,
+               "scheduled frames must leave TX slots for immediate frames");
+_Static_assert(CONFIG_CAN_BRIDGE_TX_POOL_SIZE <= 255, "TX slot indices are 8 bit");
+
+// The alarm fires this early; the ISR spins out the rest to release on time
+#define SCHED_LEAD_US       20
+
+// 1 MHz GPTimer: one tick per microsecond, like esp_timer
+#define SCHED_TIMER_HZ      1000000
+
+/**
+ * @brief One TX slot: the frame stays here until on_tx_done
+ */
+typedef struct {
+    twai_frame_t frame;
+    uint8_t data[TWAI_FRAME_MAX_LEN];
+    bool in_use;
+    bool scheduled;
+    can_tx_done_cb_t done_cb;
+    can_tx_sched_cb_t sched_cb;
+    void *done_arg;
+    uint32_t tag;
+    int64_t target_us;
+    int64_t release_us;
+} tx_slot_t;
+
+// Transmitter state
+static struct {
+    twai_node_handle_t node;
+    gptimer_handle_t timer;
+    tx_slot_t slots[CONFIG_CAN_BRIDGE_TX_POOL_SIZE];
+    
+    // Min-heap of scheduled slot indices ordered by target time
+    uint8_t heap[CONFIG_CAN_BRIDGE_TX_SCHED_DEPTH];
+    uint32_t heap_len;
+    uint32_t next_tag;
+    
+    can_tx_result_t results[CAN_TX_RESULT_COUNT];
+    uint32_t results_written;
+    
+    uint32_t sent;
+    uint32_t failed;
+    uint32_t no_slot;
+    uint32_t late;
+} s_tx;
+
+static portMUX_TYPE s_tx_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/** @brief Command line arguments for sched command */
+static struct {
+    struct arg_str *time;
+    struct arg_str *frame;
+    struct arg_lit *cancel;
+    struct arg_end *end;
+} sched_args;
+
+/**
+ * @brief Take a free slot and copy the frame into it (call with s_tx_mux held)
+ */
+static IRAM_ATTR tx_slot_t *tx_slot_alloc(const twai_frame_t *frame)
+{
+    for (uint32_t i = 0; i < CONFIG_CAN_BRIDGE_TX_POOL_SIZE; i++) {
+        tx_slot_t *slot = &s_tx.slots[i];
+        if (slot->in_use) {
+            continue;
+        }
+        size_t len = frame->header.rtr ? 0 : twaifd_dlc2len(frame->header.dlc);
+        slot->in_use = true;
+        slot->scheduled = false;
+        slot->done_cb = NULL;
+        slot->sched_cb = NULL;
+        slot->frame.header = frame->header;
+        memcpy(slot->data, frame->buffer, len);
+        slot->frame.buffer = slot->data;
+        slot->frame.buffer_len = len;
+        return slot;
+    }
+    s_tx.no_slot++;
+    return NULL;
+}
+
+/**
+ * @brief Record the outcome of a scheduled frame (call with s_tx_mux held)
+ */
+static IRAM_ATTR void tx_record_result(const tx_slot_t *slot, int64_t done_us, bool ok)
+{
+    can_tx_result_t *r = &s_tx.results[s_tx.results_written % CAN_TX_RESULT_COUNT];
+    r->tag = slot->tag;
+    r->id = slot->frame.header.id;
+    r->target_us = slot->target_us;
+    r->release_us = (int32_t)(slot->release_us - slot->target_us);
+    r->done_us = (int32_t)(done_us - slot->target_us);
+    r->ok = ok;
+    s_tx.results_written++;
+}
+
+/**
+ * @brief Hand a slot to the driver; frees it again if the driver refuses
+ */
+static IRAM_ATTR esp_err_t tx_slot_submit(tx_slot_t *slot)
+{
+    // The node is gone after can_tx_reset(): a frame released meanwhile fails here
+    twai_node_handle_t node = s_tx.node;
+    esp_err_t ret = node ? twai_node_transmit(node, &slot->frame, 0) : ESP_ERR_INVALID_STATE;
+    if (ret != ESP_OK) {
+        int64_t now = esp_timer_get_time();
+        portENTER_CRITICAL_SAFE(&s_tx_mux);
+        if (!slot->in_use) {
+            // Already reclaimed by can_tx_reset()
+            portEXIT_CRITICAL_SAFE(&s_tx_mux);
+            return ret;
+        }
+        can_tx_sched_cb_t sched_cb = slot->sched_cb;
+        void *done_arg = slot->done_arg;
+        s_tx.failed++;
+        if (slot->scheduled) {
+            tx_record_result(slot, now, false);
+        }
+        slot->in_use = false;
+        portEXIT_CRITICAL_SAFE(&s_tx_mux);
+        // A scheduled frame fails at its release time, so the owner learns it from the callback
+        if (sched_cb) {
+            sched_cb(done_arg, now, now, false);
+        }
+    }
+    return ret;
+}
+
+// --- Schedule heap (call with s_tx_mux held) ---
+
+static IRAM_ATTR int64_t heap_target(uint32_t pos)
+{
+    return s_tx.slots[s_tx.heap[pos]].target_us;
+}
+
+static IRAM_ATTR void heap_swap(uint32_t a, uint32_t b)
+{
+    uint8_t t = s_tx.heap[a];
+    s_tx.heap[a] = s_tx.heap[b];
+    s_tx.heap[b] = t;
+}
+
+static IRAM_ATTR void heap_push(uint8_t slot_index)
+{
+    uint32_t pos = s_tx.heap_len++;
+    s_tx.heap[pos] = slot_index;
+    while (pos > 0 && heap_target(pos) < heap_target((pos - 1) / 2)) {
+        heap_swap(pos, (pos - 1) / 2);
+        pos = (pos - 1) / 2;
+    }
+}
+
+static IRAM_ATTR uint8_t heap_pop(void)
+{
+    uint8_t top = s_tx.heap[0];
+    s_tx.heap[0] = s_tx.heap[--s_tx.heap_len];
+    uint32_t pos = 0;
+    for (;;) {
+        uint32_t l = 2 * pos + 1;
+        uint32_t r = l + 1;
+        uint32_t min = pos;
+        if (l < s_tx.heap_len && heap_target(l) < heap_target(min)) min = l;
+        if (r < s_tx.heap_len && heap_target(r) < heap_target(min)) min = r;
+        if (min == pos) {
+            break;
+        }
+        heap_swap(pos, min);
+        pos = min;
+    }
+    return top;
+}
+
+/**
+ * @brief Arm the alarm for the earliest scheduled frame (call with s_tx_mux held)
+ */
+static IRAM_ATTR void sched_arm(void)
+{
+    if (s_tx.heap_len == 0) {
+        return;
+    }
+    
+    uint64_t count = 0;
+    gptimer_get_raw_count(s_tx.timer, &count);
+    int64_t delay = heap_target(0) - SCHED_LEAD_US - esp_timer_get_time();
+    gptimer_alarm_config_t alarm = {
+        .alarm_count = count + (delay > 1 ? (uint64_t)delay : 1),
+    };
+    gptimer_set_alarm_action(s_tx.timer, &alarm);
+}
+
+/**
+ * @brief GPTimer alarm: release every frame whose target has come
+ */
+static IRAM_ATTR bool sched_alarm_cb(gptimer_handle_t timer, const gptimer_alarm_event_data_t *edata, void *user_ctx)
+{
+    for (;;) {
+        portENTER_CRITICAL_ISR(&s_tx_mux);
+        if (s_tx.heap_len == 0 || heap_target(0) - SCHED_LEAD_US > esp_timer_get_time()) {
+            sched_arm();
+            portEXIT_CRITICAL_ISR(&s_tx_mux);
+            break;
+        }
+        tx_slot_t *slot = &s_tx.slots[heap_pop()];
+        portEXIT_CRITICAL_ISR(&s_tx_mux);
+        
+        // Spin out the lead time so the frame is released at its target
+        int64_t now;
+        while ((now = esp_timer_get_time()) < slot->target_us) {
+        }
+        slot->release_us = now;
+        tx_slot_submit(slot);
+    }
+    return false;
+}
+
+IRAM_ATTR bool can_tx_on_done(twai_node_handle_t handle, const twai_tx_done_event_data_t *edata, void *user_ctx)
+{
+    const tx_slot_t *first = &s_tx.slots[0];
+    const tx_slot_t *slot = (const tx_slot_t *)edata->done_tx_frame;
+    if (slot < first || slot >= first + CONFIG_CAN_BRIDGE_TX_POOL_SIZE) {
+        return false;
+    }
+    
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL_ISR(&s_tx_mux);
+    if (!slot->in_use) {
+        // Reclaimed by can_tx_reset() while the node was being torn down
+        portEXIT_CRITICAL_ISR(&s_tx_mux);
+        return false;
+    }
+    can_tx_done_cb_t done_cb = slot->done_cb;
+    can_tx_sched_cb_t sched_cb = slot->sched_cb;
+    void *done_arg = slot->done_arg;
+    int64_t release_us = slot->release_us;
+    if (edata->is_tx_success) {
+        s_tx.sent++;
+    } else {
+        s_tx.failed++;
+    }
+    if (slot->scheduled) {
+        tx_record_result(slot, now, edata->is_tx_success);
+    }
+    s_tx.slots[slot - first].in_use = false;
+    portEXIT_CRITICAL_ISR(&s_tx_mux);
+    
+    if (done_cb) {
+        done_cb(done_arg, now, edata->is_tx_success);
+    } else if (sched_cb) {
+        sched_cb(done_arg, release_us, now, edata->is_tx_success);
+    }
+    return false;
+}
+
+esp_err_t can_tx_init(twai_node_handle_t node_handle)
+{
+    s_tx.node = node_handle;
+    if (s_tx.timer != NULL) {
+        // Controller restarted (can_tx_reset() emptied the slots): the schedule timer is still running
+        return ESP_OK;
+    }
+    
+    gptimer_config_t timer_config = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = SCHED_TIMER_HZ,
+    };
+    esp_err_t ret = gptimer_new_timer(&timer_config, &s_tx.timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create schedule timer: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    gptimer_event_callbacks_t cbs = {
+        .on_alarm = sched_alarm_cb,
+    };
+    ret = gptimer_register_event_callbacks(s_tx.timer, &cbs, NULL);
+    if (ret == ESP_OK) {
+        ret = gptimer_enable(s_tx.timer);
+    }
+    if (ret == ESP_OK) {
+        ret = gptimer_start(s_tx.timer);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start schedule timer: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+IRAM_ATTR esp_err_t can_tx_send_with_callback(const twai_frame_t *frame, can_tx_done_cb_t done_cb, void *arg)
+{
+    if (s_tx.node == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!frame->header.rtr && twaifd_dlc2len(frame->header.dlc) > TWAI_FRAME_MAX_LEN) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    
+    portENTER_CRITICAL_SAFE(&s_tx_mux);
+    tx_slot_t *slot = tx_slot_alloc(frame);
+    if (slot != NULL) {
+        slot->done_cb = done_cb;
+        slot->done_arg = arg;
+    }
+    portEXIT_CRITICAL_SAFE(&s_tx_mux);
+    if (slot == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    return tx_slot_submit(slot);
+}
+
+IRAM_ATTR esp_err_t can_tx_send(const twai_frame_t *frame)
+{
+    return can_tx_send_with_callback(frame, NULL, NULL);
+}
+
+IRAM_ATTR esp_err_t can_tx_schedule_with_callback(const twai_frame_t *frame, int64_t target_us,
+                                                  can_tx_sched_cb_t done_cb, void *arg, uint32_t *tag)
+{
+    if (s_tx.node == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!frame->header.rtr && twaifd_dlc2len(frame->header.dlc) > TWAI_FRAME_MAX_LEN) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    
+    portENTER_CRITICAL_SAFE(&s_tx_mux);
+    if (s_tx.heap_len == CONFIG_CAN_BRIDGE_TX_SCHED_DEPTH) {
+        portEXIT_CRITICAL_SAFE(&s_tx_mux);
+        return ESP_ERR_NO_MEM;
+    }
+    tx_slot_t *slot = tx_slot_alloc(frame);
+    if (slot == NULL) {
+        portEXIT_CRITICAL_SAFE(&s_tx_mux);
+        return ESP_ERR_NO_MEM;
+    }
+    slot->scheduled = true;
+    slot->sched_cb = done_cb;
+    slot->done_arg = arg;
+    slot->tag = s_tx.next_tag++;
+    slot->target_us = target_us;
+    if (tag) {
+        *tag = slot->tag;
+    }
+    
+    // Target 0: now, by request rather than late
+    int64_t now = esp_timer_get_time();
+    bool immediate = target_us <= now;
+    if (immediate) {
+        if (target_us != 0) {
+            s_tx.late++;
+        } else {
+            slot->target_us = now;
+        }
+    } else {
+        heap_push((uint8_t)(slot - s_tx.slots));
+        if (s_tx.heap[0] == slot - s_tx.slots) {
+            sched_arm();
+        }
+    }
+    portEXIT_CRITICAL_SAFE(&s_tx_mux);
+    
+    if (immediate) {
+        slot->release_us = esp_timer_get_time();
+        tx_slot_submit(slot);
+    }
+    return ESP_OK;
+}
+
+esp_err_t can_tx_schedule(const twai_frame_t *frame, int64_t target_us, uint32_t *tag)
+{
+    return can_tx_schedule_with_callback(frame, target_us, NULL, NULL, tag);
+}
+
+void can_tx_cancel_scheduled(void)
+{
+    while (true) {
+        // One frame per pass: its callback runs outside the lock
+        int64_t now = esp_timer_get_time();
+        portENTER_CRITICAL(&s_tx_mux);
+        if (s_tx.heap_len == 0) {
+            portEXIT_CRITICAL(&s_tx_mux);
+            return;
+        }
+        tx_slot_t *slot = &s_tx.slots[heap_pop()];
+        can_tx_sched_cb_t sched_cb = slot->sched_cb;
+        void *done_arg = slot->done_arg;
+        slot->release_us = now;
+        tx_record_result(slot, now, false);
+        slot->in_use = false;
+        portEXIT_CRITICAL(&s_tx_mux);
+        
+        // The owner of a cancelled frame learns it the same way as of a failed one
+        if (sched_cb) {
+            sched_cb(done_arg, now, now, false);
+        }
+    }
+}
+
+void can_tx_reset(void)
+{
+    portENTER_CRITICAL(&s_tx_mux);
+    s_tx.node = NULL;
+    portEXIT_CRITICAL(&s_tx_mux);
+    can_tx_cancel_scheduled();
+    
+    // Frames queued to the driver never complete once the node is deleted
+    for (uint32_t i = 0; i < CONFIG_CAN_BRIDGE_TX_POOL_SIZE; i++) {
+        tx_slot_t *slot = &s_tx.slots[i];
+        int64_t now = esp_timer_get_time();
+        portENTER_CRITICAL(&s_tx_mux);
+        if (!slot->in_use) {
+            portEXIT_CRITICAL(&s_tx_mux);
+            continue;
+        }
+        can_tx_done_cb_t done_cb = slot->done_cb;
+        can_tx_sched_cb_t sched_cb = slot->sched_cb;
+        void *done_arg = slot->done_arg;
+        int64_t release_us = slot->release_us;
+        s_tx.failed++;
+        if (slot->scheduled) {
+            tx_record_result(slot, now, false);
+        }
+        slot->in_use = false;
+        portEXIT_CRITICAL(&s_tx_mux);
+        
+        if (done_cb) {
+            done_cb(done_arg, now, false);
+        } else if (sched_cb) {
+            sched_cb(done_arg, release_us, now, false);
+        }
+    }
+}
+
+void can_tx_get_stats(can_tx_stats_t *out)
+{
+    portENTER_CRITICAL(&s_tx_mux);
+    out->sent = s_tx.sent;
+    out->failed = s_tx.failed;
+    out->no_slot = s_tx.no_slot;
+    out->pending = s_tx.heap_len;
+    out->late = s_tx.late;
+    portEXIT_CRITICAL(&s_tx_mux);
+}
+
+twai_node_handle_t can_tx_get_node(void)
+{
+    return s_tx.node;
+}
+
+/**
+ * @brief "sched" command handler
+ */
+static int sched_cmd_handler(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&sched_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, sched_args.end, argv[0]);
+        return 1;
+    }
+    
+    if (sched_args.cancel->count > 0) {
+        can_tx_cancel_scheduled();
+    }
+    
+    if (sched_args.time->count > 0) {
+        if (sched_args.frame->count == 0 || s_tx.node == NULL) {
+            printf("sched: need <time_us> <frame> and a running bridge\n");
+            return 1;
+        }
+        
+        // "+<us>" is relative to now, otherwise the RX timestamp timebase
+        const char *time = sched_args.time->sval[0];
+        const char *digits = (time[0] == '+') ? &time[1] : time;
+        char *end;
+        long long value = strtoll(digits, &end, 10);
+        if (end == digits || *end != '\0') {
+            printf("sched: invalid time '%s'\n", time);
+            return 1;
+        }
+        int64_t target_us;
+        if (time[0] == '+') {
+            target_us = esp_timer_get_time() + value;
+        } else {
+            target_us = clock_sync_to_device(value);
+        }
+        
+        uint8_t payload[TWAI_FRAME_MAX_LEN];
+        twai_frame_t frame = {
+            .buffer = payload,
+            .buffer_len = sizeof(payload),
+        };
+        const char *text = sched_args.frame->sval[0];
+        if (slcan_parse_frame(text, strlen(text), &frame) != ESP_OK) {
+            printf("sched: invalid frame '%s'\n", text);
+            return 1;
+        }
+        
+        uint32_t tag;
+        esp_err_t ret = can_tx_schedule(&frame, target_us, &tag);
+        if (ret != ESP_OK) {
+            printf("sched: %s\n", esp_err_to_name(ret));
+            return 1;
+        }
+        printf("sched %lu\n", (unsigned long)tag);
+        return 0;
+    }
+    
+    can_tx_stats_t st;
+    can_tx_get_stats(&st);
+    printf("sched: now %lld, pending %lu, late %lu, sent %lu, failed %lu, no slot %lu\n",
+           (long long)clock_sync_to_host(esp_timer_get_time()), (unsigned long)st.pending,
+           (unsigned long)st.late, (unsigned long)st.sent, (unsigned long)st.failed, (unsigned long)st.no_slot);
+    
+    // Results, oldest first
+    can_tx_result_t results[CAN_TX_RESULT_COUNT];
+    portENTER_CRITICAL(&s_tx_mux);
+    uint32_t written = s_tx.results_written;
+    memcpy(results, s_tx.results, sizeof(results));
+    portEXIT_CRITICAL(&s_tx_mux);
+    
+    uint32_t n = written < CAN_TX_RESULT_COUNT ? written : CAN_TX_RESULT_COUNT;
+    for (uint32_t i = written - n; i < written; i++) {
+        const can_tx_result_t *r = &results[i % CAN_TX_RESULT_COUNT];
+        printf("  %lu id %lX target %lld release %+ld us done %+ld us %s\n",
+               (unsigned long)r->tag, (unsigned long)r->id,
+               (long long)clock_sync_to_host(r->target_us), (long)r->release_us,
+               (long)r->done_us, r->ok ? "ok" : "failed");
+    }
+    return 0;
+}
+
+void can_tx_register_commands(void)
+{
+    sched_args.time = arg_str0(NULL, NULL, "<time_us>", "Target time (RX timestamp timebase, or +<us> from now)");
+    sched_args.frame = arg_str0(NULL, NULL, "<frame>", "Frame in SLCAN notation (t/T/r/R...)");
+    sched_args.cancel = arg_lit0("c", "cancel", "Drop all pending frames");
+    sched_args.end = arg_end(3);
+    
+    const esp_console_cmd_t sched_cmd = {
+        .command = "sched",
+        .help = "Time-triggered transmission\n"
+        "  sched <time_us> <frame>   # send frame at time, prints its tag\n"
+        "  sched                     # pending count and release/done error per frame\n"
+        "  sched -c                  # cancel pending frames",
+        .hint = NULL,
+        .func = &sched_cmd_handler,
+        .argtable = &sched_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&sched_cmd));
+}
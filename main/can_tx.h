@@ -0,0 +1,199 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_twai.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Frame transmission: immediate and time-triggered
+ *
+ * The TWAI driver keeps a pointer to each queued frame until it has been
+ * sent, so frames are copied into a fixed pool of TX slots which the
+ * on_tx_done callback returns.
+ *
+ * Time-triggered frames carry an absolute target time. They wait in a
+ * min-heap ordered by target and are handed to the controller from a
+ * GPTimer alarm ISR at the target, so USB jitter does not reach the bus.
+ * For every scheduled frame the release and completion times are recorded
+ * relative to the target ('Xsched').
+ */
+
+#ifndef CONFIG_CAN_BRIDGE_TX_POOL_SIZE
+#define CONFIG_CAN_BRIDGE_TX_POOL_SIZE 64
+#endif
+
+#ifndef CONFIG_CAN_BRIDGE_TX_SCHED_DEPTH
+#define CONFIG_CAN_BRIDGE_TX_SCHED_DEPTH 48
+#endif
+
+/** @brief Completed scheduled frames kept for reporting */
+#define CAN_TX_RESULT_COUNT     32
+
+/**
+ * @brief Outcome of one scheduled frame
+ */
+typedef struct {
+    uint32_t tag;           /**< Tag returned by can_tx_schedule() */
+    uint32_t id;            /**< CAN identifier */
+    int64_t target_us;      /**< Target time (device timebase) */
+    int32_t release_us;     /**< Handed to the controller, relative to target */
+    int32_t done_us;        /**< Transmission complete, relative to target */
+    bool ok;                /**< Transmitted successfully */
+} can_tx_result_t;
+
+/**
+ * @brief TX statistics
+ */
+typedef struct {
+    uint32_t sent;          /**< Frames transmitted successfully */
+    uint32_t failed;        /**< Frames the controller reported as failed */
+    uint32_t no_slot;       /**< Frames rejected because the TX pool was full */
+    uint32_t pending;       /**< Scheduled frames waiting for their target time */
+    uint32_t late;          /**< Scheduled frames whose target had already passed */
+} can_tx_stats_t;
+
+/**
+ * @brief Completion callback of a frame sent with can_tx_send_with_callback()
+ *
+ * Called from the on_tx_done ISR, or from the caller of can_tx_reset().
+ *
+ * @param arg User argument
+ * @param done_us esp_timer time of completion
+ * @param ok Transmitted successfully
+ */
+typedef void (*can_tx_done_cb_t)(void *arg, int64_t done_us, bool ok);
+
+/**
+ * @brief Completion callback of a frame sent with can_tx_schedule_with_callback()
+ *
+ * Called from the on_tx_done ISR, or from the caller of can_tx_cancel_scheduled() or can_tx_reset().
+ *
+ * @param arg User argument
+ * @param release_us esp_timer time the frame was handed to the controller
+ * @param done_us esp_timer time of completion
+ * @param ok Transmitted successfully
+ */
+typedef void (*can_tx_sched_cb_t)(void *arg, int64_t release_us, int64_t done_us, bool ok);
+
+/**
+ * @brief Initialize transmission for a node
+ *
+ * Register can_tx_on_done() as the node's on_tx_done callback.
+ *
+ * @param node_handle TWAI node handle
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t can_tx_init(twai_node_handle_t node_handle);
+
+/**
+ * @brief TWAI on_tx_done callback: releases the TX slot and records completion
+ */
+bool can_tx_on_done(twai_node_handle_t handle, const twai_tx_done_event_data_t *edata, void *user_ctx);
+
+/**
+ * @brief Queue a frame for immediate transmission
+ *
+ * The frame and its payload are copied.
+ *
+ * @note ISR-safe
+ *
+ * @param frame Frame to send (classic CAN, up to 8 data bytes)
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if no TX slot is free,
+ *         ESP_ERR_INVALID_SIZE for payloads over 8 bytes, ESP_ERR_INVALID_STATE before
+ *         the controller is started, driver error otherwise
+ */
+esp_err_t can_tx_send(const twai_frame_t *frame);
+
+/**
+ * @brief Queue a frame for immediate transmission and get notified on completion
+ *
+ * @note ISR-safe
+ *
+ * @param frame Frame to send (copied)
+ * @param done_cb Called from the on_tx_done ISR (may be NULL)
+ * @param arg Argument for done_cb
+ * @return As can_tx_send()
+ */
+esp_err_t can_tx_send_with_callback(const twai_frame_t *frame, can_tx_done_cb_t done_cb, void *arg);
+
+/**
+ * @brief Schedule a frame for transmission at an absolute device time
+ *
+ * A target in the past is sent immediately and counted as late.
+ *
+ * @param frame Frame to send (copied)
+ * @param target_us Target start of transmission, esp_timer timebase (us)
+ * @param tag Output: tag identifying the frame in the results (may be NULL)
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the schedule or the TX pool is full,
+ *         ESP_ERR_INVALID_STATE before the controller is started
+ */
+esp_err_t can_tx_schedule(const twai_frame_t *frame, int64_t target_us, uint32_t *tag);
+
+/**
+ * @brief Schedule a frame and get notified on completion
+ *
+ * A target of 0 sends the frame immediately without counting it as late,
+ * so a chain of frames can be started and continued from the callback.
+ *
+ * @note ISR-safe
+ *
+ * @param frame Frame to send (copied)
+ * @param target_us Target start of transmission, esp_timer timebase (us), or 0 for now
+ * @param done_cb Called from the on_tx_done ISR (may be NULL)
+ * @param arg Argument for done_cb
+ * @param tag Output: tag identifying the frame in the results (may be NULL)
+ * @return As can_tx_schedule()
+ */
+esp_err_t can_tx_schedule_with_callback(const twai_frame_t *frame, int64_t target_us,
+                                        can_tx_sched_cb_t done_cb, void *arg, uint32_t *tag);
+
+/**
+ * @brief Detach from the node before it is deleted
+ *
+ * Cancels the schedule (as can_tx_cancel_scheduled()) and reclaims the
+ * frames queued to the driver; their done callbacks are called with
+ * ok = false. Sends fail until the next can_tx_init().
+ */
+void can_tx_reset(void);
+
+/**
+ * @brief Drop all scheduled frames that have not been released yet
+ *
+ * Each dropped frame is recorded as failed and its done callback is called
+ * with ok = false, from the calling task.
+ */
+void can_tx_cancel_scheduled(void);
+
+/**
+ * @brief Get TX statistics
+ *
+ * @param out Output statistics
+ */
+void can_tx_get_stats(can_tx_stats_t *out);
+
+/**
+ * @brief Get the node used for transmission (for error counters and state)
+ *
+ * @return Node handle, NULL before can_tx_init()
+ */
+twai_node_handle_t can_tx_get_node(void);
+
+/**
+ * @brief Register the 'sched' extension command
+ */
+void can_tx_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,909 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "canopen.h"
+#include "can_tx.h"
+#include "rx_bus.h"
+#include "clock_sync.h"
+#include "host_link.h"
+#include "slcan_protocol.h"
+
+static const char *TAG = "canopen";
+
+// Predefined connection set (11-bit COB-IDs)
+#define COB_NMT                 0x000
+#define COB_SYNC                0x080
+#define COB_EMCY                0x080
+#define COB_SDO_TX              0x580
+#define COB_SDO_RX              0x600
+#define COB_HEARTBEAT           0x700
+
+// NMT command specifiers
+#define NMT_START               0x01
+#define NMT_STOP                0x02
+#define NMT_PRE_OPERATIONAL     0x80
+
+// Heartbeat states
+#define HB_BOOT                 0x00
+#define HB_STOPPED              0x04
+#define HB_OPERATIONAL          0x05
+#define HB_PRE_OPERATIONAL      0x7F
+
+#define CANOPEN_MAX_NODES       127
+
+// Abort sent for a transfer cut short by stop
+#define SDO_ABORT_GENERAL       0x08000000
+
+// Heartbeat consumer check interval
+#define HB_CHECK_US             50000
+
+// Margin on the automatic heartbeat timeout
+#define HB_MARGIN_US            20000
+
+// Subscriber ring: a SYNC burst of PDOs from every node
+#define CANOPEN_RING_DEPTH      256
+
+// SDO record: header plus the data in hex
+#define CANOPEN_LINE_LEN        (64 + 2 * CANOPEN_SDO_MAX_LEN)
+
+// Per-node heartbeat consumer
+typedef struct {
+    bool seen;
+    canopen_node_state_t state;
+    int64_t last_us;
+    int64_t period_us;
+    uint32_t heartbeats;
+    uint32_t emcy;
+    uint16_t last_emcy;
+} node_t;
+
+// Engine state
+static struct {
+    volatile bool running;
+    uint32_t hb_timeout_ms;
+    rx_bus_sub_handle_t sub;
+    SemaphoreHandle_t done_sem;
+    node_t nodes[CANOPEN_MAX_NODES + 1];
+    canopen_pdo_map_t pdos[CANOPEN_MAX_PDOS];
+    uint8_t pdo_count;
+    // SDO: queued by the console, run by the task
+    volatile bool sdo_pending;
+    canopen_sdo_info_t sdo_info;
+    uint32_t sdo_timeout_ms;
+    uint8_t sdo_blksize;
+    uint32_t sdo_len;
+    int64_t sdo_start_us;
+    int64_t sdo_deadline_us;
+    canopen_sdo_t sdo;
+    uint8_t sdo_buf[CANOPEN_SDO_MAX_LEN];
+    uint32_t nmt;
+    uint32_t sync;
+    uint32_t emcy;
+    uint32_t heartbeats;
+    uint32_t pdos_decoded;
+    uint32_t records;
+    uint32_t records_dropped;
+} s_co;
+
+static portMUX_TYPE s_co_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static char s_line[CANOPEN_LINE_LEN];
+
+/** @brief Command line arguments for canopen command */
+static struct {
+    struct arg_str *action;
+    struct arg_str *params;
+    struct arg_int *blksize;
+    struct arg_int *timeout;
+    struct arg_int *hb_timeout;
+    struct arg_end *end;
+} canopen_args;
+
+static const char *const s_state_names[] = {
+    "unknown", "boot", "stopped", "operational", "preop", "lost",
+};
+
+/**
+ * @brief Send a record to the host (line has room for the terminator)
+ */
+static void send_record(char *line, int pos)
+{
+    if (!slcan_is_open() || !host_link_present()) {
+        s_co.records_dropped++;
+        return;
+    }
+    line[pos++] = '\r';
+    host_link_write(line, pos);
+    s_co.records++;
+}
+
+/**
+ * @brief Change the state of a node and report it
+ */
+static void set_node_state(uint8_t id, canopen_node_state_t state, int64_t time_us)
+{
+    node_t *node = &s_co.nodes[id];
+    if (!node->seen || node->state != state) {
+        portENTER_CRITICAL(&s_co_mux);
+        node->seen = true;
+        node->state = state;
+        portEXIT_CRITICAL(&s_co_mux);
+        
+        char line[48];
+        int pos = snprintf(line, sizeof(line) - 1, "Cn %lld %u %s", (long long)clock_sync_to_host(time_us), id,
+                           s_state_names[state]);
+        send_record(line, pos);
+    }
+}
+
+/**
+ * @brief Heartbeat (or boot-up) message
+ */
+static void handle_heartbeat(uint8_t id, const uint8_t *data, uint8_t len, int64_t time_us)
+{
+    if (len < 1) {
+        return;
+    }
+    node_t *node = &s_co.nodes[id];
+    if (node->heartbeats > 0 && data[0] != HB_BOOT) {
+        node->period_us = time_us - node->last_us;
+    } else {
+        node->period_us = 0;
+    }
+    node->last_us = time_us;
+    node->heartbeats++;
+    s_co.heartbeats++;
+    
+    canopen_node_state_t state;
+    // Bit 7 is the node guarding toggle
+    switch (data[0] & 0x7F) {
+    case HB_BOOT:
+        state = CANOPEN_NODE_BOOT;
+        break;
+    case HB_STOPPED:
+        state = CANOPEN_NODE_STOPPED;
+        break;
+    case HB_OPERATIONAL:
+        state = CANOPEN_NODE_OPERATIONAL;
+        break;
+    case HB_PRE_OPERATIONAL:
+        state = CANOPEN_NODE_PRE_OPERATIONAL;
+        break;
+    default:
+        state = CANOPEN_NODE_UNKNOWN;
+        break;
+    }
+    set_node_state(id, state, time_us);
+}
+
+/**
+ * @brief NMT command: nodes without heartbeat take the commanded state
+ */
+static void handle_nmt(const uint8_t *data, uint8_t len, int64_t time_us)
+{
+    if (len < 2 || data[1] > CANOPEN_MAX_NODES) {
+        return;
+    }
+    s_co.nmt++;
+    
+    char line[48];
+    int pos = snprintf(line, sizeof(line) - 1, "Cm %lld %u %u", (long long)clock_sync_to_host(time_us), data[0],
+                       data[1]);
+    send_record(line, pos);
+    
+    canopen_node_state_t state;
+    switch (data[0]) {
+    case NMT_START:
+        state = CANOPEN_NODE_OPERATIONAL;
+        break;
+    case NMT_STOP:
+        state = CANOPEN_NODE_STOPPED;
+        break;
+    case NMT_PRE_OPERATIONAL:
+        state = CANOPEN_NODE_PRE_OPERATIONAL;
+        break;
+    default:
+        // Resets: the boot-up message tells the outcome
+        return;
+    }
+    for (uint8_t id = 1; id <= CANOPEN_MAX_NODES; id++) {
+        // Node 0 addresses all nodes; only known ones are updated then
+        bool addressed = data[1] == 0 ? s_co.nodes[id].seen : data[1] == id;
+        if (addressed && s_co.nodes[id].heartbeats == 0) {
+            set_node_state(id, state, time_us);
+        }
+    }
+}
+
+/**
+ * @brief Emergency message
+ */
+static void handle_emcy(uint8_t id, const uint8_t *data, uint8_t len, int64_t time_us)
+{
+    if (len < 3) {
+        return;
+    }
+    node_t *node = &s_co.nodes[id];
+    uint16_t code = data[0] | (data[1] << 8);
+    portENTER_CRITICAL(&s_co_mux);
+    node->seen = true;
+    node->emcy++;
+    node->last_emcy = code;
+    portEXIT_CRITICAL(&s_co_mux);
+    s_co.emcy++;
+    
+    // Error code 0000 is the "error reset" message
+    char line[64];
+    int pos = snprintf(line, sizeof(line) - 1, "Ce %lld %u %04X %02X ", (long long)clock_sync_to_host(time_us), id,
+                       code, data[2]);
+    for (uint8_t i = 3; i < len; i++) {
+        pos += snprintf(&line[pos], sizeof(line) - 1 - pos, "%02X", data[i]);
+    }
+    send_record(line, pos);
+}
+
+/**
+ * @brief Decode a configured PDO
+ */
+static void handle_pdo(const canopen_pdo_map_t *map, const uint8_t *data, uint8_t len, int64_t time_us)
+{
+    int64_t values[CANOPEN_PDO_MAX_ENTRIES];
+    if (!canopen_pdo_unpack(map, data, len, values)) {
+        return;
+    }
+    s_co.pdos_decoded++;
+    
+    char line[48 + CANOPEN_PDO_MAX_ENTRIES * 22];
+    int pos = snprintf(line, sizeof(line) - 1, "Cp %lld %03X", (long long)clock_sync_to_host(time_us), map->cob_id);
+    for (uint8_t i = 0; i < map->count; i++) {
+        if (map->entries[i].is_signed) {
+            pos += snprintf(&line[pos], sizeof(line) - 1 - pos, " %lld", (long long)values[i]);
+        } else {
+            pos += snprintf(&line[pos], sizeof(line) - 1 - pos, " %llu", (unsigned long long)values[i]);
+        }
+    }
+    send_record(line, pos);
+}
+
+/**
+ * @brief Send an SDO request to the node of the transfer
+ */
+static void sdo_send(const uint8_t req[8])
+{
+    twai_frame_t frame = {
+        .header = {
+            .id = COB_SDO_RX + s_co.sdo_info.node,
+            .dlc = 8,
+        },
+        .buffer = (uint8_t *)req,
+        .buffer_len = 8,
+    };
+    if (can_tx_send(&frame) != ESP_OK) {
+        ESP_LOGW(TAG, "SDO request to node %u not sent", s_co.sdo_info.node);
+    }
+}
+
+/**
+ * @brief Report the end of the SDO transfer
+ */
+static void sdo_finish(int64_t time_us)
+{
+    const canopen_sdo_t *sdo = &s_co.sdo;
+    bool ok = sdo->state == CANOPEN_SDO_DONE;
+    
+    portENTER_CRITICAL(&s_co_mux);
+    s_co.sdo_info.ok = ok;
+    s_co.sdo_info.abort_code = ok ? 0 : sdo->abort_code;
+    s_co.sdo_info.len = sdo->len;
+    s_co.sdo_info.time_ms = (uint32_t)((time_us - s_co.sdo_start_us) / 1000);
+    s_co.sdo_info.active = false;
+    portEXIT_CRITICAL(&s_co_mux);
+    
+    int pos = snprintf(s_line, sizeof(s_line) - 1, "Cs %lld %u %04X:%02X ", (long long)clock_sync_to_host(time_us),
+                       s_co.sdo_info.node, sdo->index, sdo->sub);
+    if (!ok) {
+        pos += snprintf(&s_line[pos], sizeof(s_line) - 1 - pos, "abort %08lX", (unsigned long)sdo->abort_code);
+    } else {
+        pos += snprintf(&s_line[pos], sizeof(s_line) - 1 - pos, "ok %lu", (unsigned long)sdo->len);
+        if (s_co.sdo_info.upload) {
+            s_line[pos++] = ' ';
+            for (uint32_t i = 0; i < sdo->len; i++) {
+                pos += snprintf(&s_line[pos], sizeof(s_line) - 1 - pos, "%02X", sdo->buf[i]);
+            }
+        }
+    }
+    send_record(s_line, pos);
+}
+
+/**
+ * @brief Start the queued SDO transfer
+ */
+static void sdo_begin(void)
+{
+    uint8_t req[8];
+    const canopen_sdo_info_t *info = &s_co.sdo_info;
+    
+    if (info->upload) {
+        canopen_sdo_start_upload(&s_co.sdo, info->index, info->sub, s_co.sdo_buf, sizeof(s_co.sdo_buf),
+                                 s_co.sdo_blksize, req);
+    } else {
+        canopen_sdo_start_download(&s_co.sdo, info->index, info->sub, s_co.sdo_buf, s_co.sdo_len, req);
+    }
+    s_co.sdo_start_us = esp_timer_get_time();
+    s_co.sdo_deadline_us = s_co.sdo_start_us + (int64_t)s_co.sdo_timeout_ms * 1000;
+    s_co.sdo_pending = false;
+    sdo_send(req);
+}
+
+/**
+ * @brief SDO response of the transfer node
+ */
+static void handle_sdo(const uint8_t *data, uint8_t len, int64_t time_us)
+{
+    uint8_t req[8];
+    if (canopen_sdo_feed(&s_co.sdo, data, len, req) == CANOPEN_SDO_SEND) {
+        sdo_send(req);
+    }
+    if (s_co.sdo.state == CANOPEN_SDO_DONE || s_co.sdo.state == CANOPEN_SDO_ABORTED) {
+        sdo_finish(time_us);
+    } else {
+        s_co.sdo_deadline_us = esp_timer_get_time() + (int64_t)s_co.sdo_timeout_ms * 1000;
+    }
+}
+
+/**
+ * @brief Abort the running SDO transfer from the client side
+ */
+static void sdo_cancel(uint32_t code)
+{
+    uint8_t req[8];
+    canopen_sdo_abort(&s_co.sdo, code, req);
+    sdo_send(req);
+    sdo_finish(esp_timer_get_time());
+}
+
+/**
+ * @brief Heartbeat consumer: report nodes whose heartbeat stopped
+ */
+static void check_heartbeats(int64_t now)
+{
+    for (uint8_t id = 1; id <= CANOPEN_MAX_NODES; id++) {
+        const node_t *node = &s_co.nodes[id];
+        if (node->heartbeats == 0 || node->state == CANOPEN_NODE_LOST) {
+            continue;
+        }
+        int64_t timeout_us;
+        if (s_co.hb_timeout_ms) {
+            timeout_us = (int64_t)s_co.hb_timeout_ms * 1000;
+        } else if (node->period_us > 0) {
+            timeout_us = 3 * node->period_us + HB_MARGIN_US;
+        } else {
+            continue;
+        }
+        if (now - node->last_us > timeout_us) {
+            set_node_state(id, CANOPEN_NODE_LOST, now);
+        }
+    }
+}
+
+/**
+ * @brief Dispatch a received frame
+ */
+static void handle_frame(const rx_bus_frame_t *rx_frame)
+{
+    const twai_frame_t *frame = &rx_frame->frame;
+    if (frame->header.ide || frame->header.rtr) {
+        return;
+    }
+    uint32_t id = frame->header.id;
+    uint8_t len = twaifd_dlc2len(frame->header.dlc);
+    if (len > 8) {
+        len = 8;
+    }
+    int64_t t = rx_frame->timestamp_us;
+    
+    if (id == COB_NMT) {
+        handle_nmt(frame->buffer, len, t);
+    } else if (id == COB_SYNC) {
+        s_co.sync++;
+    } else if (id > COB_EMCY && id <= COB_EMCY + CANOPEN_MAX_NODES) {
+        handle_emcy(id - COB_EMCY, frame->buffer, len, t);
+    } else if (id > COB_HEARTBEAT && id <= COB_HEARTBEAT + CANOPEN_MAX_NODES) {
+        handle_heartbeat(id - COB_HEARTBEAT, frame->buffer, len, t);
+    } else if (s_co.sdo_info.active && !s_co.sdo_pending && id == COB_SDO_TX + s_co.sdo_info.node) {
+        handle_sdo(frame->buffer, len, t);
+    } else {
+        for (uint8_t i = 0; i < s_co.pdo_count; i++) {
+            if (s_co.pdos[i].cob_id == id) {
+                handle_pdo(&s_co.pdos[i], frame->buffer, len, t);
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Engine task: RX bus "canopen" subscriber
+ */
+static void canopen_task(void *arg)
+{
+    int64_t next_check_us = esp_timer_get_time() + HB_CHECK_US;
+    
+    while (s_co.running) {
+        if (s_co.sdo_pending) {
+            sdo_begin();
+        }
+        
+        const rx_bus_frame_t *rx_frame = rx_bus_receive(s_co.sub, pdMS_TO_TICKS(10));
+        if (rx_frame != NULL) {
+            handle_frame(rx_frame);
+            rx_bus_release(rx_frame);
+        }
+        
+        int64_t now = esp_timer_get_time();
+        if (s_co.sdo_info.active && !s_co.sdo_pending && now > s_co.sdo_deadline_us) {
+            sdo_cancel(CANOPEN_SDO_ABORT_TIMEOUT);
+        }
+        if (now >= next_check_us) {
+            check_heartbeats(now);
+            next_check_us = now + HB_CHECK_US;
+        }
+    }
+    
+    if (s_co.sdo_info.active) {
+        if (s_co.sdo_pending) {
+            s_co.sdo_pending = false;
+            s_co.sdo_info.active = false;
+        } else {
+            sdo_cancel(SDO_ABORT_GENERAL);
+        }
+    }
+    
+    rx_bus_unsubscribe(s_co.sub);
+    s_co.sub = NULL;
+    
+    xSemaphoreGive(s_co.done_sem);
+    vTaskDelete(NULL);
+}
+
+esp_err_t canopen_start(uint32_t hb_timeout_ms)
+{
+    if (s_co.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (s_co.done_sem == NULL) {
+        s_co.done_sem = xSemaphoreCreateBinary();
+        if (s_co.done_sem == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    xSemaphoreTake(s_co.done_sem, 0);
+    
+    esp_err_t ret = rx_bus_subscribe("canopen", CANOPEN_RING_DEPTH, &s_co.sub);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    portENTER_CRITICAL(&s_co_mux);
+    s_co.hb_timeout_ms = hb_timeout_ms;
+    memset(s_co.nodes, 0, sizeof(s_co.nodes));
+    s_co.sdo_pending = false;
+    s_co.sdo_info.active = false;
+    s_co.nmt = 0;
+    s_co.sync = 0;
+    s_co.emcy = 0;
+    s_co.heartbeats = 0;
+    s_co.pdos_decoded = 0;
+    s_co.records = 0;
+    s_co.records_dropped = 0;
+    s_co.running = true;
+    portEXIT_CRITICAL(&s_co_mux);
+    
+    // Same priority as the transport task: SDO block segments arrive back to back
+    if (xTaskCreate(canopen_task, "canopen", 4096, NULL, 10, NULL) != pdPASS) {
+        s_co.running = false;
+        rx_bus_unsubscribe(s_co.sub);
+        s_co.sub = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Started: %u PDO(s)", s_co.pdo_count);
+    return ESP_OK;
+}
+
+esp_err_t canopen_stop(void)
+{
+    if (!s_co.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    s_co.running = false;
+    if (xSemaphoreTake(s_co.done_sem, pdMS_TO_TICKS(2000)) != pdTRUE) {
+        ESP_LOGE(TAG, "CANopen task did not stop");
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+esp_err_t canopen_add_pdo(const canopen_pdo_map_t *map)
+{
+    if (s_co.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // NMT, SYNC, emergency and heartbeat COB-IDs are always decoded as such
+    if (map->cob_id <= COB_EMCY + CANOPEN_MAX_NODES || map->cob_id > TWAI_STD_ID_MASK ||
+        (map->cob_id > COB_HEARTBEAT && map->cob_id <= COB_HEARTBEAT + CANOPEN_MAX_NODES) || map->count == 0 ||
+        map->count > CANOPEN_PDO_MAX_ENTRIES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t bits = 0;
+    for (uint8_t i = 0; i < map->count; i++) {
+        if (map->entries[i].bits == 0 || map->entries[i].bits > 64) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        bits += map->entries[i].bits;
+    }
+    if (bits > 64) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    for (uint8_t i = 0; i < s_co.pdo_count; i++) {
+        if (s_co.pdos[i].cob_id == map->cob_id) {
+            s_co.pdos[i] = *map;
+            return ESP_OK;
+        }
+    }
+    if (s_co.pdo_count == CANOPEN_MAX_PDOS) {
+        return ESP_ERR_NO_MEM;
+    }
+    s_co.pdos[s_co.pdo_count++] = *map;
+    return ESP_OK;
+}
+
+esp_err_t canopen_clear_pdos(void)
+{
+    if (s_co.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_co.pdo_count = 0;
+    return ESP_OK;
+}
+
+/**
+ * @brief Queue an SDO transfer for the task
+ */
+static esp_err_t sdo_queue(uint8_t node, uint16_t index, uint8_t sub, bool upload, uint8_t blksize, uint32_t len,
+                           uint32_t timeout_ms)
+{
+    portENTER_CRITICAL(&s_co_mux);
+    s_co.sdo_info = (canopen_sdo_info_t) {
+        .active = true,
+        .upload = upload,
+        .block = blksize > 0,
+        .node = node,
+        .index = index,
+        .sub = sub,
+    };
+    s_co.sdo_blksize = blksize;
+    s_co.sdo_len = len;
+    s_co.sdo_timeout_ms = timeout_ms;
+    s_co.sdo_pending = true;
+    portEXIT_CRITICAL(&s_co_mux);
+    return ESP_OK;
+}
+
+esp_err_t canopen_sdo_read(uint8_t node, uint16_t index, uint8_t sub, uint8_t blksize, uint32_t timeout_ms)
+{
+    if (!s_co.running || s_co.sdo_info.active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (node == 0 || node > CANOPEN_MAX_NODES || blksize > CANOPEN_SDO_MAX_BLKSIZE || timeout_ms == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return sdo_queue(node, index, sub, true, blksize, 0, timeout_ms);
+}
+
+esp_err_t canopen_sdo_write(uint8_t node, uint16_t index, uint8_t sub, const uint8_t *data, uint32_t len,
+                            uint32_t timeout_ms)
+{
+    if (!s_co.running || s_co.sdo_info.active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (node == 0 || node > CANOPEN_MAX_NODES || len == 0 || len > CANOPEN_SDO_MAX_LEN || timeout_ms == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // The buffer is idle: no transfer is active
+    memcpy(s_co.sdo_buf, data, len);
+    return sdo_queue(node, index, sub, false, 0, len, timeout_ms);
+}
+
+bool canopen_owns_frame(const twai_frame_t *frame)
+{
+    if (!s_co.running || frame->header.ide || frame->header.rtr) {
+        return false;
+    }
+    uint32_t id = frame->header.id;
+    if (id == COB_NMT || id == COB_SYNC || (id > COB_EMCY && id <= COB_EMCY + CANOPEN_MAX_NODES) ||
+        (id > COB_HEARTBEAT && id <= COB_HEARTBEAT + CANOPEN_MAX_NODES)) {
+        return true;
+    }
+    if (s_co.sdo_info.active && id == COB_SDO_TX + s_co.sdo_info.node) {
+        return true;
+    }
+    // The table does not change while running
+    for (uint8_t i = 0; i < s_co.pdo_count; i++) {
+        if (s_co.pdos[i].cob_id == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void canopen_get_status(canopen_status_t *out)
+{
+    portENTER_CRITICAL(&s_co_mux);
+    out->running = s_co.running;
+    out->nodes = 0;
+    for (uint8_t id = 1; id <= CANOPEN_MAX_NODES; id++) {
+        out->nodes += s_co.nodes[id].seen;
+    }
+    out->nmt = s_co.nmt;
+    out->sync = s_co.sync;
+    out->emcy = s_co.emcy;
+    out->heartbeats = s_co.heartbeats;
+    out->pdos = s_co.pdos_decoded;
+    out->records = s_co.records;
+    out->records_dropped = s_co.records_dropped;
+    portEXIT_CRITICAL(&s_co_mux);
+}
+
+bool canopen_get_node(uint8_t node, canopen_node_info_t *out)
+{
+    if (node == 0 || node > CANOPEN_MAX_NODES) {
+        return false;
+    }
+    portENTER_CRITICAL(&s_co_mux);
+    const node_t *n = &s_co.nodes[node];
+    bool seen = n->seen;
+    out->state = n->state;
+    out->heartbeats = n->heartbeats;
+    out->period_ms = (uint32_t)(n->period_us / 1000);
+    out->emcy = n->emcy;
+    out->last_emcy = n->last_emcy;
+    portEXIT_CRITICAL(&s_co_mux);
+    return seen;
+}
+
+void canopen_get_sdo(canopen_sdo_info_t *out)
+{
+    portENTER_CRITICAL(&s_co_mux);
+    *out = s_co.sdo_info;
+    portEXIT_CRITICAL(&s_co_mux);
+}
+
+/**
+ * @brief Parse "index:sub" (hexadecimal)
+ */
+static bool parse_object(const char *text, uint16_t *index, uint8_t *sub, const char **rest)
+{
+    char *end;
+    unsigned long i = strtoul(text, &end, 16);
+    if (end == text || *end != ':' || i > 0xFFFF) {
+        return false;
+    }
+    const char *s = end + 1;
+    unsigned long sb = strtoul(s, &end, 16);
+    if (end == s || sb > 0xFF) {
+        return false;
+    }
+    *index = (uint16_t)i;
+    *sub = (uint8_t)sb;
+    *rest = end;
+    return true;
+}
+
+/**
+ * @brief "canopen pdo <cob_id> <index:sub:bits[s]>..."
+ */
+static int pdo_action(int count, const char *const *params)
+{
+    if (count == 1 && strcmp(params[0], "clear") == 0) {
+        if (canopen_clear_pdos() != ESP_OK) {
+            printf("canopen: stop the engine first\n");
+            return 1;
+        }
+        return 0;
+    }
+    if (count < 2) {
+        printf("canopen pdo: need a COB-ID and mapped objects\n");
+        return 1;
+    }
+    canopen_pdo_map_t map = {
+        .cob_id = (uint16_t)strtoul(params[0], NULL, 0),
+        .count = (uint8_t)(count - 1),
+    };
+    if (map.count > CANOPEN_PDO_MAX_ENTRIES) {
+        printf("canopen pdo: at most %d objects\n", CANOPEN_PDO_MAX_ENTRIES);
+        return 1;
+    }
+    for (uint8_t i = 0; i < map.count; i++) {
+        canopen_pdo_entry_t *e = &map.entries[i];
+        const char *rest;
+        char *end;
+        if (!parse_object(params[i + 1], &e->index, &e->sub, &rest) || *rest != ':' ||
+            (e->bits = (uint8_t)strtoul(rest + 1, &end, 10)) == 0 || (*end != '\0' && strcmp(end, "s") != 0)) {
+            printf("canopen pdo: bad object '%s'\n", params[i + 1]);
+            return 1;
+        }
+        e->is_signed = *end == 's';
+    }
+    esp_err_t ret = canopen_add_pdo(&map);
+    if (ret != ESP_OK) {
+        printf("canopen pdo: %s\n", esp_err_to_name(ret));
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief "canopen sdo <node> <index:sub> [<hex data>]"
+ */
+static int sdo_action(int count, const char *const *params)
+{
+    uint16_t index;
+    uint8_t sub;
+    const char *rest;
+    if (count < 2 || count > 3 || !parse_object(params[1], &index, &sub, &rest) || *rest != '\0') {
+        printf("canopen sdo: need <node> <index:sub> [<hex data>]\n");
+        return 1;
+    }
+    uint8_t node = (uint8_t)strtoul(params[0], NULL, 0);
+    uint32_t timeout_ms = canopen_args.timeout->count ? canopen_args.timeout->ival[0] : 1000;
+    esp_err_t ret;
+    
+    if (count == 3) {
+        static uint8_t data[CANOPEN_SDO_MAX_LEN];
+        size_t hex_len = strlen(params[2]);
+        if (hex_len == 0 || hex_len % 2 || hex_len / 2 > sizeof(data)) {
+            printf("canopen sdo: bad data\n");
+            return 1;
+        }
+        for (size_t i = 0; i < hex_len / 2; i++) {
+            char byte[3] = {params[2][2 * i], params[2][2 * i + 1], '\0'};
+            char *end;
+            data[i] = (uint8_t)strtoul(byte, &end, 16);
+            if (*end != '\0') {
+                printf("canopen sdo: bad data\n");
+                return 1;
+            }
+        }
+        ret = canopen_sdo_write(node, index, sub, data, hex_len / 2, timeout_ms);
+    } else {
+        uint8_t blksize = canopen_args.blksize->count ? canopen_args.blksize->ival[0] : 0;
+        ret = canopen_sdo_read(node, index, sub, blksize, timeout_ms);
+    }
+    if (ret != ESP_OK) {
+        printf("canopen sdo: %s\n", esp_err_to_name(ret));
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief "canopen" command handler
+ */
+static int canopen_cmd_handler(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&canopen_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, canopen_args.end, argv[0]);
+        return 1;
+    }
+    
+    const char *action = canopen_args.action->count ? canopen_args.action->sval[0] : "show";
+    int count = canopen_args.params->count;
+    const char *const *params = canopen_args.params->sval;
+    
+    if (strcmp(action, "pdo") == 0) {
+        if (pdo_action(count, params) != 0) {
+            return 1;
+        }
+    } else if (strcmp(action, "sdo") == 0) {
+        if (sdo_action(count, params) != 0) {
+            return 1;
+        }
+    } else if (strcmp(action, "start") == 0) {
+        uint32_t hb_timeout = canopen_args.hb_timeout->count ? canopen_args.hb_timeout->ival[0] : 0;
+        esp_err_t ret = canopen_start(hb_timeout);
+        if (ret != ESP_OK) {
+            printf("canopen start: %s\n", esp_err_to_name(ret));
+            return 1;
+        }
+    } else if (strcmp(action, "stop") == 0) {
+        if (canopen_stop() != ESP_OK) {
+            printf("canopen: not running\n");
+            return 1;
+        }
+    } else if (strcmp(action, "show") != 0) {
+        printf("canopen: unknown action '%s'\n", action);
+        return 1;
+    }
+    
+    canopen_status_t st;
+    canopen_get_status(&st);
+    printf("canopen: %s, %u node(s), %u PDO(s), %lu NMT, %lu SYNC, %lu EMCY, %lu heartbeats, %lu PDOs decoded, "
+           "%lu records, %lu dropped\n", st.running ? "running" : "stopped", st.nodes, s_co.pdo_count,
+           (unsigned long)st.nmt, (unsigned long)st.sync, (unsigned long)st.emcy, (unsigned long)st.heartbeats,
+           (unsigned long)st.pdos, (unsigned long)st.records, (unsigned long)st.records_dropped);
+    for (uint8_t id = 1; id <= CANOPEN_MAX_NODES; id++) {
+        canopen_node_info_t node;
+        if (canopen_get_node(id, &node)) {
+            printf("  node %u: %s, %lu heartbeats", id, s_state_names[node.state], (unsigned long)node.heartbeats);
+            if (node.period_ms) {
+                printf(" every %lu ms", (unsigned long)node.period_ms);
+            }
+            if (node.emcy) {
+                printf(", %lu EMCY (last %04X)", (unsigned long)node.emcy, node.last_emcy);
+            }
+            printf("\n");
+        }
+    }
+    for (uint8_t i = 0; i < s_co.pdo_count; i++) {
+        const canopen_pdo_map_t *map = &s_co.pdos[i];
+        printf("  PDO %03X:", map->cob_id);
+        for (uint8_t e = 0; e < map->count; e++) {
+            printf(" %04X:%02X:%u%s", map->entries[e].index, map->entries[e].sub, map->entries[e].bits,
+                   map->entries[e].is_signed ? "s" : "");
+        }
+        printf("\n");
+    }
+    canopen_sdo_info_t sdo;
+    canopen_get_sdo(&sdo);
+    if (sdo.node) {
+        printf("  SDO %s node %u %04X:%02X%s: ", sdo.upload ? "read" : "write", sdo.node, sdo.index, sdo.sub,
+               sdo.block ? " (block)" : "");
+        if (sdo.active) {
+            printf("in progress\n");
+        } else if (sdo.ok) {
+            printf("%lu byte(s) in %lu ms\n", (unsigned long)sdo.len, (unsigned long)sdo.time_ms);
+        } else {
+            printf("abort %08lX\n", (unsigned long)sdo.abort_code);
+        }
+    }
+    return 0;
+}
+
+void canopen_register_commands(void)
+{
+    canopen_args.action = arg_str0(NULL, NULL, "<start|stop|show|pdo|sdo>", "Action (default: show)");
+    canopen_args.params = arg_strn(NULL, NULL, "<arg>", 0, CANOPEN_PDO_MAX_ENTRIES + 1,
+                                   "pdo: <cob_id> <index:sub:bits[s]>... | clear; sdo: <node> <index:sub> [<hex>]");
+    canopen_args.blksize = arg_int0("b", "block", "<1-127>", "sdo read: block upload with this block size");
+    canopen_args.timeout = arg_int0("t", "timeout", "<ms>", "sdo: response timeout (default: 1000)");
+    canopen_args.hb_timeout = arg_int0("h", "heartbeat", "<ms>", "start: heartbeat timeout (default: 3 periods)");
+    canopen_args.end = arg_end(10);
+    
+    const esp_console_cmd_t canopen_cmd = {
+        .command = "canopen",
+        .help = "CANopen monitor and SDO client; node states, PDO values and SDO results go to the host as records\n"
+        "  canopen pdo 0x181 6041:0:16 6064:0:32s  # decode TPDO1 of node 1\n"
+        "  canopen start\n"
+        "  canopen sdo 1 1008:0 -b 16              # read the device name with a block upload",
+        .hint = NULL,
+        .func = &canopen_cmd_handler,
+        .argtable = &canopen_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&canopen_cmd));
+}
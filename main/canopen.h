@@ -0,0 +1,176 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_twai.h"
+#include "canopen_proto.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief CANopen network monitor and SDO client
+ *
+ * While running, NMT, SYNC, EMCY, heartbeat and configured PDO frames (and
+ * the SDO responses of the device's own transfers) are consumed on the
+ * device instead of being forwarded. The host receives compact records:
+ *
+ *   Cn <time_us> <node> <state>                         node state change
+ *   Cm <time_us> <command> <node>                       NMT command seen
+ *   Ce <time_us> <node> <code> <register> <data>        emergency
+ *   Cp <time_us> <cob_id> <value> ...                   decoded PDO
+ *   Cs <time_us> <node> <index>:<sub> ok <len> <data>   SDO transfer result
+ *   Cs <time_us> <node> <index>:<sub> abort <code>
+ *
+ * Node states follow the heartbeats (boot-up, stopped, operational,
+ * pre-operational); a node whose heartbeat stops is reported lost. Nodes
+ * without heartbeat follow the NMT commands.
+ */
+
+/** @brief Maximum configured PDOs */
+#define CANOPEN_MAX_PDOS            16
+
+/** @brief Largest SDO transfer */
+#define CANOPEN_SDO_MAX_LEN         1024
+
+/**
+ * @brief Node state
+ */
+typedef enum {
+    CANOPEN_NODE_UNKNOWN = 0,
+    CANOPEN_NODE_BOOT,
+    CANOPEN_NODE_STOPPED,
+    CANOPEN_NODE_OPERATIONAL,
+    CANOPEN_NODE_PRE_OPERATIONAL,
+    CANOPEN_NODE_LOST,          /**< Heartbeat stopped */
+} canopen_node_state_t;
+
+/**
+ * @brief Node information
+ */
+typedef struct {
+    canopen_node_state_t state;
+    uint32_t heartbeats;        /**< Heartbeats received */
+    uint32_t period_ms;         /**< Last heartbeat interval */
+    uint32_t emcy;              /**< Emergencies received */
+    uint16_t last_emcy;         /**< Last emergency error code */
+} canopen_node_info_t;
+
+/**
+ * @brief Last SDO transfer
+ */
+typedef struct {
+    bool active;                /**< Transfer in progress */
+    bool ok;                    /**< Completed successfully */
+    bool upload;                /**< Read (upload) */
+    bool block;                 /**< Block upload requested */
+    uint8_t node;
+    uint16_t index;
+    uint8_t sub;
+    uint32_t abort_code;        /**< Abort code (sent or received) */
+    uint32_t len;               /**< Bytes transferred */
+    uint32_t time_ms;           /**< Duration */
+} canopen_sdo_info_t;
+
+/**
+ * @brief Engine status
+ */
+typedef struct {
+    bool running;
+    uint8_t nodes;              /**< Nodes seen */
+    uint32_t nmt;               /**< NMT commands */
+    uint32_t sync;              /**< SYNC frames */
+    uint32_t emcy;              /**< Emergencies */
+    uint32_t heartbeats;        /**< Heartbeats */
+    uint32_t pdos;              /**< Decoded PDOs */
+    uint32_t records;           /**< Records sent to the host */
+    uint32_t records_dropped;   /**< Records dropped (channel closed) */
+} canopen_status_t;
+
+/**
+ * @brief Start the engine
+ *
+ * @param hb_timeout_ms Heartbeat consumer time; 0 uses three times the observed interval
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if running, ESP_ERR_NO_MEM
+ */
+esp_err_t canopen_start(uint32_t hb_timeout_ms);
+
+/**
+ * @brief Stop the engine (a running SDO transfer is aborted)
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not running, ESP_ERR_TIMEOUT
+ */
+esp_err_t canopen_stop(void);
+
+/**
+ * @brief Add or replace a PDO mapping
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE while running, ESP_ERR_INVALID_ARG, ESP_ERR_NO_MEM
+ */
+esp_err_t canopen_add_pdo(const canopen_pdo_map_t *map);
+
+/**
+ * @brief Remove all PDO mappings
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE while running
+ */
+esp_err_t canopen_clear_pdos(void);
+
+/**
+ * @brief Read an object (SDO upload) in the background
+ *
+ * @param node Node ID (1..127)
+ * @param index Object index
+ * @param sub Sub-index
+ * @param blksize Block upload with this block size (1..127), 0 for expedited/segmented
+ * @param timeout_ms Response timeout
+ * @return ESP_OK if queued, ESP_ERR_INVALID_STATE if not running or a transfer is active, ESP_ERR_INVALID_ARG
+ */
+esp_err_t canopen_sdo_read(uint8_t node, uint16_t index, uint8_t sub, uint8_t blksize, uint32_t timeout_ms);
+
+/**
+ * @brief Write an object (SDO download) in the background
+ *
+ * @return ESP_OK if queued, ESP_ERR_INVALID_STATE if not running or a transfer is active, ESP_ERR_INVALID_ARG
+ */
+esp_err_t canopen_sdo_write(uint8_t node, uint16_t index, uint8_t sub, const uint8_t *data, uint32_t len,
+                            uint32_t timeout_ms);
+
+/**
+ * @brief Whether a received frame is consumed by the engine (not forwarded to the host)
+ */
+bool canopen_owns_frame(const twai_frame_t *frame);
+
+/**
+ * @brief Get the engine status
+ */
+void canopen_get_status(canopen_status_t *out);
+
+/**
+ * @brief Get the information of a node
+ *
+ * @return true if the node has been seen
+ */
+bool canopen_get_node(uint8_t node, canopen_node_info_t *out);
+
+/**
+ * @brief Get the last SDO transfer
+ */
+void canopen_get_sdo(canopen_sdo_info_t *out);
+
+/**
+ * @brief Register the 'canopen' extension command
+ */
+void canopen_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
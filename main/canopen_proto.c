@@ -0,0 +1,373 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <string.h>
+#include "canopen_proto.h"
+
+// Client command specifiers (byte 0, bits 7-5)
+#define CCS_DOWNLOAD_SEGMENT    0x00
+#define CCS_DOWNLOAD_INITIATE   0x20
+#define CCS_UPLOAD_INITIATE     0x40
+#define CCS_UPLOAD_SEGMENT      0x60
+#define CCS_ABORT               0x80
+#define CCS_BLOCK_UPLOAD        0xA0
+
+// Server command specifiers
+#define SCS_UPLOAD_SEGMENT      0x00
+#define SCS_DOWNLOAD_SEGMENT    0x20
+#define SCS_UPLOAD_INITIATE     0x40
+#define SCS_DOWNLOAD_INITIATE   0x60
+#define SCS_ABORT               0x80
+#define SCS_BLOCK_UPLOAD        0xC0
+
+// Block upload subcommands (client cs, server ss)
+#define BLOCK_CS_INITIATE       0x00
+#define BLOCK_CS_END            0x01
+#define BLOCK_CS_ACK            0x02
+#define BLOCK_CS_START          0x03
+#define BLOCK_CRC_SUPPORTED     0x04
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief Start a request with the command byte and the multiplexer (index, sub-index)
+ */
+static void build_request(const canopen_sdo_t *sdo, uint8_t cmd, uint8_t req[8])
+{
+    memset(req, 0, 8);
+    req[0] = cmd;
+    req[1] = (uint8_t)sdo->index;
+    req[2] = (uint8_t)(sdo->index >> 8);
+    req[3] = sdo->sub;
+}
+
+/**
+ * @brief Whether a response carries the multiplexer of the transfer
+ */
+static bool same_object(const canopen_sdo_t *sdo, const uint8_t *resp)
+{
+    return (resp[1] | (resp[2] << 8)) == sdo->index && resp[3] == sdo->sub;
+}
+
+/**
+ * @brief Build the next download segment
+ */
+static void build_download_segment(canopen_sdo_t *sdo, uint8_t req[8])
+{
+    uint32_t n = sdo->size - sdo->len;
+    if (n > 7) {
+        n = 7;
+    }
+    memset(req, 0, 8);
+    req[0] = CCS_DOWNLOAD_SEGMENT | (sdo->toggle << 4) | ((7 - n) << 1) | (sdo->len + n == sdo->size ? 1 : 0);
+    memcpy(&req[1], &sdo->src[sdo->len], n);
+    sdo->len += n;
+}
+
+void canopen_sdo_start_upload(canopen_sdo_t *sdo, uint16_t index, uint8_t sub, uint8_t *buf, uint32_t size,
+                              uint8_t blksize, uint8_t req[8])
+{
+    memset(sdo, 0, sizeof(*sdo));
+    sdo->index = index;
+    sdo->sub = sub;
+    sdo->buf = buf;
+    sdo->size = size;
+    sdo->blksize = blksize > CANOPEN_SDO_MAX_BLKSIZE ? CANOPEN_SDO_MAX_BLKSIZE : blksize;
+    
+    if (sdo->blksize == 0) {
+        sdo->state = CANOPEN_SDO_UPLOAD;
+        build_request(sdo, CCS_UPLOAD_INITIATE, req);
+        return;
+    }
+    sdo->state = CANOPEN_SDO_BLOCK_INIT;
+    build_request(sdo, CCS_BLOCK_UPLOAD | BLOCK_CRC_SUPPORTED | BLOCK_CS_INITIATE, req);
+    req[4] = sdo->blksize;
+    // Protocol switch threshold 0: the server must not switch to a normal upload
+    req[5] = 0;
+}
+
+bool canopen_sdo_start_download(canopen_sdo_t *sdo, uint16_t index, uint8_t sub, const uint8_t *data, uint32_t len,
+                                uint8_t req[8])
+{
+    memset(sdo, 0, sizeof(*sdo));
+    if (len == 0) {
+        return false;
+    }
+    sdo->index = index;
+    sdo->sub = sub;
+    sdo->src = data;
+    sdo->size = len;
+    sdo->state = CANOPEN_SDO_DOWNLOAD;
+    
+    if (len <= 4) {
+        // Expedited, size indicated
+        build_request(sdo, CCS_DOWNLOAD_INITIATE | ((4 - len) << 2) | 0x03, req);
+        memcpy(&req[4], data, len);
+        sdo->len = len;
+    } else {
+        build_request(sdo, CCS_DOWNLOAD_INITIATE | 0x01, req);
+        put_le32(&req[4], len);
+    }
+    return true;
+}
+
+void canopen_sdo_abort(canopen_sdo_t *sdo, uint32_t code, uint8_t req[8])
+{
+    build_request(sdo, CCS_ABORT, req);
+    put_le32(&req[4], code);
+    sdo->abort_code = code;
+    sdo->state = CANOPEN_SDO_ABORTED;
+}
+
+/**
+ * @brief Store received upload data
+ *
+ * @return false if the data does not fit the buffer
+ */
+static bool store(canopen_sdo_t *sdo, const uint8_t *data, uint32_t n)
+{
+    if (sdo->len + n > sdo->size) {
+        return false;
+    }
+    memcpy(&sdo->buf[sdo->len], data, n);
+    sdo->len += n;
+    return true;
+}
+
+/**
+ * @brief Block upload segment
+ */
+static canopen_sdo_result_t feed_block_segment(canopen_sdo_t *sdo, const uint8_t *resp, uint8_t len, uint8_t req[8])
+{
+    uint8_t seq = resp[0] & 0x7F;
+    bool last = (resp[0] & 0x80) != 0;
+    
+    if (seq == sdo->seqno + 1 && len == 8) {
+        // The last segment may be padded: keep up to 7 bytes beyond the buffer and trim at the end
+        uint32_t room = sdo->size + 7 - sdo->len;
+        if (room < 7) {
+            canopen_sdo_abort(sdo, CANOPEN_SDO_ABORT_MEMORY, req);
+            return CANOPEN_SDO_SEND;
+        }
+        uint32_t n = sdo->len + 7 <= sdo->size ? 7 : sdo->size - sdo->len;
+        memcpy(&sdo->buf[sdo->len], &resp[1], n);
+        sdo->len += 7;
+        sdo->seqno = seq;
+    } else {
+        // Out of sequence: ignored, the acknowledgement makes the server repeat from seqno + 1
+        last = false;
+    }
+    
+    if (seq != sdo->blksize && !(resp[0] & 0x80)) {
+        return CANOPEN_SDO_WAIT;
+    }
+    memset(req, 0, 8);
+    req[0] = CCS_BLOCK_UPLOAD | BLOCK_CS_ACK;
+    req[1] = sdo->seqno;
+    req[2] = sdo->blksize;
+    if (last) {
+        sdo->state = CANOPEN_SDO_BLOCK_END;
+    }
+    sdo->seqno = 0;
+    return CANOPEN_SDO_SEND;
+}
+
+canopen_sdo_result_t canopen_sdo_feed(canopen_sdo_t *sdo, const uint8_t *resp, uint8_t len, uint8_t req[8])
+{
+    if (len == 0 || sdo->state == CANOPEN_SDO_IDLE || sdo->state == CANOPEN_SDO_DONE ||
+        sdo->state == CANOPEN_SDO_ABORTED) {
+        return CANOPEN_SDO_WAIT;
+    }
+    
+    if (sdo->state == CANOPEN_SDO_BLOCK_DATA && resp[0] != SCS_ABORT) {
+        return feed_block_segment(sdo, resp, len, req);
+    }
+    if (len < 8) {
+        canopen_sdo_abort(sdo, CANOPEN_SDO_ABORT_CS, req);
+        return CANOPEN_SDO_SEND;
+    }
+    if (resp[0] == SCS_ABORT) {
+        if (sdo->state == CANOPEN_SDO_BLOCK_INIT && get_le32(&resp[4]) == CANOPEN_SDO_ABORT_CS) {
+            // Block transfer not supported: retry as a normal upload
+            sdo->state = CANOPEN_SDO_UPLOAD;
+            sdo->blksize = 0;
+            build_request(sdo, CCS_UPLOAD_INITIATE, req);
+            return CANOPEN_SDO_SEND;
+        }
+        sdo->abort_code = get_le32(&resp[4]);
+        sdo->state = CANOPEN_SDO_ABORTED;
+        return CANOPEN_SDO_WAIT;
+    }
+    
+    uint8_t scs = resp[0] & 0xE0;
+    switch (sdo->state) {
+    case CANOPEN_SDO_UPLOAD:
+        if (scs != SCS_UPLOAD_INITIATE || !same_object(sdo, resp)) {
+            break;
+        }
+        if (resp[0] & 0x02) {
+            // Expedited: the size is 4 - n if indicated
+            uint32_t n = (resp[0] & 0x01) ? 4 - ((resp[0] >> 2) & 0x03) : 4;
+            if (!store(sdo, &resp[4], n)) {
+                canopen_sdo_abort(sdo, CANOPEN_SDO_ABORT_MEMORY, req);
+                return CANOPEN_SDO_SEND;
+            }
+            sdo->state = CANOPEN_SDO_DONE;
+            return CANOPEN_SDO_WAIT;
+        }
+        sdo->expected = (resp[0] & 0x01) ? get_le32(&resp[4]) : 0;
+        if (sdo->expected > sdo->size) {
+            canopen_sdo_abort(sdo, CANOPEN_SDO_ABORT_MEMORY, req);
+            return CANOPEN_SDO_SEND;
+        }
+        sdo->state = CANOPEN_SDO_UPLOAD_SEG;
+        sdo->toggle = 0;
+        memset(req, 0, 8);
+        req[0] = CCS_UPLOAD_SEGMENT;
+        return CANOPEN_SDO_SEND;
+        
+    case CANOPEN_SDO_UPLOAD_SEG: {
+        if (scs != SCS_UPLOAD_SEGMENT) {
+            break;
+        }
+        if (((resp[0] >> 4) & 0x01) != sdo->toggle) {
+            canopen_sdo_abort(sdo, CANOPEN_SDO_ABORT_TOGGLE, req);
+            return CANOPEN_SDO_SEND;
+        }
+        if (!store(sdo, &resp[1], 7 - ((resp[0] >> 1) & 0x07))) {
+            canopen_sdo_abort(sdo, CANOPEN_SDO_ABORT_MEMORY, req);
+            return CANOPEN_SDO_SEND;
+        }
+        if (resp[0] & 0x01) {
+            sdo->state = CANOPEN_SDO_DONE;
+            return CANOPEN_SDO_WAIT;
+        }
+        sdo->toggle ^= 1;
+        memset(req, 0, 8);
+        req[0] = CCS_UPLOAD_SEGMENT | (sdo->toggle << 4);
+        return CANOPEN_SDO_SEND;
+    }
+        
+    case CANOPEN_SDO_DOWNLOAD:
+        if (scs != SCS_DOWNLOAD_INITIATE || !same_object(sdo, resp)) {
+            break;
+        }
+        if (sdo->len == sdo->size) {
+            sdo->state = CANOPEN_SDO_DONE;
+            return CANOPEN_SDO_WAIT;
+        }
+        sdo->state = CANOPEN_SDO_DOWNLOAD_SEG;
+        sdo->toggle = 0;
+        build_download_segment(sdo, req);
+        return CANOPEN_SDO_SEND;
+        
+    case CANOPEN_SDO_DOWNLOAD_SEG:
+        if (scs != SCS_DOWNLOAD_SEGMENT) {
+            break;
+        }
+        if (((resp[0] >> 4) & 0x01) != sdo->toggle) {
+            canopen_sdo_abort(sdo, CANOPEN_SDO_ABORT_TOGGLE, req);
+            return CANOPEN_SDO_SEND;
+        }
+        if (sdo->len == sdo->size) {
+            sdo->state = CANOPEN_SDO_DONE;
+            return CANOPEN_SDO_WAIT;
+        }
+        sdo->toggle ^= 1;
+        build_download_segment(sdo, req);
+        return CANOPEN_SDO_SEND;
+        
+    case CANOPEN_SDO_BLOCK_INIT:
+        if ((resp[0] & 0xE1) != (SCS_BLOCK_UPLOAD | BLOCK_CS_INITIATE) || !same_object(sdo, resp)) {
+            break;
+        }
+        sdo->crc = (resp[0] & 0x04) != 0;
+        sdo->expected = (resp[0] & 0x02) ? get_le32(&resp[4]) : 0;
+        if (sdo->expected > sdo->size) {
+            canopen_sdo_abort(sdo, CANOPEN_SDO_ABORT_MEMORY, req);
+            return CANOPEN_SDO_SEND;
+        }
+        sdo->state = CANOPEN_SDO_BLOCK_DATA;
+        sdo->seqno = 0;
+        memset(req, 0, 8);
+        req[0] = CCS_BLOCK_UPLOAD | BLOCK_CS_START;
+        return CANOPEN_SDO_SEND;
+        
+    case CANOPEN_SDO_BLOCK_END: {
+        if ((resp[0] & 0xE1) != (SCS_BLOCK_UPLOAD | BLOCK_CS_END)) {
+            break;
+        }
+        // n: bytes of the last segment without data
+        uint32_t n = (resp[0] >> 2) & 0x07;
+        if (n > sdo->len || sdo->len - n > sdo->size) {
+            canopen_sdo_abort(sdo, CANOPEN_SDO_ABORT_MEMORY, req);
+            return CANOPEN_SDO_SEND;
+        }
+        sdo->len -= n;
+        if (sdo->crc && canopen_crc16(sdo->buf, sdo->len) != (resp[1] | (resp[2] << 8))) {
+            canopen_sdo_abort(sdo, CANOPEN_SDO_ABORT_CRC, req);
+            return CANOPEN_SDO_SEND;
+        }
+        sdo->state = CANOPEN_SDO_DONE;
+        memset(req, 0, 8);
+        req[0] = CCS_BLOCK_UPLOAD | BLOCK_CS_END;
+        return CANOPEN_SDO_SEND;
+    }
+        
+    default:
+        break;
+    }
+    
+    canopen_sdo_abort(sdo, CANOPEN_SDO_ABORT_CS, req);
+    return CANOPEN_SDO_SEND;
+}
+
+uint16_t canopen_crc16(const uint8_t *data, uint32_t len)
+{
+    uint16_t crc = 0;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+bool canopen_pdo_unpack(const canopen_pdo_map_t *map, const uint8_t *data, uint8_t len, int64_t *values)
+{
+    uint64_t raw = 0;
+    for (uint8_t i = 0; i < len && i < 8; i++) {
+        raw |= (uint64_t)data[i] << (8 * i);
+    }
+    
+    uint32_t pos = 0;
+    for (uint8_t i = 0; i < map->count; i++) {
+        const canopen_pdo_entry_t *e = &map->entries[i];
+        if (e->bits == 0 || pos + e->bits > (uint32_t)len * 8 || pos + e->bits > 64) {
+            return false;
+        }
+        uint64_t mask = e->bits == 64 ? UINT64_MAX : (1ULL << e->bits) - 1;
+        uint64_t v = (raw >> pos) & mask;
+        if (e->is_signed && e->bits < 64 && (v >> (e->bits - 1)) & 1) {
+            v |= ~mask;
+        }
+        values[i] = (int64_t)v;
+        pos += e->bits;
+    }
+    return true;
+}
@@ -0,0 +1,165 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief CANopen (CiA 301) SDO client and PDO unpacking
+ *
+ * Pure C (no ESP-IDF dependencies) so it can be built and tested on the host.
+ * The SDO client runs expedited and segmented uploads/downloads and block
+ * uploads (with CRC); it only converts between server responses and client
+ * requests, the caller owns the COB-IDs, the timeout and transmission. A
+ * block upload the server does not support falls back to a normal upload.
+ */
+
+/** @brief SDO abort codes used by the client */
+#define CANOPEN_SDO_ABORT_TOGGLE    0x05030000  /**< Toggle bit not alternated */
+#define CANOPEN_SDO_ABORT_TIMEOUT   0x05040000  /**< SDO protocol timed out */
+#define CANOPEN_SDO_ABORT_CS        0x05040001  /**< Command specifier not valid or unknown */
+#define CANOPEN_SDO_ABORT_CRC       0x05040004  /**< CRC error (block mode) */
+#define CANOPEN_SDO_ABORT_MEMORY    0x05040005  /**< Out of memory */
+
+/** @brief Largest block size (segments per block) */
+#define CANOPEN_SDO_MAX_BLKSIZE     127
+
+/** @brief Maximum entries of a PDO mapping */
+#define CANOPEN_PDO_MAX_ENTRIES     8
+
+/**
+ * @brief SDO transfer state
+ */
+typedef enum {
+    CANOPEN_SDO_IDLE = 0,
+    CANOPEN_SDO_UPLOAD,         /**< Upload initiated */
+    CANOPEN_SDO_UPLOAD_SEG,     /**< Segmented upload */
+    CANOPEN_SDO_DOWNLOAD,       /**< Download initiated */
+    CANOPEN_SDO_DOWNLOAD_SEG,   /**< Segmented download */
+    CANOPEN_SDO_BLOCK_INIT,     /**< Block upload initiated */
+    CANOPEN_SDO_BLOCK_DATA,     /**< Block upload: receiving segments */
+    CANOPEN_SDO_BLOCK_END,      /**< Block upload: waiting for the end */
+    CANOPEN_SDO_DONE,           /**< Transfer complete */
+    CANOPEN_SDO_ABORTED,        /**< Aborted (abort_code) */
+} canopen_sdo_state_t;
+
+/**
+ * @brief Result of feeding a server response
+ */
+typedef enum {
+    CANOPEN_SDO_WAIT = 0,       /**< Nothing to send */
+    CANOPEN_SDO_SEND,           /**< Send the request (8 bytes) */
+} canopen_sdo_result_t;
+
+/**
+ * @brief SDO client transfer
+ */
+typedef struct {
+    canopen_sdo_state_t state;
+    uint16_t index;             /**< Object index */
+    uint8_t sub;                /**< Sub-index */
+    uint8_t *buf;               /**< Upload destination */
+    const uint8_t *src;         /**< Download source */
+    uint32_t size;              /**< Upload buffer size / download length */
+    uint32_t len;               /**< Bytes received / sent */
+    uint32_t expected;          /**< Size indicated by the server (0: not indicated) */
+    uint8_t toggle;             /**< Segment toggle bit */
+    uint8_t blksize;            /**< Block upload: segments per block (0: normal upload) */
+    uint8_t seqno;              /**< Block upload: last segment received in sequence */
+    bool crc;                   /**< Block upload: server sends a CRC */
+    uint32_t abort_code;        /**< Abort code (ABORTED) */
+} canopen_sdo_t;
+
+/**
+ * @brief One mapped object of a PDO
+ */
+typedef struct {
+    uint16_t index;             /**< Object index */
+    uint8_t sub;                /**< Sub-index */
+    uint8_t bits;               /**< Length in bits (1..64) */
+    bool is_signed;             /**< Two's complement value */
+} canopen_pdo_entry_t;
+
+/**
+ * @brief PDO mapping
+ */
+typedef struct {
+    uint16_t cob_id;            /**< PDO COB-ID */
+    uint8_t count;              /**< Mapped objects */
+    canopen_pdo_entry_t entries[CANOPEN_PDO_MAX_ENTRIES];
+} canopen_pdo_map_t;
+
+/**
+ * @brief Start an upload (read)
+ *
+ * @param sdo Transfer
+ * @param index Object index
+ * @param sub Sub-index
+ * @param buf Destination
+ * @param size Destination size
+ * @param blksize Block transfer with this block size (1..127), 0 for a normal upload
+ * @param req Output: first request
+ */
+void canopen_sdo_start_upload(canopen_sdo_t *sdo, uint16_t index, uint8_t sub, uint8_t *buf, uint32_t size,
+                              uint8_t blksize, uint8_t req[8]);
+
+/**
+ * @brief Start a download (write), expedited up to 4 bytes, segmented above
+ *
+ * @param data Data, kept until the transfer ends
+ * @param len Data length (1..)
+ * @param req Output: first request
+ * @return false if len is 0
+ */
+bool canopen_sdo_start_download(canopen_sdo_t *sdo, uint16_t index, uint8_t sub, const uint8_t *data, uint32_t len,
+                                uint8_t req[8]);
+
+/**
+ * @brief Feed a server response
+ *
+ * On a protocol error the client aborts: the request is the abort frame and
+ * the state is ABORTED.
+ *
+ * @param sdo Transfer
+ * @param resp Response payload
+ * @param len Payload length
+ * @param req Output: request to send (SEND)
+ * @return SEND or WAIT
+ */
+canopen_sdo_result_t canopen_sdo_feed(canopen_sdo_t *sdo, const uint8_t *resp, uint8_t len, uint8_t req[8]);
+
+/**
+ * @brief Abort the transfer from the client side (e.g. timeout)
+ *
+ * @param req Output: abort frame to send
+ */
+void canopen_sdo_abort(canopen_sdo_t *sdo, uint32_t code, uint8_t req[8]);
+
+/**
+ * @brief CRC of the SDO block transfer (CRC-16-CCITT, polynomial 0x1021, initial value 0)
+ */
+uint16_t canopen_crc16(const uint8_t *data, uint32_t len);
+
+/**
+ * @brief Unpack the mapped objects of a PDO (little-endian bit order)
+ *
+ * @param map PDO mapping
+ * @param data PDO payload
+ * @param len Payload length
+ * @param values Output: one value per mapped object (signed values sign-extended)
+ * @return false if the payload is shorter than the mapping
+ */
+bool canopen_pdo_unpack(const canopen_pdo_map_t *map, const uint8_t *data, uint8_t len, int64_t *values);
+
+#ifdef __cplusplus
+}
+#endif
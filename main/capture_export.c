@@ -0,0 +1,140 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+#include "esp_partition.h"
+#include "capture_export.h"
+#include "flash_capture.h"
+#include "host_link.h"
+
+static const char *TAG = "capture_export";
+
+/** @brief Command line arguments for export command */
+static struct {
+    struct arg_int *start;
+    struct arg_int *chunk_blocks;
+    struct arg_end *end;
+} export_args;
+
+esp_err_t capture_export_run(uint32_t start_chunk, uint32_t chunk_blocks)
+{
+    const esp_partition_t *part = flash_capture_partition();
+    if (part == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (chunk_blocks == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    capture_status_t st;
+    flash_capture_get_status(&st);
+    if (st.running) {
+        // Block order and chunk indices must stay stable across resumes
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    uint32_t total = (st.blocks_used + chunk_blocks - 1) / chunk_blocks;
+    if (start_chunk > total) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    const uint8_t *map = NULL;
+    esp_partition_mmap_handle_t map_handle;
+    esp_err_t ret = esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA,
+                                       (const void **)&map, &map_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to map capture partition: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    printf("export %lu %lu %lu\n", (unsigned long)total,
+           (unsigned long)(chunk_blocks * CAPTURE_BLOCK_SIZE), (unsigned long)start_chunk);
+    fflush(stdout);
+    
+    int64_t start_us = esp_timer_get_time();
+    uint64_t bytes = 0;
+    
+    for (uint32_t chunk = start_chunk; chunk < total && ret == ESP_OK; chunk++) {
+        uint32_t first = chunk * chunk_blocks;
+        uint32_t count = st.blocks_used - first;
+        if (count > chunk_blocks) {
+            count = chunk_blocks;
+        }
+        
+        // Blocks are consecutive in the ring, starting at the oldest one
+        capture_export_chunk_t hdr = {
+            .magic = CAPTURE_EXPORT_MAGIC,
+            .index = chunk,
+            .total = total,
+            .length = count * CAPTURE_BLOCK_SIZE,
+            .crc32 = 0,
+        };
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t block = (st.oldest_block + first + i) % st.blocks_total;
+            hdr.crc32 = esp_rom_crc32_le(hdr.crc32, &map[(size_t)block * CAPTURE_BLOCK_SIZE], CAPTURE_BLOCK_SIZE);
+        }
+        
+        ret = host_link_write(&hdr, sizeof(hdr));
+        for (uint32_t i = 0; i < count && ret == ESP_OK; i++) {
+            uint32_t block = (st.oldest_block + first + i) % st.blocks_total;
+            ret = host_link_write(&map[(size_t)block * CAPTURE_BLOCK_SIZE], CAPTURE_BLOCK_SIZE);
+        }
+        bytes += sizeof(hdr) + hdr.length;
+    }
+    
+    esp_partition_munmap(map_handle);
+    
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+    printf("export done %llu bytes in %lld ms (%llu kB/s)\n", (unsigned long long)bytes,
+           (long long)(elapsed_us / 1000),
+           (unsigned long long)(elapsed_us > 0 ? bytes * 1000 / (uint64_t)elapsed_us : 0));
+    return ret;
+}
+
+/**
+ * @brief "export" command handler
+ */
+static int export_cmd_handler(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&export_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, export_args.end, argv[0]);
+        return 1;
+    }
+    
+    uint32_t start = export_args.start->count ? (uint32_t)export_args.start->ival[0] : 0;
+    uint32_t blocks = export_args.chunk_blocks->count ? (uint32_t)export_args.chunk_blocks->ival[0]
+                                                      : CAPTURE_EXPORT_CHUNK_BLOCKS;
+    
+    esp_err_t ret = capture_export_run(start, blocks);
+    if (ret != ESP_OK) {
+        printf("export: %s\n", esp_err_to_name(ret));
+        return 1;
+    }
+    return 0;
+}
+
+void capture_export_register_commands(void)
+{
+    export_args.start = arg_int0("s", "start", "<chunk>", "First chunk to send (resume), default 0");
+    export_args.chunk_blocks = arg_int0("b", "blocks", "<n>", "4 KB blocks per chunk, default 16");
+    export_args.end = arg_end(2);
+    
+    const esp_console_cmd_t export_cmd = {
+        .command = "export",
+        .help = "Stream the capture partition to the host in CRC-checked binary chunks\n"
+        "Use tools/bridge_tool.py export to receive and convert it.",
+        .hint = NULL,
+        .func = &export_cmd_handler,
+        .argtable = &export_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&export_cmd));
+}
@@ -0,0 +1,62 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Bulk export of the capture partition to the host
+ *
+ * The capture partition is memory-mapped and its blocks are written to the
+ * host link straight from the mapping, oldest first, grouped into chunks.
+ * Each chunk is preceded by a capture_export_chunk_t carrying its index and
+ * CRC-32, so the host can verify it and resume an interrupted transfer
+ * with "export -s <index>".
+ *
+ * Transfer: "export <chunks> <chunk_bytes> <start>\n", then the chunks,
+ * then "export done ...\n" and the SLCAN acknowledge.
+ */
+
+/** @brief Chunk header magic ("CEXP") */
+#define CAPTURE_EXPORT_MAGIC        0x50584543
+
+/** @brief Default blocks per chunk (64 KB) */
+#define CAPTURE_EXPORT_CHUNK_BLOCKS 16
+
+/**
+ * @brief Chunk header
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;             /**< CAPTURE_EXPORT_MAGIC */
+    uint32_t index;             /**< Chunk index, 0 = oldest data */
+    uint32_t total;             /**< Number of chunks in the export */
+    uint32_t length;            /**< Payload bytes following the header */
+    uint32_t crc32;             /**< CRC-32 of the payload */
+} capture_export_chunk_t;
+
+/**
+ * @brief Export the capture partition
+ *
+ * @param start_chunk First chunk to send (for resume)
+ * @param chunk_blocks Blocks per chunk
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE while capture is running
+ */
+esp_err_t capture_export_run(uint32_t start_chunk, uint32_t chunk_blocks);
+
+/**
+ * @brief Register the "export" extension command
+ */
+void capture_export_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,242 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "clock_sync.h"
+
+static const char *TAG = "clock_sync";
+
+// Estimator state (updated from the host RX task)
+static struct {
+    int64_t line_start_us;
+    uint32_t beacons;
+    
+    // Current min-delay filter window
+    uint32_t win_count;
+    int64_t win_dev_us;
+    int64_t win_offset_us;
+    
+    // Filtered samples (ring)
+    int64_t pt_dev_us[CLOCK_SYNC_MAX_POINTS];
+    int64_t pt_offset_us[CLOCK_SYNC_MAX_POINTS];
+    uint32_t n_points;
+    uint32_t next_point;
+    
+    uint32_t residual_rms_us;
+    uint32_t residual_max_us;
+} s_est;
+
+// Fitted model, read by the forwarding path
+static struct {
+    bool synced;
+    int64_t ref_dev_us;     // Device time the offset refers to
+    int64_t offset_us;      // host - device at ref_dev_us
+    int64_t drift_ppb;      // d(host - device)/d(device) in ppb
+} s_model;
+
+static portMUX_TYPE s_model_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/** @brief Command line arguments for sync command */
+static struct {
+    struct arg_str *host_us;
+    struct arg_lit *reset;
+    struct arg_end *end;
+} sync_args;
+
+/**
+ * @brief Least-squares fit of offset = a + b * (device - mean) over the filtered samples
+ */
+static void clock_sync_fit(void)
+{
+    uint32_t n = s_est.n_points;
+    int64_t ref = s_est.pt_dev_us[0];
+    double mean_x = 0, mean_y = 0;
+    
+    for (uint32_t i = 0; i < n; i++) {
+        mean_x += (double)(s_est.pt_dev_us[i] - ref);
+        mean_y += (double)s_est.pt_offset_us[i];
+    }
+    mean_x /= n;
+    mean_y /= n;
+    
+    double sxx = 0, sxy = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        double dx = (double)(s_est.pt_dev_us[i] - ref) - mean_x;
+        sxx += dx * dx;
+        sxy += dx * ((double)s_est.pt_offset_us[i] - mean_y);
+    }
+    double slope = (n >= 2 && sxx > 0) ? sxy / sxx : 0.0;
+    
+    double sum_sq = 0, max_abs = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        double dx = (double)(s_est.pt_dev_us[i] - ref) - mean_x;
+        double res = (double)s_est.pt_offset_us[i] - (mean_y + slope * dx);
+        sum_sq += res * res;
+        if (fabs(res) > max_abs) max_abs = fabs(res);
+    }
+    s_est.residual_rms_us = (uint32_t)sqrt(sum_sq / n);
+    s_est.residual_max_us = (uint32_t)max_abs;
+    
+    portENTER_CRITICAL(&s_model_mux);
+    s_model.ref_dev_us = ref + (int64_t)mean_x;
+    s_model.offset_us = (int64_t)mean_y;
+    s_model.drift_ppb = (int64_t)(slope * 1e9);
+    s_model.synced = (n >= 2);
+    portEXIT_CRITICAL(&s_model_mux);
+}
+
+void clock_sync_reset(void)
+{
+    memset(&s_est, 0, sizeof(s_est));
+    
+    portENTER_CRITICAL(&s_model_mux);
+    memset(&s_model, 0, sizeof(s_model));
+    portEXIT_CRITICAL(&s_model_mux);
+}
+
+void clock_sync_mark_line_start(int64_t device_us)
+{
+    s_est.line_start_us = device_us;
+}
+
+void clock_sync_add_beacon(int64_t host_us, int64_t device_us)
+{
+    // Link delay only ever makes the device see the beacon late, so the
+    // largest (host - device) in a window is the least delayed sample
+    int64_t offset = host_us - device_us;
+    
+    s_est.beacons++;
+    if (s_est.win_count == 0 || offset > s_est.win_offset_us) {
+        s_est.win_dev_us = device_us;
+        s_est.win_offset_us = offset;
+    }
+    if (++s_est.win_count < CLOCK_SYNC_WINDOW) {
+        return;
+    }
+    s_est.win_count = 0;
+    
+    // Keep samples in chronological order: shift out the oldest when full
+    if (s_est.n_points == CLOCK_SYNC_MAX_POINTS) {
+        memmove(&s_est.pt_dev_us[0], &s_est.pt_dev_us[1], sizeof(int64_t) * (CLOCK_SYNC_MAX_POINTS - 1));
+        memmove(&s_est.pt_offset_us[0], &s_est.pt_offset_us[1], sizeof(int64_t) * (CLOCK_SYNC_MAX_POINTS - 1));
+        s_est.n_points--;
+    }
+    s_est.pt_dev_us[s_est.n_points] = s_est.win_dev_us;
+    s_est.pt_offset_us[s_est.n_points] = s_est.win_offset_us;
+    s_est.n_points++;
+    
+    clock_sync_fit();
+}
+
+int64_t clock_sync_to_host(int64_t device_us)
+{
+    portENTER_CRITICAL(&s_model_mux);
+    bool synced = s_model.synced;
+    int64_t ref = s_model.ref_dev_us;
+    int64_t offset = s_model.offset_us;
+    int64_t drift_ppb = s_model.drift_ppb;
+    portEXIT_CRITICAL(&s_model_mux);
+    
+    if (!synced) {
+        return device_us;
+    }
+    return device_us + offset + ((device_us - ref) * drift_ppb) / 1000000000LL;
+}
+
+int64_t clock_sync_to_device(int64_t host_us)
+{
+    portENTER_CRITICAL(&s_model_mux);
+    bool synced = s_model.synced;
+    int64_t ref = s_model.ref_dev_us;
+    int64_t offset = s_model.offset_us;
+    int64_t drift_ppb = s_model.drift_ppb;
+    portEXIT_CRITICAL(&s_model_mux);
+    
+    if (!synced) {
+        return host_us;
+    }
+    // First-order inverse; the drift term is tiny, so the error is far below 1 us
+    int64_t device_us = host_us - offset;
+    return device_us - ((device_us - ref) * drift_ppb) / 1000000000LL;
+}
+
+void clock_sync_get_status(clock_sync_status_t *out)
+{
+    portENTER_CRITICAL(&s_model_mux);
+    out->synced = s_model.synced;
+    out->drift_ppb = (int32_t)s_model.drift_ppb;
+    portEXIT_CRITICAL(&s_model_mux);
+    
+    int64_t now = esp_timer_get_time();
+    out->offset_us = clock_sync_to_host(now) - now;
+    out->beacons = s_est.beacons;
+    out->points = s_est.n_points;
+    out->residual_rms_us = s_est.residual_rms_us;
+    out->residual_max_us = s_est.residual_max_us;
+}
+
+/**
+ * @brief "sync" command handler - take a beacon or print status
+ */
+static int sync_cmd_handler(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&sync_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, sync_args.end, argv[0]);
+        return 1;
+    }
+    
+    if (sync_args.reset->count > 0) {
+        clock_sync_reset();
+        ESP_LOGI(TAG, "Estimator reset");
+    }
+    
+    if (sync_args.host_us->count > 0) {
+        char *end = NULL;
+        long long host_us = strtoll(sync_args.host_us->sval[0], &end, 10);
+        if (end == sync_args.host_us->sval[0] || *end != '\0') {
+            printf("sync: invalid host time '%s'\n", sync_args.host_us->sval[0]);
+            return 1;
+        }
+        clock_sync_add_beacon(host_us, s_est.line_start_us);
+        return 0;
+    }
+    
+    clock_sync_status_t st;
+    clock_sync_get_status(&st);
+    printf("sync: %s, beacons %lu, points %lu, offset %lldus, drift %ldppb, residual rms %luus max %luus\n",
+           st.synced ? "locked" : "unlocked", (unsigned long)st.beacons, (unsigned long)st.points,
+           (long long)st.offset_us, (long)st.drift_ppb,
+           (unsigned long)st.residual_rms_us, (unsigned long)st.residual_max_us);
+    return 0;
+}
+
+void clock_sync_register_commands(void)
+{
+    sync_args.host_us = arg_str0(NULL, NULL, "<host_us>", "Beacon: host clock in microseconds");
+    sync_args.reset = arg_lit0("r", "reset", "Reset the estimator");
+    sync_args.end = arg_end(2);
+    
+    const esp_console_cmd_t sync_cmd = {
+        .command = "sync",
+        .help = "Clock synchronization with the host\n"
+        "  sync <host_us>   # beacon, sent periodically by the host tool\n"
+        "  sync             # print offset, drift and fit residual\n"
+        "  sync -r          # reset the estimator",
+        .hint = NULL,
+        .func = &sync_cmd_handler,
+        .argtable = &sync_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&sync_cmd));
+}
@@ -0,0 +1,104 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Host-beacon clock synchronization
+ *
+ * The host periodically sends its own clock ("Xsync <host_us>") to every
+ * bridge. Each beacon gives one sample of (host - device) time, biased by a
+ * variable link delay. Per window of beacons only the sample with the
+ * smallest delay is kept; a linear regression over the kept samples yields
+ * offset and drift, which are applied to frame timestamps so that bridges
+ * on different buses share the host timebase.
+ */
+
+/** @brief Beacons per min-delay filter window */
+#define CLOCK_SYNC_WINDOW           4
+
+/** @brief Filtered samples used by the regression */
+#define CLOCK_SYNC_MAX_POINTS       32
+
+/**
+ * @brief Synchronization status
+ */
+typedef struct {
+    bool synced;            /**< At least two filtered samples available */
+    uint32_t beacons;       /**< Beacons received */
+    uint32_t points;        /**< Filtered samples in the regression */
+    int64_t offset_us;      /**< Current host - device offset (us) */
+    int32_t drift_ppb;      /**< Device clock drift relative to host (ppb) */
+    uint32_t residual_rms_us; /**< RMS residual of the fit (us) */
+    uint32_t residual_max_us; /**< Maximum absolute residual of the fit (us) */
+} clock_sync_status_t;
+
+/**
+ * @brief Reset the estimator
+ */
+void clock_sync_reset(void);
+
+/**
+ * @brief Note the device time at which the current host line started to arrive
+ *
+ * Called by the host RX task for the first byte of every line; the beacon
+ * command uses it as its arrival time.
+ *
+ * @param device_us esp_timer time (us)
+ */
+void clock_sync_mark_line_start(int64_t device_us);
+
+/**
+ * @brief Add one beacon sample
+ *
+ * @param host_us Host clock carried in the beacon (us)
+ * @param device_us Device arrival time of the beacon (us)
+ */
+void clock_sync_add_beacon(int64_t host_us, int64_t device_us);
+
+/**
+ * @brief Convert a device timestamp to the host timebase
+ *
+ * Returns device_us unchanged until the estimator is synced.
+ *
+ * @param device_us esp_timer timestamp (us)
+ * @return Timestamp in host time (us)
+ */
+int64_t clock_sync_to_host(int64_t device_us);
+
+/**
+ * @brief Convert a host timestamp to the device timebase (inverse of clock_sync_to_host)
+ *
+ * Returns host_us unchanged until the estimator is synced.
+ *
+ * @param host_us Timestamp in host time (us)
+ * @return esp_timer timestamp (us)
+ */
+int64_t clock_sync_to_device(int64_t host_us);
+
+/**
+ * @brief Get synchronization status
+ *
+ * @param out Output status
+ */
+void clock_sync_get_status(clock_sync_status_t *out);
+
+/**
+ * @brief Register the "sync" extension command
+ */
+void clock_sync_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
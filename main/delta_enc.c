@@ -0,0 +1,98 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <string.h>
+#include "delta_enc.h"
+
+void delta_enc_reset(delta_enc_t *enc)
+{
+    enc->count = 0;
+    memset(enc->hash, 0, sizeof(enc->hash));
+    enc->last_ts = 0;
+}
+
+/**
+ * @brief Find the hash slot of a key: its entry, or the free slot it would take
+ */
+static uint32_t hash_slot(const delta_enc_t *enc, uint32_t key)
+{
+    uint32_t slot = (key * 2654435761UL) >> 16 & (DELTA_ENC_HASH_SIZE - 1);
+    // The table is never more than half full, so a free slot ends every probe
+    while (enc->hash[slot] != 0 && enc->entries[enc->hash[slot] - 1].key != key) {
+        slot = (slot + 1) & (DELTA_ENC_HASH_SIZE - 1);
+    }
+    return slot;
+}
+
+size_t delta_enc_frame(delta_enc_t *enc, uint32_t id, bool ext, bool rtr, uint8_t dlc, const uint8_t *data,
+                       bool has_ts, uint16_t ts, uint8_t *out)
+{
+    static const uint8_t zero[8] = {0};
+    uint32_t key = id | (ext ? DELTA_ENC_ID_EXT : 0);
+    if (dlc > 8) {
+        dlc = 8;
+    }
+    
+    size_t pos = 1;
+    uint8_t header = DELTA_ENC_MARK | (has_ts ? DELTA_ENC_TS : 0) | (rtr ? DELTA_ENC_RTR : 0) | dlc;
+    uint32_t slot = hash_slot(enc, key);
+    delta_enc_entry_t *entry = NULL;
+    
+    if (enc->hash[slot] != 0) {
+        entry = &enc->entries[enc->hash[slot] - 1];
+        out[pos++] = (uint8_t)(enc->hash[slot] - 1);
+    } else {
+        header |= DELTA_ENC_DEF;
+        for (int i = 0; i < 4; i++) {
+            out[pos++] = (uint8_t)(key >> (8 * i));
+        }
+        // Once the dictionary is full, new IDs are always sent in full
+        if (enc->count < DELTA_ENC_MAX_IDS) {
+            entry = &enc->entries[enc->count++];
+            entry->key = key;
+            memset(entry->data, 0, sizeof(entry->data));
+            enc->hash[slot] = (uint8_t)enc->count;
+        }
+    }
+    out[0] = header;
+    
+    if (!rtr && dlc > 0) {
+        const uint8_t *prev = (header & DELTA_ENC_DEF) ? zero : entry->data;
+        size_t bitmap_pos = pos++;
+        uint8_t bitmap = 0;
+        for (uint8_t i = 0; i < dlc; i++) {
+            uint8_t delta = data[i] ^ prev[i];
+            if (delta != 0) {
+                bitmap |= 1 << i;
+                out[pos++] = delta;
+            }
+        }
+        out[bitmap_pos] = bitmap;
+    }
+    if (!rtr && entry != NULL) {
+        memcpy(entry->data, data, dlc);
+        memset(&entry->data[dlc], 0, sizeof(entry->data) - dlc);
+    }
+    
+    if (has_ts) {
+        uint32_t delta = (ts + DELTA_ENC_TS_PERIOD - enc->last_ts) % DELTA_ENC_TS_PERIOD;
+        enc->last_ts = ts;
+        while (delta >= 0x80) {
+            out[pos++] = (uint8_t)(delta | 0x80);
+            delta >>= 7;
+        }
+        out[pos++] = (uint8_t)delta;
+    }
+    return pos;
+}
+
+size_t delta_enc_raw_len(bool rtr, uint8_t dlc, bool has_ts)
+{
+    if (dlc > 8) {
+        dlc = 8;
+    }
+    return 4 + 1 + (rtr ? 0 : dlc) + (has_ts ? 2 : 0);
+}
@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Lossless delta encoding of the forwarded frames
+ *
+ * Pure C (no ESP-IDF dependencies) so it can be built and tested on the host.
+ * Each frame becomes a binary record holding what the SLCAN record holds:
+ * the payload is XORed with the previous payload of the same ID and only
+ * the non-zero bytes are sent after a bitmap of them, the ID is replaced by
+ * a dictionary index once seen, the SLCAN timestamp is sent as the
+ * difference to the previous one. The decoder keeps the same dictionary and
+ * rebuilds the exact SLCAN records.
+ *
+ * Record (first byte >= 0x80, so records can share the link with text
+ * records, which are ASCII):
+ *
+ *   header   1 byte   0x80 | DEF | TS | RTR | DLC (0-8)
+ *   id       4 bytes  DEF: ID, bit 31 set for 29-bit (little endian); the
+ *                     ID takes the next dictionary index while it has room
+ *   index    1 byte   no DEF: dictionary index
+ *   bitmap   1 byte   data frames with DLC > 0: bit i = byte i changed
+ *   data     n bytes  the changed bytes, XORed with the previous payload
+ *   time     1-3 bytes TS: SLCAN timestamp minus the previous one modulo
+ *                     60000 ms, 7 bits per byte, low bits first, bit 7 set
+ *                     if more bytes follow
+ *
+ * A DEF record (new ID) is XORed with a zero payload. RTR frames carry no
+ * data and leave the stored payload unchanged. The single byte
+ * DELTA_ENC_RESET clears the dictionary and the timestamp on both sides.
+ */
+
+/** @brief Dictionary size (indices 0-254) */
+#define DELTA_ENC_MAX_IDS           255
+
+/** @brief Hash slots of the dictionary (power of two) */
+#define DELTA_ENC_HASH_SIZE         512
+
+/** @brief Longest record: header, ID, bitmap, 8 bytes, 3-byte timestamp */
+#define DELTA_ENC_MAX_RECORD        17
+
+/** @brief Header bits */
+#define DELTA_ENC_MARK              0x80
+#define DELTA_ENC_DEF               0x40
+#define DELTA_ENC_TS                0x20
+#define DELTA_ENC_RTR               0x10
+
+/** @brief Reset record (not a valid header: DLC 15) */
+#define DELTA_ENC_RESET             0xFF
+
+/** @brief ID flag of 29-bit identifiers in DEF records */
+#define DELTA_ENC_ID_EXT            (1UL << 31)
+
+/** @brief SLCAN timestamp period in ms */
+#define DELTA_ENC_TS_PERIOD         60000
+
+/**
+ * @brief Dictionary entry: an ID and its last payload
+ */
+typedef struct {
+    uint32_t key;               /**< ID | DELTA_ENC_ID_EXT */
+    uint8_t data[8];            /**< Last payload, zero beyond its DLC */
+} delta_enc_entry_t;
+
+/**
+ * @brief Encoder state
+ */
+typedef struct {
+    delta_enc_entry_t entries[DELTA_ENC_MAX_IDS];
+    uint16_t count;                         /**< Entries in use */
+    uint8_t hash[DELTA_ENC_HASH_SIZE];      /**< Entry index + 1, 0: free */
+    uint16_t last_ts;                       /**< Previous timestamp */
+} delta_enc_t;
+
+/**
+ * @brief Clear the dictionary and the timestamp (as DELTA_ENC_RESET does in the decoder)
+ */
+void delta_enc_reset(delta_enc_t *enc);
+
+/**
+ * @brief Encode a frame
+ *
+ * @param enc Encoder state
+ * @param id Identifier
+ * @param ext 29-bit identifier
+ * @param rtr Remote frame
+ * @param dlc Data length (0-8)
+ * @param data Payload (dlc bytes, unused for RTR)
+ * @param has_ts Append the timestamp
+ * @param ts SLCAN timestamp (0-59999 ms)
+ * @param out Output: up to DELTA_ENC_MAX_RECORD bytes
+ * @return Record length
+ */
+size_t delta_enc_frame(delta_enc_t *enc, uint32_t id, bool ext, bool rtr, uint8_t dlc, const uint8_t *data,
+                       bool has_ts, uint16_t ts, uint8_t *out);
+
+/**
+ * @brief Size of the same frame as a plain binary record, for comparison
+ *
+ * 4-byte ID, 1-byte DLC, the payload and a 2-byte timestamp if enabled.
+ */
+size_t delta_enc_raw_len(bool rtr, uint8_t dlc, bool has_ts);
+
+#ifdef __cplusplus
+}
+#endif
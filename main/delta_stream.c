@@ -0,0 +1,186 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "delta_stream.h"
+#include "delta_enc.h"
+#include "host_link.h"
+#include "slcan_protocol.h"
+
+static const char *TAG = "delta_stream";
+
+// Stream state; the encoder is only touched by the transport task
+static struct {
+    volatile bool active;
+    volatile bool reset_pending;
+    delta_enc_t enc;
+    uint32_t frames;
+    uint64_t encoded_bytes;
+    uint64_t raw_bytes;
+    uint64_t text_bytes;
+    uint32_t definitions;
+    uint32_t resets;
+} s_stream;
+
+static portMUX_TYPE s_stream_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/** @brief Command line arguments for stream command */
+static struct {
+    struct arg_str *action;
+    struct arg_lit *clear;
+    struct arg_end *end;
+} stream_args;
+
+void delta_stream_enable(bool enable)
+{
+    if (enable && !s_stream.active) {
+        s_stream.reset_pending = true;
+    }
+    s_stream.active = enable;
+    ESP_LOGI(TAG, "Delta stream %s", enable ? "on" : "off");
+}
+
+bool delta_stream_is_active(void)
+{
+    return s_stream.active;
+}
+
+void delta_stream_reset(void)
+{
+    s_stream.reset_pending = true;
+}
+
+esp_err_t delta_stream_send(const twai_frame_t *frame, bool has_ts, uint16_t timestamp)
+{
+    uint8_t record[1 + DELTA_ENC_MAX_RECORD];
+    size_t len = 0;
+    bool reset = s_stream.reset_pending;
+    
+    if (reset) {
+        s_stream.reset_pending = false;
+        delta_enc_reset(&s_stream.enc);
+        record[len++] = DELTA_ENC_RESET;
+    }
+    
+    // Same ID and DLC interpretation as the SLCAN text record
+    uint8_t dlc = frame->header.dlc > 8 ? 8 : frame->header.dlc;
+    bool ext = frame->header.id > 0x7FF;
+    uint32_t id = frame->header.id & (ext ? 0x1FFFFFFF : 0x7FF);
+    size_t start = len;
+    len += delta_enc_frame(&s_stream.enc, id, ext, frame->header.rtr, dlc, frame->buffer, has_ts, timestamp,
+                           &record[len]);
+    
+    esp_err_t ret = host_link_write(record, len);
+    if (ret != ESP_OK) {
+        // The host may have got part of the record: both sides start over
+        s_stream.reset_pending = true;
+        return ret;
+    }
+    
+    portENTER_CRITICAL(&s_stream_mux);
+    s_stream.frames++;
+    s_stream.encoded_bytes += len;
+    s_stream.raw_bytes += delta_enc_raw_len(frame->header.rtr, dlc, has_ts);
+    s_stream.text_bytes += slcan_frame_len(frame);
+    if (record[start] & DELTA_ENC_DEF) {
+        s_stream.definitions++;
+    }
+    if (reset) {
+        s_stream.resets++;
+    }
+    portEXIT_CRITICAL(&s_stream_mux);
+    return ESP_OK;
+}
+
+void delta_stream_get_status(delta_stream_status_t *out)
+{
+    portENTER_CRITICAL(&s_stream_mux);
+    out->active = s_stream.active;
+    out->frames = s_stream.frames;
+    out->encoded_bytes = s_stream.encoded_bytes;
+    out->raw_bytes = s_stream.raw_bytes;
+    out->text_bytes = s_stream.text_bytes;
+    out->definitions = s_stream.definitions;
+    out->resets = s_stream.resets;
+    out->dictionary = s_stream.enc.count;
+    portEXIT_CRITICAL(&s_stream_mux);
+}
+
+/**
+ * @brief Print a size ratio with one decimal
+ */
+static void print_ratio(const char *name, uint64_t bytes, uint64_t encoded)
+{
+    uint64_t tenths = encoded > 0 ? bytes * 10 / encoded : 0;
+    printf(", %s %llu B (%llu.%llux)", name, (unsigned long long)bytes, (unsigned long long)(tenths / 10),
+           (unsigned long long)(tenths % 10));
+}
+
+/**
+ * @brief "stream" command handler
+ */
+static int stream_cmd_handler(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&stream_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, stream_args.end, argv[0]);
+        return 1;
+    }
+    
+    const char *action = stream_args.action->count ? stream_args.action->sval[0] : "show";
+    
+    if (strcmp(action, "delta") == 0) {
+        delta_stream_enable(true);
+    } else if (strcmp(action, "text") == 0) {
+        delta_stream_enable(false);
+    } else if (strcmp(action, "show") != 0) {
+        printf("stream: unknown action '%s'\n", action);
+        return 1;
+    }
+    
+    if (stream_args.clear->count > 0) {
+        portENTER_CRITICAL(&s_stream_mux);
+        s_stream.frames = 0;
+        s_stream.encoded_bytes = 0;
+        s_stream.raw_bytes = 0;
+        s_stream.text_bytes = 0;
+        s_stream.definitions = 0;
+        s_stream.resets = 0;
+        portEXIT_CRITICAL(&s_stream_mux);
+    }
+    
+    delta_stream_status_t st;
+    delta_stream_get_status(&st);
+    printf("stream: %s, %lu frames, %llu B encoded", st.active ? "delta" : "text", (unsigned long)st.frames,
+           (unsigned long long)st.encoded_bytes);
+    print_ratio("binary", st.raw_bytes, st.encoded_bytes);
+    print_ratio("text", st.text_bytes, st.encoded_bytes);
+    printf(", %lu definitions, %lu resets, dictionary %lu/%d\n", (unsigned long)st.definitions,
+           (unsigned long)st.resets, (unsigned long)st.dictionary, DELTA_ENC_MAX_IDS);
+    return 0;
+}
+
+void delta_stream_register_commands(void)
+{
+    stream_args.action = arg_str0(NULL, NULL, "<delta|text|show>", "Action (default: show)");
+    stream_args.clear = arg_lit0("c", "clear", "Clear the byte counters");
+    stream_args.end = arg_end(2);
+    
+    const esp_console_cmd_t stream_cmd = {
+        .command = "stream",
+        .help = "Frame stream encoding: SLCAN text, or XOR-delta records with an ID dictionary\n"
+        "(decoded back to SLCAN text by bridge_tool.py)",
+        .hint = NULL,
+        .func = &stream_cmd_handler,
+        .argtable = &stream_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&stream_cmd));
+}
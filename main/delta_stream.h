@@ -0,0 +1,85 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_twai.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Delta-encoded live stream
+ *
+ * While active, slcan_send_frame() sends every forwarded frame as a
+ * delta_enc.h record instead of the SLCAN text record; responses and other
+ * records stay text. The host decoder (tools/bridge_tool.py) rebuilds the
+ * exact SLCAN text, so SLCAN tools run unchanged behind it.
+ *
+ * Encoder and decoder must agree on the dictionary, so a reset record is
+ * sent before the first frame after the stream is switched on, after the
+ * channel is opened, and after a failed write (the host may have lost part
+ * of a record).
+ */
+
+/**
+ * @brief Stream status
+ */
+typedef struct {
+    bool active;                /**< Delta encoding on */
+    uint32_t frames;            /**< Frames encoded */
+    uint64_t encoded_bytes;     /**< Bytes of the encoded records */
+    uint64_t raw_bytes;         /**< Same frames as plain binary records (delta_enc_raw_len()) */
+    uint64_t text_bytes;        /**< Same frames as SLCAN text records */
+    uint32_t definitions;       /**< Records with a full ID */
+    uint32_t resets;            /**< Reset records sent */
+    uint32_t dictionary;        /**< Dictionary entries in use */
+} delta_stream_status_t;
+
+/**
+ * @brief Switch the delta encoding on or off
+ */
+void delta_stream_enable(bool enable);
+
+/**
+ * @brief Check whether the delta encoding is on
+ */
+bool delta_stream_is_active(void);
+
+/**
+ * @brief Start over with an empty dictionary at the next frame (sends a reset record)
+ */
+void delta_stream_reset(void);
+
+/**
+ * @brief Encode a frame and write it to the host
+ *
+ * @note Called from slcan_send_frame(), in the transport task only
+ *
+ * @param frame Frame to send
+ * @param has_ts Append the timestamp
+ * @param timestamp SLCAN timestamp (0-59999 ms)
+ * @return Result of host_link_write()
+ */
+esp_err_t delta_stream_send(const twai_frame_t *frame, bool has_ts, uint16_t timestamp);
+
+/**
+ * @brief Get the stream status
+ */
+void delta_stream_get_status(delta_stream_status_t *out);
+
+/**
+ * @brief Register the 'stream' extension command
+ */
+void delta_stream_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,557 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "ecu_scan.h"
+#include "can_tx.h"
+#include "rx_bus.h"
+#include "bridge_config.h"
+
+static const char *TAG = "ecu_scan";
+
+// 11-bit addressing
+#define SCAN_STD_FUNC_ID        0x7DF
+#define SCAN_STD_RESP_OFFSET    8
+
+// 29-bit normal fixed addressing, tester address 0xF1
+#define SCAN_EXT_PHYS_BASE      0x18DA0000
+#define SCAN_EXT_FUNC_ID        0x18DB33F1
+#define SCAN_TESTER_ADDR        0xF1
+
+#define SCAN_PADDING            0xAA
+
+// Scan subscriber ring
+#define SCAN_RING_DEPTH         64
+
+// Worst-case 29-bit frame with 8 data bytes, including stuff bits
+#define SCAN_FRAME_BITS         160
+
+/**
+ * @brief One probe in flight
+ */
+typedef struct {
+    bool used;
+    bool functional;
+    uint32_t resp_id;
+    volatile int64_t done_us;   // Set by the TX-done callback
+    int64_t deadline_us;
+} probe_t;
+
+// Scanner state
+static struct {
+    volatile bool running;
+    ecu_scan_config_t cfg;
+    rx_bus_sub_handle_t sub;
+    SemaphoreHandle_t done_sem;
+    probe_t inflight[ECU_SCAN_MAX_INFLIGHT];
+    uint32_t inflight_count;
+    uint32_t probes_total;
+    uint32_t probes_sent;
+    uint32_t responses;
+    uint32_t timeouts;
+    uint32_t tx_errors;
+    int64_t start_us;
+    int64_t end_us;
+    uint32_t result_count;
+    ecu_scan_result_t results[ECU_SCAN_MAX_RESULTS];
+} s_scan;
+
+static portMUX_TYPE s_scan_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/** @brief Command line arguments for scan command */
+static struct {
+    struct arg_str *action;
+    struct arg_lit *ext;
+    struct arg_int *first;
+    struct arg_int *last;
+    struct arg_str *probe;
+    struct arg_int *timeout;
+    struct arg_int *load;
+    struct arg_int *window;
+    struct arg_lit *physical_only;
+    struct arg_end *end;
+} scan_args;
+
+/**
+ * @brief Service ID of the configured probe
+ */
+static uint8_t probe_sid(void)
+{
+    switch (s_scan.cfg.probe) {
+    case ECU_SCAN_PROBE_SESSION:
+        return 0x10;
+    case ECU_SCAN_PROBE_OBD:
+        return 0x01;
+    default:
+        return 0x3E;
+    }
+}
+
+/**
+ * @brief Probe sent: record the completion time for the latency
+ */
+static IRAM_ATTR void probe_tx_done(void *arg, int64_t done_us, bool ok)
+{
+    probe_t *p = arg;
+    p->done_us = ok ? done_us : -1;
+}
+
+/**
+ * @brief Queue a probe on a request ID
+ */
+static void send_probe(uint32_t req_id, uint32_t resp_id, bool functional, int64_t now)
+{
+    probe_t *p = NULL;
+    for (uint32_t i = 0; i < ECU_SCAN_MAX_INFLIGHT && p == NULL; i++) {
+        if (!s_scan.inflight[i].used) {
+            p = &s_scan.inflight[i];
+        }
+    }
+    if (p == NULL) {
+        return;
+    }
+    
+    uint8_t data[8];
+    memset(data, SCAN_PADDING, sizeof(data));
+    data[0] = 2;
+    data[1] = probe_sid();
+    data[2] = s_scan.cfg.probe == ECU_SCAN_PROBE_SESSION ? 0x01 : 0x00;
+    twai_frame_t frame = {
+        .header = {
+            .id = req_id,
+            .ide = s_scan.cfg.ext,
+            .dlc = 8,
+        },
+        .buffer = data,
+        .buffer_len = sizeof(data),
+    };
+    
+    p->used = true;
+    p->functional = functional;
+    p->resp_id = resp_id;
+    p->done_us = 0;
+    p->deadline_us = now + (int64_t)s_scan.cfg.timeout_ms * 1000;
+    
+    portENTER_CRITICAL(&s_scan_mux);
+    s_scan.probes_sent++;
+    portEXIT_CRITICAL(&s_scan_mux);
+    
+    if (can_tx_send_with_callback(&frame, probe_tx_done, p) != ESP_OK) {
+        p->used = false;
+        portENTER_CRITICAL(&s_scan_mux);
+        s_scan.tx_errors++;
+        portEXIT_CRITICAL(&s_scan_mux);
+        return;
+    }
+    s_scan.inflight_count++;
+}
+
+/**
+ * @brief Add or update the result of a responding ECU
+ */
+static void record_result(uint32_t resp_id, bool functional, const twai_frame_t *frame, uint8_t len, uint32_t latency_us)
+{
+    uint32_t req_id = s_scan.cfg.ext ? SCAN_EXT_PHYS_BASE | ((resp_id & 0xFF) << 8) | SCAN_TESTER_ADDR
+                                     : resp_id - SCAN_STD_RESP_OFFSET;
+    
+    portENTER_CRITICAL(&s_scan_mux);
+    s_scan.responses++;
+    ecu_scan_result_t *r = NULL;
+    for (uint32_t i = 0; i < s_scan.result_count && r == NULL; i++) {
+        if (s_scan.results[i].resp_id == resp_id) {
+            r = &s_scan.results[i];
+        }
+    }
+    if (r == NULL && s_scan.result_count < ECU_SCAN_MAX_RESULTS) {
+        r = &s_scan.results[s_scan.result_count++];
+        memset(r, 0, sizeof(*r));
+        r->req_id = req_id;
+        r->resp_id = resp_id;
+        r->ext = s_scan.cfg.ext;
+    }
+    if (r != NULL) {
+        // The physical latency is the one that matters for a tester
+        if (!r->physical || !functional) {
+            r->latency_us = latency_us;
+            r->len = len;
+            memcpy(r->data, frame->buffer, len);
+        }
+        r->functional |= functional;
+        r->physical |= !functional;
+    }
+    portEXIT_CRITICAL(&s_scan_mux);
+}
+
+/**
+ * @brief Match a received frame against the probes in flight
+ */
+static void scan_handle_frame(const rx_bus_frame_t *rx_frame)
+{
+    const twai_frame_t *frame = &rx_frame->frame;
+    if (frame->header.rtr || (bool)frame->header.ide != s_scan.cfg.ext) {
+        return;
+    }
+    uint8_t len = (uint8_t)twaifd_dlc2len(frame->header.dlc);
+    if (len < 2) {
+        return;
+    }
+    
+    // Single frame (or first frame) carrying a positive or negative response to the probe
+    const uint8_t *d = frame->buffer;
+    uint8_t pci = d[0] & 0xF0;
+    uint8_t sid = pci == 0x10 ? (len > 2 ? d[2] : 0) : d[1];
+    if ((pci != 0x00 && pci != 0x10) || (sid != (probe_sid() | 0x40) && sid != 0x7F)) {
+        return;
+    }
+    
+    uint32_t id = frame->header.id;
+    for (uint32_t i = 0; i < ECU_SCAN_MAX_INFLIGHT; i++) {
+        probe_t *p = &s_scan.inflight[i];
+        if (!p->used) {
+            continue;
+        }
+        bool match;
+        if (p->functional) {
+            match = s_scan.cfg.ext ? (id & 0x1FFFFF00) == (SCAN_EXT_PHYS_BASE | (SCAN_TESTER_ADDR << 8))
+                                   : (id >= 0x7E8 && id <= 0x7EF);
+        } else {
+            match = id == p->resp_id;
+        }
+        if (!match) {
+            continue;
+        }
+        
+        int64_t done_us = p->done_us;
+        uint32_t latency = done_us > 0 && rx_frame->timestamp_us > done_us ? (uint32_t)(rx_frame->timestamp_us - done_us) : 0;
+        record_result(id, p->functional, frame, len, latency);
+        // The functional probe collects responders until its timeout
+        if (!p->functional) {
+            p->used = false;
+            s_scan.inflight_count--;
+        }
+        return;
+    }
+}
+
+/**
+ * @brief Drop probes past their response timeout
+ *
+ * @return true if the functional probe is still pending
+ */
+static bool scan_expire(int64_t now)
+{
+    bool functional_pending = false;
+    for (uint32_t i = 0; i < ECU_SCAN_MAX_INFLIGHT; i++) {
+        probe_t *p = &s_scan.inflight[i];
+        if (!p->used) {
+            continue;
+        }
+        if (now > p->deadline_us) {
+            p->used = false;
+            s_scan.inflight_count--;
+            if (!p->functional) {
+                portENTER_CRITICAL(&s_scan_mux);
+                s_scan.timeouts++;
+                portEXIT_CRITICAL(&s_scan_mux);
+            }
+        } else if (p->functional) {
+            functional_pending = true;
+        }
+    }
+    return functional_pending;
+}
+
+/**
+ * @brief Scanner task: RX bus "scan" subscriber, paces the probes
+ */
+static void scan_task(void *arg)
+{
+    const ecu_scan_config_t *cfg = &s_scan.cfg;
+    
+    uint32_t bitrate;
+    if (!bridge_config_get_bitrate(&bitrate) || bitrate == 0) {
+        bitrate = 500000;
+    }
+    int64_t interval_us = (int64_t)SCAN_FRAME_BITS * 1000000 * 100 / ((int64_t)bitrate * cfg->bus_load_pct);
+    
+    int64_t now = esp_timer_get_time();
+    int64_t next_send_us = now;
+    uint32_t next_target = cfg->first;
+    
+    if (cfg->functional) {
+        send_probe(cfg->ext ? SCAN_EXT_FUNC_ID : SCAN_STD_FUNC_ID, 0, true, now);
+    }
+    
+    while (s_scan.running) {
+        now = esp_timer_get_time();
+        // Physical probes start after the functional responders have been collected
+        bool functional_pending = scan_expire(now);
+        
+        if (!functional_pending) {
+            if (next_send_us < now - interval_us) {
+                next_send_us = now;
+            }
+            while (s_scan.inflight_count < cfg->max_inflight && next_target <= cfg->last && now >= next_send_us) {
+                uint32_t req_id, resp_id;
+                if (cfg->ext) {
+                    req_id = SCAN_EXT_PHYS_BASE | (next_target << 8) | SCAN_TESTER_ADDR;
+                    resp_id = SCAN_EXT_PHYS_BASE | (SCAN_TESTER_ADDR << 8) | next_target;
+                } else {
+                    req_id = next_target;
+                    resp_id = next_target + SCAN_STD_RESP_OFFSET;
+                }
+                send_probe(req_id, resp_id, false, now);
+                next_target++;
+                next_send_us += interval_us;
+            }
+            if (next_target > cfg->last && s_scan.inflight_count == 0) {
+                break;
+            }
+        }
+        
+        const rx_bus_frame_t *rx_frame = rx_bus_receive(s_scan.sub, 1);
+        if (rx_frame != NULL) {
+            scan_handle_frame(rx_frame);
+            rx_bus_release(rx_frame);
+        }
+    }
+    
+    s_scan.end_us = esp_timer_get_time();
+    rx_bus_unsubscribe(s_scan.sub);
+    s_scan.sub = NULL;
+    ESP_LOGI(TAG, "Scan finished: %lu ECU(s) in %lld ms", (unsigned long)s_scan.result_count,
+             (long long)((s_scan.end_us - s_scan.start_us) / 1000));
+    
+    s_scan.running = false;
+    xSemaphoreGive(s_scan.done_sem);
+    vTaskDelete(NULL);
+}
+
+void ecu_scan_default_config(ecu_scan_config_t *config)
+{
+    *config = (ecu_scan_config_t) {
+        .ext = false,
+        .first = 0x700,
+        .last = 0x7F7,
+        .probe = ECU_SCAN_PROBE_TESTER_PRESENT,
+        .functional = true,
+        .timeout_ms = 50,
+        .bus_load_pct = 30,
+        .max_inflight = 32,
+    };
+}
+
+esp_err_t ecu_scan_start(const ecu_scan_config_t *config)
+{
+    if (s_scan.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    uint32_t max_target = config->ext ? 0xFF : TWAI_STD_ID_MASK - SCAN_STD_RESP_OFFSET;
+    if (config->first > config->last || config->last > max_target || config->timeout_ms == 0 ||
+        config->bus_load_pct == 0 || config->bus_load_pct > 100 ||
+        config->max_inflight == 0 || config->max_inflight > ECU_SCAN_MAX_INFLIGHT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_scan.done_sem == NULL) {
+        s_scan.done_sem = xSemaphoreCreateBinary();
+        if (s_scan.done_sem == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    // A previous scan that finished on its own left the semaphore given
+    xSemaphoreTake(s_scan.done_sem, 0);
+    
+    esp_err_t ret = rx_bus_subscribe("scan", SCAN_RING_DEPTH, &s_scan.sub);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    portENTER_CRITICAL(&s_scan_mux);
+    s_scan.cfg = *config;
+    memset(s_scan.inflight, 0, sizeof(s_scan.inflight));
+    s_scan.inflight_count = 0;
+    s_scan.probes_total = config->last - config->first + 1 + (config->functional ? 1 : 0);
+    s_scan.probes_sent = 0;
+    s_scan.responses = 0;
+    s_scan.timeouts = 0;
+    s_scan.tx_errors = 0;
+    s_scan.result_count = 0;
+    s_scan.start_us = esp_timer_get_time();
+    s_scan.end_us = 0;
+    s_scan.running = true;
+    portEXIT_CRITICAL(&s_scan_mux);
+    
+    // Above the transport task: response timing is measured in this task
+    if (xTaskCreate(scan_task, "scan", 3072, NULL, 11, NULL) != pdPASS) {
+        s_scan.running = false;
+        rx_bus_unsubscribe(s_scan.sub);
+        s_scan.sub = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t ecu_scan_stop(void)
+{
+    if (!s_scan.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    s_scan.running = false;
+    if (xSemaphoreTake(s_scan.done_sem, pdMS_TO_TICKS(2000)) != pdTRUE) {
+        ESP_LOGE(TAG, "Scan task did not stop");
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+void ecu_scan_get_status(ecu_scan_status_t *out)
+{
+    portENTER_CRITICAL(&s_scan_mux);
+    out->running = s_scan.running;
+    out->probes_total = s_scan.probes_total;
+    out->probes_sent = s_scan.probes_sent;
+    out->responses = s_scan.responses;
+    out->timeouts = s_scan.timeouts;
+    out->tx_errors = s_scan.tx_errors;
+    out->results = s_scan.result_count;
+    int64_t end_us = s_scan.running || s_scan.end_us == 0 ? esp_timer_get_time() : s_scan.end_us;
+    out->elapsed_ms = s_scan.start_us ? (uint32_t)((end_us - s_scan.start_us) / 1000) : 0;
+    portEXIT_CRITICAL(&s_scan_mux);
+}
+
+bool ecu_scan_get_result(uint32_t index, ecu_scan_result_t *out)
+{
+    portENTER_CRITICAL(&s_scan_mux);
+    bool found = index < s_scan.result_count;
+    if (found) {
+        *out = s_scan.results[index];
+    }
+    portEXIT_CRITICAL(&s_scan_mux);
+    return found;
+}
+
+/**
+ * @brief "scan" command handler
+ */
+static int scan_cmd_handler(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&scan_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, scan_args.end, argv[0]);
+        return 1;
+    }
+    
+    const char *action = scan_args.action->count ? scan_args.action->sval[0] : "show";
+    
+    if (strcmp(action, "start") == 0) {
+        ecu_scan_config_t cfg;
+        ecu_scan_default_config(&cfg);
+        if (scan_args.ext->count) {
+            cfg.ext = true;
+            cfg.first = 0x00;
+            cfg.last = 0xFF;
+        }
+        if (scan_args.first->count) {
+            cfg.first = scan_args.first->ival[0];
+        }
+        if (scan_args.last->count) {
+            cfg.last = scan_args.last->ival[0];
+        }
+        if (scan_args.probe->count) {
+            const char *p = scan_args.probe->sval[0];
+            if (strcmp(p, "tp") == 0) {
+                cfg.probe = ECU_SCAN_PROBE_TESTER_PRESENT;
+            } else if (strcmp(p, "dsc") == 0) {
+                cfg.probe = ECU_SCAN_PROBE_SESSION;
+            } else if (strcmp(p, "obd") == 0) {
+                cfg.probe = ECU_SCAN_PROBE_OBD;
+            } else {
+                printf("scan: unknown probe '%s'\n", p);
+                return 1;
+            }
+        }
+        if (scan_args.timeout->count) {
+            cfg.timeout_ms = scan_args.timeout->ival[0];
+        }
+        if (scan_args.load->count) {
+            cfg.bus_load_pct = scan_args.load->ival[0];
+        }
+        if (scan_args.window->count) {
+            cfg.max_inflight = scan_args.window->ival[0];
+        }
+        cfg.functional = scan_args.physical_only->count == 0;
+        
+        esp_err_t ret = ecu_scan_start(&cfg);
+        if (ret != ESP_OK) {
+            printf("scan start: %s\n", esp_err_to_name(ret));
+            return 1;
+        }
+    } else if (strcmp(action, "stop") == 0) {
+        if (ecu_scan_stop() != ESP_OK) {
+            printf("scan: not running\n");
+            return 1;
+        }
+    } else if (strcmp(action, "show") != 0) {
+        printf("scan: unknown action '%s'\n", action);
+        return 1;
+    }
+    
+    ecu_scan_status_t st;
+    ecu_scan_get_status(&st);
+    printf("scan: %s, %lu/%lu probes, %lu responses, %lu timeouts, %lu tx errors, %lu ECU(s), %lu ms\n",
+           st.running ? "running" : "done", (unsigned long)st.probes_sent, (unsigned long)st.probes_total,
+           (unsigned long)st.responses, (unsigned long)st.timeouts, (unsigned long)st.tx_errors,
+           (unsigned long)st.results, (unsigned long)st.elapsed_ms);
+    
+    ecu_scan_result_t r;
+    for (uint32_t i = 0; ecu_scan_get_result(i, &r); i++) {
+        if (r.ext) {
+            printf("  %08lX -> %08lX", (unsigned long)r.req_id, (unsigned long)r.resp_id);
+        } else {
+            printf("  %03lX -> %03lX", (unsigned long)r.req_id, (unsigned long)r.resp_id);
+        }
+        printf(" %s%s%s %lu us ", r.physical ? "phys" : "", r.physical && r.functional ? "+" : "",
+               r.functional ? "func" : "", (unsigned long)r.latency_us);
+        for (uint8_t b = 0; b < r.len; b++) {
+            printf("%02X", r.data[b]);
+        }
+        printf("\n");
+    }
+    return 0;
+}
+
+void ecu_scan_register_commands(void)
+{
+    scan_args.action = arg_str0(NULL, NULL, "<start|stop|show>", "Action (default: show)");
+    scan_args.ext = arg_lit0("x", "ext", "29-bit normal fixed addressing (target addresses 00-FF)");
+    scan_args.first = arg_int0("f", "first", "<id>", "First request ID / target address (default: 0x700)");
+    scan_args.last = arg_int0("l", "last", "<id>", "Last request ID / target address (default: 0x7F7)");
+    scan_args.probe = arg_str0("p", "probe", "<tp|dsc|obd>", "Probe: tester present, default session, OBD 01 00");
+    scan_args.timeout = arg_int0("t", "timeout", "<ms>", "Response timeout per probe (default: 50)");
+    scan_args.load = arg_int0("b", "load", "<%>", "Bus-load budget for probes (default: 30)");
+    scan_args.window = arg_int0("w", "window", "<n>", "Probes in flight (default: 32)");
+    scan_args.physical_only = arg_lit0("n", "no-functional", "Skip the functional probe");
+    scan_args.end = arg_end(9);
+    
+    const esp_console_cmd_t scan_cmd = {
+        .command = "scan",
+        .help = "Discover diagnosable ECUs: functional probe, then a physical sweep\n"
+        "with many probes in flight within a bus-load budget",
+        .hint = NULL,
+        .func = &scan_cmd_handler,
+        .argtable = &scan_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&scan_cmd));
+}
@@ -0,0 +1,136 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Active discovery of diagnosable ECUs
+ *
+ * A scan first sends the probe to the functional address and collects all
+ * responders, then sweeps a range of physical request IDs with many probes
+ * in flight at once. New probes are paced so that the scan stays within a
+ * bus-load budget, and each probe waits at most the response timeout (P2),
+ * so a full sweep of 256 addresses takes well under a second.
+ *
+ * Addressing:
+ *  - 11-bit: request ID n, response expected on n + 8 (functional 0x7DF,
+ *    responses 0x7E8-0x7EF)
+ *  - 29-bit normal fixed (ISO 15765-4): request 0x18DA<TA><F1>, response
+ *    0x18DA<F1><TA> (functional 0x18DB33F1)
+ *
+ * Latency is measured from the completion of the probe frame to the
+ * reception of the response.
+ */
+
+/** @brief Maximum ECUs in the result table */
+#define ECU_SCAN_MAX_RESULTS        64
+
+/** @brief Maximum probes in flight */
+#define ECU_SCAN_MAX_INFLIGHT       64
+
+/**
+ * @brief Probe request
+ */
+typedef enum {
+    ECU_SCAN_PROBE_TESTER_PRESENT = 0,  /**< UDS 3E 00 */
+    ECU_SCAN_PROBE_SESSION,             /**< UDS 10 01 (default session) */
+    ECU_SCAN_PROBE_OBD,                 /**< OBD-II 01 00 (supported PIDs) */
+} ecu_scan_probe_t;
+
+/**
+ * @brief Scan parameters
+ */
+typedef struct {
+    bool ext;                   /**< 29-bit normal fixed addressing */
+    uint32_t first;             /**< First request ID (11-bit) or target address (29-bit) */
+    uint32_t last;              /**< Last request ID / target address */
+    ecu_scan_probe_t probe;     /**< Probe request */
+    bool functional;            /**< Send a functional probe before the sweep */
+    uint32_t timeout_ms;        /**< Response timeout per probe */
+    uint8_t bus_load_pct;       /**< Bus-load budget for probes (1..100) */
+    uint8_t max_inflight;       /**< Probes in flight (1..ECU_SCAN_MAX_INFLIGHT) */
+} ecu_scan_config_t;
+
+/**
+ * @brief One responding ECU
+ */
+typedef struct {
+    uint32_t req_id;            /**< Physical request ID */
+    uint32_t resp_id;           /**< Response ID */
+    bool ext;                   /**< 29-bit identifiers */
+    bool functional;            /**< Answered the functional probe */
+    bool physical;              /**< Answered a physical probe */
+    uint32_t latency_us;        /**< Probe completion to response (physical if available) */
+    uint8_t len;                /**< Response payload length */
+    uint8_t data[8];            /**< Response payload */
+} ecu_scan_result_t;
+
+/**
+ * @brief Scan progress
+ */
+typedef struct {
+    bool running;               /**< Scan in progress */
+    uint32_t probes_total;      /**< Probes of the scan (including functional) */
+    uint32_t probes_sent;       /**< Probes sent */
+    uint32_t responses;         /**< Responses matched to a probe */
+    uint32_t timeouts;          /**< Probes without a response */
+    uint32_t tx_errors;         /**< Probes that could not be queued */
+    uint32_t results;           /**< ECUs found */
+    uint32_t elapsed_ms;        /**< Scan duration so far */
+} ecu_scan_status_t;
+
+/**
+ * @brief Fill a configuration with defaults (11-bit 0x700-0x7F7, tester present, 50 ms, 30%, 32 in flight)
+ */
+void ecu_scan_default_config(ecu_scan_config_t *config);
+
+/**
+ * @brief Start a scan in the background (clears the results)
+ *
+ * @param config Scan parameters
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if a scan runs, ESP_ERR_INVALID_ARG, ESP_ERR_NO_MEM
+ */
+esp_err_t ecu_scan_start(const ecu_scan_config_t *config);
+
+/**
+ * @brief Abort a running scan
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no scan runs, ESP_ERR_TIMEOUT
+ */
+esp_err_t ecu_scan_stop(void);
+
+/**
+ * @brief Get the scan progress
+ *
+ * @param out Output status
+ */
+void ecu_scan_get_status(ecu_scan_status_t *out);
+
+/**
+ * @brief Get a result
+ *
+ * @param index Result index
+ * @param out Output result
+ * @return true if the result exists
+ */
+bool ecu_scan_get_result(uint32_t index, ecu_scan_result_t *out);
+
+/**
+ * @brief Register the 'scan' extension command
+ */
+void ecu_scan_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,337 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "flash_capture.h"
+#include "rx_bus.h"
+#include "clock_sync.h"
+
+static const char *TAG = "flash_capture";
+
+// Capture subscriber ring: absorbs frames while a sector is being erased
+#define CAPTURE_RING_DEPTH      256
+
+// Capture writer state
+static struct {
+    const esp_partition_t *part;
+    uint32_t n_blocks;
+    uint32_t write_block;       // Physical block written next
+    uint32_t next_seq;          // Sequence number of the next block
+    uint32_t blocks_used;
+    volatile bool running;
+    rx_bus_sub_handle_t sub;
+    SemaphoreHandle_t done_sem;
+    uint32_t records;
+    uint32_t dropped;
+    uint32_t block_count;       // Records in the block being filled
+    uint8_t block[CAPTURE_BLOCK_SIZE];
+} s_cap;
+
+/** @brief Command line arguments for capture command */
+static struct {
+    struct arg_str *action;
+    struct arg_end *end;
+} capture_args;
+
+/**
+ * @brief Read a block header, returning true if it holds valid capture data
+ */
+static bool capture_read_header(uint32_t block, capture_block_header_t *hdr)
+{
+    if (esp_partition_read(s_cap.part, (size_t)block * CAPTURE_BLOCK_SIZE, hdr, sizeof(*hdr)) != ESP_OK) {
+        return false;
+    }
+    return hdr->magic == CAPTURE_BLOCK_MAGIC &&
+           hdr->record_size == sizeof(capture_record_t) &&
+           hdr->record_count <= CAPTURE_RECORDS_PER_BLOCK;
+}
+
+/**
+ * @brief Scan block headers to continue after the newest block
+ */
+static void capture_scan(void)
+{
+    bool found = false;
+    uint32_t newest_seq = 0;
+    uint32_t newest_block = 0;
+    
+    s_cap.blocks_used = 0;
+    for (uint32_t i = 0; i < s_cap.n_blocks; i++) {
+        capture_block_header_t hdr;
+        if (!capture_read_header(i, &hdr)) {
+            continue;
+        }
+        s_cap.blocks_used++;
+        if (!found || (int32_t)(hdr.seq - newest_seq) > 0) {
+            found = true;
+            newest_seq = hdr.seq;
+            newest_block = i;
+        }
+    }
+    
+    s_cap.write_block = found ? (newest_block + 1) % s_cap.n_blocks : 0;
+    s_cap.next_seq = found ? newest_seq + 1 : 0;
+}
+
+/**
+ * @brief Write the block being filled to flash and start a new one
+ */
+static esp_err_t capture_flush_block(void)
+{
+    if (s_cap.block_count == 0) {
+        return ESP_OK;
+    }
+    
+    size_t rec_bytes = s_cap.block_count * sizeof(capture_record_t);
+    capture_block_header_t *hdr = (capture_block_header_t *)s_cap.block;
+    hdr->magic = CAPTURE_BLOCK_MAGIC;
+    hdr->seq = s_cap.next_seq;
+    hdr->record_count = (uint16_t)s_cap.block_count;
+    hdr->record_size = sizeof(capture_record_t);
+    hdr->crc32 = esp_rom_crc32_le(0, &s_cap.block[sizeof(*hdr)], rec_bytes);
+    
+    size_t offset = (size_t)s_cap.write_block * CAPTURE_BLOCK_SIZE;
+    esp_err_t ret = esp_partition_erase_range(s_cap.part, offset, CAPTURE_BLOCK_SIZE);
+    if (ret == ESP_OK) {
+        ret = esp_partition_write(s_cap.part, offset, s_cap.block, sizeof(*hdr) + rec_bytes);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write block %lu: %s", (unsigned long)s_cap.write_block, esp_err_to_name(ret));
+    }
+    
+    if (s_cap.blocks_used < s_cap.n_blocks) {
+        s_cap.blocks_used++;
+    }
+    s_cap.write_block = (s_cap.write_block + 1) % s_cap.n_blocks;
+    s_cap.next_seq++;
+    s_cap.block_count = 0;
+    memset(s_cap.block, 0xFF, sizeof(s_cap.block));
+    return ret;
+}
+
+/**
+ * @brief Append one frame to the block being filled
+ */
+static void capture_append(const rx_bus_frame_t *rx_frame)
+{
+    const twai_frame_t *frame = &rx_frame->frame;
+    capture_record_t rec = {
+        .timestamp_us = (uint64_t)clock_sync_to_host(rx_frame->timestamp_us),
+        .id_flags = frame->header.id & TWAI_EXT_ID_MASK,
+        .dlc = (uint8_t)frame->header.dlc,
+    };
+    
+    if (frame->header.ide) rec.id_flags |= CAPTURE_FLAG_EXT;
+    if (frame->header.rtr) rec.id_flags |= CAPTURE_FLAG_RTR;
+    if (frame->header.fdf) rec.id_flags |= CAPTURE_FLAG_FDF;
+    if (!frame->header.rtr) {
+        uint16_t len = twaifd_dlc2len(frame->header.dlc);
+        rec.len = len < sizeof(rec.data) ? len : sizeof(rec.data);
+        memcpy(rec.data, frame->buffer, rec.len);
+    }
+    
+    memcpy(&s_cap.block[sizeof(capture_block_header_t) + s_cap.block_count * sizeof(rec)], &rec, sizeof(rec));
+    s_cap.records++;
+    if (++s_cap.block_count == CAPTURE_RECORDS_PER_BLOCK) {
+        capture_flush_block();
+    }
+}
+
+/**
+ * @brief Capture writer task: RX bus "capture" subscriber
+ */
+static void capture_task(void *arg)
+{
+    while (s_cap.running) {
+        const rx_bus_frame_t *rx_frame = rx_bus_receive(s_cap.sub, pdMS_TO_TICKS(100));
+        if (rx_frame != NULL) {
+            capture_append(rx_frame);
+            rx_bus_release(rx_frame);
+        }
+    }
+    
+    capture_flush_block();
+    
+    rx_bus_sub_stats_t st;
+    rx_bus_get_sub_stats(s_cap.sub, &st);
+    s_cap.dropped = st.dropped;
+    rx_bus_unsubscribe(s_cap.sub);
+    s_cap.sub = NULL;
+    
+    xSemaphoreGive(s_cap.done_sem);
+    vTaskDelete(NULL);
+}
+
+esp_err_t flash_capture_init(void)
+{
+    s_cap.part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, CAPTURE_PARTITION_SUBTYPE,
+                                          CAPTURE_PARTITION_LABEL);
+    if (s_cap.part == NULL) {
+        ESP_LOGW(TAG, "No '%s' partition, flash capture disabled", CAPTURE_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    s_cap.done_sem = xSemaphoreCreateBinary();
+    if (s_cap.done_sem == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    s_cap.n_blocks = s_cap.part->size / CAPTURE_BLOCK_SIZE;
+    memset(s_cap.block, 0xFF, sizeof(s_cap.block));
+    capture_scan();
+    
+    ESP_LOGI(TAG, "Capture partition: %lu blocks, %lu in use, next block %lu (seq %lu)",
+             (unsigned long)s_cap.n_blocks, (unsigned long)s_cap.blocks_used,
+             (unsigned long)s_cap.write_block, (unsigned long)s_cap.next_seq);
+    return ESP_OK;
+}
+
+esp_err_t flash_capture_start(void)
+{
+    if (s_cap.part == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (s_cap.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    esp_err_t ret = rx_bus_subscribe("capture", CAPTURE_RING_DEPTH, &s_cap.sub);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    s_cap.records = 0;
+    s_cap.dropped = 0;
+    s_cap.block_count = 0;
+    s_cap.running = true;
+    if (xTaskCreate(capture_task, "capture", 4096, NULL, 8, NULL) != pdPASS) {
+        s_cap.running = false;
+        rx_bus_unsubscribe(s_cap.sub);
+        s_cap.sub = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    
+    ESP_LOGI(TAG, "Capture started at block %lu", (unsigned long)s_cap.write_block);
+    return ESP_OK;
+}
+
+esp_err_t flash_capture_stop(void)
+{
+    if (!s_cap.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    s_cap.running = false;
+    if (xSemaphoreTake(s_cap.done_sem, pdMS_TO_TICKS(2000)) != pdTRUE) {
+        ESP_LOGE(TAG, "Capture task did not stop");
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    ESP_LOGI(TAG, "Capture stopped: %lu records, %lu dropped",
+             (unsigned long)s_cap.records, (unsigned long)s_cap.dropped);
+    return ESP_OK;
+}
+
+esp_err_t flash_capture_erase(void)
+{
+    if (s_cap.part == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (s_cap.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    esp_err_t ret = esp_partition_erase_range(s_cap.part, 0, s_cap.part->size);
+    if (ret == ESP_OK) {
+        s_cap.write_block = 0;
+        s_cap.next_seq = 0;
+        s_cap.blocks_used = 0;
+    }
+    return ret;
+}
+
+void flash_capture_get_status(capture_status_t *out)
+{
+    out->running = s_cap.running;
+    out->blocks_total = s_cap.n_blocks;
+    out->blocks_used = s_cap.blocks_used;
+    out->oldest_block = (s_cap.blocks_used < s_cap.n_blocks) ? 0 : s_cap.write_block;
+    out->records = s_cap.records;
+    out->dropped = s_cap.dropped;
+    
+    if (s_cap.running && s_cap.sub) {
+        rx_bus_sub_stats_t st;
+        rx_bus_get_sub_stats(s_cap.sub, &st);
+        out->dropped = st.dropped;
+    }
+}
+
+const esp_partition_t *flash_capture_partition(void)
+{
+    return s_cap.part;
+}
+
+/**
+ * @brief "capture" command handler
+ */
+static int capture_cmd_handler(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&capture_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, capture_args.end, argv[0]);
+        return 1;
+    }
+    
+    const char *action = capture_args.action->count ? capture_args.action->sval[0] : "status";
+    esp_err_t ret = ESP_OK;
+    
+    if (strcmp(action, "start") == 0) {
+        ret = flash_capture_start();
+    } else if (strcmp(action, "stop") == 0) {
+        ret = flash_capture_stop();
+    } else if (strcmp(action, "erase") == 0) {
+        ret = flash_capture_erase();
+    } else if (strcmp(action, "status") != 0) {
+        printf("capture: unknown action '%s'\n", action);
+        return 1;
+    }
+    
+    if (ret != ESP_OK) {
+        printf("capture %s: %s\n", action, esp_err_to_name(ret));
+        return 1;
+    }
+    
+    capture_status_t st;
+    flash_capture_get_status(&st);
+    printf("capture: %s, blocks %lu/%lu, oldest %lu, records %lu, dropped %lu\n",
+           st.running ? "running" : "stopped", (unsigned long)st.blocks_used,
+           (unsigned long)st.blocks_total, (unsigned long)st.oldest_block,
+           (unsigned long)st.records, (unsigned long)st.dropped);
+    return 0;
+}
+
+void flash_capture_register_commands(void)
+{
+    capture_args.action = arg_str0(NULL, NULL, "<start|stop|erase|status>", "Action (default: status)");
+    capture_args.end = arg_end(2);
+    
+    const esp_console_cmd_t capture_cmd = {
+        .command = "capture",
+        .help = "Record received frames to the 'capture' flash partition",
+        .hint = NULL,
+        .func = &capture_cmd_handler,
+        .argtable = &capture_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&capture_cmd));
+}
@@ -0,0 +1,135 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_partition.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Recording of received frames to the "capture" flash partition
+ *
+ * The partition is used as a ring of 4 KB blocks (one flash sector each).
+ * Every block starts with a capture_block_header_t followed by fixed-size
+ * capture_record_t entries. Blocks carry an increasing sequence number, so
+ * the oldest block can be found after a wrap or a reboot.
+ *
+ * The layout is shared with the host tool (tools/bridge_tool.py).
+ */
+
+/** @brief Block size: one flash sector */
+#define CAPTURE_BLOCK_SIZE          4096
+
+/** @brief Block header magic ("CCAP") */
+#define CAPTURE_BLOCK_MAGIC         0x50414343
+
+/** @brief Label of the capture partition in partitions.csv */
+#define CAPTURE_PARTITION_LABEL     "capture"
+
+/** @brief Data partition subtype of the capture partition */
+#define CAPTURE_PARTITION_SUBTYPE   0x40
+
+/** @brief Record flag: 29-bit identifier */
+#define CAPTURE_FLAG_EXT            (1U << 31)
+/** @brief Record flag: remote frame */
+#define CAPTURE_FLAG_RTR            (1U << 30)
+/** @brief Record flag: TWAI-FD frame (payload truncated to 8 bytes) */
+#define CAPTURE_FLAG_FDF            (1U << 29)
+
+/**
+ * @brief Block header
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;             /**< CAPTURE_BLOCK_MAGIC */
+    uint32_t seq;               /**< Block sequence number */
+    uint16_t record_count;      /**< Valid records in this block */
+    uint16_t record_size;       /**< sizeof(capture_record_t) */
+    uint32_t crc32;             /**< CRC-32 of the valid records */
+} capture_block_header_t;
+
+/**
+ * @brief One captured frame
+ */
+typedef struct __attribute__((packed)) {
+    uint64_t timestamp_us;      /**< Frame time (host timebase once clock sync is locked) */
+    uint32_t id_flags;          /**< Identifier | CAPTURE_FLAG_* */
+    uint8_t dlc;                /**< Data length code */
+    uint8_t len;                /**< Stored payload bytes (0-8) */
+    uint8_t data[8];            /**< Payload */
+    uint8_t reserved[2];        /**< Zero */
+} capture_record_t;
+
+/** @brief Records per block */
+#define CAPTURE_RECORDS_PER_BLOCK   ((CAPTURE_BLOCK_SIZE - sizeof(capture_block_header_t)) / sizeof(capture_record_t))
+
+/**
+ * @brief Capture status
+ */
+typedef struct {
+    bool running;               /**< Recording active */
+    uint32_t blocks_total;      /**< Blocks in the partition */
+    uint32_t blocks_used;       /**< Blocks holding data */
+    uint32_t oldest_block;      /**< Physical index of the oldest block */
+    uint32_t records;           /**< Records written since start */
+    uint32_t dropped;           /**< Frames lost by the capture subscriber */
+} capture_status_t;
+
+/**
+ * @brief Find the capture partition and locate the write position
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if there is no capture partition
+ */
+esp_err_t flash_capture_init(void);
+
+/**
+ * @brief Start recording (subscribes to the RX bus)
+ *
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t flash_capture_start(void);
+
+/**
+ * @brief Stop recording and flush the partial block
+ *
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t flash_capture_stop(void);
+
+/**
+ * @brief Erase the whole capture partition
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE while recording
+ */
+esp_err_t flash_capture_erase(void);
+
+/**
+ * @brief Get capture status
+ *
+ * @param out Output status
+ */
+void flash_capture_get_status(capture_status_t *out);
+
+/**
+ * @brief Get the capture partition
+ *
+ * @return Partition, or NULL if not initialized
+ */
+const esp_partition_t *flash_capture_partition(void);
+
+/**
+ * @brief Register the "capture" extension command
+ */
+void flash_capture_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
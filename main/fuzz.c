@@ -0,0 +1,773 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "fuzz.h"
+#include "can_tx.h"
+#include "rx_bus.h"
+#include "bridge_config.h"
+#include "clock_sync.h"
+#include "slcan_protocol.h"
+
+static const char *TAG = "fuzz";
+
+// Frames sent, kept for the anomaly logs (power of two)
+#define FUZZ_LOG_LEN            64
+
+// Periodic IDs watched for disappearing
+#define FUZZ_MAX_HEARTBEATS     64
+
+// IDs with a longer gap while learning are not treated as periodic
+#define FUZZ_HEARTBEAT_MAX_GAP_US   1000000
+
+// Fuzz subscriber ring
+#define FUZZ_RING_DEPTH         128
+
+// Frames generated per loop at most, so received frames are drained in between
+#define FUZZ_BURST              32
+
+// 29-bit Bloom filter of the IDs seen while learning
+#define BLOOM_BITS_LOG2         13
+#define BLOOM_BITS              (1U << BLOOM_BITS_LOG2)
+
+/**
+ * @brief Periodic ID learned before fuzzing
+ */
+typedef struct {
+    uint32_t key;
+    uint32_t frames;
+    uint32_t max_gap_us;
+    int64_t last_us;
+    bool missing;
+} heartbeat_t;
+
+// Fuzzer state
+static struct {
+    volatile bool running;
+    bool learning;
+    bool capture_seeds;
+    fuzz_config_t cfg;
+    rx_bus_sub_handle_t sub;
+    SemaphoreHandle_t done_sem;
+    int64_t learn_end_us;
+    int64_t send_start_us;
+    int64_t end_us;
+    uint32_t sent;
+    uint32_t tx_full;
+    uint32_t baseline_ids;
+    uint32_t std_seen[2048 / 32];
+    uint32_t ext_bloom[BLOOM_BITS / 32];
+    uint32_t hb_count;
+    heartbeat_t hb[FUZZ_MAX_HEARTBEATS];
+    uint32_t bus_errors;
+    twai_error_state_t state;
+    uint32_t log_written;
+    fuzz_frame_t log[FUZZ_LOG_LEN];
+    uint32_t seed_count;
+    fuzz_frame_t seeds[FUZZ_MAX_SEEDS];
+    uint32_t anomaly_count;
+    fuzz_anomaly_t anomalies[FUZZ_MAX_ANOMALIES];
+} s_fuzz;
+
+static portMUX_TYPE s_fuzz_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/** @brief Command line arguments for fuzz command */
+static struct {
+    struct arg_str *action;
+    struct arg_str *arg;
+    struct arg_str *gen;
+    struct arg_lit *ext;
+    struct arg_int *first;
+    struct arg_int *last;
+    struct arg_int *load;
+    struct arg_str *seed;
+    struct arg_int *seq;
+    struct arg_int *count;
+    struct arg_int *learn;
+    struct arg_lit *stop;
+    struct arg_end *end;
+} fuzz_args;
+
+static const char *const s_gen_names[] = {"random", "mutate", "sweep"};
+static const char *const s_anomaly_names[] = {"new-id", "missing", "bus-errors", "state"};
+
+/**
+ * @brief 32-bit finalizer (murmur3 fmix32 constants)
+ */
+static uint32_t mix32(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7FEB352DU;
+    x ^= x >> 15;
+    x *= 0x846CA68BU;
+    x ^= x >> 16;
+    return x;
+}
+
+/**
+ * @brief Counter-based random stream of one frame
+ */
+typedef struct {
+    uint32_t base;
+    uint32_t n;
+} frame_rng_t;
+
+static uint32_t rng_next(frame_rng_t *r)
+{
+    return mix32(r->base + 0x9E3779B9U * ++r->n);
+}
+
+static void rng_fill(frame_rng_t *r, uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i += 4) {
+        uint32_t v = rng_next(r);
+        for (size_t b = i; b < len && b < i + 4; b++) {
+            data[b] = (uint8_t)(v >> (8 * (b - i)));
+        }
+    }
+}
+
+void fuzz_generate(const fuzz_config_t *config, uint32_t seq, fuzz_frame_t *out)
+{
+    frame_rng_t r = {.base = mix32(config->seed ^ mix32(seq)), .n = 0};
+    // Span 0 means the full 32-bit range, larger than any ID range
+    uint32_t span = config->last_id - config->first_id + 1;
+    
+    memset(out, 0, sizeof(*out));
+    out->seq = seq;
+    out->ext = config->ext;
+    rng_fill(&r, out->data, sizeof(out->data));
+    
+    if (config->gen == FUZZ_GEN_SWEEP) {
+        out->id = config->first_id + (span ? seq % span : seq);
+        out->dlc = span ? (seq / span) % 9 : 8;
+        return;
+    }
+    if (config->gen != FUZZ_GEN_MUTATE || s_fuzz.seed_count == 0) {
+        uint32_t v = rng_next(&r);
+        out->id = config->first_id + (span ? v % span : v);
+        out->dlc = rng_next(&r) % 9;
+        return;
+    }
+    
+    static const uint8_t boundary[] = {0x00, 0xFF, 0x7F, 0x80, 0x01, 0xFE};
+    const fuzz_frame_t *s = &s_fuzz.seeds[rng_next(&r) % s_fuzz.seed_count];
+    uint8_t fresh[8];
+    memcpy(fresh, out->data, sizeof(fresh));
+    out->id = s->id;
+    out->ext = s->ext;
+    out->dlc = s->dlc;
+    memcpy(out->data, s->data, sizeof(out->data));
+    
+    uint32_t mutations = 1 + rng_next(&r) % 3;
+    for (uint32_t m = 0; m < mutations; m++) {
+        uint32_t v = rng_next(&r);
+        uint8_t pos = out->dlc ? (v >> 8) % out->dlc : 0;
+        switch (v % 4) {
+        case 0:
+            out->data[pos] ^= 1 << ((v >> 16) % 8);
+            break;
+        case 1:
+            out->data[pos] = (uint8_t)(v >> 24);
+            break;
+        case 2:
+            out->data[pos] = boundary[(v >> 16) % sizeof(boundary)];
+            break;
+        default: {
+            // New length; bytes beyond the seed payload are random
+            uint8_t dlc = (v >> 16) % 9;
+            for (uint8_t b = out->dlc; b < dlc; b++) {
+                out->data[b] = fresh[b];
+            }
+            out->dlc = dlc;
+            break;
+        }
+        }
+    }
+}
+
+/**
+ * @brief Test and set the seen bit(s) of an ID
+ *
+ * @return true if the ID was not seen before
+ */
+static bool seen_insert(uint32_t id, bool ext)
+{
+    if (!ext) {
+        uint32_t mask = 1U << (id & 31);
+        bool is_new = !(s_fuzz.std_seen[id >> 5] & mask);
+        s_fuzz.std_seen[id >> 5] |= mask;
+        return is_new;
+    }
+    
+    static const uint32_t mult[3] = {0x9E3779B1U, 0x85EBCA77U, 0xC2B2AE3DU};
+    bool is_new = false;
+    for (int k = 0; k < 3; k++) {
+        uint32_t bit = (id * mult[k]) >> (32 - BLOOM_BITS_LOG2);
+        uint32_t mask = 1U << (bit & 31);
+        if (!(s_fuzz.ext_bloom[bit >> 5] & mask)) {
+            is_new = true;
+            s_fuzz.ext_bloom[bit >> 5] |= mask;
+        }
+    }
+    return is_new;
+}
+
+/**
+ * @brief Record an anomaly with the seed, sequence number and the last frames sent
+ */
+static void record_anomaly(fuzz_anomaly_kind_t kind, uint32_t key, uint32_t detail, int64_t time_us)
+{
+    portENTER_CRITICAL(&s_fuzz_mux);
+    uint32_t index = s_fuzz.anomaly_count++;
+    if (index < FUZZ_MAX_ANOMALIES) {
+        fuzz_anomaly_t *a = &s_fuzz.anomalies[index];
+        a->kind = kind;
+        a->id = key & ~(1U << 31);
+        a->ext = (key >> 31) != 0;
+        a->detail = detail;
+        a->seed = s_fuzz.cfg.seed;
+        a->seq = s_fuzz.cfg.first_seq + s_fuzz.sent;
+        a->time_us = clock_sync_to_host(time_us);
+        uint32_t n = s_fuzz.log_written < FUZZ_ANOMALY_FRAMES ? s_fuzz.log_written : FUZZ_ANOMALY_FRAMES;
+        for (uint32_t i = 0; i < n; i++) {
+            a->frames[i] = s_fuzz.log[(s_fuzz.log_written - n + i) % FUZZ_LOG_LEN];
+        }
+        a->n_frames = n;
+    }
+    portEXIT_CRITICAL(&s_fuzz_mux);
+    
+    ESP_LOGW(TAG, "Anomaly %lu: %s", (unsigned long)index, s_anomaly_names[kind]);
+    if (s_fuzz.cfg.stop_on_anomaly) {
+        s_fuzz.running = false;
+    }
+}
+
+/**
+ * @brief Find the heartbeat entry of a key, inserting it while learning
+ */
+static heartbeat_t *heartbeat_get(uint32_t key, bool insert)
+{
+    for (uint32_t i = 0; i < s_fuzz.hb_count; i++) {
+        if (s_fuzz.hb[i].key == key) {
+            return &s_fuzz.hb[i];
+        }
+    }
+    if (!insert || s_fuzz.hb_count == FUZZ_MAX_HEARTBEATS) {
+        return NULL;
+    }
+    heartbeat_t *hb = &s_fuzz.hb[s_fuzz.hb_count++];
+    memset(hb, 0, sizeof(*hb));
+    hb->key = key;
+    return hb;
+}
+
+/**
+ * @brief Learn or check one received frame
+ */
+static void fuzz_handle_frame(const rx_bus_frame_t *rx_frame)
+{
+    const twai_frame_t *frame = &rx_frame->frame;
+    uint32_t key = frame->header.id | (frame->header.ide ? (1U << 31) : 0);
+    int64_t t = rx_frame->timestamp_us;
+    bool is_new = seen_insert(frame->header.id, frame->header.ide);
+    
+    if (s_fuzz.learning) {
+        if (is_new) {
+            s_fuzz.baseline_ids++;
+            // Seeds for the mutate generator, one per ID
+            if (s_fuzz.capture_seeds && s_fuzz.seed_count < FUZZ_MAX_SEEDS && !frame->header.rtr) {
+                fuzz_frame_t *s = &s_fuzz.seeds[s_fuzz.seed_count++];
+                memset(s, 0, sizeof(*s));
+                s->id = frame->header.id;
+                s->ext = frame->header.ide;
+                s->dlc = frame->header.dlc > 8 ? 8 : frame->header.dlc;
+                memcpy(s->data, frame->buffer, s->dlc);
+            }
+        }
+        heartbeat_t *hb = heartbeat_get(key, true);
+        if (hb != NULL) {
+            if (hb->frames > 0 && t - hb->last_us > hb->max_gap_us) {
+                hb->max_gap_us = (uint32_t)(t - hb->last_us);
+            }
+            hb->frames++;
+            hb->last_us = t;
+        }
+        return;
+    }
+    
+    if (is_new) {
+        record_anomaly(FUZZ_ANOMALY_NEW_ID, key, 0, t);
+    }
+    heartbeat_t *hb = heartbeat_get(key, false);
+    if (hb != NULL) {
+        hb->last_us = t;
+        hb->missing = false;
+    }
+}
+
+/**
+ * @brief End of learning: keep only periodic IDs as heartbeats
+ */
+static void fuzz_finish_learning(int64_t now)
+{
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < s_fuzz.hb_count; i++) {
+        heartbeat_t *hb = &s_fuzz.hb[i];
+        if (hb->frames >= 3 && hb->max_gap_us <= FUZZ_HEARTBEAT_MAX_GAP_US) {
+            s_fuzz.hb[n++] = *hb;
+        }
+    }
+    s_fuzz.hb_count = n;
+    s_fuzz.learning = false;
+    s_fuzz.send_start_us = now;
+    ESP_LOGI(TAG, "Learned %lu IDs, %lu periodic; fuzzing with seed 0x%08lX",
+             (unsigned long)s_fuzz.baseline_ids, (unsigned long)n, (unsigned long)s_fuzz.cfg.seed);
+}
+
+/**
+ * @brief Check heartbeats and the controller error counters
+ */
+static void fuzz_check(int64_t now)
+{
+    for (uint32_t i = 0; i < s_fuzz.hb_count; i++) {
+        heartbeat_t *hb = &s_fuzz.hb[i];
+        int64_t gap = now - hb->last_us;
+        if (!hb->missing && gap > 3 * (int64_t)hb->max_gap_us + 10000) {
+            hb->missing = true;
+            record_anomaly(FUZZ_ANOMALY_MISSING, hb->key, (uint32_t)(gap / 1000), now);
+        }
+    }
+    
+    twai_node_status_t status;
+    twai_node_record_t record;
+    if (twai_node_get_info(can_tx_get_node(), &status, &record) != ESP_OK) {
+        return;
+    }
+    if (record.bus_err_num > s_fuzz.bus_errors) {
+        record_anomaly(FUZZ_ANOMALY_BUS_ERRORS, 0, record.bus_err_num - s_fuzz.bus_errors, now);
+    }
+    s_fuzz.bus_errors = record.bus_err_num;
+    if (status.state != s_fuzz.state && status.state != TWAI_ERROR_ACTIVE) {
+        record_anomaly(FUZZ_ANOMALY_STATE, 0, status.state, now);
+    }
+    s_fuzz.state = status.state;
+}
+
+/**
+ * @brief Send the frames due at the configured rate
+ *
+ * @return false when the frame count has been reached
+ */
+static bool fuzz_send(int64_t now, uint32_t fps)
+{
+    uint64_t due = (uint64_t)(now - s_fuzz.send_start_us) * fps / 1000000;
+    
+    for (int burst = 0; burst < FUZZ_BURST && s_fuzz.sent < due; burst++) {
+        if (s_fuzz.cfg.count != 0 && s_fuzz.sent >= s_fuzz.cfg.count) {
+            return false;
+        }
+        fuzz_frame_t f;
+        fuzz_generate(&s_fuzz.cfg, s_fuzz.cfg.first_seq + s_fuzz.sent, &f);
+        twai_frame_t frame = {
+            .header = {
+                .id = f.id,
+                .ide = f.ext,
+                .dlc = f.dlc,
+            },
+            .buffer = f.data,
+            .buffer_len = f.dlc,
+        };
+        if (can_tx_send(&frame) != ESP_OK) {
+            // TX pool full: the same frame is retried on the next pass
+            s_fuzz.tx_full++;
+            break;
+        }
+        portENTER_CRITICAL(&s_fuzz_mux);
+        s_fuzz.log[s_fuzz.log_written++ % FUZZ_LOG_LEN] = f;
+        s_fuzz.sent++;
+        portEXIT_CRITICAL(&s_fuzz_mux);
+    }
+    return s_fuzz.cfg.count == 0 || s_fuzz.sent < s_fuzz.cfg.count;
+}
+
+/**
+ * @brief Fuzzer task: learns the bus, generates frames, watches the RX bus "fuzz" subscriber
+ */
+static void fuzz_task(void *arg)
+{
+    uint32_t bitrate;
+    if (!bridge_config_get_bitrate(&bitrate) || bitrate == 0) {
+        bitrate = 500000;
+    }
+    // Average frame: header plus half the maximum payload, with stuff bits
+    uint32_t frame_bits = (s_fuzz.cfg.ext ? 67 : 47) + 32 + 16;
+    uint32_t fps = (uint32_t)((uint64_t)bitrate * s_fuzz.cfg.bus_load_pct / 100 / frame_bits);
+    
+    twai_node_status_t status;
+    twai_node_record_t record;
+    if (twai_node_get_info(can_tx_get_node(), &status, &record) == ESP_OK) {
+        s_fuzz.bus_errors = record.bus_err_num;
+        s_fuzz.state = status.state;
+    }
+    
+    while (s_fuzz.running) {
+        const rx_bus_frame_t *rx_frame;
+        while ((rx_frame = rx_bus_receive(s_fuzz.sub, 0)) != NULL) {
+            fuzz_handle_frame(rx_frame);
+            rx_bus_release(rx_frame);
+        }
+        
+        int64_t now = esp_timer_get_time();
+        if (s_fuzz.learning) {
+            if (now >= s_fuzz.learn_end_us) {
+                fuzz_finish_learning(now);
+            }
+        } else {
+            fuzz_check(now);
+            if (!fuzz_send(now, fps)) {
+                break;
+            }
+        }
+        vTaskDelay(1);
+    }
+    
+    s_fuzz.end_us = esp_timer_get_time();
+    rx_bus_unsubscribe(s_fuzz.sub);
+    s_fuzz.sub = NULL;
+    ESP_LOGI(TAG, "Fuzzing stopped: %lu frames, %lu anomalies", (unsigned long)s_fuzz.sent,
+             (unsigned long)s_fuzz.anomaly_count);
+    
+    s_fuzz.running = false;
+    xSemaphoreGive(s_fuzz.done_sem);
+    vTaskDelete(NULL);
+}
+
+void fuzz_default_config(fuzz_config_t *config)
+{
+    *config = (fuzz_config_t) {
+        .gen = FUZZ_GEN_RANDOM,
+        .ext = false,
+        .first_id = 0x000,
+        .last_id = TWAI_STD_ID_MASK,
+        .bus_load_pct = 50,
+        .seed = esp_random(),
+        .first_seq = 0,
+        .count = 0,
+        .learn_ms = 2000,
+        .stop_on_anomaly = false,
+    };
+}
+
+esp_err_t fuzz_start(const fuzz_config_t *config)
+{
+    if (s_fuzz.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    uint32_t id_mask = config->ext ? TWAI_EXT_ID_MASK : TWAI_STD_ID_MASK;
+    if (config->first_id > config->last_id || config->last_id > id_mask ||
+        config->bus_load_pct == 0 || config->bus_load_pct > 100) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_fuzz.done_sem == NULL) {
+        s_fuzz.done_sem = xSemaphoreCreateBinary();
+        if (s_fuzz.done_sem == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    // A run that ended on its own left the semaphore given
+    xSemaphoreTake(s_fuzz.done_sem, 0);
+    
+    esp_err_t ret = rx_bus_subscribe("fuzz", FUZZ_RING_DEPTH, &s_fuzz.sub);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    portENTER_CRITICAL(&s_fuzz_mux);
+    s_fuzz.cfg = *config;
+    s_fuzz.learning = true;
+    s_fuzz.capture_seeds = config->gen == FUZZ_GEN_MUTATE && s_fuzz.seed_count == 0;
+    s_fuzz.learn_end_us = esp_timer_get_time() + (int64_t)config->learn_ms * 1000;
+    s_fuzz.send_start_us = 0;
+    s_fuzz.end_us = 0;
+    s_fuzz.sent = 0;
+    s_fuzz.tx_full = 0;
+    s_fuzz.baseline_ids = 0;
+    memset(s_fuzz.std_seen, 0, sizeof(s_fuzz.std_seen));
+    memset(s_fuzz.ext_bloom, 0, sizeof(s_fuzz.ext_bloom));
+    s_fuzz.hb_count = 0;
+    s_fuzz.log_written = 0;
+    s_fuzz.anomaly_count = 0;
+    s_fuzz.running = true;
+    portEXIT_CRITICAL(&s_fuzz_mux);
+    
+    // Below the transport task: forwarding keeps priority over generation
+    if (xTaskCreate(fuzz_task, "fuzz", 4096, NULL, 9, NULL) != pdPASS) {
+        s_fuzz.running = false;
+        rx_bus_unsubscribe(s_fuzz.sub);
+        s_fuzz.sub = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t fuzz_stop(void)
+{
+    if (!s_fuzz.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    s_fuzz.running = false;
+    if (xSemaphoreTake(s_fuzz.done_sem, pdMS_TO_TICKS(2000)) != pdTRUE) {
+        ESP_LOGE(TAG, "Fuzz task did not stop");
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+esp_err_t fuzz_add_seed(const twai_frame_t *frame)
+{
+    // The seed table is read by the generator without locking
+    if (s_fuzz.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (s_fuzz.seed_count == FUZZ_MAX_SEEDS) {
+        return ESP_ERR_NO_MEM;
+    }
+    fuzz_frame_t *s = &s_fuzz.seeds[s_fuzz.seed_count++];
+    memset(s, 0, sizeof(*s));
+    s->id = frame->header.id;
+    s->ext = frame->header.ide;
+    s->dlc = frame->header.dlc > 8 ? 8 : frame->header.dlc;
+    if (!frame->header.rtr) {
+        memcpy(s->data, frame->buffer, s->dlc);
+    }
+    return ESP_OK;
+}
+
+void fuzz_clear_seeds(void)
+{
+    if (!s_fuzz.running) {
+        s_fuzz.seed_count = 0;
+    }
+}
+
+void fuzz_get_status(fuzz_status_t *out)
+{
+    portENTER_CRITICAL(&s_fuzz_mux);
+    out->running = s_fuzz.running;
+    out->learning = s_fuzz.learning;
+    out->config = s_fuzz.cfg;
+    out->sent = s_fuzz.sent;
+    out->tx_full = s_fuzz.tx_full;
+    out->baseline_ids = s_fuzz.baseline_ids;
+    out->heartbeats = s_fuzz.hb_count;
+    out->seeds = s_fuzz.seed_count;
+    out->anomalies = s_fuzz.anomaly_count;
+    int64_t end_us = s_fuzz.running ? esp_timer_get_time() : s_fuzz.end_us;
+    int64_t span = s_fuzz.send_start_us ? end_us - s_fuzz.send_start_us : 0;
+    out->fps = span > 0 ? (uint32_t)((uint64_t)s_fuzz.sent * 1000000 / span) : 0;
+    portEXIT_CRITICAL(&s_fuzz_mux);
+}
+
+bool fuzz_get_anomaly(uint32_t index, fuzz_anomaly_t *out)
+{
+    portENTER_CRITICAL(&s_fuzz_mux);
+    bool found = index < s_fuzz.anomaly_count && index < FUZZ_MAX_ANOMALIES;
+    if (found) {
+        *out = s_fuzz.anomalies[index];
+    }
+    portEXIT_CRITICAL(&s_fuzz_mux);
+    return found;
+}
+
+/**
+ * @brief Print a frame in SLCAN notation
+ */
+static void print_frame(const fuzz_frame_t *f)
+{
+    if (f->ext) {
+        printf("T%08lX%u", (unsigned long)f->id, f->dlc);
+    } else {
+        printf("t%03lX%u", (unsigned long)f->id, f->dlc);
+    }
+    for (uint8_t i = 0; i < f->dlc; i++) {
+        printf("%02X", f->data[i]);
+    }
+}
+
+/**
+ * @brief Print one anomaly line
+ */
+static void print_anomaly(uint32_t index, const fuzz_anomaly_t *a)
+{
+    printf("  %lu %s", (unsigned long)index, s_anomaly_names[a->kind]);
+    if (a->kind == FUZZ_ANOMALY_NEW_ID || a->kind == FUZZ_ANOMALY_MISSING) {
+        printf(a->ext ? " %08lX" : " %03lX", (unsigned long)a->id);
+    }
+    if (a->kind != FUZZ_ANOMALY_NEW_ID) {
+        printf(" %lu%s", (unsigned long)a->detail, a->kind == FUZZ_ANOMALY_MISSING ? " ms" : "");
+    }
+    printf(" seq %lu time %lld\n", (unsigned long)a->seq, (long long)a->time_us);
+}
+
+/**
+ * @brief "fuzz" command handler
+ */
+static int fuzz_cmd_handler(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&fuzz_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, fuzz_args.end, argv[0]);
+        return 1;
+    }
+    
+    const char *action = fuzz_args.action->count ? fuzz_args.action->sval[0] : "show";
+    
+    if (strcmp(action, "start") == 0) {
+        fuzz_config_t cfg;
+        fuzz_default_config(&cfg);
+        if (fuzz_args.gen->count) {
+            const char *g = fuzz_args.gen->sval[0];
+            for (cfg.gen = 0; cfg.gen <= FUZZ_GEN_SWEEP && strcmp(g, s_gen_names[cfg.gen]) != 0; cfg.gen++) {
+            }
+            if (cfg.gen > FUZZ_GEN_SWEEP) {
+                printf("fuzz: unknown generator '%s'\n", g);
+                return 1;
+            }
+        }
+        if (fuzz_args.ext->count) {
+            cfg.ext = true;
+            cfg.last_id = TWAI_EXT_ID_MASK;
+        }
+        if (fuzz_args.first->count) {
+            cfg.first_id = fuzz_args.first->ival[0];
+        }
+        if (fuzz_args.last->count) {
+            cfg.last_id = fuzz_args.last->ival[0];
+        }
+        if (fuzz_args.load->count) {
+            cfg.bus_load_pct = fuzz_args.load->ival[0];
+        }
+        if (fuzz_args.seed->count) {
+            cfg.seed = strtoul(fuzz_args.seed->sval[0], NULL, 0);
+        }
+        if (fuzz_args.seq->count) {
+            cfg.first_seq = fuzz_args.seq->ival[0];
+        }
+        if (fuzz_args.count->count) {
+            cfg.count = fuzz_args.count->ival[0];
+        }
+        if (fuzz_args.learn->count) {
+            cfg.learn_ms = fuzz_args.learn->ival[0];
+        }
+        cfg.stop_on_anomaly = fuzz_args.stop->count > 0;
+        
+        esp_err_t ret = fuzz_start(&cfg);
+        if (ret != ESP_OK) {
+            printf("fuzz start: %s\n", esp_err_to_name(ret));
+            return 1;
+        }
+    } else if (strcmp(action, "stop") == 0) {
+        if (fuzz_stop() != ESP_OK) {
+            printf("fuzz: not running\n");
+            return 1;
+        }
+    } else if (strcmp(action, "seed") == 0) {
+        uint8_t data[8];
+        twai_frame_t frame = {.buffer = data, .buffer_len = sizeof(data)};
+        if (fuzz_args.arg->count == 0 ||
+            slcan_parse_frame(fuzz_args.arg->sval[0], strlen(fuzz_args.arg->sval[0]), &frame) != ESP_OK) {
+            printf("fuzz seed: need an SLCAN frame, e.g. t1A0400FF1234\n");
+            return 1;
+        }
+        esp_err_t ret = fuzz_add_seed(&frame);
+        if (ret != ESP_OK) {
+            printf("fuzz seed: %s\n", esp_err_to_name(ret));
+            return 1;
+        }
+    } else if (strcmp(action, "clear") == 0) {
+        fuzz_clear_seeds();
+    } else if (strcmp(action, "log") == 0) {
+        fuzz_anomaly_t a;
+        uint32_t index = fuzz_args.arg->count ? strtoul(fuzz_args.arg->sval[0], NULL, 0) : 0;
+        if (!fuzz_get_anomaly(index, &a)) {
+            printf("fuzz log: no anomaly %lu\n", (unsigned long)index);
+            return 1;
+        }
+        print_anomaly(index, &a);
+        for (uint8_t i = 0; i < a.n_frames; i++) {
+            printf("  %lu ", (unsigned long)a.frames[i].seq);
+            print_frame(&a.frames[i]);
+            printf("\n");
+        }
+        if (a.n_frames > 0) {
+            fuzz_status_t st;
+            fuzz_get_status(&st);
+            printf("replay: fuzz start -g %s%s -f 0x%lX -l 0x%lX -S 0x%08lX -q %lu -n %u\n",
+                   s_gen_names[st.config.gen], st.config.ext ? " -x" : "",
+                   (unsigned long)st.config.first_id, (unsigned long)st.config.last_id,
+                   (unsigned long)a.seed, (unsigned long)a.frames[0].seq, a.n_frames);
+        }
+        return 0;
+    } else if (strcmp(action, "show") != 0) {
+        printf("fuzz: unknown action '%s'\n", action);
+        return 1;
+    }
+    
+    fuzz_status_t st;
+    fuzz_get_status(&st);
+    printf("fuzz: %s (%s), seed 0x%08lX, sent %lu (%lu/s), tx full %lu, anomalies %lu, "
+           "baseline %lu IDs, %lu heartbeats, %lu seeds\n",
+           st.running ? (st.learning ? "learning" : "running") : "stopped", s_gen_names[st.config.gen],
+           (unsigned long)st.config.seed, (unsigned long)st.sent, (unsigned long)st.fps,
+           (unsigned long)st.tx_full, (unsigned long)st.anomalies, (unsigned long)st.baseline_ids,
+           (unsigned long)st.heartbeats, (unsigned long)st.seeds);
+    fuzz_anomaly_t a;
+    for (uint32_t i = 0; fuzz_get_anomaly(i, &a); i++) {
+        print_anomaly(i, &a);
+    }
+    return 0;
+}
+
+void fuzz_register_commands(void)
+{
+    fuzz_args.action = arg_str0(NULL, NULL, "<start|stop|show|seed|clear|log>", "Action (default: show)");
+    fuzz_args.arg = arg_str0(NULL, NULL, "<frame|n>", "seed: SLCAN frame; log: anomaly index");
+    fuzz_args.gen = arg_str0("g", "gen", "<random|mutate|sweep>", "Generator (default: random)");
+    fuzz_args.ext = arg_lit0("x", "ext", "29-bit IDs");
+    fuzz_args.first = arg_int0("f", "first", "<id>", "First ID (default: 0)");
+    fuzz_args.last = arg_int0("l", "last", "<id>", "Last ID (default: largest)");
+    fuzz_args.load = arg_int0("b", "load", "<%>", "Bus load of the fuzz frames (default: 50)");
+    fuzz_args.seed = arg_str0("S", "seed", "<seed>", "Run seed (default: random)");
+    fuzz_args.seq = arg_int0("q", "seq", "<n>", "First sequence number (replay)");
+    fuzz_args.count = arg_int0("n", "count", "<n>", "Frames to send (default: until stopped)");
+    fuzz_args.learn = arg_int0("L", "learn", "<ms>", "Bus learning time before sending (default: 2000)");
+    fuzz_args.stop = arg_lit0("s", "stop", "Stop at the first anomaly");
+    fuzz_args.end = arg_end(12);
+    
+    const esp_console_cmd_t fuzz_cmd = {
+        .command = "fuzz",
+        .help = "On-device CAN fuzzing with anomaly detection\n"
+        "  fuzz start -g mutate -b 30 -s     # mutate frames captured while learning\n"
+        "  fuzz seed t7E0802100300000000000  # add a seed frame\n"
+        "  fuzz log 0                        # frames sent before anomaly 0, replay command",
+        .hint = NULL,
+        .func = &fuzz_cmd_handler,
+        .argtable = &fuzz_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&fuzz_cmd));
+}
@@ -0,0 +1,186 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_twai.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief On-device CAN fuzzing engine
+ *
+ * Frames are generated on the device and fed straight into the TX pool at a
+ * configured bus load, so the rate is limited by the bus instead of the host
+ * link. Generators:
+ *  - random: random ID in a range, random DLC and payload
+ *  - mutate: bit flips, byte replacements, boundary values and DLC changes
+ *    applied to seed frames (added by the host or captured from the bus)
+ *  - sweep:  every ID of a range with every DLC (0..8), random payload
+ *
+ * Frame n of a run is a pure function of the run seed and n (counter-based
+ * generator), so any sequence can be reproduced exactly with the seed and
+ * the sequence numbers of an anomaly.
+ *
+ * Before sending, the engine learns the bus for a while: the IDs present
+ * and the periodic ("heartbeat") IDs with their longest gap. While fuzzing,
+ * the RX path reports anomalies: a new ID, a heartbeat ID missing for three
+ * times its longest gap, bus errors or a controller state change. Each
+ * anomaly keeps the seed, the sequence number and the last frames sent.
+ */
+
+/** @brief Maximum seed frames */
+#define FUZZ_MAX_SEEDS              32
+
+/** @brief Maximum recorded anomalies */
+#define FUZZ_MAX_ANOMALIES          8
+
+/** @brief Frames sent before an anomaly kept with it */
+#define FUZZ_ANOMALY_FRAMES         16
+
+/**
+ * @brief Frame generator
+ */
+typedef enum {
+    FUZZ_GEN_RANDOM = 0,
+    FUZZ_GEN_MUTATE,
+    FUZZ_GEN_SWEEP,
+} fuzz_gen_t;
+
+/**
+ * @brief Anomaly kind
+ */
+typedef enum {
+    FUZZ_ANOMALY_NEW_ID = 0,    /**< ID not seen while learning */
+    FUZZ_ANOMALY_MISSING,       /**< Heartbeat ID stopped (detail: gap in ms) */
+    FUZZ_ANOMALY_BUS_ERRORS,    /**< Bus error counter increased (detail: new errors) */
+    FUZZ_ANOMALY_STATE,         /**< Controller left error-active (detail: twai_error_state_t) */
+} fuzz_anomaly_kind_t;
+
+/**
+ * @brief Fuzzing run parameters
+ */
+typedef struct {
+    fuzz_gen_t gen;             /**< Generator */
+    bool ext;                   /**< 29-bit IDs (random, sweep) */
+    uint32_t first_id;          /**< First ID (random, sweep) */
+    uint32_t last_id;           /**< Last ID (random, sweep) */
+    uint8_t bus_load_pct;       /**< Bus load of the generated frames (1..100) */
+    uint32_t seed;              /**< Run seed */
+    uint32_t first_seq;         /**< Sequence number of the first frame (replay) */
+    uint32_t count;             /**< Frames to send (0: until stopped) */
+    uint32_t learn_ms;          /**< Bus learning time before sending */
+    bool stop_on_anomaly;       /**< Stop at the first anomaly */
+} fuzz_config_t;
+
+/**
+ * @brief Logged frame
+ */
+typedef struct {
+    uint32_t seq;               /**< Sequence number */
+    uint32_t id;                /**< Identifier */
+    bool ext;                   /**< 29-bit identifier */
+    uint8_t dlc;                /**< DLC */
+    uint8_t data[8];            /**< Payload */
+} fuzz_frame_t;
+
+/**
+ * @brief Recorded anomaly
+ */
+typedef struct {
+    fuzz_anomaly_kind_t kind;
+    uint32_t id;                /**< ID concerned (new, missing) */
+    bool ext;                   /**< 29-bit ID */
+    uint32_t detail;            /**< Kind-specific value */
+    uint32_t seed;              /**< Run seed */
+    uint32_t seq;               /**< Sequence number of the next frame when detected */
+    int64_t time_us;            /**< Detection time (host timebase) */
+    uint8_t n_frames;           /**< Frames in the log */
+    fuzz_frame_t frames[FUZZ_ANOMALY_FRAMES];   /**< Last frames sent, oldest first */
+} fuzz_anomaly_t;
+
+/**
+ * @brief Fuzzing status
+ */
+typedef struct {
+    bool running;               /**< Run in progress */
+    bool learning;              /**< Still learning the bus */
+    fuzz_config_t config;       /**< Parameters of the current or last run */
+    uint32_t sent;              /**< Frames sent */
+    uint32_t tx_full;           /**< Send attempts deferred because the TX pool was full */
+    uint32_t fps;               /**< Frames per second over the run */
+    uint32_t baseline_ids;      /**< IDs seen while learning */
+    uint32_t heartbeats;        /**< Periodic IDs watched */
+    uint32_t seeds;             /**< Seed frames */
+    uint32_t anomalies;         /**< Anomalies detected (recorded: up to FUZZ_MAX_ANOMALIES) */
+} fuzz_status_t;
+
+/**
+ * @brief Fill a configuration with defaults (random 11-bit IDs, 50% load, 2 s learning)
+ */
+void fuzz_default_config(fuzz_config_t *config);
+
+/**
+ * @brief Start a run (clears the anomalies)
+ *
+ * @param config Run parameters
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if running, ESP_ERR_INVALID_ARG, ESP_ERR_NO_MEM
+ */
+esp_err_t fuzz_start(const fuzz_config_t *config);
+
+/**
+ * @brief Stop the run
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not running, ESP_ERR_TIMEOUT
+ */
+esp_err_t fuzz_stop(void);
+
+/**
+ * @brief Add a seed frame for the mutate generator
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if running, ESP_ERR_NO_MEM if the seed table is full
+ */
+esp_err_t fuzz_add_seed(const twai_frame_t *frame);
+
+/**
+ * @brief Remove all seed frames (the next run captures seeds while learning)
+ */
+void fuzz_clear_seeds(void);
+
+/**
+ * @brief Generate frame seq of a run without sending it
+ *
+ * @param config Run parameters (generator, ID range, seed)
+ * @param seq Sequence number
+ * @param out Output frame
+ */
+void fuzz_generate(const fuzz_config_t *config, uint32_t seq, fuzz_frame_t *out);
+
+/**
+ * @brief Get the fuzzing status
+ */
+void fuzz_get_status(fuzz_status_t *out);
+
+/**
+ * @brief Get a recorded anomaly
+ *
+ * @return true if the anomaly exists
+ */
+bool fuzz_get_anomaly(uint32_t index, fuzz_anomaly_t *out);
+
+/**
+ * @brief Register the 'fuzz' extension command
+ */
+void fuzz_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
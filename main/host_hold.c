@@ -0,0 +1,109 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "host_hold.h"
+#include "clock_sync.h"
+#include "slcan_protocol.h"
+
+// Classic CAN payload; longer frames are truncated as in the SLCAN output
+#define HOLD_DATA_LEN           8
+
+// Held frame, unformatted (24 bytes)
+typedef struct {
+    int64_t timestamp_us;
+    uint32_t id;
+    uint8_t dlc;
+    uint8_t ide : 1;
+    uint8_t rtr : 1;
+    uint8_t data[HOLD_DATA_LEN];
+} held_frame_t;
+
+// Ring of held frames; 'head' is the oldest
+static struct {
+#if CONFIG_CAN_BRIDGE_HOST_HOLD_FRAMES > 0
+    held_frame_t frames[CONFIG_CAN_BRIDGE_HOST_HOLD_FRAMES];
+#endif
+    uint32_t head;
+    uint32_t count;
+    uint32_t held;
+    uint32_t lost;
+    uint32_t flushed;
+} s_hold;
+
+static portMUX_TYPE s_hold_mux = portMUX_INITIALIZER_UNLOCKED;
+
+bool host_hold_push(const twai_frame_t *frame, int64_t timestamp_us)
+{
+#if CONFIG_CAN_BRIDGE_HOST_HOLD_FRAMES > 0
+    if (s_hold.count < CONFIG_CAN_BRIDGE_HOST_HOLD_FRAMES) {
+        held_frame_t *h = &s_hold.frames[(s_hold.head + s_hold.count) % CONFIG_CAN_BRIDGE_HOST_HOLD_FRAMES];
+        h->timestamp_us = timestamp_us;
+        h->id = frame->header.id;
+        h->dlc = frame->header.dlc;
+        h->ide = frame->header.ide;
+        h->rtr = frame->header.rtr;
+        size_t len = frame->buffer_len < HOLD_DATA_LEN ? frame->buffer_len : HOLD_DATA_LEN;
+        memcpy(h->data, frame->buffer, len);
+        
+        portENTER_CRITICAL(&s_hold_mux);
+        s_hold.count++;
+        s_hold.held++;
+        portEXIT_CRITICAL(&s_hold_mux);
+        return true;
+    }
+#endif
+    portENTER_CRITICAL(&s_hold_mux);
+    s_hold.lost++;
+    portEXIT_CRITICAL(&s_hold_mux);
+    return false;
+}
+
+uint32_t host_hold_count(void)
+{
+    return s_hold.count;
+}
+
+uint32_t host_hold_flush(void)
+{
+    uint32_t sent = 0;
+#if CONFIG_CAN_BRIDGE_HOST_HOLD_FRAMES > 0
+    while (s_hold.count > 0) {
+        held_frame_t *h = &s_hold.frames[s_hold.head];
+        twai_frame_t frame = {
+            .header.id = h->id,
+            .header.dlc = h->dlc,
+            .header.ide = h->ide,
+            .header.rtr = h->rtr,
+            .buffer = h->data,
+            .buffer_len = HOLD_DATA_LEN,
+        };
+        if (slcan_send_frame(&frame, clock_sync_to_host(h->timestamp_us)) != ESP_OK) {
+            break;
+        }
+        
+        portENTER_CRITICAL(&s_hold_mux);
+        s_hold.head = (s_hold.head + 1) % CONFIG_CAN_BRIDGE_HOST_HOLD_FRAMES;
+        s_hold.count--;
+        s_hold.flushed++;
+        portEXIT_CRITICAL(&s_hold_mux);
+        sent++;
+    }
+#endif
+    return sent;
+}
+
+void host_hold_get_status(host_hold_status_t *out)
+{
+    portENTER_CRITICAL(&s_hold_mux);
+    out->capacity = CONFIG_CAN_BRIDGE_HOST_HOLD_FRAMES;
+    out->count = s_hold.count;
+    out->held = s_hold.held;
+    out->lost = s_hold.lost;
+    out->flushed = s_hold.flushed;
+    portEXIT_CRITICAL(&s_hold_mux);
+}
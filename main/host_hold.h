@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_twai.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Frames held while no host is reading
+ *
+ * While the channel is open but the host has gone (see host_link_present()),
+ * received frames are copied here unformatted instead of being encoded for
+ * a link nobody drains. They are sent in order, before any newer frame, as
+ * soon as the host is back and the channel is open. When the buffer is full
+ * further frames are lost and the oldest are kept. Used by the transport
+ * task only.
+ */
+
+#ifndef CONFIG_CAN_BRIDGE_HOST_HOLD_FRAMES
+#define CONFIG_CAN_BRIDGE_HOST_HOLD_FRAMES 256
+#endif
+
+/**
+ * @brief Hold buffer status
+ */
+typedef struct {
+    uint32_t capacity;      /**< Buffer size in frames (0: holding disabled) */
+    uint32_t count;         /**< Frames waiting */
+    uint32_t held;          /**< Frames held since boot */
+    uint32_t lost;          /**< Frames lost with the buffer full */
+    uint32_t flushed;       /**< Held frames sent to the host */
+} host_hold_status_t;
+
+/**
+ * @brief Hold a frame
+ *
+ * @param frame Received frame
+ * @param timestamp_us esp_timer time of reception
+ * @return true if held, false if the buffer is full (the frame is lost)
+ */
+bool host_hold_push(const twai_frame_t *frame, int64_t timestamp_us);
+
+/**
+ * @brief Number of frames waiting
+ */
+uint32_t host_hold_count(void);
+
+/**
+ * @brief Send the held frames to the host
+ *
+ * Stops at the first frame that cannot be sent (host gone again), which
+ * stays held.
+ *
+ * @return Number of frames sent
+ */
+uint32_t host_hold_flush(void);
+
+/**
+ * @brief Get the hold buffer status
+ */
+void host_hold_get_status(host_hold_status_t *out);
+
+#ifdef __cplusplus
+}
+#endif
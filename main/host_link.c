@@ -0,0 +1,254 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <sys/select.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "host_link.h"
+#if CONFIG_ESP_CONSOLE_USB_CDC
+#include "esp_vfs_cdcacm.h"
+#elif CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+#include "driver/usb_serial_jtag.h"
+#include "driver/usb_serial_jtag_vfs.h"
+#elif CONFIG_ESP_CONSOLE_UART
+#include "driver/uart.h"
+#include "driver/uart_vfs.h"
+#endif
+
+static const char *TAG = "host_link";
+
+// A write taking longer than this (plus the time of its bytes at 115200 baud) means nobody reads
+#define STALL_BASE_US           100000
+#define STALL_US_PER_BYTE       100
+
+// Stalled writes in a row that make the host absent (a single slow write is not enough)
+#define STALL_LIMIT             3
+
+// While absent, one write per interval is let through to find out whether the host reads again
+#define PROBE_INTERVAL_US       1000000
+
+// Driver ring buffers with the direct transport
+#define DRIVER_BUFFER_SIZE      4096
+
+// Host presence
+static struct {
+    volatile bool stalled;
+    uint32_t stall_run;
+    int64_t probe_us;
+    bool connected;
+    bool present;
+    int64_t since_us;
+    uint32_t absences;
+    uint32_t stalls;
+} s_link = {
+    .connected = true,
+    .present = true,
+};
+
+static portMUX_TYPE s_link_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Whether the console transport reports a host
+ */
+static bool link_connected(void)
+{
+#if CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+    // Start-of-frame packets seen recently: the USB host polls the port
+    return usb_serial_jtag_is_connected();
+#else
+    // The console CDC-ACM and UART drivers do not expose the line state, only stalls tell
+    return true;
+#endif
+}
+
+/**
+ * @brief Write to the transport fixed at build time
+ */
+static inline bool link_write(const void *data, size_t len)
+{
+#if CONFIG_CAN_BRIDGE_TRANSPORT_DRIVER && CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+    return usb_serial_jtag_write_bytes(data, len, pdMS_TO_TICKS(STALL_BASE_US / 1000)) == (int)len;
+#elif CONFIG_CAN_BRIDGE_TRANSPORT_DRIVER
+    return uart_write_bytes(CONFIG_ESP_CONSOLE_UART_NUM, data, len) == (int)len;
+#else
+    return fwrite(data, 1, len, stdout) == len && fflush(stdout) == 0;
+#endif
+}
+
+esp_err_t host_link_init(void)
+{
+    s_link.since_us = esp_timer_get_time();
+    fflush(stdout);
+    
+#if CONFIG_ESP_CONSOLE_USB_CDC
+    esp_vfs_dev_cdcacm_set_tx_line_endings(ESP_LINE_ENDINGS_LF);
+    esp_vfs_dev_cdcacm_set_rx_line_endings(ESP_LINE_ENDINGS_LF);
+#elif CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+    usb_serial_jtag_vfs_set_tx_line_endings(ESP_LINE_ENDINGS_LF);
+    usb_serial_jtag_vfs_set_rx_line_endings(ESP_LINE_ENDINGS_LF);
+#elif CONFIG_ESP_CONSOLE_UART
+    uart_vfs_dev_port_set_tx_line_endings(CONFIG_ESP_CONSOLE_UART_NUM, ESP_LINE_ENDINGS_LF);
+    uart_vfs_dev_port_set_rx_line_endings(CONFIG_ESP_CONSOLE_UART_NUM, ESP_LINE_ENDINGS_LF);
+#else
+    ESP_LOGW(TAG, "Unknown console, line endings left unchanged");
+#endif
+    
+#if CONFIG_CAN_BRIDGE_TRANSPORT_DRIVER
+    // Direct transport: install the console driver and move stdio onto it, so text and frames share one queue
+#if CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+    usb_serial_jtag_driver_config_t jtag_config = USB_SERIAL_JTAG_DRIVER_CONFIG_DEFAULT();
+    jtag_config.tx_buffer_size = DRIVER_BUFFER_SIZE;
+    esp_err_t ret = usb_serial_jtag_driver_install(&jtag_config);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    usb_serial_jtag_vfs_use_driver();
+#else
+    esp_err_t ret = uart_driver_install(CONFIG_ESP_CONSOLE_UART_NUM, DRIVER_BUFFER_SIZE, DRIVER_BUFFER_SIZE,
+                                        0, NULL, 0);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    uart_vfs_dev_use_driver(CONFIG_ESP_CONSOLE_UART_NUM);
+#endif
+#endif
+    
+    return ESP_OK;
+}
+
+const char *host_link_transport_name(void)
+{
+#if CONFIG_CAN_BRIDGE_TRANSPORT_DRIVER && CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+    return "usb-serial-jtag";
+#elif CONFIG_CAN_BRIDGE_TRANSPORT_DRIVER
+    return "uart";
+#else
+    return "stdio";
+#endif
+}
+
+esp_err_t host_link_write(const void *data, size_t len)
+{
+    if (!host_link_present()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    int64_t start_us = esp_timer_get_time();
+    bool ok = link_write(data, len);
+    int64_t end_us = esp_timer_get_time();
+    bool stalled = end_us - start_us > STALL_BASE_US + (int64_t)len * STALL_US_PER_BYTE;
+    
+    portENTER_CRITICAL(&s_link_mux);
+    if (stalled) {
+        s_link.stalls++;
+        s_link.stall_run++;
+        s_link.probe_us = end_us + PROBE_INTERVAL_US;
+    } else {
+        // A write in time (a probe while absent): the host reads
+        s_link.stall_run = 0;
+    }
+    portEXIT_CRITICAL(&s_link_mux);
+    s_link.stalled = s_link.stall_run >= STALL_LIMIT;
+    if (!stalled) {
+        host_link_present();
+    }
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+bool host_link_present(void)
+{
+    bool connected = link_connected();
+    if (connected != s_link.connected) {
+        // USB host back (or gone): earlier stalls say nothing about the new connection
+        portENTER_CRITICAL(&s_link_mux);
+        s_link.connected = connected;
+        s_link.stall_run = 0;
+        portEXIT_CRITICAL(&s_link_mux);
+        s_link.stalled = false;
+    }
+    
+    bool present = !s_link.stalled && connected;
+    if (present != s_link.present) {
+        portENTER_CRITICAL(&s_link_mux);
+        if (present != s_link.present) {
+            s_link.present = present;
+            s_link.since_us = esp_timer_get_time();
+            if (!present) {
+                s_link.absences++;
+            }
+        }
+        portEXIT_CRITICAL(&s_link_mux);
+    }
+    // Absent after stalls: let a write through now and then, a listen-only host never sends a byte
+    return present || (connected && s_link.stalled && esp_timer_get_time() >= s_link.probe_us);
+}
+
+void host_link_on_rx(void)
+{
+    s_link.stall_run = 0;
+    if (s_link.stalled) {
+        s_link.stalled = false;
+        host_link_present();
+    }
+}
+
+esp_err_t host_link_read(void *data, size_t len, uint32_t timeout_ms)
+{
+    uint8_t *out = data;
+    size_t got = 0;
+    int64_t deadline_us = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    
+    while (got < len) {
+        size_t n = fread(&out[got], 1, len - got, stdin);
+        if (n > 0) {
+            got += n;
+            host_link_on_rx();
+            deadline_us = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+            continue;
+        }
+        // Non-blocking console: no data is reported as end of file
+        clearerr(stdin);
+        if (esp_timer_get_time() > deadline_us) {
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(1);
+    }
+    return ESP_OK;
+}
+
+bool host_link_wait_rx(uint32_t timeout_ms)
+{
+    int fd = fileno(stdin);
+    fd_set rfds;
+    FD_ZERO(&rfds);
+    FD_SET(fd, &rfds);
+    struct timeval tv = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_usec = (timeout_ms % 1000) * 1000,
+    };
+    int n = select(fd + 1, &rfds, NULL, NULL, &tv);
+    if (n < 0) {
+        // No select() on this console: poll
+        vTaskDelay(1);
+        return true;
+    }
+    return n > 0;
+}
+
+void host_link_get_status(host_link_status_t *out)
+{
+    host_link_present();
+    portENTER_CRITICAL(&s_link_mux);
+    out->present = s_link.present;
+    out->since_us = s_link.since_us;
+    out->absences = s_link.absences;
+    out->stalls = s_link.stalls;
+    portEXIT_CRITICAL(&s_link_mux);
+}
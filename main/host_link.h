@@ -0,0 +1,118 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Raw byte access to the host link (the console USB CDC / USB-Serial-JTAG / UART)
+ *
+ * SLCAN is line-based text, but bulk transfers (capture export, binary
+ * streams) carry arbitrary bytes. host_link_init() turns off the console
+ * VFS line-ending translation in both directions so binary data passes
+ * unmodified; SLCAN itself only uses '\r' and is not affected.
+ *
+ * The link also tracks whether a host is there to read. With the
+ * USB-Serial-JTAG console the host is absent while the USB host is not
+ * polling the port; with any console it becomes absent when several writes
+ * in a row stall (nobody drains the USB or UART buffer). It is present again
+ * when the host sends a byte, when the USB connection comes back, or when a
+ * probe succeeds: while absent, one write per second is let through, and if
+ * it completes in time the host reads again (a listen-only host never sends
+ * anything). Otherwise writes return at once instead of blocking, and the
+ * frame and record producers skip formatting altogether.
+ */
+
+/**
+ * @brief Host link status
+ */
+typedef struct {
+    bool present;               /**< A host is reading */
+    int64_t since_us;           /**< Time of the last presence change */
+    uint32_t absences;          /**< Present to absent changes */
+    uint32_t stalls;            /**< Writes that took longer than the stall limit */
+} host_link_status_t;
+
+/**
+ * @brief Disable console line-ending translation
+ *
+ * With CONFIG_CAN_BRIDGE_TRANSPORT_DRIVER this also installs the console
+ * driver, which host_link_write() then writes to directly.
+ *
+ * @return ESP_OK on success, error code of the driver install otherwise
+ */
+esp_err_t host_link_init(void);
+
+/**
+ * @brief Write raw bytes to the host
+ *
+ * Blocks until all bytes have been handed to the console driver, through
+ * stdio or directly depending on the transport chosen at build time.
+ *
+ * @param data Bytes to write
+ * @param len Number of bytes
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no host is present, ESP_FAIL on write error
+ */
+esp_err_t host_link_write(const void *data, size_t len);
+
+/**
+ * @brief Read raw bytes from the host
+ *
+ * Reads the input the SLCAN command lines come from, so it must only be
+ * called from a command handler (the task that reads the lines).
+ *
+ * @param data Output buffer
+ * @param len Number of bytes to read
+ * @param timeout_ms Longest gap between received bytes
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT if the host stopped sending
+ */
+esp_err_t host_link_read(void *data, size_t len, uint32_t timeout_ms);
+
+/**
+ * @brief Wait until the host has sent something
+ *
+ * Blocks in select() on the console input, so the caller wakes up when the
+ * bytes arrive rather than at its next poll. Consoles without select()
+ * support fall back to a one-tick delay.
+ *
+ * @param timeout_ms Longest wait
+ * @return true if input may be available, false on timeout
+ */
+bool host_link_wait_rx(uint32_t timeout_ms);
+
+/**
+ * @brief Name of the transport chosen at build time ("stdio", "usb-serial-jtag", "uart")
+ */
+const char *host_link_transport_name(void);
+
+/**
+ * @brief Check whether a host is reading the link
+ *
+ * @return true if present, or absent but due for a probe write
+ */
+bool host_link_present(void);
+
+/**
+ * @brief Note a byte received from the host: the host is present
+ */
+void host_link_on_rx(void);
+
+/**
+ * @brief Get the host link status
+ */
+void host_link_get_status(host_link_status_t *out);
+
+#ifdef __cplusplus
+}
+#endif
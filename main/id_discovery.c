@@ -0,0 +1,360 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "id_discovery.h"
+#include "host_link.h"
+#include "slcan_protocol.h"
+#include "clock_sync.h"
+
+static const char *TAG = "id_discovery";
+
+#define TABLE_SIZE              CONFIG_CAN_BRIDGE_DISCOVERY_MAX_IDS
+
+// 29-bit Bloom filter: 8192 bits, 3 hashes (about 1% false positives at 700 IDs)
+#define BLOOM_BITS_LOG2         13
+#define BLOOM_BITS              (1U << BLOOM_BITS_LOG2)
+
+// Summary records are split into lines of at most this many IDs
+#define SUMMARY_IDS_PER_LINE    16
+
+/**
+ * @brief Rate counters of one identifier
+ */
+typedef struct {
+    uint32_t key;
+    uint32_t total;
+    uint32_t period;
+    int64_t first_us;
+} disc_entry_t;
+
+// Discovery state
+static struct {
+    volatile bool active;
+    uint32_t period_ms;
+    int64_t period_start_us;
+    uint32_t ids_std;
+    uint32_t ids_ext;
+    uint32_t ids_tracked;
+    uint32_t frames;
+    uint32_t period_frames;
+    uint32_t untracked;
+    uint32_t std_seen[2048 / 32];
+    uint32_t ext_bloom[BLOOM_BITS / 32];
+    bool used[TABLE_SIZE];
+    disc_entry_t table[TABLE_SIZE];
+} s_disc;
+
+static portMUX_TYPE s_disc_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/** @brief Command line arguments for discover command */
+static struct {
+    struct arg_str *action;
+    struct arg_int *period;
+    struct arg_lit *reset;
+    struct arg_end *end;
+} discover_args;
+
+/**
+ * @brief Test and set the seen bit(s) of an identifier
+ *
+ * @return true if the identifier was not seen before
+ */
+static bool seen_insert(uint32_t id, bool ext)
+{
+    if (!ext) {
+        uint32_t mask = 1U << (id & 31);
+        bool is_new = !(s_disc.std_seen[id >> 5] & mask);
+        s_disc.std_seen[id >> 5] |= mask;
+        return is_new;
+    }
+    
+    static const uint32_t mult[3] = {0x9E3779B1U, 0x85EBCA77U, 0xC2B2AE3DU};
+    bool is_new = false;
+    for (int k = 0; k < 3; k++) {
+        uint32_t bit = (id * mult[k]) >> (32 - BLOOM_BITS_LOG2);
+        uint32_t mask = 1U << (bit & 31);
+        if (!(s_disc.ext_bloom[bit >> 5] & mask)) {
+            is_new = true;
+            s_disc.ext_bloom[bit >> 5] |= mask;
+        }
+    }
+    return is_new;
+}
+
+/**
+ * @brief Find the rate entry of a key, inserting it if there is room
+ *
+ * @return Entry, or NULL if the key is new and the table is full
+ */
+static disc_entry_t *entry_get(uint32_t key, int64_t now)
+{
+    uint32_t i = (key * 2654435761U) % TABLE_SIZE;
+    
+    for (uint32_t n = 0; n < TABLE_SIZE; n++) {
+        if (!s_disc.used[i]) {
+            if (s_disc.ids_tracked == TABLE_SIZE) {
+                return NULL;
+            }
+            s_disc.used[i] = true;
+            s_disc.ids_tracked++;
+            memset(&s_disc.table[i], 0, sizeof(s_disc.table[i]));
+            s_disc.table[i].key = key;
+            s_disc.table[i].first_us = now;
+            return &s_disc.table[i];
+        }
+        if (s_disc.table[i].key == key) {
+            return &s_disc.table[i];
+        }
+        i = (i + 1) % TABLE_SIZE;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Format an identifier key in SLCAN notation
+ */
+static int format_key(char *out, size_t size, uint32_t key)
+{
+    if (key & ID_DISCOVERY_KEY_EXT) {
+        return snprintf(out, size, "%08lX", (unsigned long)(key & ~ID_DISCOVERY_KEY_EXT));
+    }
+    return snprintf(out, size, "%03lX", (unsigned long)key);
+}
+
+/**
+ * @brief Send the "first seen" record of a frame
+ */
+static void send_new_id(const rx_bus_frame_t *rx_frame, uint32_t key)
+{
+    const twai_frame_t *frame = &rx_frame->frame;
+    char line[64];
+    int pos = snprintf(line, sizeof(line), "Dn %lld ", (long long)clock_sync_to_host(rx_frame->timestamp_us));
+    pos += format_key(&line[pos], sizeof(line) - pos, key);
+    uint8_t dlc = frame->header.dlc > 8 ? 8 : frame->header.dlc;
+    pos += snprintf(&line[pos], sizeof(line) - pos, " %u ", dlc);
+    if (frame->header.rtr) {
+        line[pos++] = 'R';
+    } else {
+        for (uint8_t i = 0; i < dlc; i++) {
+            pos += snprintf(&line[pos], sizeof(line) - pos, "%02X", frame->buffer[i]);
+        }
+    }
+    line[pos++] = '\r';
+    host_link_write(line, pos);
+}
+
+/**
+ * @brief Send the rate summary of the elapsed period and start the next one
+ */
+static void send_summary(int64_t now)
+{
+    char line[64 + SUMMARY_IDS_PER_LINE * 21];
+    uint32_t period_ms = (uint32_t)((now - s_disc.period_start_us) / 1000);
+    
+    portENTER_CRITICAL(&s_disc_mux);
+    uint32_t ids = s_disc.ids_std + s_disc.ids_ext;
+    uint32_t frames = s_disc.period_frames;
+    s_disc.period_frames = 0;
+    s_disc.period_start_us = now;
+    portEXIT_CRITICAL(&s_disc_mux);
+    
+    int pos = snprintf(line, sizeof(line), "Ds %lld %lu %lu %lu", (long long)clock_sync_to_host(now),
+                       (unsigned long)period_ms, (unsigned long)ids, (unsigned long)frames);
+    uint32_t in_line = 0;
+    for (uint32_t i = 0; i < TABLE_SIZE; i++) {
+        portENTER_CRITICAL(&s_disc_mux);
+        bool used = s_disc.used[i];
+        uint32_t key = s_disc.table[i].key;
+        uint32_t count = s_disc.table[i].period;
+        s_disc.table[i].period = 0;
+        portEXIT_CRITICAL(&s_disc_mux);
+        if (!used || count == 0) {
+            continue;
+        }
+        if (in_line == SUMMARY_IDS_PER_LINE) {
+            // Continuation lines repeat the header so each line stands alone
+            line[pos++] = '\r';
+            host_link_write(line, pos);
+            pos = snprintf(line, sizeof(line), "Ds %lld %lu %lu %lu", (long long)clock_sync_to_host(now),
+                           (unsigned long)period_ms, (unsigned long)ids, (unsigned long)frames);
+            in_line = 0;
+        }
+        line[pos++] = ' ';
+        pos += format_key(&line[pos], sizeof(line) - pos, key);
+        pos += snprintf(&line[pos], sizeof(line) - pos, ":%lu", (unsigned long)count);
+        in_line++;
+    }
+    line[pos++] = '\r';
+    host_link_write(line, pos);
+}
+
+void id_discovery_start(uint32_t period_ms, bool reset)
+{
+    portENTER_CRITICAL(&s_disc_mux);
+    if (reset) {
+        memset(s_disc.std_seen, 0, sizeof(s_disc.std_seen));
+        memset(s_disc.ext_bloom, 0, sizeof(s_disc.ext_bloom));
+        memset(s_disc.used, 0, sizeof(s_disc.used));
+        s_disc.ids_std = 0;
+        s_disc.ids_ext = 0;
+        s_disc.ids_tracked = 0;
+        s_disc.frames = 0;
+        s_disc.untracked = 0;
+    }
+    s_disc.period_ms = period_ms;
+    s_disc.period_frames = 0;
+    s_disc.period_start_us = esp_timer_get_time();
+    s_disc.active = true;
+    portEXIT_CRITICAL(&s_disc_mux);
+    
+    ESP_LOGI(TAG, "Discovery on, summary every %lu ms", (unsigned long)period_ms);
+}
+
+void id_discovery_stop(void)
+{
+    s_disc.active = false;
+}
+
+bool id_discovery_is_active(void)
+{
+    return s_disc.active;
+}
+
+void id_discovery_process(const rx_bus_frame_t *rx_frame)
+{
+    // Records sent while the channel is closed or nobody reads it would be lost, and with them the IDs
+    if (!slcan_is_open() || !host_link_present()) {
+        return;
+    }
+    
+    const twai_frame_t *frame = &rx_frame->frame;
+    uint32_t id = frame->header.id;
+    bool ext = frame->header.ide;
+    uint32_t key = id | (ext ? ID_DISCOVERY_KEY_EXT : 0);
+    
+    portENTER_CRITICAL(&s_disc_mux);
+    bool is_new = seen_insert(id, ext);
+    if (is_new) {
+        if (ext) {
+            s_disc.ids_ext++;
+        } else {
+            s_disc.ids_std++;
+        }
+    }
+    disc_entry_t *e = entry_get(key, rx_frame->timestamp_us);
+    if (e != NULL) {
+        e->total++;
+        e->period++;
+    } else if (is_new) {
+        s_disc.untracked++;
+    }
+    s_disc.frames++;
+    s_disc.period_frames++;
+    portEXIT_CRITICAL(&s_disc_mux);
+    
+    if (is_new) {
+        send_new_id(rx_frame, key);
+    }
+    id_discovery_poll();
+}
+
+void id_discovery_poll(void)
+{
+    if (!s_disc.active || s_disc.period_ms == 0 || !slcan_is_open() || !host_link_present()) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    if (now - s_disc.period_start_us >= (int64_t)s_disc.period_ms * 1000) {
+        send_summary(now);
+    }
+}
+
+void id_discovery_get_status(id_discovery_status_t *out)
+{
+    portENTER_CRITICAL(&s_disc_mux);
+    out->active = s_disc.active;
+    out->period_ms = s_disc.period_ms;
+    out->ids_std = s_disc.ids_std;
+    out->ids_ext = s_disc.ids_ext;
+    out->frames = s_disc.frames;
+    out->untracked = s_disc.untracked;
+    portEXIT_CRITICAL(&s_disc_mux);
+}
+
+/**
+ * @brief "discover" command handler
+ */
+static int discover_cmd_handler(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&discover_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, discover_args.end, argv[0]);
+        return 1;
+    }
+    
+    const char *action = discover_args.action->count ? discover_args.action->sval[0] : "show";
+    
+    if (strcmp(action, "start") == 0) {
+        id_discovery_start(discover_args.period->count ? discover_args.period->ival[0] : 5000,
+                           discover_args.reset->count > 0);
+    } else if (strcmp(action, "stop") == 0) {
+        id_discovery_stop();
+    } else if (strcmp(action, "show") != 0) {
+        printf("discover: unknown action '%s'\n", action);
+        return 1;
+    }
+    
+    id_discovery_status_t st;
+    id_discovery_get_status(&st);
+    printf("discover: %s, %lu 11-bit + %lu 29-bit IDs, %lu frames, %lu untracked, summary %lu ms\n",
+           st.active ? "on" : "off", (unsigned long)st.ids_std, (unsigned long)st.ids_ext,
+           (unsigned long)st.frames, (unsigned long)st.untracked, (unsigned long)st.period_ms);
+    
+    if (strcmp(action, "show") == 0) {
+        int64_t now = esp_timer_get_time();
+        for (uint32_t i = 0; i < TABLE_SIZE; i++) {
+            portENTER_CRITICAL(&s_disc_mux);
+            bool used = s_disc.used[i];
+            disc_entry_t e = s_disc.table[i];
+            portEXIT_CRITICAL(&s_disc_mux);
+            if (!used) {
+                continue;
+            }
+            char key[12];
+            format_key(key, sizeof(key), e.key);
+            int64_t age_ms = (now - e.first_us) / 1000;
+            uint64_t tenths = age_ms > 0 ? e.total * 10000ULL / age_ms : 0;
+            printf("  %s %lu frames, %llu.%llu /s\n", key, (unsigned long)e.total,
+                   (unsigned long long)(tenths / 10), (unsigned long long)(tenths % 10));
+        }
+    }
+    return 0;
+}
+
+void id_discovery_register_commands(void)
+{
+    discover_args.action = arg_str0(NULL, NULL, "<start|stop|show>", "Action (default: show)");
+    discover_args.period = arg_int0("p", "period", "<ms>", "start: rate summary period, 0 = off (default: 5000)");
+    discover_args.reset = arg_lit0("r", "reset", "start: forget the IDs seen so far");
+    discover_args.end = arg_end(3);
+    
+    const esp_console_cmd_t discover_cmd = {
+        .command = "discover",
+        .help = "ID discovery: send only first-seen IDs (Dn records) and rate summaries (Ds)\n"
+        "instead of every frame",
+        .hint = NULL,
+        .func = &discover_cmd_handler,
+        .argtable = &discover_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&discover_cmd));
+}
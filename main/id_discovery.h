@@ -0,0 +1,101 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "rx_bus.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief ID discovery mode: report new identifiers instead of every frame
+ *
+ * While active, the transport task hands frames to id_discovery_process()
+ * instead of forwarding them. Seen identifiers are kept in a bitmap (11-bit)
+ * and a Bloom filter (29-bit), so membership costs a few bit tests per frame
+ * and the set never fills up. Only the first frame of each identifier is
+ * sent to the host, followed by periodic rate summaries:
+ *
+ *   Dn <time_us> <id> <dlc> <data>\r                       first seen
+ *   Ds <time_us> <period_ms> <ids> <frames> <id>:<n> ...\r  frames per ID in the period
+ *
+ * Times are in the RX timestamp timebase (host time once clock sync is
+ * locked), identifiers in SLCAN notation (3 or 8 hex digits), data is "R"
+ * for remote frames. Per-ID rates are tracked for up to
+ * CONFIG_CAN_BRIDGE_DISCOVERY_MAX_IDS identifiers.
+ */
+
+#ifndef CONFIG_CAN_BRIDGE_DISCOVERY_MAX_IDS
+#define CONFIG_CAN_BRIDGE_DISCOVERY_MAX_IDS 256
+#endif
+
+/** @brief Key flag: 29-bit identifier */
+#define ID_DISCOVERY_KEY_EXT        (1U << 31)
+
+/**
+ * @brief Discovery status
+ */
+typedef struct {
+    bool active;                /**< Discovery mode on */
+    uint32_t period_ms;         /**< Summary period */
+    uint32_t ids_std;           /**< 11-bit identifiers seen */
+    uint32_t ids_ext;           /**< 29-bit identifiers seen */
+    uint32_t frames;            /**< Frames processed */
+    uint32_t untracked;         /**< Identifiers seen but not rate-tracked (table full) */
+} id_discovery_status_t;
+
+/**
+ * @brief Enable discovery mode
+ *
+ * @param period_ms Summary period (0: no summaries)
+ * @param reset Forget the identifiers seen so far
+ */
+void id_discovery_start(uint32_t period_ms, bool reset);
+
+/**
+ * @brief Disable discovery mode (normal forwarding resumes)
+ */
+void id_discovery_stop(void);
+
+/**
+ * @brief Check whether discovery mode is on
+ */
+bool id_discovery_is_active(void);
+
+/**
+ * @brief Process a received frame in discovery mode
+ *
+ * @note Called from the transport task instead of forwarding the frame
+ *
+ * @param rx_frame Received frame (not released)
+ */
+void id_discovery_process(const rx_bus_frame_t *rx_frame);
+
+/**
+ * @brief Send a rate summary if the period has elapsed (call when idle)
+ */
+void id_discovery_poll(void);
+
+/**
+ * @brief Get the discovery status
+ *
+ * @param out Output status
+ */
+void id_discovery_get_status(id_discovery_status_t *out);
+
+/**
+ * @brief Register the 'discover' extension command
+ */
+void id_discovery_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
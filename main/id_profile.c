@@ -0,0 +1,512 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "id_profile.h"
+#include "rx_bus.h"
+
+static const char *TAG = "id_profile";
+
+#define TABLE_SIZE              CONFIG_CAN_BRIDGE_PROFILE_MAX_IDS
+
+// Profile subscriber ring
+#define PROFILE_RING_DEPTH      128
+
+// Profiler state
+static struct {
+    volatile bool running;
+    rx_bus_sub_handle_t sub;
+    SemaphoreHandle_t done_sem;
+    uint32_t ids;
+    uint32_t frames;
+    uint32_t ids_dropped;
+    uint32_t dropped;
+    uint32_t generation;
+    bool used[TABLE_SIZE];
+    id_profile_entry_t table[TABLE_SIZE];
+    id_profile_entry_t work;
+} s_prof;
+
+static portMUX_TYPE s_prof_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/** @brief Command line arguments for classify command */
+static struct {
+    struct arg_str *id;
+    struct arg_lit *compact;
+    struct arg_end *end;
+} classify_args;
+
+/** @brief Command line arguments for heatmap command */
+static struct {
+    struct arg_str *action;
+    struct arg_str *id;
+    struct arg_lit *verbose;
+    struct arg_end *end;
+} heatmap_args;
+
+/**
+ * @brief Find the table slot of a key, inserting it if there is room
+ *
+ * @return Slot index, or -1 if the key is new and the table is full
+ */
+static int profile_slot(uint32_t key)
+{
+    uint32_t i = (key * 2654435761U) % TABLE_SIZE;
+    
+    for (uint32_t n = 0; n < TABLE_SIZE; n++) {
+        if (!s_prof.used[i]) {
+            if (s_prof.ids == TABLE_SIZE) {
+                return -1;
+            }
+            s_prof.used[i] = true;
+            s_prof.ids++;
+            memset(&s_prof.table[i], 0, sizeof(s_prof.table[i]));
+            s_prof.table[i].key = key;
+            return (int)i;
+        }
+        if (s_prof.table[i].key == key) {
+            return (int)i;
+        }
+        i = (i + 1) % TABLE_SIZE;
+    }
+    return -1;
+}
+
+/**
+ * @brief Halve all toggle counters of an entry before one overflows
+ */
+static void profile_decay(id_profile_entry_t *e)
+{
+    for (uint32_t b = 0; b < ID_PROFILE_DATA_LEN * 8; b++) {
+        e->toggles[b] >>= 1;
+    }
+    e->samples >>= 1;
+}
+
+/**
+ * @brief Update the entry of a frame: XOR with the previous payload, count changed bits
+ */
+static void profile_update(const rx_bus_frame_t *rx_frame)
+{
+    const twai_frame_t *frame = &rx_frame->frame;
+    uint32_t key = frame->header.id | (frame->header.ide ? ID_PROFILE_KEY_EXT : 0);
+    uint8_t len = 0;
+    if (!frame->header.rtr) {
+        uint16_t n = twaifd_dlc2len(frame->header.dlc);
+        len = n < ID_PROFILE_DATA_LEN ? n : ID_PROFILE_DATA_LEN;
+    }
+    
+    // The lock only covers the lookup and the copies: the update (byte classes with their
+    // CRC trials) runs on a private copy with interrupts enabled
+    portENTER_CRITICAL(&s_prof_mux);
+    int slot = profile_slot(key);
+    if (slot < 0) {
+        s_prof.ids_dropped++;
+        portEXIT_CRITICAL(&s_prof_mux);
+        return;
+    }
+    uint32_t generation = s_prof.generation;
+    s_prof.work = s_prof.table[slot];
+    portEXIT_CRITICAL(&s_prof_mux);
+    
+    id_profile_entry_t *e = &s_prof.work;
+    if (e->frames > 0) {
+        if (e->samples == UINT16_MAX) {
+            profile_decay(e);
+        }
+        e->samples++;
+        // Bytes missing in the shorter frame compare against zero
+        uint8_t n = len > e->len ? len : e->len;
+        for (uint8_t i = 0; i < n; i++) {
+            uint8_t cur = i < len ? frame->buffer[i] : 0;
+            uint8_t diff = cur ^ e->data[i];
+            if (diff == 0) {
+                continue;
+            }
+            e->byte_change_us[i] = rx_frame->timestamp_us;
+            while (diff) {
+                uint32_t bit = i * 8 + __builtin_ctz(diff);
+                if (e->toggles[bit] == UINT16_MAX) {
+                    profile_decay(e);
+                }
+                e->toggles[bit]++;
+                diff &= diff - 1;
+            }
+        }
+    }
+    if (!frame->header.rtr) {
+        byte_class_update(&e->classes, frame->buffer, len);
+    }
+    memset(e->data, 0, sizeof(e->data));
+    memcpy(e->data, frame->buffer, len);
+    e->len = len;
+    e->frames++;
+    e->last_rx_us = rx_frame->timestamp_us;
+    
+    portENTER_CRITICAL(&s_prof_mux);
+    // A reset in between emptied the table: the copy is stale
+    if (generation == s_prof.generation) {
+        s_prof.table[slot] = *e;
+        s_prof.frames++;
+    }
+    portEXIT_CRITICAL(&s_prof_mux);
+}
+
+/**
+ * @brief Profiler task: RX bus "profile" subscriber
+ */
+static void profile_task(void *arg)
+{
+    while (s_prof.running) {
+        const rx_bus_frame_t *rx_frame = rx_bus_receive(s_prof.sub, pdMS_TO_TICKS(100));
+        if (rx_frame != NULL) {
+            profile_update(rx_frame);
+            rx_bus_release(rx_frame);
+        }
+    }
+    
+    rx_bus_sub_stats_t st;
+    rx_bus_get_sub_stats(s_prof.sub, &st);
+    s_prof.dropped = st.dropped;
+    rx_bus_unsubscribe(s_prof.sub);
+    s_prof.sub = NULL;
+    
+    xSemaphoreGive(s_prof.done_sem);
+    vTaskDelete(NULL);
+}
+
+esp_err_t id_profile_start(void)
+{
+    if (s_prof.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (s_prof.done_sem == NULL) {
+        s_prof.done_sem = xSemaphoreCreateBinary();
+        if (s_prof.done_sem == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
+    esp_err_t ret = rx_bus_subscribe("profile", PROFILE_RING_DEPTH, &s_prof.sub);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    s_prof.dropped = 0;
+    s_prof.running = true;
+    if (xTaskCreate(profile_task, "profile", 3072, NULL, 7, NULL) != pdPASS) {
+        s_prof.running = false;
+        rx_bus_unsubscribe(s_prof.sub);
+        s_prof.sub = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    
+    ESP_LOGI(TAG, "Profiling started");
+    return ESP_OK;
+}
+
+esp_err_t id_profile_stop(void)
+{
+    if (!s_prof.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    s_prof.running = false;
+    if (xSemaphoreTake(s_prof.done_sem, pdMS_TO_TICKS(2000)) != pdTRUE) {
+        ESP_LOGE(TAG, "Profile task did not stop");
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+void id_profile_reset(void)
+{
+    portENTER_CRITICAL(&s_prof_mux);
+    memset(s_prof.used, 0, sizeof(s_prof.used));
+    s_prof.generation++;
+    s_prof.ids = 0;
+    s_prof.frames = 0;
+    s_prof.ids_dropped = 0;
+    portEXIT_CRITICAL(&s_prof_mux);
+}
+
+void id_profile_get_status(id_profile_status_t *out)
+{
+    portENTER_CRITICAL(&s_prof_mux);
+    out->running = s_prof.running;
+    out->ids = s_prof.ids;
+    out->frames = s_prof.frames;
+    out->ids_dropped = s_prof.ids_dropped;
+    portEXIT_CRITICAL(&s_prof_mux);
+    
+    out->dropped = s_prof.dropped;
+    if (s_prof.running && s_prof.sub) {
+        rx_bus_sub_stats_t st;
+        rx_bus_get_sub_stats(s_prof.sub, &st);
+        out->dropped = st.dropped;
+    }
+}
+
+bool id_profile_get_entry(uint32_t index, id_profile_entry_t *out)
+{
+    if (index >= TABLE_SIZE) {
+        return false;
+    }
+    
+    portENTER_CRITICAL(&s_prof_mux);
+    bool used = s_prof.used[index];
+    if (used) {
+        *out = s_prof.table[index];
+    }
+    portEXIT_CRITICAL(&s_prof_mux);
+    return used;
+}
+
+uint8_t id_profile_bit_level(const id_profile_entry_t *entry, uint32_t bit)
+{
+    uint32_t toggles = entry->toggles[bit];
+    if (toggles == 0 || entry->samples == 0) {
+        return 0;
+    }
+    uint32_t level = 1 + toggles * 14 / entry->samples;
+    return level > 15 ? 15 : (uint8_t)level;
+}
+
+/**
+ * @brief Parse a hex ID: 29-bit if longer than 3 digits
+ */
+static uint32_t parse_key(const char *id)
+{
+    uint32_t key = strtoul(id, NULL, 16);
+    if (strlen(id) > 3) {
+        key |= ID_PROFILE_KEY_EXT;
+    }
+    return key;
+}
+
+/**
+ * @brief Print an ID in SLCAN notation (3 or 8 hex digits)
+ */
+static void print_key(uint32_t key)
+{
+    if (key & ID_PROFILE_KEY_EXT) {
+        printf("%08lX", (unsigned long)(key & ~ID_PROFILE_KEY_EXT));
+    } else {
+        printf("%03lX", (unsigned long)key);
+    }
+}
+
+/**
+ * @brief Print one entry: ID, length, frame count and one hex level per bit
+ *
+ * Bytes in payload order, bits MSB first within a byte.
+ */
+static void heatmap_print_entry(const id_profile_entry_t *e, bool verbose)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    char map[ID_PROFILE_DATA_LEN * 8 + 1];
+    
+    for (uint32_t byte = 0; byte < ID_PROFILE_DATA_LEN; byte++) {
+        for (uint32_t bit = 0; bit < 8; bit++) {
+            map[byte * 8 + bit] = hex[id_profile_bit_level(e, byte * 8 + (7 - bit))];
+        }
+    }
+    map[sizeof(map) - 1] = '\0';
+    
+    print_key(e->key);
+    printf(" %u %lu %s\n", e->len, (unsigned long)e->frames, map);
+    
+    if (verbose) {
+        int64_t now = esp_timer_get_time();
+        printf("  changed ms ago:");
+        for (uint32_t byte = 0; byte < ID_PROFILE_DATA_LEN; byte++) {
+            if (e->byte_change_us[byte] == 0) {
+                printf(" -");
+            } else {
+                printf(" %lld", (long long)((now - e->byte_change_us[byte]) / 1000));
+            }
+        }
+        printf("\n");
+    }
+}
+
+/**
+ * @brief "heatmap" command handler
+ */
+static int heatmap_cmd_handler(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&heatmap_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, heatmap_args.end, argv[0]);
+        return 1;
+    }
+    
+    const char *action = heatmap_args.action->count ? heatmap_args.action->sval[0] : "show";
+    esp_err_t ret = ESP_OK;
+    
+    if (strcmp(action, "start") == 0) {
+        ret = id_profile_start();
+    } else if (strcmp(action, "stop") == 0) {
+        ret = id_profile_stop();
+    } else if (strcmp(action, "reset") == 0) {
+        id_profile_reset();
+    } else if (strcmp(action, "show") != 0) {
+        printf("heatmap: unknown action '%s'\n", action);
+        return 1;
+    }
+    
+    if (ret != ESP_OK) {
+        printf("heatmap %s: %s\n", action, esp_err_to_name(ret));
+        return 1;
+    }
+    
+    id_profile_status_t st;
+    id_profile_get_status(&st);
+    printf("heatmap: %s, ids %lu, frames %lu, table full %lu, dropped %lu\n",
+           st.running ? "running" : "stopped", (unsigned long)st.ids, (unsigned long)st.frames,
+           (unsigned long)st.ids_dropped, (unsigned long)st.dropped);
+    if (strcmp(action, "show") != 0) {
+        return 0;
+    }
+    
+    bool filter = heatmap_args.id->count > 0;
+    uint32_t filter_key = filter ? parse_key(heatmap_args.id->sval[0]) : 0;
+    
+    id_profile_entry_t e;
+    for (uint32_t i = 0; i < TABLE_SIZE; i++) {
+        if (id_profile_get_entry(i, &e) && (!filter || e.key == filter_key)) {
+            heatmap_print_entry(&e, heatmap_args.verbose->count > 0);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Print the byte classes of one entry
+ *
+ * Compact form, one token per byte: ? unknown, K<hh> constant,
+ * C<step>/<period> counter (c: low nibble), S<x|s|1|2> checksum (xor, sum,
+ * CRC-8 0x1D, CRC-8 0x2F), E<n> enumeration, V continuous, R random.
+ */
+static void classify_print_entry(const id_profile_entry_t *e, bool compact)
+{
+    static const char csum_code[BYTE_CLASS_CSUM_COUNT] = {'x', 's', '1', '2'};
+    
+    print_key(e->key);
+    printf(compact ? " %u %lu" : " len %u frames %lu\n", e->len, (unsigned long)e->frames);
+    
+    for (uint8_t i = 0; i < e->classes.len; i++) {
+        byte_class_result_t r;
+        byte_class_classify(&e->classes, i, &r);
+        
+        if (compact) {
+            switch (r.cls) {
+            case BYTE_CLASS_CONSTANT:   printf(" K%02X", r.value); break;
+            case BYTE_CLASS_COUNTER:    printf(" %c%u/%u", r.mask == 0xFF ? 'C' : 'c', r.step, r.period); break;
+            case BYTE_CLASS_CHECKSUM:   printf(" S%c", csum_code[r.csum]); break;
+            case BYTE_CLASS_ENUM:       printf(" E%u", r.n_values); break;
+            case BYTE_CLASS_CONTINUOUS: printf(" V"); break;
+            case BYTE_CLASS_RANDOM:     printf(" R"); break;
+            default:                    printf(" ?"); break;
+            }
+            continue;
+        }
+        
+        printf("  %u %-10s", i, byte_class_name(r.cls));
+        switch (r.cls) {
+        case BYTE_CLASS_CONSTANT:
+            printf(" %02X\n", r.value);
+            break;
+        case BYTE_CLASS_COUNTER:
+            printf(" step %u period %u%s %u%%\n", r.step, r.period,
+                   r.mask == 0xFF ? "" : " (low nibble)", r.confidence);
+            break;
+        case BYTE_CLASS_CHECKSUM:
+            printf(" %s k=%02X %u%%\n", byte_class_csum_name(r.csum), r.value, r.confidence);
+            break;
+        case BYTE_CLASS_ENUM:
+            printf(" %u values %02X..%02X\n", r.n_values, r.lo, r.hi);
+            break;
+        case BYTE_CLASS_CONTINUOUS:
+        case BYTE_CLASS_RANDOM:
+            printf(" %02X..%02X\n", r.lo, r.hi);
+            break;
+        default:
+            printf("\n");
+            break;
+        }
+    }
+    if (compact) {
+        printf("\n");
+    }
+}
+
+/**
+ * @brief "classify" command handler
+ */
+static int classify_cmd_handler(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&classify_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, classify_args.end, argv[0]);
+        return 1;
+    }
+    
+    bool filter = classify_args.id->count > 0;
+    uint32_t filter_key = filter ? parse_key(classify_args.id->sval[0]) : 0;
+    
+    id_profile_entry_t e;
+    for (uint32_t i = 0; i < TABLE_SIZE; i++) {
+        if (id_profile_get_entry(i, &e) && (!filter || e.key == filter_key)) {
+            classify_print_entry(&e, classify_args.compact->count > 0);
+        }
+    }
+    return 0;
+}
+
+void id_profile_register_commands(void)
+{
+    heatmap_args.action = arg_str0(NULL, NULL, "<start|stop|reset|show>", "Action (default: show)");
+    heatmap_args.id = arg_str0("i", "id", "<hex>", "Only this ID (more than 3 digits: 29-bit)");
+    heatmap_args.verbose = arg_lit0("v", "verbose", "Also print when each byte last changed");
+    heatmap_args.end = arg_end(3);
+    
+    const esp_console_cmd_t heatmap_cmd = {
+        .command = "heatmap",
+        .help = "Per-ID bit toggle heatmap\n"
+        "  One line per ID: <id> <len> <frames> <64 hex levels>, one level per bit,\n"
+        "  bytes in payload order, MSB first. 0 = never toggled, F = toggles every frame",
+        .hint = NULL,
+        .func = &heatmap_cmd_handler,
+        .argtable = &heatmap_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&heatmap_cmd));
+    
+    classify_args.id = arg_str0("i", "id", "<hex>", "Only this ID (more than 3 digits: 29-bit)");
+    classify_args.compact = arg_lit0("c", "compact", "One line per ID, one token per byte");
+    classify_args.end = arg_end(2);
+    
+    const esp_console_cmd_t classify_cmd = {
+        .command = "classify",
+        .help = "Classify the payload bytes of each ID profiled by 'heatmap start'\n"
+        "  const, counter (step/period), checksum (xor/sum/crc8-1d/crc8-2f),\n"
+        "  enum, continuous or random; unknown until 32 frames of the ID were seen\n"
+        "  Compact tokens: K<hh> C<step>/<period> (c: low nibble) S<x|s|1|2> E<n> V R ?",
+        .hint = NULL,
+        .func = &classify_cmd_handler,
+        .argtable = &classify_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&classify_cmd));
+}
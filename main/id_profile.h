@@ -0,0 +1,128 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "byte_class.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Per-ID payload profiling for reverse engineering
+ *
+ * An RX bus subscriber keeps one entry per identifier with a toggle counter
+ * for every payload bit and the time each payload byte last changed. Each
+ * frame is XORed with the previous payload of its ID, so the update costs
+ * one XOR per byte plus one increment per changed bit. The host only fetches
+ * compact snapshots ('Xheatmap'), so a fully loaded bus can be profiled over
+ * a slow link without streaming raw frames.
+ *
+ * The same pass feeds the byte classifier (byte_class.h), which tells
+ * constants, counters, checksums, enumerations and continuous values apart
+ * ('Xclassify').
+ *
+ * Toggle counters are 16 bit; when one would overflow, all counters of the
+ * ID and its sample count are halved, which keeps the rates and slowly
+ * weights them towards recent traffic.
+ */
+
+#ifndef CONFIG_CAN_BRIDGE_PROFILE_MAX_IDS
+#define CONFIG_CAN_BRIDGE_PROFILE_MAX_IDS 128
+#endif
+
+/** @brief Profiled payload bytes per ID (classic CAN; FD payloads are truncated) */
+#define ID_PROFILE_DATA_LEN     8
+
+/** @brief Key flag: 29-bit identifier */
+#define ID_PROFILE_KEY_EXT      (1U << 31)
+
+/**
+ * @brief Snapshot of one profiled ID
+ */
+typedef struct {
+    uint32_t key;                               /**< Identifier | ID_PROFILE_KEY_EXT */
+    uint32_t frames;                            /**< Frames received */
+    uint8_t len;                                /**< Payload length of the last frame */
+    uint8_t data[ID_PROFILE_DATA_LEN];          /**< Last payload */
+    int64_t last_rx_us;                         /**< esp_timer time of the last frame */
+    int64_t byte_change_us[ID_PROFILE_DATA_LEN];/**< Last change per byte, 0 = never */
+    uint16_t samples;                           /**< Payload comparisons the toggle counts cover */
+    uint16_t toggles[ID_PROFILE_DATA_LEN * 8];  /**< Toggles per bit (byte * 8 + bit) */
+    byte_class_state_t classes;                 /**< Byte classifier state (data frames only) */
+} id_profile_entry_t;
+
+/**
+ * @brief Profiler status
+ */
+typedef struct {
+    bool running;           /**< Subscribed to the RX bus */
+    uint32_t ids;           /**< IDs in the table */
+    uint32_t frames;        /**< Frames profiled */
+    uint32_t ids_dropped;   /**< Frames of new IDs ignored because the table was full */
+    uint32_t dropped;       /**< Frames lost by the profile subscriber */
+} id_profile_status_t;
+
+/**
+ * @brief Start profiling (subscribes to the RX bus)
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if already running
+ */
+esp_err_t id_profile_start(void);
+
+/**
+ * @brief Stop profiling; the collected statistics are kept
+ *
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t id_profile_stop(void);
+
+/**
+ * @brief Clear all collected statistics
+ */
+void id_profile_reset(void);
+
+/**
+ * @brief Get profiler status
+ *
+ * @param out Output status
+ */
+void id_profile_get_status(id_profile_status_t *out);
+
+/**
+ * @brief Copy the entry at a table position
+ *
+ * Iterate with index = 0 .. CONFIG_CAN_BRIDGE_PROFILE_MAX_IDS - 1.
+ *
+ * @param index Table position
+ * @param out Output entry
+ * @return true if the position holds an ID
+ */
+bool id_profile_get_entry(uint32_t index, id_profile_entry_t *out);
+
+/**
+ * @brief Heat level of one bit: 0 = never toggled, 1..15 = toggle rate
+ *
+ * 15 means the bit toggled on (nearly) every frame.
+ *
+ * @param entry Entry snapshot
+ * @param bit Bit index (byte * 8 + bit, bit 0 = LSB)
+ * @return Level 0..15
+ */
+uint8_t id_profile_bit_level(const id_profile_entry_t *entry, uint32_t bit);
+
+/**
+ * @brief Register the 'heatmap' and 'classify' extension commands
+ */
+void id_profile_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,196 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <string.h>
+#include "isotp.h"
+
+void isotp_rx_init(isotp_rx_t *rx, uint8_t *buf, uint16_t size, uint8_t bs)
+{
+    memset(rx, 0, sizeof(*rx));
+    rx->buf = buf;
+    rx->size = size;
+    rx->bs = bs;
+}
+
+isotp_rx_result_t isotp_rx_feed(isotp_rx_t *rx, const uint8_t *data, uint8_t len)
+{
+    if (len == 0) {
+        return ISOTP_RX_IGNORED;
+    }
+    
+    switch (data[0] & 0xF0) {
+    case ISOTP_PCI_SF: {
+        uint8_t n = data[0] & 0x0F;
+        if (n == 0 || n > ISOTP_SF_MAX_LEN || n > len - 1 || n > rx->size) {
+            return ISOTP_RX_IGNORED;
+        }
+        rx->active = false;
+        memcpy(rx->buf, &data[1], n);
+        rx->len = n;
+        rx->pos = n;
+        return ISOTP_RX_COMPLETE;
+    }
+    case ISOTP_PCI_FF: {
+        if (len < 8) {
+            return ISOTP_RX_IGNORED;
+        }
+        uint16_t n = ((data[0] & 0x0F) << 8) | data[1];
+        if (n <= ISOTP_SF_MAX_LEN) {
+            return ISOTP_RX_IGNORED;
+        }
+        rx->active = false;
+        if (n > rx->size) {
+            return ISOTP_RX_OVERFLOW;
+        }
+        memcpy(rx->buf, &data[2], 6);
+        rx->len = n;
+        rx->pos = 6;
+        rx->next_sn = 1;
+        rx->block_left = rx->bs;
+        rx->active = true;
+        return ISOTP_RX_SEND_FC;
+    }
+    case ISOTP_PCI_CF: {
+        if (!rx->active) {
+            return ISOTP_RX_IGNORED;
+        }
+        if ((data[0] & 0x0F) != rx->next_sn) {
+            rx->active = false;
+            return ISOTP_RX_SEQ_ERROR;
+        }
+        uint16_t n = rx->len - rx->pos;
+        if (n > 7) {
+            n = 7;
+        }
+        if (n > len - 1) {
+            rx->active = false;
+            return ISOTP_RX_SEQ_ERROR;
+        }
+        memcpy(&rx->buf[rx->pos], &data[1], n);
+        rx->pos += n;
+        rx->next_sn = (rx->next_sn + 1) & 0x0F;
+        if (rx->pos == rx->len) {
+            rx->active = false;
+            return ISOTP_RX_COMPLETE;
+        }
+        if (rx->bs != 0 && --rx->block_left == 0) {
+            rx->block_left = rx->bs;
+            return ISOTP_RX_SEND_FC;
+        }
+        return ISOTP_RX_IN_PROGRESS;
+    }
+    default:
+        return ISOTP_RX_IGNORED;
+    }
+}
+
+uint8_t isotp_build_fc(uint8_t out[8], uint8_t status, uint8_t bs, uint8_t stmin, uint8_t padding)
+{
+    memset(out, padding, 8);
+    out[0] = ISOTP_PCI_FC | (status & 0x0F);
+    out[1] = bs;
+    out[2] = stmin;
+    return 8;
+}
+
+bool isotp_tx_start(isotp_tx_t *tx, const uint8_t *data, uint16_t len, uint8_t padding)
+{
+    memset(tx, 0, sizeof(*tx));
+    if (len == 0 || len > ISOTP_MAX_LEN) {
+        return false;
+    }
+    tx->data = data;
+    tx->len = len;
+    tx->padding = padding;
+    tx->state = ISOTP_TX_SEND;
+    return true;
+}
+
+uint8_t isotp_tx_next(isotp_tx_t *tx, uint8_t out[8])
+{
+    if (tx->state != ISOTP_TX_SEND) {
+        return 0;
+    }
+    memset(out, tx->padding, 8);
+    
+    if (tx->pos == 0 && tx->len <= ISOTP_SF_MAX_LEN) {
+        out[0] = ISOTP_PCI_SF | tx->len;
+        memcpy(&out[1], tx->data, tx->len);
+        tx->pos = tx->len;
+        tx->state = ISOTP_TX_DONE;
+        return 8;
+    }
+    
+    if (tx->pos == 0) {
+        out[0] = ISOTP_PCI_FF | (tx->len >> 8);
+        out[1] = tx->len & 0xFF;
+        memcpy(&out[2], tx->data, 6);
+        tx->pos = 6;
+        tx->sn = 1;
+        tx->state = ISOTP_TX_WAIT_FC;
+        return 8;
+    }
+    
+    uint16_t n = tx->len - tx->pos;
+    if (n > 7) {
+        n = 7;
+    }
+    out[0] = ISOTP_PCI_CF | tx->sn;
+    memcpy(&out[1], &tx->data[tx->pos], n);
+    tx->pos += n;
+    tx->sn = (tx->sn + 1) & 0x0F;
+    
+    if (tx->pos == tx->len) {
+        tx->state = ISOTP_TX_DONE;
+    } else if (tx->block_left != 0 && --tx->block_left == 0) {
+        tx->state = ISOTP_TX_WAIT_FC;
+    }
+    return 8;
+}
+
+bool isotp_tx_on_fc(isotp_tx_t *tx, const uint8_t *data, uint8_t len)
+{
+    if (tx->state != ISOTP_TX_WAIT_FC || len < 3 || (data[0] & 0xF0) != ISOTP_PCI_FC) {
+        return false;
+    }
+    
+    switch (data[0] & 0x0F) {
+    case ISOTP_FC_CTS:
+        tx->block_left = data[1];
+        tx->stmin_us = isotp_stmin_us(data[2]);
+        tx->state = ISOTP_TX_SEND;
+        break;
+    case ISOTP_FC_WAIT:
+        break;
+    default:
+        tx->state = ISOTP_TX_ABORTED;
+        break;
+    }
+    return true;
+}
+
+uint32_t isotp_stmin_us(uint8_t stmin)
+{
+    if (stmin <= 0x7F) {
+        return stmin * 1000U;
+    }
+    if (stmin >= 0xF1 && stmin <= 0xF9) {
+        return (stmin - 0xF0) * 100U;
+    }
+    return 127000U;
+}
+
+uint8_t isotp_stmin_encode(uint32_t us)
+{
+    if (us == 0) {
+        return 0;
+    }
+    if (us <= 900) {
+        return 0xF0 + (us + 99) / 100;
+    }
+    uint32_t ms = (us + 999) / 1000;
+    return ms > 0x7F ? 0x7F : (uint8_t)ms;
+}
@@ -0,0 +1,178 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief ISO 15765-2 (ISO-TP) segmentation and reassembly on classic CAN
+ *
+ * Pure C (no ESP-IDF dependencies) so it can be built and tested on the host.
+ * The state machines only convert between messages and 8-byte frame payloads;
+ * the caller owns the CAN IDs, timers and transmission. Frames are always
+ * padded to 8 bytes, as required for OBD-II (ISO 15765-4).
+ */
+
+/** @brief Largest message (12-bit first frame length) */
+#define ISOTP_MAX_LEN               4095
+
+/** @brief Largest single frame payload */
+#define ISOTP_SF_MAX_LEN            7
+
+/** @brief Protocol control information (high nibble of byte 0) */
+#define ISOTP_PCI_SF                0x00
+#define ISOTP_PCI_FF                0x10
+#define ISOTP_PCI_CF                0x20
+#define ISOTP_PCI_FC                0x30
+
+/** @brief Flow control status */
+#define ISOTP_FC_CTS                0
+#define ISOTP_FC_WAIT               1
+#define ISOTP_FC_OVFLW              2
+
+/**
+ * @brief Result of feeding a frame to the receiver
+ */
+typedef enum {
+    ISOTP_RX_IGNORED = 0,       /**< Not a SF/FF/CF, or a CF without a message in progress */
+    ISOTP_RX_IN_PROGRESS,       /**< Consecutive frame stored, more expected */
+    ISOTP_RX_SEND_FC,           /**< First frame or a full block received: send a CTS flow control */
+    ISOTP_RX_COMPLETE,          /**< Message complete in the buffer */
+    ISOTP_RX_OVERFLOW,          /**< First frame larger than the buffer: send an OVFLW flow control */
+    ISOTP_RX_SEQ_ERROR,         /**< Wrong sequence number, message dropped */
+} isotp_rx_result_t;
+
+/**
+ * @brief Receiver state
+ */
+typedef struct {
+    uint8_t *buf;               /**< Message buffer */
+    uint16_t size;              /**< Buffer size */
+    uint16_t len;               /**< Message length */
+    uint16_t pos;               /**< Bytes received */
+    uint8_t next_sn;            /**< Expected sequence number */
+    uint8_t bs;                 /**< Block size announced in our flow control (0: no limit) */
+    uint8_t block_left;         /**< Consecutive frames left in the current block */
+    bool active;                /**< Multi-frame message in progress */
+} isotp_rx_t;
+
+/**
+ * @brief Transmitter state
+ */
+typedef enum {
+    ISOTP_TX_IDLE = 0,          /**< Nothing to send */
+    ISOTP_TX_SEND,              /**< Next frame may be sent (pace consecutive frames by stmin_us) */
+    ISOTP_TX_WAIT_FC,           /**< Waiting for a flow control frame */
+    ISOTP_TX_DONE,              /**< Last frame handed out */
+    ISOTP_TX_ABORTED,           /**< Overflow or invalid flow control from the receiver */
+} isotp_tx_state_t;
+
+/**
+ * @brief Transmitter
+ */
+typedef struct {
+    const uint8_t *data;        /**< Message (must stay valid until done) */
+    uint16_t len;               /**< Message length */
+    uint16_t pos;               /**< Bytes handed out */
+    uint8_t sn;                 /**< Next sequence number */
+    uint8_t block_left;         /**< Consecutive frames left before the next flow control (0: no limit) */
+    uint8_t padding;            /**< Padding byte */
+    uint32_t stmin_us;          /**< Separation time requested by the receiver */
+    isotp_tx_state_t state;
+} isotp_tx_t;
+
+/**
+ * @brief Reset a receiver
+ *
+ * @param rx Receiver
+ * @param buf Message buffer
+ * @param size Buffer size
+ * @param bs Block size sent in our flow control frames (0: no limit)
+ */
+void isotp_rx_init(isotp_rx_t *rx, uint8_t *buf, uint16_t size, uint8_t bs);
+
+/**
+ * @brief Feed a received frame payload to a receiver
+ *
+ * A single or first frame always starts a new message.
+ *
+ * @param rx Receiver
+ * @param data Frame payload
+ * @param len Payload length
+ * @return What happened, and what the caller has to send
+ */
+isotp_rx_result_t isotp_rx_feed(isotp_rx_t *rx, const uint8_t *data, uint8_t len);
+
+/**
+ * @brief Build a flow control frame
+ *
+ * @param out Output: 8-byte payload
+ * @param status ISOTP_FC_CTS, ISOTP_FC_WAIT or ISOTP_FC_OVFLW
+ * @param bs Block size
+ * @param stmin Separation time (ISO-TP encoding)
+ * @param padding Padding byte
+ * @return Payload length (8)
+ */
+uint8_t isotp_build_fc(uint8_t out[8], uint8_t status, uint8_t bs, uint8_t stmin, uint8_t padding);
+
+/**
+ * @brief Start sending a message
+ *
+ * @param tx Transmitter
+ * @param data Message (not copied)
+ * @param len Message length (1..ISOTP_MAX_LEN)
+ * @param padding Padding byte
+ * @return true if started, false if the length is out of range
+ */
+bool isotp_tx_start(isotp_tx_t *tx, const uint8_t *data, uint16_t len, uint8_t padding);
+
+/**
+ * @brief Get the next frame to send
+ *
+ * Only valid in state ISOTP_TX_SEND. After a first frame, or the last
+ * consecutive frame of a block, the state changes to ISOTP_TX_WAIT_FC.
+ *
+ * @param tx Transmitter
+ * @param out Output: 8-byte payload
+ * @return Payload length (8), or 0 if no frame may be sent now
+ */
+uint8_t isotp_tx_next(isotp_tx_t *tx, uint8_t out[8]);
+
+/**
+ * @brief Feed a received flow control frame to a transmitter
+ *
+ * CTS switches to ISOTP_TX_SEND with the new block size and separation
+ * time, WAIT keeps waiting, OVFLW or a malformed frame aborts.
+ *
+ * @param tx Transmitter
+ * @param data Frame payload
+ * @param len Payload length
+ * @return true if the frame was a flow control frame in state ISOTP_TX_WAIT_FC
+ */
+bool isotp_tx_on_fc(isotp_tx_t *tx, const uint8_t *data, uint8_t len);
+
+/**
+ * @brief Decode an STmin byte to microseconds
+ *
+ * 0x00-0x7F: milliseconds, 0xF1-0xF9: 100-900 us; reserved values are
+ * treated as the maximum (127 ms), as ISO 15765-2 requires.
+ */
+uint32_t isotp_stmin_us(uint8_t stmin);
+
+/**
+ * @brief Encode a separation time, rounding up to the next representable value
+ */
+uint8_t isotp_stmin_encode(uint32_t us);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,612 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "isotp_send.h"
+#include "can_tx.h"
+#include "rx_bus.h"
+
+static const char *TAG = "isotp_send";
+
+// Receiver frames subscriber ring
+#define SEND_RING_DEPTH         32
+
+// Flow control timeout (ISO 15765-2 N_Bs) when none is given
+#define SEND_FC_TIMEOUT_MS      1000
+
+// WAIT flow control frames accepted in a row (N_WFTmax)
+#define SEND_FC_WAIT_MAX        16
+
+// Time allowed per frame of a chain beyond STmin (arbitration, bus load)
+#define SEND_FRAME_TIMEOUT_US   20000
+
+// Sender state: the chain fields are advanced from the TX-done ISR
+static struct {
+    bool busy;
+    SemaphoreHandle_t done_sem;
+    rx_bus_sub_handle_t sub;
+    isotp_send_config_t cfg;
+    const rx_bus_frame_t *held;     // Receiver frame kept for the next peer_receive()
+    
+    // Frames of the current block, sent one after the other
+    uint8_t frames[ISOTP_SEND_MAX_CF + 1][8];
+    volatile bool chain_active;
+    uint32_t chain_gen;             // Bumped by every chain and timeout; TX-done callbacks of older chains are ignored
+    uint16_t chain_next;
+    uint16_t chain_end;
+    uint32_t stmin_us;
+    int64_t prev_done_us;
+    volatile bool chain_failed;
+    int64_t first_release_us;
+    int64_t last_done_us;
+    
+    // Separation achieved minus STmin
+    uint32_t sep_count;
+    int64_t sep_err_sum;
+    int32_t sep_err_min;
+    int32_t sep_err_max;
+    
+    uint32_t transfers;
+    uint32_t failures;
+    esp_err_t last_result;
+    uint16_t len;
+    uint16_t frames_sent;
+    uint16_t blocks;
+    uint16_t fc_waits;
+    uint8_t block_size;
+    uint32_t fc_latency_max_us;
+} s_send;
+
+static portMUX_TYPE s_send_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Message staged with 'tp data' (command lines are too short for long messages)
+static uint8_t s_msg[ISOTP_MAX_LEN];
+static uint16_t s_msg_len;
+
+/** @brief Command line arguments for tp command */
+static struct {
+    struct arg_str *action;
+    struct arg_str *params;
+    struct arg_lit *ext;
+    struct arg_int *padding;
+    struct arg_int *timeout;
+    struct arg_end *end;
+} tp_args;
+
+static void chain_done(void *arg, int64_t release_us, int64_t done_us, bool ok);
+
+/**
+ * @brief Schedule frame 'index' of chain 'gen' (now if target_us is 0)
+ */
+static IRAM_ATTR esp_err_t chain_submit(uint32_t gen, uint16_t index, int64_t target_us)
+{
+    twai_frame_t frame = {
+        .header = {
+            .id = s_send.cfg.tx_id,
+            .ide = s_send.cfg.extended,
+            .dlc = 8,
+        },
+        .buffer = s_send.frames[index],
+        .buffer_len = 8,
+    };
+    return can_tx_schedule_with_callback(&frame, target_us, chain_done, (void *)(uintptr_t)gen, NULL);
+}
+
+/**
+ * @brief End chain 'gen' and wake the sender, unless the sender has given up on it
+ */
+static IRAM_ATTR void chain_finish(uint32_t gen, bool failed)
+{
+    portENTER_CRITICAL_SAFE(&s_send_mux);
+    if (gen != s_send.chain_gen) {
+        portEXIT_CRITICAL_SAFE(&s_send_mux);
+        return;
+    }
+    s_send.chain_failed = failed;
+    s_send.chain_active = false;
+    portEXIT_CRITICAL_SAFE(&s_send_mux);
+    // Also reached from the scheduler timer on a submit failure: no yield, the sender wakes on the next tick
+    xSemaphoreGiveFromISR(s_send.done_sem, NULL);
+}
+
+/**
+ * @brief TX-done ISR of a chain frame: measure the separation and schedule the next frame
+ */
+static IRAM_ATTR void chain_done(void *arg, int64_t release_us, int64_t done_us, bool ok)
+{
+    uint32_t gen = (uint32_t)(uintptr_t)arg;
+    
+    portENTER_CRITICAL_SAFE(&s_send_mux);
+    // A frame of a chain that timed out must not advance the current one
+    if (!s_send.chain_active || gen != s_send.chain_gen) {
+        portEXIT_CRITICAL_SAFE(&s_send_mux);
+        return;
+    }
+    if (s_send.prev_done_us != 0) {
+        int32_t err = (int32_t)(release_us - s_send.prev_done_us - s_send.stmin_us);
+        s_send.sep_err_sum += err;
+        if (s_send.sep_count == 0 || err < s_send.sep_err_min) {
+            s_send.sep_err_min = err;
+        }
+        if (s_send.sep_count == 0 || err > s_send.sep_err_max) {
+            s_send.sep_err_max = err;
+        }
+        s_send.sep_count++;
+    }
+    if (s_send.first_release_us == 0) {
+        s_send.first_release_us = release_us;
+    }
+    s_send.prev_done_us = done_us;
+    s_send.last_done_us = done_us;
+    if (ok) {
+        s_send.frames_sent++;
+    }
+    bool last = s_send.chain_next == s_send.chain_end;
+    uint16_t next = last ? 0 : s_send.chain_next++;
+    portEXIT_CRITICAL_SAFE(&s_send_mux);
+    
+    if (!ok || last) {
+        chain_finish(gen, !ok);
+        return;
+    }
+    // STmin counts from the end of this frame; 0 sends at once
+    int64_t target_us = s_send.stmin_us ? done_us + s_send.stmin_us : 0;
+    if (chain_submit(gen, next, target_us) != ESP_OK) {
+        chain_finish(gen, true);
+    }
+}
+
+/**
+ * @brief Next frame from the receiver (rx_id), dropping all other frames
+ *
+ * @return Frame (must be released), or NULL at the deadline
+ */
+static const rx_bus_frame_t *peer_receive(int64_t deadline_us)
+{
+    if (s_send.held != NULL) {
+        const rx_bus_frame_t *rx_frame = s_send.held;
+        s_send.held = NULL;
+        return rx_frame;
+    }
+    while (true) {
+        int64_t left_us = deadline_us - esp_timer_get_time();
+        if (left_us <= 0) {
+            return NULL;
+        }
+        const rx_bus_frame_t *rx_frame = rx_bus_receive(s_send.sub, pdMS_TO_TICKS(left_us / 1000) + 1);
+        if (rx_frame == NULL) {
+            continue;
+        }
+        const twai_frame_t *frame = &rx_frame->frame;
+        if (frame->header.id == s_send.cfg.rx_id && frame->header.ide == s_send.cfg.extended &&
+            !frame->header.rtr) {
+            return rx_frame;
+        }
+        rx_bus_release(rx_frame);
+    }
+}
+
+/**
+ * @brief Send the first 'count' prepared frames, paced by STmin, and wait for the last completion
+ *
+ * The subscriber is drained meanwhile, so a busy bus cannot fill it before
+ * the receiver answers. A receiver frame is held for the next
+ * peer_receive() if it came after the last frame of the chain.
+ */
+static esp_err_t run_chain(uint16_t count, uint32_t stmin_us)
+{
+    portENTER_CRITICAL(&s_send_mux);
+    s_send.chain_next = 1;
+    s_send.chain_end = count;
+    s_send.stmin_us = stmin_us;
+    s_send.prev_done_us = 0;
+    s_send.chain_failed = false;
+    s_send.chain_active = true;
+    uint32_t gen = ++s_send.chain_gen;
+    portEXIT_CRITICAL(&s_send_mux);
+    xSemaphoreTake(s_send.done_sem, 0);
+    
+    esp_err_t ret = chain_submit(gen, 0, 0);
+    if (ret != ESP_OK) {
+        s_send.chain_active = false;
+        return ret;
+    }
+    
+    int64_t deadline_us = esp_timer_get_time() + (int64_t)count * (stmin_us + SEND_FRAME_TIMEOUT_US);
+    while (xSemaphoreTake(s_send.done_sem, 0) != pdTRUE) {
+        if (esp_timer_get_time() > deadline_us) {
+            // A frame still scheduled finds its generation outdated and ends there, even once the next chain runs
+            portENTER_CRITICAL(&s_send_mux);
+            s_send.chain_active = false;
+            s_send.chain_gen++;
+            portEXIT_CRITICAL(&s_send_mux);
+            return ESP_ERR_TIMEOUT;
+        }
+        const rx_bus_frame_t *rx_frame = rx_bus_receive(s_send.sub, 1);
+        if (rx_frame == NULL) {
+            continue;
+        }
+        const twai_frame_t *frame = &rx_frame->frame;
+        if (frame->header.id == s_send.cfg.rx_id && frame->header.ide == s_send.cfg.extended &&
+            !frame->header.rtr) {
+            if (s_send.held != NULL) {
+                rx_bus_release(s_send.held);
+            }
+            s_send.held = rx_frame;
+        } else {
+            rx_bus_release(rx_frame);
+        }
+    }
+    
+    // Anything the receiver sent before the end of the chain is stale
+    if (s_send.held != NULL && s_send.held->timestamp_us <= s_send.last_done_us) {
+        rx_bus_release(s_send.held);
+        s_send.held = NULL;
+    }
+    return s_send.chain_failed ? ESP_FAIL : ESP_OK;
+}
+
+/**
+ * @brief Flow control timeout (N_Bs) in microseconds
+ */
+static int64_t fc_timeout_us(void)
+{
+    return (int64_t)(s_send.cfg.fc_timeout_ms ? s_send.cfg.fc_timeout_ms : SEND_FC_TIMEOUT_MS) * 1000;
+}
+
+/**
+ * @brief Wait for a flow control frame and feed it to the transmitter
+ */
+static esp_err_t wait_fc(isotp_tx_t *tx)
+{
+    int64_t wait_start_us = s_send.last_done_us;
+    int64_t deadline_us = esp_timer_get_time() + fc_timeout_us();
+    uint32_t waits = 0;
+    
+    while (tx->state == ISOTP_TX_WAIT_FC) {
+        const rx_bus_frame_t *rx_frame = peer_receive(deadline_us);
+        if (rx_frame == NULL) {
+            return ESP_ERR_TIMEOUT;
+        }
+        
+        const twai_frame_t *frame = &rx_frame->frame;
+        if (isotp_tx_on_fc(tx, frame->buffer, (uint8_t)twaifd_dlc2len(frame->header.dlc))) {
+            uint32_t latency_us = (uint32_t)(rx_frame->timestamp_us - wait_start_us);
+            if (latency_us > s_send.fc_latency_max_us) {
+                s_send.fc_latency_max_us = latency_us;
+            }
+            if (tx->state == ISOTP_TX_WAIT_FC) {
+                // WAIT: the receiver asks for more time, the timeout restarts
+                s_send.fc_waits++;
+                if (++waits > SEND_FC_WAIT_MAX) {
+                    rx_bus_release(rx_frame);
+                    return ESP_ERR_TIMEOUT;
+                }
+                deadline_us = esp_timer_get_time() + fc_timeout_us();
+            } else if (tx->state == ISOTP_TX_SEND) {
+                s_send.block_size = frame->buffer[1];
+            }
+        }
+        rx_bus_release(rx_frame);
+    }
+    return tx->state == ISOTP_TX_ABORTED ? ESP_ERR_INVALID_RESPONSE : ESP_OK;
+}
+
+esp_err_t isotp_send_open(const isotp_send_config_t *config)
+{
+    uint32_t max_id = config->extended ? TWAI_EXT_ID_MASK : TWAI_STD_ID_MASK;
+    if (config->tx_id > max_id || config->rx_id > max_id) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (can_tx_get_node() == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    portENTER_CRITICAL(&s_send_mux);
+    bool busy = s_send.busy;
+    s_send.busy = true;
+    portEXIT_CRITICAL(&s_send_mux);
+    if (busy) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    if (s_send.done_sem == NULL) {
+        s_send.done_sem = xSemaphoreCreateBinary();
+    }
+    // Subscribed for the whole session, so no flow control or response can be missed
+    esp_err_t ret = s_send.done_sem ? rx_bus_subscribe("isotp", SEND_RING_DEPTH, &s_send.sub) : ESP_ERR_NO_MEM;
+    if (ret != ESP_OK) {
+        s_send.busy = false;
+        return ret;
+    }
+    s_send.cfg = *config;
+    s_send.held = NULL;
+    return ESP_OK;
+}
+
+esp_err_t isotp_send_message(const uint8_t *data, uint16_t len)
+{
+    if (s_send.sub == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (len == 0 || len > ISOTP_MAX_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    portENTER_CRITICAL(&s_send_mux);
+    s_send.len = len;
+    s_send.frames_sent = 0;
+    s_send.blocks = 0;
+    s_send.fc_waits = 0;
+    s_send.block_size = 0;
+    s_send.fc_latency_max_us = 0;
+    s_send.first_release_us = 0;
+    s_send.last_done_us = 0;
+    s_send.sep_count = 0;
+    s_send.sep_err_sum = 0;
+    s_send.sep_err_min = 0;
+    s_send.sep_err_max = 0;
+    portEXIT_CRITICAL(&s_send_mux);
+    
+    esp_err_t ret = ESP_OK;
+    isotp_tx_t tx;
+    isotp_tx_start(&tx, data, len, s_send.cfg.padding);
+    while (ret == ESP_OK && tx.state != ISOTP_TX_DONE) {
+        if (tx.state == ISOTP_TX_WAIT_FC) {
+            ret = wait_fc(&tx);
+            continue;
+        }
+        
+        // Single frame, first frame, or a block of consecutive frames
+        bool block = tx.pos != 0;
+        uint16_t count = 0;
+        while (tx.state == ISOTP_TX_SEND && isotp_tx_next(&tx, s_send.frames[count]) != 0) {
+            count++;
+        }
+        ret = run_chain(count, block ? tx.stmin_us : 0);
+        if (block) {
+            s_send.blocks++;
+        }
+    }
+    
+    portENTER_CRITICAL(&s_send_mux);
+    s_send.stmin_us = tx.stmin_us;
+    s_send.last_result = ret;
+    if (ret == ESP_OK) {
+        s_send.transfers++;
+    } else {
+        s_send.failures++;
+    }
+    portEXIT_CRITICAL(&s_send_mux);
+    if (ret != ESP_OK) {
+        ESP_LOGD(TAG, "Transfer to %lX failed: %s", (unsigned long)s_send.cfg.tx_id, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/**
+ * @brief Send a flow control frame for a message we receive
+ */
+static esp_err_t send_fc(uint8_t status)
+{
+    uint8_t data[8];
+    isotp_build_fc(data, status, 0, 0, s_send.cfg.padding);
+    twai_frame_t frame = {
+        .header = {
+            .id = s_send.cfg.tx_id,
+            .ide = s_send.cfg.extended,
+            .dlc = 8,
+        },
+        .buffer = data,
+        .buffer_len = 8,
+    };
+    return can_tx_send(&frame);
+}
+
+esp_err_t isotp_send_receive(uint8_t *buf, uint16_t size, uint16_t *len, uint32_t timeout_ms)
+{
+    if (s_send.sub == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    isotp_rx_t rx;
+    isotp_rx_init(&rx, buf, size, 0);
+    int64_t deadline_us = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    
+    while (true) {
+        const rx_bus_frame_t *rx_frame = peer_receive(deadline_us);
+        if (rx_frame == NULL) {
+            return ESP_ERR_TIMEOUT;
+        }
+        const twai_frame_t *frame = &rx_frame->frame;
+        isotp_rx_result_t result = isotp_rx_feed(&rx, frame->buffer, (uint8_t)twaifd_dlc2len(frame->header.dlc));
+        rx_bus_release(rx_frame);
+        
+        switch (result) {
+        case ISOTP_RX_COMPLETE:
+            *len = rx.len;
+            return ESP_OK;
+        case ISOTP_RX_SEND_FC:
+            // No block limit and no separation time: the rest of the message is sent at bus speed
+            send_fc(ISOTP_FC_CTS);
+            deadline_us = esp_timer_get_time() + fc_timeout_us();
+            break;
+        case ISOTP_RX_IN_PROGRESS:
+            // Consecutive frame timeout (N_Cr)
+            deadline_us = esp_timer_get_time() + fc_timeout_us();
+            break;
+        case ISOTP_RX_OVERFLOW:
+            send_fc(ISOTP_FC_OVFLW);
+            return ESP_ERR_INVALID_SIZE;
+        case ISOTP_RX_SEQ_ERROR:
+            return ESP_ERR_INVALID_RESPONSE;
+        default:
+            break;
+        }
+    }
+}
+
+void isotp_send_close(void)
+{
+    if (s_send.sub == NULL) {
+        return;
+    }
+    if (s_send.held != NULL) {
+        rx_bus_release(s_send.held);
+        s_send.held = NULL;
+    }
+    rx_bus_unsubscribe(s_send.sub);
+    s_send.sub = NULL;
+    s_send.busy = false;
+}
+
+esp_err_t isotp_send(const isotp_send_config_t *config, const uint8_t *data, uint16_t len)
+{
+    if (len == 0 || len > ISOTP_MAX_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t ret = isotp_send_open(config);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = isotp_send_message(data, len);
+    isotp_send_close();
+    return ret;
+}
+
+void isotp_send_get_status(isotp_send_status_t *out)
+{
+    portENTER_CRITICAL(&s_send_mux);
+    out->busy = s_send.busy;
+    out->transfers = s_send.transfers;
+    out->failures = s_send.failures;
+    out->last_result = s_send.last_result;
+    out->len = s_send.len;
+    out->frames = s_send.frames_sent;
+    out->blocks = s_send.blocks;
+    out->fc_waits = s_send.fc_waits;
+    out->block_size = s_send.block_size;
+    out->stmin_us = s_send.stmin_us;
+    int64_t duration_us = s_send.last_done_us - s_send.first_release_us;
+    out->duration_us = duration_us > 0 ? (uint32_t)duration_us : 0;
+    out->bytes_per_s = duration_us > 0 ? (uint32_t)((uint64_t)s_send.len * 1000000 / duration_us) : 0;
+    out->fc_latency_max_us = s_send.fc_latency_max_us;
+    out->sep_count = s_send.sep_count;
+    out->sep_err_min_us = s_send.sep_err_min;
+    out->sep_err_avg_us = s_send.sep_count ? (int32_t)(s_send.sep_err_sum / s_send.sep_count) : 0;
+    out->sep_err_max_us = s_send.sep_err_max;
+    portEXIT_CRITICAL(&s_send_mux);
+}
+
+/**
+ * @brief Append hex bytes to the staged message
+ */
+static bool stage_hex(const char *hex)
+{
+    size_t hex_len = strlen(hex);
+    if (hex_len == 0 || hex_len % 2 || s_msg_len + hex_len / 2 > sizeof(s_msg)) {
+        return false;
+    }
+    for (size_t i = 0; i < hex_len / 2; i++) {
+        char byte[3] = {hex[2 * i], hex[2 * i + 1], '\0'};
+        char *end;
+        s_msg[s_msg_len + i] = (uint8_t)strtoul(byte, &end, 16);
+        if (*end != '\0') {
+            return false;
+        }
+    }
+    s_msg_len += hex_len / 2;
+    return true;
+}
+
+/**
+ * @brief "tp" command handler
+ */
+static int tp_cmd_handler(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&tp_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, tp_args.end, argv[0]);
+        return 1;
+    }
+    
+    const char *action = tp_args.action->count ? tp_args.action->sval[0] : "show";
+    int count = tp_args.params->count;
+    const char *const *params = tp_args.params->sval;
+    
+    if (strcmp(action, "data") == 0) {
+        for (int i = 0; i < count; i++) {
+            if (!stage_hex(params[i])) {
+                printf("tp data: bad hex or message over %u bytes\n", ISOTP_MAX_LEN);
+                return 1;
+            }
+        }
+        printf("tp: %u byte(s) staged\n", s_msg_len);
+        return 0;
+    } else if (strcmp(action, "clear") == 0) {
+        s_msg_len = 0;
+    } else if (strcmp(action, "send") == 0) {
+        if (count < 2 || count > 3 || (count == 3 && !stage_hex(params[2]))) {
+            printf("tp send: need <tx_id> <rx_id> [<hex>]\n");
+            return 1;
+        }
+        isotp_send_config_t config = {
+            .tx_id = strtoul(params[0], NULL, 16),
+            .rx_id = strtoul(params[1], NULL, 16),
+            .extended = tp_args.ext->count > 0,
+            .padding = tp_args.padding->count ? tp_args.padding->ival[0] : 0xAA,
+            .fc_timeout_ms = tp_args.timeout->count ? tp_args.timeout->ival[0] : 0,
+        };
+        esp_err_t ret = isotp_send(&config, s_msg, s_msg_len);
+        s_msg_len = 0;
+        if (ret != ESP_OK) {
+            printf("tp send: %s\n", esp_err_to_name(ret));
+            return 1;
+        }
+    } else if (strcmp(action, "show") != 0) {
+        printf("tp: unknown action '%s'\n", action);
+        return 1;
+    }
+    
+    isotp_send_status_t st;
+    isotp_send_get_status(&st);
+    printf("tp: %lu sent, %lu failed; last %s: %u bytes, %u frames, %u blocks (BS %u, STmin %lu us, %u waits), "
+           "%lu us, %lu bytes/s, FC wait max %lu us, separation error %ld/%ld/%ld us (min/avg/max, n=%lu)\n",
+           (unsigned long)st.transfers, (unsigned long)st.failures, esp_err_to_name(st.last_result), st.len,
+           st.frames, st.blocks, st.block_size, (unsigned long)st.stmin_us, st.fc_waits,
+           (unsigned long)st.duration_us, (unsigned long)st.bytes_per_s, (unsigned long)st.fc_latency_max_us,
+           (long)st.sep_err_min_us, (long)st.sep_err_avg_us, (long)st.sep_err_max_us, (unsigned long)st.sep_count);
+    return 0;
+}
+
+void isotp_send_register_commands(void)
+{
+    tp_args.action = arg_str0(NULL, NULL, "<send|data|clear|show>", "Action (default: show)");
+    tp_args.params = arg_strn(NULL, NULL, "<arg>", 0, 8, "send: <tx_id> <rx_id> [<hex>] (IDs in hex); data: <hex>...");
+    tp_args.ext = arg_lit0("x", "extended", "send: 29-bit identifiers");
+    tp_args.padding = arg_int0("p", "padding", "<byte>", "send: padding byte (default: 0xAA)");
+    tp_args.timeout = arg_int0("t", "timeout", "<ms>", "send: flow control timeout (default: 1000)");
+    tp_args.end = arg_end(6);
+    
+    const esp_console_cmd_t tp_cmd = {
+        .command = "tp",
+        .help = "ISO-TP transmission on the device, consecutive frames paced by the receiver's STmin\n"
+        "  tp data 2EF190 3132333435363738  # stage a message (repeat for long ones)\n"
+        "  tp send 7E0 7E8                  # send it, then print throughput and timing",
+        .hint = NULL,
+        .func = &tp_cmd_handler,
+        .argtable = &tp_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&tp_cmd));
+}
@@ -0,0 +1,136 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "isotp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief On-device ISO-TP transmission
+ *
+ * Sends a message of up to 4095 bytes with the segmentation of isotp.h:
+ * first frame, flow control from the receiver, then consecutive frames in
+ * blocks of the announced size. Only the message comes from the host, so
+ * USB latency cannot break the receiver's block size or separation time.
+ *
+ * The consecutive frames of a block are prepared in advance and chained
+ * from the TX-done interrupt: each one is scheduled on the can_tx GPTimer
+ * at the completion of the previous frame plus STmin, which ISO 15765-2
+ * counts from the end of a frame. The 100-900 us separation times
+ * (0xF1-0xF9) are kept like the millisecond ones. The separation achieved
+ * is measured from the completion of each frame to the release of the
+ * next one; a frame that loses arbitration starts later than that, never
+ * earlier.
+ *
+ * For request/response protocols a session keeps one receiver subscription
+ * across messages: isotp_send_open(), then isotp_send_message() and
+ * isotp_send_receive() as often as needed, then isotp_send_close(). The
+ * response is received with our own flow control (no block limit, no
+ * separation time), so it comes at bus speed as well.
+ */
+
+/** @brief Consecutive frames of the longest message */
+#define ISOTP_SEND_MAX_CF           ((ISOTP_MAX_LEN - 6 + 7 - 1) / 7)
+
+/**
+ * @brief Transfer parameters
+ */
+typedef struct {
+    uint32_t tx_id;             /**< Identifier of our frames */
+    uint32_t rx_id;             /**< Identifier of the receiver's flow control */
+    bool extended;              /**< 29-bit identifiers */
+    uint8_t padding;            /**< Padding byte */
+    uint32_t fc_timeout_ms;     /**< Flow control timeout (N_Bs, 0: 1000) */
+} isotp_send_config_t;
+
+/**
+ * @brief Sender status: counters and the results of the last transfer
+ */
+typedef struct {
+    bool busy;                  /**< Transfer in progress */
+    uint32_t transfers;         /**< Transfers completed */
+    uint32_t failures;          /**< Transfers failed */
+    esp_err_t last_result;
+    uint16_t len;               /**< Message length */
+    uint16_t frames;            /**< Frames sent */
+    uint16_t blocks;            /**< Blocks of consecutive frames */
+    uint16_t fc_waits;          /**< WAIT flow control frames received */
+    uint8_t block_size;         /**< Block size of the last flow control */
+    uint32_t stmin_us;          /**< Separation time of the last flow control */
+    uint32_t duration_us;       /**< First frame release to last frame completion */
+    uint32_t bytes_per_s;       /**< Message bytes per second */
+    uint32_t fc_latency_max_us; /**< Longest wait for a flow control */
+    uint32_t sep_count;         /**< Separations measured */
+    int32_t sep_err_min_us;     /**< Separation achieved minus STmin */
+    int32_t sep_err_avg_us;
+    int32_t sep_err_max_us;
+} isotp_send_status_t;
+
+/**
+ * @brief Start a session with a receiver
+ *
+ * @param config Transfer parameters
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG, ESP_ERR_INVALID_STATE if a session is open or the
+ *         controller is not started, ESP_ERR_NO_MEM
+ */
+esp_err_t isotp_send_open(const isotp_send_config_t *config);
+
+/**
+ * @brief Send a message in the open session, blocking until it has been transmitted
+ *
+ * @param data Message
+ * @param len Message length (1..ISOTP_MAX_LEN)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG, ESP_ERR_INVALID_STATE if no session is open,
+ *         ESP_ERR_TIMEOUT if a flow control or a frame completion did not come,
+ *         ESP_ERR_INVALID_RESPONSE on overflow or an invalid flow control, ESP_FAIL if a frame
+ *         was not transmitted
+ */
+esp_err_t isotp_send_message(const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Receive a message from the receiver in the open session
+ *
+ * @param buf Message buffer
+ * @param size Buffer size
+ * @param len Output: message length
+ * @param timeout_ms Time allowed for the message to start
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no session is open, ESP_ERR_TIMEOUT,
+ *         ESP_ERR_INVALID_SIZE if the message does not fit, ESP_ERR_INVALID_RESPONSE on a sequence error
+ */
+esp_err_t isotp_send_receive(uint8_t *buf, uint16_t size, uint16_t *len, uint32_t timeout_ms);
+
+/**
+ * @brief End the session
+ */
+void isotp_send_close(void);
+
+/**
+ * @brief Send a single message: open, send and close
+ *
+ * @return As isotp_send_open() and isotp_send_message()
+ */
+esp_err_t isotp_send(const isotp_send_config_t *config, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Get the sender status
+ */
+void isotp_send_get_status(isotp_send_status_t *out);
+
+/**
+ * @brief Register the 'tp' extension command
+ */
+void isotp_send_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,306 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "n2k.h"
+#include "rx_bus.h"
+#include "clock_sync.h"
+#include "host_link.h"
+#include "slcan_protocol.h"
+
+static const char *TAG = "n2k";
+
+// Subscriber ring: a burst of fast-packet frames from several sources
+#define N2K_RING_DEPTH          256
+
+// Expiry check interval
+#define N2K_EXPIRE_US           100000
+
+// One record: header plus the largest payload in hex
+#define N2K_LINE_LEN            (48 + 2 * N2K_MAX_PAYLOAD)
+
+// Engine state
+static struct {
+    volatile bool running;
+    n2k_config_t cfg;
+    rx_bus_sub_handle_t sub;
+    SemaphoreHandle_t done_sem;
+    n2k_fast_t fast;
+    uint32_t frames;
+    uint32_t decoded;
+    uint32_t records;
+    uint32_t records_dropped;
+} s_n2k;
+
+static portMUX_TYPE s_n2k_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static char s_line[N2K_LINE_LEN];
+
+/** @brief Command line arguments for n2k command */
+static struct {
+    struct arg_str *action;
+    struct arg_lit *raw;
+    struct arg_int *timeout;
+    struct arg_end *end;
+} n2k_args;
+
+/**
+ * @brief Whether the engine handles a PGN
+ */
+static bool handles_pgn(uint32_t pgn)
+{
+    return n2k_is_fast_packet(pgn) || (!s_n2k.cfg.raw && n2k_find_pgn(pgn) != NULL);
+}
+
+/**
+ * @brief Send the record of a complete message
+ */
+static void send_message(const n2k_header_t *hdr, const uint8_t *data, uint16_t len, int64_t time_us)
+{
+    if (!slcan_is_open() || !host_link_present()) {
+        s_n2k.records_dropped++;
+        return;
+    }
+    
+    const n2k_pgn_t *dec = s_n2k.cfg.raw ? NULL : n2k_find_pgn(hdr->pgn);
+    int pos;
+    if (dec != NULL) {
+        pos = snprintf(s_line, sizeof(s_line), "Nd %lld %lu %u", (long long)clock_sync_to_host(time_us),
+                       (unsigned long)hdr->pgn, hdr->src);
+        pos += n2k_format_fields(dec, data, len, &s_line[pos], sizeof(s_line) - pos - 1);
+        s_n2k.decoded++;
+    } else {
+        pos = snprintf(s_line, sizeof(s_line), "Nf %lld %lu %u %u ", (long long)clock_sync_to_host(time_us),
+                       (unsigned long)hdr->pgn, hdr->src, hdr->dst);
+        for (uint16_t i = 0; i < len; i++) {
+            pos += snprintf(&s_line[pos], sizeof(s_line) - pos, "%02X", data[i]);
+        }
+    }
+    s_line[pos++] = '\r';
+    host_link_write(s_line, pos);
+    s_n2k.records++;
+}
+
+/**
+ * @brief Handle a frame of a PGN the engine owns
+ */
+static void handle_frame(const rx_bus_frame_t *rx_frame)
+{
+    const twai_frame_t *frame = &rx_frame->frame;
+    n2k_header_t hdr;
+    n2k_parse_id(frame->header.id, &hdr);
+    if (!handles_pgn(hdr.pgn)) {
+        return;
+    }
+    uint8_t len = twaifd_dlc2len(frame->header.dlc);
+    if (len > 8) {
+        len = 8;
+    }
+    s_n2k.frames++;
+    
+    if (!n2k_is_fast_packet(hdr.pgn)) {
+        send_message(&hdr, frame->buffer, len, rx_frame->timestamp_us);
+        return;
+    }
+    const n2k_fast_msg_t *msg;
+    portENTER_CRITICAL(&s_n2k_mux);
+    n2k_fast_result_t r = n2k_fast_feed(&s_n2k.fast, &hdr, frame->buffer, len, rx_frame->timestamp_us, &msg);
+    portEXIT_CRITICAL(&s_n2k_mux);
+    if (r == N2K_FAST_COMPLETE) {
+        send_message(&msg->hdr, msg->data, msg->len, msg->time_us);
+    }
+}
+
+/**
+ * @brief Engine task: RX bus "n2k" subscriber
+ */
+static void n2k_task(void *arg)
+{
+    int64_t next_expire_us = esp_timer_get_time() + N2K_EXPIRE_US;
+    
+    while (s_n2k.running) {
+        const rx_bus_frame_t *rx_frame = rx_bus_receive(s_n2k.sub, pdMS_TO_TICKS(100));
+        if (rx_frame != NULL) {
+            handle_frame(rx_frame);
+            rx_bus_release(rx_frame);
+        }
+        
+        int64_t now = esp_timer_get_time();
+        if (now >= next_expire_us) {
+            portENTER_CRITICAL(&s_n2k_mux);
+            n2k_fast_expire(&s_n2k.fast, now, (int64_t)s_n2k.cfg.timeout_ms * 1000);
+            portEXIT_CRITICAL(&s_n2k_mux);
+            next_expire_us = now + N2K_EXPIRE_US;
+        }
+    }
+    
+    rx_bus_unsubscribe(s_n2k.sub);
+    s_n2k.sub = NULL;
+    
+    xSemaphoreGive(s_n2k.done_sem);
+    vTaskDelete(NULL);
+}
+
+esp_err_t n2k_start(const n2k_config_t *config)
+{
+    if (s_n2k.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (config->timeout_ms == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_n2k.done_sem == NULL) {
+        s_n2k.done_sem = xSemaphoreCreateBinary();
+        if (s_n2k.done_sem == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    xSemaphoreTake(s_n2k.done_sem, 0);
+    
+    esp_err_t ret = rx_bus_subscribe("n2k", N2K_RING_DEPTH, &s_n2k.sub);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    portENTER_CRITICAL(&s_n2k_mux);
+    s_n2k.cfg = *config;
+    n2k_fast_init(&s_n2k.fast);
+    s_n2k.frames = 0;
+    s_n2k.decoded = 0;
+    s_n2k.records = 0;
+    s_n2k.records_dropped = 0;
+    s_n2k.running = true;
+    portEXIT_CRITICAL(&s_n2k_mux);
+    
+    if (xTaskCreate(n2k_task, "n2k", 3072, NULL, 9, NULL) != pdPASS) {
+        s_n2k.running = false;
+        rx_bus_unsubscribe(s_n2k.sub);
+        s_n2k.sub = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Started%s", config->raw ? " (raw)" : "");
+    return ESP_OK;
+}
+
+esp_err_t n2k_stop(void)
+{
+    if (!s_n2k.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    s_n2k.running = false;
+    if (xSemaphoreTake(s_n2k.done_sem, pdMS_TO_TICKS(2000)) != pdTRUE) {
+        ESP_LOGE(TAG, "N2K task did not stop");
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+bool n2k_owns_frame(const twai_frame_t *frame)
+{
+    if (!s_n2k.running || !frame->header.ide || frame->header.rtr) {
+        return false;
+    }
+    n2k_header_t hdr;
+    n2k_parse_id(frame->header.id, &hdr);
+    return handles_pgn(hdr.pgn);
+}
+
+void n2k_get_status(n2k_status_t *out)
+{
+    portENTER_CRITICAL(&s_n2k_mux);
+    out->running = s_n2k.running;
+    out->raw = s_n2k.cfg.raw;
+    out->frames = s_n2k.frames;
+    out->messages = s_n2k.fast.messages;
+    out->decoded = s_n2k.decoded;
+    out->seq_errors = s_n2k.fast.seq_errors;
+    out->no_buffer = s_n2k.fast.no_buffer;
+    out->timeouts = s_n2k.fast.timeouts;
+    out->records = s_n2k.records;
+    out->records_dropped = s_n2k.records_dropped;
+    portEXIT_CRITICAL(&s_n2k_mux);
+}
+
+/**
+ * @brief "n2k" command handler
+ */
+static int n2k_cmd_handler(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&n2k_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, n2k_args.end, argv[0]);
+        return 1;
+    }
+    
+    const char *action = n2k_args.action->count ? n2k_args.action->sval[0] : "show";
+    
+    if (strcmp(action, "start") == 0) {
+        n2k_config_t cfg = {
+            .raw = n2k_args.raw->count > 0,
+            .timeout_ms = n2k_args.timeout->count ? n2k_args.timeout->ival[0] : 750,
+        };
+        esp_err_t ret = n2k_start(&cfg);
+        if (ret != ESP_OK) {
+            printf("n2k start: %s\n", esp_err_to_name(ret));
+            return 1;
+        }
+    } else if (strcmp(action, "stop") == 0) {
+        if (n2k_stop() != ESP_OK) {
+            printf("n2k: not running\n");
+            return 1;
+        }
+    } else if (strcmp(action, "pgns") == 0) {
+        size_t count;
+        const n2k_pgn_t *table = n2k_pgn_table(&count);
+        for (size_t i = 0; i < count; i++) {
+            printf("  %lu %s:", (unsigned long)table[i].pgn, table[i].name);
+            for (uint8_t f = 0; f < table[i].count; f++) {
+                printf(" %s", table[i].fields[f].name);
+            }
+            printf("%s\n", n2k_is_fast_packet(table[i].pgn) ? " (fast-packet)" : "");
+        }
+    } else if (strcmp(action, "show") != 0) {
+        printf("n2k: unknown action '%s'\n", action);
+        return 1;
+    }
+    
+    n2k_status_t st;
+    n2k_get_status(&st);
+    printf("n2k: %s%s, %lu frames, %lu fast-packet messages, %lu decoded, %lu sequence errors, %lu no buffer, "
+           "%lu timeouts, %lu records, %lu dropped\n", st.running ? "running" : "stopped", st.raw ? " (raw)" : "",
+           (unsigned long)st.frames, (unsigned long)st.messages, (unsigned long)st.decoded,
+           (unsigned long)st.seq_errors, (unsigned long)st.no_buffer, (unsigned long)st.timeouts,
+           (unsigned long)st.records, (unsigned long)st.records_dropped);
+    return 0;
+}
+
+void n2k_register_commands(void)
+{
+    n2k_args.action = arg_str0(NULL, NULL, "<start|stop|show|pgns>", "Action (default: show)");
+    n2k_args.raw = arg_lit0("r", "raw", "start: reassemble fast-packets only, no decoding");
+    n2k_args.timeout = arg_int0("t", "timeout", "<ms>", "start: fast-packet reassembly timeout (default: 750)");
+    n2k_args.end = arg_end(4);
+    
+    const esp_console_cmd_t n2k_cmd = {
+        .command = "n2k",
+        .help = "NMEA 2000 fast-packet reassembly and PGN decoding; one record per message\n"
+        "  n2k start      # decode the PGN table, reassemble fast-packets\n"
+        "  n2k pgns       # list the decoded PGNs and their fields",
+        .hint = NULL,
+        .func = &n2k_cmd_handler,
+        .argtable = &n2k_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&n2k_cmd));
+}
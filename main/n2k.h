@@ -0,0 +1,88 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_twai.h"
+#include "n2k_proto.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief NMEA 2000 message engine
+ *
+ * While running, the frames of fast-packet PGNs and of the PGNs in the
+ * decode table are consumed on the device; every other frame is still
+ * forwarded. Each complete message reaches the host as one record:
+ *
+ *   Nd <time_us> <pgn> <src> <value> ...        decoded PGN (see n2k_proto.c)
+ *   Nf <time_us> <pgn> <src> <dst> <data>       reassembled fast-packet, hex
+ *
+ * The time of a fast-packet message is the time of its first frame.
+ * Incomplete messages are dropped after the reassembly timeout.
+ */
+
+/**
+ * @brief Engine parameters
+ */
+typedef struct {
+    bool raw;                   /**< Do not decode: fast-packet messages only, as Nf */
+    uint32_t timeout_ms;        /**< Fast-packet reassembly timeout */
+} n2k_config_t;
+
+/**
+ * @brief Engine status
+ */
+typedef struct {
+    bool running;
+    bool raw;
+    uint32_t frames;            /**< Frames consumed */
+    uint32_t messages;          /**< Fast-packet messages reassembled */
+    uint32_t decoded;           /**< Messages decoded */
+    uint32_t seq_errors;        /**< Fast-packet messages with a lost frame */
+    uint32_t no_buffer;         /**< Fast-packet messages without a free buffer */
+    uint32_t timeouts;          /**< Fast-packet messages never completed */
+    uint32_t records;           /**< Records sent to the host */
+    uint32_t records_dropped;   /**< Records dropped (channel closed) */
+} n2k_status_t;
+
+/**
+ * @brief Start the engine
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if running, ESP_ERR_INVALID_ARG, ESP_ERR_NO_MEM
+ */
+esp_err_t n2k_start(const n2k_config_t *config);
+
+/**
+ * @brief Stop the engine
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not running, ESP_ERR_TIMEOUT
+ */
+esp_err_t n2k_stop(void);
+
+/**
+ * @brief Whether a received frame is consumed by the engine (not forwarded to the host)
+ */
+bool n2k_owns_frame(const twai_frame_t *frame);
+
+/**
+ * @brief Get the engine status
+ */
+void n2k_get_status(n2k_status_t *out);
+
+/**
+ * @brief Register the 'n2k' extension command
+ */
+void n2k_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
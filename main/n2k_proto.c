@@ -0,0 +1,367 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "n2k_proto.h"
+
+// Proprietary fast-packet range (all PGNs in it use the fast-packet transport)
+#define N2K_PROPRIETARY_FAST_FIRST  130816
+#define N2K_PROPRIETARY_FAST_LAST   131071
+
+// Standard PGNs sent as fast-packet, sorted
+static const uint32_t s_fast_pgns[] = {
+    126208, 126464, 126720, 126983, 126984, 126985, 126986, 126987, 126988, 126996, 126998, 127233, 127237,
+    127489, 127494, 127495, 127496, 127497, 127498, 127503, 127504, 127506, 127507, 127509, 127510, 127511,
+    127512, 127513, 127514, 128275, 128520, 128538, 129029, 129038, 129039, 129040, 129041, 129044, 129045,
+    129284, 129285, 129301, 129302, 129538, 129540, 129541, 129542, 129545, 129547, 129549, 129551, 129556,
+    129792, 129793, 129794, 129795, 129796, 129797, 129798, 129799, 129800, 129801, 129802, 129803, 129804,
+    129805, 129806, 129807, 129808, 129809, 129810, 130052, 130053, 130054, 130060, 130061, 130064, 130065,
+    130066, 130067, 130068, 130069, 130070, 130071, 130072, 130073, 130074, 130320, 130321, 130322, 130323,
+    130324, 130330, 130560, 130567, 130569, 130570, 130571, 130572, 130573, 130574, 130577, 130578, 130580,
+    130581, 130583, 130584, 130586,
+};
+
+// Common navigation PGNs, sorted. Angles in 1e-4 rad, speeds in 0.01 m/s, temperatures in 0.01 K
+static const n2k_pgn_t s_pgns[] = {
+    {126992, "system_time", 4, {
+        {"sid", 0, 8, false, 1, 0},
+        {"source", 8, 4, false, 1, 0},
+        {"date", 16, 16, false, 1, 0},
+        {"time", 32, 32, false, 1, 4},
+    }},
+    {127250, "heading", 5, {
+        {"sid", 0, 8, false, 1, 0},
+        {"heading", 8, 16, false, 1, 4},
+        {"deviation", 24, 16, true, 1, 4},
+        {"variation", 40, 16, true, 1, 4},
+        {"reference", 56, 2, false, 1, 0},
+    }},
+    {127251, "rate_of_turn", 2, {
+        {"sid", 0, 8, false, 1, 0},
+        {"rate", 8, 32, true, 3125, 11},
+    }},
+    {127257, "attitude", 4, {
+        {"sid", 0, 8, false, 1, 0},
+        {"yaw", 8, 16, true, 1, 4},
+        {"pitch", 24, 16, true, 1, 4},
+        {"roll", 40, 16, true, 1, 4},
+    }},
+    {127488, "engine_rapid", 4, {
+        {"instance", 0, 8, false, 1, 0},
+        {"speed", 8, 16, false, 25, 2},
+        {"boost_pressure", 24, 16, false, 100, 0},
+        {"tilt_trim", 40, 8, true, 1, 0},
+    }},
+    {127489, "engine_dynamic", 9, {
+        {"instance", 0, 8, false, 1, 0},
+        {"oil_pressure", 8, 16, false, 100, 0},
+        {"oil_temperature", 24, 16, false, 1, 1},
+        {"temperature", 40, 16, false, 1, 2},
+        {"alternator_voltage", 56, 16, true, 1, 2},
+        {"fuel_rate", 72, 16, true, 1, 1},
+        {"hours", 88, 32, false, 1, 0},
+        {"coolant_pressure", 120, 16, false, 100, 0},
+        {"fuel_pressure", 136, 16, false, 1000, 0},
+    }},
+    {127508, "battery_status", 5, {
+        {"instance", 0, 8, false, 1, 0},
+        {"voltage", 8, 16, true, 1, 2},
+        {"current", 24, 16, true, 1, 1},
+        {"temperature", 40, 16, false, 1, 2},
+        {"sid", 56, 8, false, 1, 0},
+    }},
+    {128259, "speed", 3, {
+        {"sid", 0, 8, false, 1, 0},
+        {"water", 8, 16, false, 1, 2},
+        {"ground", 24, 16, false, 1, 2},
+    }},
+    {128267, "water_depth", 4, {
+        {"sid", 0, 8, false, 1, 0},
+        {"depth", 8, 32, false, 1, 2},
+        {"offset", 40, 16, true, 1, 3},
+        {"range", 56, 8, false, 10, 0},
+    }},
+    {128275, "distance_log", 4, {
+        {"date", 0, 16, false, 1, 0},
+        {"time", 16, 32, false, 1, 4},
+        {"log", 48, 32, false, 1, 0},
+        {"trip", 80, 32, false, 1, 0},
+    }},
+    {129025, "position_rapid", 2, {
+        {"latitude", 0, 32, true, 1, 7},
+        {"longitude", 32, 32, true, 1, 7},
+    }},
+    {129026, "cog_sog_rapid", 4, {
+        {"sid", 0, 8, false, 1, 0},
+        {"reference", 8, 2, false, 1, 0},
+        {"cog", 16, 16, false, 1, 4},
+        {"sog", 32, 16, false, 1, 2},
+    }},
+    {129029, "gnss_position", 12, {
+        {"sid", 0, 8, false, 1, 0},
+        {"date", 8, 16, false, 1, 0},
+        {"time", 24, 32, false, 1, 4},
+        {"latitude", 56, 64, true, 1, 16},
+        {"longitude", 120, 64, true, 1, 16},
+        {"altitude", 184, 64, true, 1, 6},
+        {"gnss_type", 248, 4, false, 1, 0},
+        {"method", 252, 4, false, 1, 0},
+        {"integrity", 256, 2, false, 1, 0},
+        {"satellites", 264, 8, false, 1, 0},
+        {"hdop", 272, 16, true, 1, 2},
+        {"pdop", 288, 16, true, 1, 2},
+    }},
+    {130306, "wind", 4, {
+        {"sid", 0, 8, false, 1, 0},
+        {"speed", 8, 16, false, 1, 2},
+        {"angle", 24, 16, false, 1, 4},
+        {"reference", 40, 3, false, 1, 0},
+    }},
+    {130310, "environment", 4, {
+        {"sid", 0, 8, false, 1, 0},
+        {"water_temperature", 8, 16, false, 1, 2},
+        {"air_temperature", 24, 16, false, 1, 2},
+        {"pressure", 40, 16, false, 100, 0},
+    }},
+    {130312, "temperature", 5, {
+        {"sid", 0, 8, false, 1, 0},
+        {"instance", 8, 8, false, 1, 0},
+        {"source", 16, 8, false, 1, 0},
+        {"actual", 24, 16, false, 1, 2},
+        {"set", 40, 16, false, 1, 2},
+    }},
+};
+
+void n2k_parse_id(uint32_t id, n2k_header_t *out)
+{
+    uint8_t pf = (uint8_t)(id >> 16);
+    uint8_t ps = (uint8_t)(id >> 8);
+    // EDP, DP and PDU format; PDU1 (PF < 240) carries the destination in PS
+    uint32_t pgn = (id >> 8) & 0x3FF00;
+    out->priority = (id >> 26) & 0x07;
+    out->src = (uint8_t)id;
+    if (pf < 240) {
+        out->pgn = pgn;
+        out->dst = ps;
+    } else {
+        out->pgn = pgn | ps;
+        out->dst = 0xFF;
+    }
+}
+
+bool n2k_is_fast_packet(uint32_t pgn)
+{
+    if (pgn >= N2K_PROPRIETARY_FAST_FIRST && pgn <= N2K_PROPRIETARY_FAST_LAST) {
+        return true;
+    }
+    size_t lo = 0;
+    size_t hi = sizeof(s_fast_pgns) / sizeof(s_fast_pgns[0]);
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (s_fast_pgns[mid] == pgn) {
+            return true;
+        }
+        if (s_fast_pgns[mid] < pgn) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return false;
+}
+
+void n2k_fast_init(n2k_fast_t *fp)
+{
+    memset(fp, 0, sizeof(*fp));
+}
+
+/**
+ * @brief Buffer of the message being reassembled for a PGN and source
+ */
+static n2k_fast_msg_t *find_msg(n2k_fast_t *fp, uint32_t pgn, uint8_t src)
+{
+    for (int i = 0; i < N2K_FAST_POOL_SIZE; i++) {
+        n2k_fast_msg_t *m = &fp->pool[i];
+        if (m->used && m->hdr.pgn == pgn && m->hdr.src == src) {
+            return m;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Append frame data to a message, up to its total length
+ */
+static void append(n2k_fast_msg_t *m, const uint8_t *data, uint8_t n)
+{
+    if (n > m->len - m->received) {
+        n = m->len - m->received;
+    }
+    memcpy(&m->data[m->received], data, n);
+    m->received += n;
+}
+
+n2k_fast_result_t n2k_fast_feed(n2k_fast_t *fp, const n2k_header_t *hdr, const uint8_t *data, uint8_t len,
+                                int64_t time_us, const n2k_fast_msg_t **msg)
+{
+    if (len < 1) {
+        return N2K_FAST_DROPPED;
+    }
+    uint8_t seq = data[0] >> 5;
+    uint8_t frame = data[0] & 0x1F;
+    n2k_fast_msg_t *m = find_msg(fp, hdr->pgn, hdr->src);
+    
+    if (frame == 0) {
+        if (len < 2 || data[1] == 0 || data[1] > N2K_MAX_PAYLOAD) {
+            return N2K_FAST_DROPPED;
+        }
+        if (m != NULL) {
+            // The previous message of this source never completed
+            fp->seq_errors++;
+        } else {
+            for (int i = 0; i < N2K_FAST_POOL_SIZE && m == NULL; i++) {
+                if (!fp->pool[i].used) {
+                    m = &fp->pool[i];
+                }
+            }
+            if (m == NULL) {
+                fp->no_buffer++;
+                return N2K_FAST_DROPPED;
+            }
+        }
+        m->used = true;
+        m->hdr = *hdr;
+        m->seq = seq;
+        m->next_frame = 1;
+        m->len = data[1];
+        m->received = 0;
+        m->time_us = time_us;
+        append(m, &data[2], len - 2);
+    } else {
+        // Without the first frame the length is unknown: the message is lost
+        if (m == NULL) {
+            return N2K_FAST_DROPPED;
+        }
+        if (seq != m->seq || frame != m->next_frame) {
+            m->used = false;
+            fp->seq_errors++;
+            return N2K_FAST_DROPPED;
+        }
+        m->next_frame++;
+        append(m, &data[1], len - 1);
+    }
+    m->last_us = time_us;
+    
+    if (m->received < m->len) {
+        return N2K_FAST_PARTIAL;
+    }
+    // The buffer is free again but keeps its data until the next call
+    m->used = false;
+    fp->messages++;
+    *msg = m;
+    return N2K_FAST_COMPLETE;
+}
+
+uint32_t n2k_fast_expire(n2k_fast_t *fp, int64_t now_us, int64_t timeout_us)
+{
+    uint32_t n = 0;
+    for (int i = 0; i < N2K_FAST_POOL_SIZE; i++) {
+        n2k_fast_msg_t *m = &fp->pool[i];
+        if (m->used && now_us - m->last_us > timeout_us) {
+            m->used = false;
+            n++;
+        }
+    }
+    fp->timeouts += n;
+    return n;
+}
+
+const n2k_pgn_t *n2k_find_pgn(uint32_t pgn)
+{
+    for (size_t i = 0; i < sizeof(s_pgns) / sizeof(s_pgns[0]); i++) {
+        if (s_pgns[i].pgn == pgn) {
+            return &s_pgns[i];
+        }
+    }
+    return NULL;
+}
+
+const n2k_pgn_t *n2k_pgn_table(size_t *count)
+{
+    *count = sizeof(s_pgns) / sizeof(s_pgns[0]);
+    return s_pgns;
+}
+
+/**
+ * @brief Read a little-endian bit field
+ */
+static uint64_t get_bits(const uint8_t *data, uint16_t offset, uint8_t bits)
+{
+    uint64_t v = 0;
+    for (uint8_t i = 0; i < bits; i++) {
+        uint16_t b = offset + i;
+        v |= (uint64_t)((data[b >> 3] >> (b & 7)) & 1) << i;
+    }
+    return v;
+}
+
+/**
+ * @brief Format one field, "-" when not available
+ */
+static int format_field(const n2k_field_t *f, const uint8_t *data, uint16_t len, char *out, size_t size)
+{
+    if (f->offset + f->bits > len * 8) {
+        return snprintf(out, size, " -");
+    }
+    uint64_t raw = get_bits(data, f->offset, f->bits);
+    uint64_t max = f->bits == 64 ? UINT64_MAX : (1ULL << f->bits) - 1;
+    int64_t v;
+    if (f->is_signed) {
+        // Largest positive value: not available
+        if (raw == max >> 1) {
+            return snprintf(out, size, " -");
+        }
+        v = (raw & (1ULL << (f->bits - 1))) ? (int64_t)(raw | ~max) : (int64_t)raw;
+    } else {
+        // All ones: not available (single bits have no such value)
+        if (f->bits > 1 && raw == max) {
+            return snprintf(out, size, " -");
+        }
+        v = (int64_t)raw;
+    }
+    v *= f->mul;
+    
+    if (f->decimals == 0) {
+        return snprintf(out, size, " %lld", (long long)v);
+    }
+    uint64_t scale = 1;
+    for (uint8_t i = 0; i < f->decimals; i++) {
+        scale *= 10;
+    }
+    uint64_t mag = v < 0 ? 0 - (uint64_t)v : (uint64_t)v;
+    return snprintf(out, size, " %s%llu.%0*llu", v < 0 ? "-" : "", (unsigned long long)(mag / scale), f->decimals,
+                    (unsigned long long)(mag % scale));
+}
+
+int n2k_format_fields(const n2k_pgn_t *dec, const uint8_t *data, uint16_t len, char *out, size_t size)
+{
+    size_t pos = 0;
+    if (size == 0) {
+        return 0;
+    }
+    out[0] = '\0';
+    for (uint8_t i = 0; i < dec->count; i++) {
+        int n = format_field(&dec->fields[i], data, len, &out[pos], size - pos);
+        if (n < 0 || pos + n >= size) {
+            // Truncated: keep whole fields only
+            out[pos] = '\0';
+            break;
+        }
+        pos += n;
+    }
+    return (int)pos;
+}
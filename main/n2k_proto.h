@@ -0,0 +1,170 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief NMEA 2000 fast-packet reassembly and PGN decoding
+ *
+ * Pure C (no ESP-IDF dependencies) so it can be built and tested on the host.
+ * Fast-packet messages (up to 223 bytes in up to 32 frames) are reassembled
+ * per PGN and source in a fixed pool of buffers; the 3-bit sequence counter
+ * and the frame counter are checked, so interleaved messages from different
+ * sources reassemble independently and a lost frame drops only its message.
+ * A table of common navigation PGNs converts payloads to scaled values.
+ */
+
+/** @brief Largest fast-packet payload: 6 bytes in the first frame, 7 in 31 more */
+#define N2K_MAX_PAYLOAD             223
+
+/** @brief Messages being reassembled at the same time */
+#define N2K_FAST_POOL_SIZE          16
+
+/** @brief Maximum fields of a decoded PGN */
+#define N2K_MAX_FIELDS              12
+
+/**
+ * @brief Fields of the 29-bit CAN ID
+ */
+typedef struct {
+    uint32_t pgn;               /**< Parameter group number */
+    uint8_t priority;           /**< 0 (highest) .. 7 */
+    uint8_t src;                /**< Source address */
+    uint8_t dst;                /**< Destination address (255: broadcast) */
+} n2k_header_t;
+
+/**
+ * @brief Result of feeding a fast-packet frame
+ */
+typedef enum {
+    N2K_FAST_PARTIAL = 0,       /**< Frame stored, message incomplete */
+    N2K_FAST_COMPLETE,          /**< Message complete */
+    N2K_FAST_DROPPED,           /**< Frame out of sequence, no free buffer or invalid */
+} n2k_fast_result_t;
+
+/**
+ * @brief Reassembly buffer
+ */
+typedef struct {
+    bool used;
+    n2k_header_t hdr;           /**< Header of the first frame */
+    uint8_t seq;                /**< Sequence counter (3 bits) */
+    uint8_t next_frame;         /**< Next expected frame counter */
+    uint8_t len;                /**< Total payload length */
+    uint8_t received;           /**< Bytes received */
+    int64_t time_us;            /**< Time of the first frame */
+    int64_t last_us;            /**< Time of the last frame */
+    uint8_t data[N2K_MAX_PAYLOAD];
+} n2k_fast_msg_t;
+
+/**
+ * @brief Fast-packet reassembler
+ */
+typedef struct {
+    n2k_fast_msg_t pool[N2K_FAST_POOL_SIZE];
+    uint32_t messages;          /**< Messages completed */
+    uint32_t seq_errors;        /**< Messages dropped for a lost or foreign frame */
+    uint32_t no_buffer;         /**< Messages dropped for lack of a buffer */
+    uint32_t timeouts;          /**< Messages dropped incomplete */
+} n2k_fast_t;
+
+/**
+ * @brief One field of a decoded PGN
+ */
+typedef struct {
+    const char *name;
+    uint16_t offset;            /**< Bit offset in the payload */
+    uint8_t bits;               /**< Length in bits (1..64) */
+    bool is_signed;
+    uint16_t mul;               /**< Value = raw * mul * 10^-decimals */
+    uint8_t decimals;
+} n2k_field_t;
+
+/**
+ * @brief Decoder of a PGN
+ */
+typedef struct {
+    uint32_t pgn;
+    const char *name;
+    uint8_t count;
+    n2k_field_t fields[N2K_MAX_FIELDS];
+} n2k_pgn_t;
+
+/**
+ * @brief Split a 29-bit CAN ID into PGN, priority, source and destination
+ */
+void n2k_parse_id(uint32_t id, n2k_header_t *out);
+
+/**
+ * @brief Whether a PGN uses the fast-packet transport
+ */
+bool n2k_is_fast_packet(uint32_t pgn);
+
+/**
+ * @brief Reset the reassembler and its counters
+ */
+void n2k_fast_init(n2k_fast_t *fp);
+
+/**
+ * @brief Feed a frame of a fast-packet PGN
+ *
+ * A first frame (frame counter 0) for a source and PGN already being
+ * reassembled drops the incomplete message and starts a new one.
+ *
+ * @param fp Reassembler
+ * @param hdr Header of the frame
+ * @param data Frame payload
+ * @param len Payload length
+ * @param time_us Receive time
+ * @param msg Output (COMPLETE): the message, valid until the next call
+ * @return PARTIAL, COMPLETE or DROPPED
+ */
+n2k_fast_result_t n2k_fast_feed(n2k_fast_t *fp, const n2k_header_t *hdr, const uint8_t *data, uint8_t len,
+                                int64_t time_us, const n2k_fast_msg_t **msg);
+
+/**
+ * @brief Drop messages whose last frame is older than the timeout
+ *
+ * @return Messages dropped
+ */
+uint32_t n2k_fast_expire(n2k_fast_t *fp, int64_t now_us, int64_t timeout_us);
+
+/**
+ * @brief Find the decoder of a PGN
+ *
+ * @return Decoder, NULL if the PGN is not in the table
+ */
+const n2k_pgn_t *n2k_find_pgn(uint32_t pgn);
+
+/**
+ * @brief Decoders of the table, in PGN order
+ *
+ * @param count Output: number of decoders
+ */
+const n2k_pgn_t *n2k_pgn_table(size_t *count);
+
+/**
+ * @brief Format the fields of a payload as " <value>..."
+ *
+ * Values are scaled to SI units (angles in radians, temperatures in kelvin,
+ * latitude/longitude in degrees); "-" marks a field that is not available or
+ * beyond the payload.
+ *
+ * @return Characters written (excluding the terminator)
+ */
+int n2k_format_fields(const n2k_pgn_t *dec, const uint8_t *data, uint16_t len, char *out, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
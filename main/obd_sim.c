@@ -0,0 +1,623 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "obd_sim.h"
+#include "isotp.h"
+#include "can_tx.h"
+#include "rx_bus.h"
+#include "bridge_config.h"
+
+static const char *TAG = "obd_sim";
+
+// ISO 15765-4 11-bit identifiers
+#define OBD_FUNC_ID             0x7DF
+#define OBD_REQ_ID_BASE         0x7E0
+#define OBD_RESP_ID_BASE        0x7E8
+
+#define OBD_PADDING             0xAA
+
+// Flow control timeout (ISO 15765-2 N_Bs)
+#define OBD_FC_TIMEOUT_US       1000000
+
+// OBD subscriber ring
+#define OBD_RING_DEPTH          32
+
+// Longest response: service 01 with 6 PIDs of 4 bytes, or one service 09 PID
+#define OBD_RESP_MAX            (2 + OBD_SIM_MAX_DATA)
+
+// Worst-case classic frame with 8 data bytes, including stuff bits
+#define OBD_FRAME_BITS          135
+
+/**
+ * @brief One PID value
+ */
+typedef struct {
+    bool used;
+    uint8_t ecu;
+    uint8_t service;
+    uint8_t pid;
+    uint8_t len;
+    uint8_t data[OBD_SIM_MAX_DATA];
+} pid_entry_t;
+
+/**
+ * @brief Response transmission of one ECU
+ */
+typedef struct {
+    isotp_tx_t tx;
+    uint8_t buf[OBD_RESP_MAX];
+    int64_t fc_deadline_us;
+} ecu_state_t;
+
+// Simulator state
+static struct {
+    volatile bool running;
+    rx_bus_sub_handle_t sub;
+    SemaphoreHandle_t done_sem;
+    uint8_t ecus;
+    uint32_t delay_us;
+    uint32_t frame_us;
+    uint32_t requests;
+    uint32_t responses;
+    uint32_t multi_frame;
+    uint32_t unsupported;
+    uint32_t fc_timeouts;
+    uint32_t tx_errors;
+    pid_entry_t pids[OBD_SIM_MAX_PIDS];
+    ecu_state_t ecu[OBD_SIM_MAX_ECUS];
+} s_obd;
+
+static portMUX_TYPE s_obd_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/** @brief Command line arguments for obd command */
+static struct {
+    struct arg_str *action;
+    struct arg_int *ecu;
+    struct arg_int *service;
+    struct arg_int *pid;
+    struct arg_str *value;
+    struct arg_str *text;
+    struct arg_int *ecus;
+    struct arg_int *delay;
+    struct arg_end *end;
+} obd_args;
+
+/**
+ * @brief Find a PID entry (caller holds s_obd_mux)
+ */
+static pid_entry_t *pid_find(uint8_t ecu, uint8_t service, uint8_t pid)
+{
+    for (int i = 0; i < OBD_SIM_MAX_PIDS; i++) {
+        pid_entry_t *e = &s_obd.pids[i];
+        if (e->used && e->ecu == ecu && e->service == service && e->pid == pid) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Supported-PID bitmap for PIDs base+1..base+0x20 (caller holds s_obd_mux)
+ *
+ * Bit 0 announces the next bitmap PID if any higher PID is supported.
+ *
+ * @return true if the bitmap PID itself is supported
+ */
+static bool pid_bitmap(uint8_t ecu, uint8_t service, uint8_t base, uint32_t *bitmap)
+{
+    uint32_t bits = 0;
+    bool higher = false;
+    
+    for (int i = 0; i < OBD_SIM_MAX_PIDS; i++) {
+        const pid_entry_t *e = &s_obd.pids[i];
+        if (!e->used || e->ecu != ecu || e->service != service || e->pid <= base) {
+            continue;
+        }
+        if (e->pid < base + 0x20) {
+            bits |= 1UL << (31 - (e->pid - base - 1));
+        } else {
+            higher = true;
+        }
+    }
+    *bitmap = bits | (higher ? 1 : 0);
+    // PID 0x00 is always supported; a higher bitmap only if announced by the previous one
+    uint32_t prev = 0;
+    return base == 0 || (pid_bitmap(ecu, service, base - 0x20, &prev) && (prev & 1));
+}
+
+/**
+ * @brief Append the answer of one PID to a response (caller holds s_obd_mux)
+ *
+ * @return Bytes appended, 0 if the PID is not supported or does not fit
+ */
+static uint8_t append_pid(uint8_t ecu, uint8_t service, uint8_t pid, uint8_t *out, uint8_t room)
+{
+    if ((pid & 0x1F) == 0) {
+        uint32_t bitmap;
+        if (room < 5 || !pid_bitmap(ecu, service, pid, &bitmap)) {
+            return 0;
+        }
+        out[0] = pid;
+        out[1] = bitmap >> 24;
+        out[2] = bitmap >> 16;
+        out[3] = bitmap >> 8;
+        out[4] = bitmap;
+        return 5;
+    }
+    
+    const pid_entry_t *e = pid_find(ecu, service, pid);
+    if (e == NULL || room < 1 + e->len) {
+        return 0;
+    }
+    out[0] = pid;
+    memcpy(&out[1], e->data, e->len);
+    return 1 + e->len;
+}
+
+/**
+ * @brief Queue one response frame of an ECU at a device time (now if in the past)
+ */
+static esp_err_t send_frame(uint8_t ecu, const uint8_t data[8], int64_t target_us)
+{
+    uint8_t buf[8];
+    memcpy(buf, data, sizeof(buf));
+    twai_frame_t frame = {
+        .header = {
+            .id = OBD_RESP_ID_BASE + ecu,
+            .dlc = 8,
+        },
+        .buffer = buf,
+        .buffer_len = sizeof(buf),
+    };
+    
+    esp_err_t ret = target_us > esp_timer_get_time() ? can_tx_schedule(&frame, target_us, NULL)
+                                                     : can_tx_send(&frame);
+    if (ret != ESP_OK) {
+        s_obd.tx_errors++;
+    }
+    return ret;
+}
+
+/**
+ * @brief Send frames while the transmitter allows, pacing consecutive frames by STmin
+ *
+ * STmin counts from the end of a frame, so frame starts are spaced by STmin
+ * plus the worst-case frame duration.
+ */
+static void send_frames(uint8_t ecu, int64_t start_us)
+{
+    ecu_state_t *st = &s_obd.ecu[ecu];
+    int64_t t = start_us;
+    uint8_t data[8];
+    
+    while (isotp_tx_next(&st->tx, data) != 0) {
+        if (send_frame(ecu, data, t) != ESP_OK) {
+            st->tx.state = ISOTP_TX_ABORTED;
+            return;
+        }
+        if (st->tx.stmin_us != 0) {
+            t += st->tx.stmin_us + s_obd.frame_us;
+        }
+    }
+    if (st->tx.state == ISOTP_TX_WAIT_FC) {
+        st->fc_deadline_us = esp_timer_get_time() + OBD_FC_TIMEOUT_US;
+    }
+}
+
+/**
+ * @brief Answer a single frame request to one ECU
+ */
+static void handle_request(uint8_t ecu, const uint8_t *req, uint8_t len, int64_t rx_us)
+{
+    ecu_state_t *st = &s_obd.ecu[ecu];
+    uint8_t service = req[0];
+    uint8_t n = 0;
+    
+    portENTER_CRITICAL(&s_obd_mux);
+    s_obd.requests++;
+    if (service == 0x01 && len >= 2) {
+        // Up to 6 PIDs per request, answered in request order
+        st->buf[n++] = 0x41;
+        for (uint8_t i = 1; i < len && i <= 6; i++) {
+            n += append_pid(ecu, service, req[i], &st->buf[n], sizeof(st->buf) - n);
+        }
+    } else if (service == 0x09 && len >= 2) {
+        st->buf[n++] = 0x49;
+        n += append_pid(ecu, service, req[1], &st->buf[n], sizeof(st->buf) - n);
+    }
+    if (n <= 1) {
+        // Unsupported requests are not answered, as on a real OBD-II network
+        s_obd.unsupported++;
+        portEXIT_CRITICAL(&s_obd_mux);
+        return;
+    }
+    s_obd.responses++;
+    portEXIT_CRITICAL(&s_obd_mux);
+    
+    // A new request replaces a response still in progress
+    isotp_tx_start(&st->tx, st->buf, n, OBD_PADDING);
+    send_frames(ecu, rx_us + s_obd.delay_us);
+    if (st->tx.state == ISOTP_TX_WAIT_FC) {
+        s_obd.multi_frame++;
+    }
+}
+
+/**
+ * @brief Handle a frame on the functional or a physical request ID
+ */
+static void obd_handle_frame(const rx_bus_frame_t *rx_frame)
+{
+    const twai_frame_t *frame = &rx_frame->frame;
+    if (frame->header.ide || frame->header.rtr) {
+        return;
+    }
+    uint8_t len = (uint8_t)twaifd_dlc2len(frame->header.dlc);
+    if (len == 0) {
+        return;
+    }
+    
+    uint32_t id = frame->header.id;
+    const uint8_t *data = frame->buffer;
+    uint8_t req[ISOTP_SF_MAX_LEN];
+    isotp_rx_t rx;
+    
+    if (id == OBD_FUNC_ID) {
+        isotp_rx_init(&rx, req, sizeof(req), 0);
+        if (isotp_rx_feed(&rx, data, len) == ISOTP_RX_COMPLETE) {
+            for (uint8_t ecu = 0; ecu < s_obd.ecus; ecu++) {
+                handle_request(ecu, req, rx.len, rx_frame->timestamp_us);
+            }
+        }
+    } else if (id >= OBD_REQ_ID_BASE && id < OBD_REQ_ID_BASE + s_obd.ecus) {
+        uint8_t ecu = id - OBD_REQ_ID_BASE;
+        ecu_state_t *st = &s_obd.ecu[ecu];
+        if ((data[0] & 0xF0) == ISOTP_PCI_FC) {
+            if (isotp_tx_on_fc(&st->tx, data, len)) {
+                st->fc_deadline_us = esp_timer_get_time() + OBD_FC_TIMEOUT_US;
+                send_frames(ecu, rx_frame->timestamp_us);
+            }
+            return;
+        }
+        isotp_rx_init(&rx, req, sizeof(req), 0);
+        if (isotp_rx_feed(&rx, data, len) == ISOTP_RX_COMPLETE) {
+            handle_request(ecu, req, rx.len, rx_frame->timestamp_us);
+        }
+    }
+}
+
+/**
+ * @brief Abort multi-frame responses whose flow control did not arrive
+ */
+static void obd_check_timeouts(void)
+{
+    int64_t now = esp_timer_get_time();
+    for (uint8_t ecu = 0; ecu < s_obd.ecus; ecu++) {
+        ecu_state_t *st = &s_obd.ecu[ecu];
+        if (st->tx.state == ISOTP_TX_WAIT_FC && now > st->fc_deadline_us) {
+            st->tx.state = ISOTP_TX_ABORTED;
+            s_obd.fc_timeouts++;
+        }
+    }
+}
+
+/**
+ * @brief Simulator task: RX bus "obd" subscriber
+ */
+static void obd_task(void *arg)
+{
+    while (s_obd.running) {
+        const rx_bus_frame_t *rx_frame = rx_bus_receive(s_obd.sub, pdMS_TO_TICKS(100));
+        if (rx_frame != NULL) {
+            obd_handle_frame(rx_frame);
+            rx_bus_release(rx_frame);
+        }
+        obd_check_timeouts();
+    }
+    
+    rx_bus_unsubscribe(s_obd.sub);
+    s_obd.sub = NULL;
+    
+    xSemaphoreGive(s_obd.done_sem);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Fill an empty table with a plausible engine ECU (index 0)
+ */
+static void load_defaults(void)
+{
+    static const struct {
+        uint8_t pid;
+        uint8_t len;
+        uint8_t data[4];
+    } service01[] = {
+        {0x01, 4, {0x00, 0x07, 0xE5, 0x00}},   // Monitor status: MIL off, no DTCs
+        {0x04, 1, {0x33}},                     // Engine load 20%
+        {0x05, 1, {0x7B}},                     // Coolant 83 C
+        {0x0C, 2, {0x1A, 0xF8}},               // 1726 rpm
+        {0x0D, 1, {0x32}},                     // 50 km/h
+        {0x0F, 1, {0x46}},                     // Intake air 30 C
+        {0x11, 1, {0x26}},                     // Throttle 15%
+        {0x1C, 1, {0x01}},                     // OBD-II (CARB)
+    };
+    static const char vin[] = "1M8GDM9AXKP042788";
+    
+    for (size_t i = 0; i < sizeof(service01) / sizeof(service01[0]); i++) {
+        obd_sim_set_pid(0, 0x01, service01[i].pid, service01[i].data, service01[i].len);
+    }
+    uint8_t vin_data[1 + sizeof(vin) - 1];
+    vin_data[0] = 1;    // Number of data items
+    memcpy(&vin_data[1], vin, sizeof(vin) - 1);
+    obd_sim_set_pid(0, 0x09, 0x02, vin_data, sizeof(vin_data));
+}
+
+esp_err_t obd_sim_start(uint8_t ecus, uint32_t delay_us)
+{
+    if (s_obd.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (ecus == 0 || ecus > OBD_SIM_MAX_ECUS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_obd.done_sem == NULL) {
+        s_obd.done_sem = xSemaphoreCreateBinary();
+        if (s_obd.done_sem == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
+    bool empty = true;
+    for (int i = 0; i < OBD_SIM_MAX_PIDS; i++) {
+        empty &= !s_obd.pids[i].used;
+    }
+    if (empty) {
+        load_defaults();
+    }
+    
+    uint32_t bitrate;
+    if (!bridge_config_get_bitrate(&bitrate) || bitrate == 0) {
+        bitrate = 500000;
+    }
+    s_obd.frame_us = (OBD_FRAME_BITS * 1000000UL + bitrate - 1) / bitrate;
+    
+    esp_err_t ret = rx_bus_subscribe("obd", OBD_RING_DEPTH, &s_obd.sub);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    memset(s_obd.ecu, 0, sizeof(s_obd.ecu));
+    s_obd.ecus = ecus;
+    s_obd.delay_us = delay_us;
+    s_obd.running = true;
+    // Above the transport task: answering in time matters more than forwarding
+    if (xTaskCreate(obd_task, "obd", 3072, NULL, 11, NULL) != pdPASS) {
+        s_obd.running = false;
+        rx_bus_unsubscribe(s_obd.sub);
+        s_obd.sub = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    
+    ESP_LOGI(TAG, "Simulating %u ECU(s), response delay %lu us", ecus, (unsigned long)delay_us);
+    return ESP_OK;
+}
+
+esp_err_t obd_sim_stop(void)
+{
+    if (!s_obd.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    s_obd.running = false;
+    if (xSemaphoreTake(s_obd.done_sem, pdMS_TO_TICKS(2000)) != pdTRUE) {
+        ESP_LOGE(TAG, "OBD task did not stop");
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+esp_err_t obd_sim_set_pid(uint8_t ecu, uint8_t service, uint8_t pid, const uint8_t *data, uint8_t len)
+{
+    if (ecu >= OBD_SIM_MAX_ECUS || (service != 0x01 && service != 0x09) || (pid & 0x1F) == 0 ||
+        len == 0 || len > OBD_SIM_MAX_DATA || (service == 0x01 && len > 4)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    portENTER_CRITICAL(&s_obd_mux);
+    pid_entry_t *e = pid_find(ecu, service, pid);
+    for (int i = 0; e == NULL && i < OBD_SIM_MAX_PIDS; i++) {
+        if (!s_obd.pids[i].used) {
+            e = &s_obd.pids[i];
+        }
+    }
+    if (e == NULL) {
+        portEXIT_CRITICAL(&s_obd_mux);
+        return ESP_ERR_NO_MEM;
+    }
+    e->used = true;
+    e->ecu = ecu;
+    e->service = service;
+    e->pid = pid;
+    e->len = len;
+    memcpy(e->data, data, len);
+    portEXIT_CRITICAL(&s_obd_mux);
+    return ESP_OK;
+}
+
+esp_err_t obd_sim_del_pid(uint8_t ecu, uint8_t service, uint8_t pid)
+{
+    portENTER_CRITICAL(&s_obd_mux);
+    pid_entry_t *e = pid_find(ecu, service, pid);
+    if (e != NULL) {
+        e->used = false;
+    }
+    portEXIT_CRITICAL(&s_obd_mux);
+    return e != NULL ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+void obd_sim_get_status(obd_sim_status_t *out)
+{
+    portENTER_CRITICAL(&s_obd_mux);
+    out->running = s_obd.running;
+    out->ecus = s_obd.ecus;
+    out->delay_us = s_obd.delay_us;
+    out->requests = s_obd.requests;
+    out->responses = s_obd.responses;
+    out->multi_frame = s_obd.multi_frame;
+    out->unsupported = s_obd.unsupported;
+    out->fc_timeouts = s_obd.fc_timeouts;
+    out->tx_errors = s_obd.tx_errors;
+    portEXIT_CRITICAL(&s_obd_mux);
+}
+
+/**
+ * @brief Parse a hex byte string into a buffer
+ *
+ * @return Bytes parsed, -1 if malformed or too long
+ */
+static int parse_hex(const char *text, uint8_t *out, size_t size)
+{
+    size_t n = strlen(text);
+    if (n % 2 != 0 || n / 2 > size) {
+        return -1;
+    }
+    for (size_t i = 0; i < n / 2; i++) {
+        unsigned int b;
+        if (sscanf(&text[i * 2], "%2x", &b) != 1) {
+            return -1;
+        }
+        out[i] = (uint8_t)b;
+    }
+    return (int)(n / 2);
+}
+
+/**
+ * @brief Print the status line and the PID table
+ */
+static void obd_print(void)
+{
+    obd_sim_status_t st;
+    obd_sim_get_status(&st);
+    printf("obd: %s, %u ECU(s), delay %lu us, requests %lu, responses %lu, multi-frame %lu, "
+           "unsupported %lu, fc timeouts %lu, tx errors %lu\n",
+           st.running ? "running" : "stopped", st.ecus, (unsigned long)st.delay_us,
+           (unsigned long)st.requests, (unsigned long)st.responses, (unsigned long)st.multi_frame,
+           (unsigned long)st.unsupported, (unsigned long)st.fc_timeouts, (unsigned long)st.tx_errors);
+    
+    for (int i = 0; i < OBD_SIM_MAX_PIDS; i++) {
+        portENTER_CRITICAL(&s_obd_mux);
+        pid_entry_t e = s_obd.pids[i];
+        portEXIT_CRITICAL(&s_obd_mux);
+        if (!e.used) {
+            continue;
+        }
+        printf("  %03X %02X %02X ", OBD_RESP_ID_BASE + e.ecu, e.service, e.pid);
+        for (uint8_t b = 0; b < e.len; b++) {
+            printf("%02X", e.data[b]);
+        }
+        printf("\n");
+    }
+}
+
+/**
+ * @brief "obd" command handler
+ */
+static int obd_cmd_handler(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&obd_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, obd_args.end, argv[0]);
+        return 1;
+    }
+    
+    const char *action = obd_args.action->count ? obd_args.action->sval[0] : "show";
+    uint8_t ecu = obd_args.ecu->count ? obd_args.ecu->ival[0] : 0;
+    uint8_t service = obd_args.service->count ? obd_args.service->ival[0] : 0x01;
+    esp_err_t ret = ESP_OK;
+    
+    if (strcmp(action, "start") == 0) {
+        ret = obd_sim_start(obd_args.ecus->count ? obd_args.ecus->ival[0] : 1,
+                            obd_args.delay->count ? obd_args.delay->ival[0] : 0);
+    } else if (strcmp(action, "stop") == 0) {
+        ret = obd_sim_stop();
+    } else if (strcmp(action, "set") == 0) {
+        uint8_t data[OBD_SIM_MAX_DATA];
+        int len = 0;
+        if (obd_args.value->count) {
+            len = parse_hex(obd_args.value->sval[0], data, sizeof(data));
+        }
+        if (len >= 0 && obd_args.text->count) {
+            size_t n = strlen(obd_args.text->sval[0]);
+            if (len + n <= sizeof(data)) {
+                memcpy(&data[len], obd_args.text->sval[0], n);
+                len += n;
+            } else {
+                len = -1;
+            }
+        }
+        if (obd_args.pid->count == 0 || len <= 0) {
+            printf("obd set: need -p <pid> and -v <hex> and/or -a <text>\n");
+            return 1;
+        }
+        ret = obd_sim_set_pid(ecu, service, obd_args.pid->ival[0], data, len);
+        if (ret == ESP_OK) {
+            return 0;
+        }
+    } else if (strcmp(action, "del") == 0) {
+        if (obd_args.pid->count == 0) {
+            printf("obd del: need -p <pid>\n");
+            return 1;
+        }
+        ret = obd_sim_del_pid(ecu, service, obd_args.pid->ival[0]);
+        if (ret == ESP_OK) {
+            return 0;
+        }
+    } else if (strcmp(action, "show") != 0) {
+        printf("obd: unknown action '%s'\n", action);
+        return 1;
+    }
+    
+    if (ret != ESP_OK) {
+        printf("obd %s: %s\n", action, esp_err_to_name(ret));
+        return 1;
+    }
+    obd_print();
+    return 0;
+}
+
+void obd_sim_register_commands(void)
+{
+    obd_args.action = arg_str0(NULL, NULL, "<start|stop|set|del|show>", "Action (default: show)");
+    obd_args.ecu = arg_int0("e", "ecu", "<n>", "ECU index, responds on 0x7E8+n (default: 0)");
+    obd_args.service = arg_int0("s", "service", "<1|9>", "Service (default: 1)");
+    obd_args.pid = arg_int0("p", "pid", "<pid>", "PID, e.g. 0x0C");
+    obd_args.value = arg_str0("v", "value", "<hex>", "Value bytes after the PID");
+    obd_args.text = arg_str0("a", "ascii", "<text>", "ASCII bytes appended to the value (VIN)");
+    obd_args.ecus = arg_int0("n", "ecus", "<n>", "start: simulated ECUs (default: 1)");
+    obd_args.delay = arg_int0("d", "delay", "<us>", "start: response delay after the request (default: 0)");
+    obd_args.end = arg_end(8);
+    
+    const esp_console_cmd_t obd_cmd = {
+        .command = "obd",
+        .help = "OBD-II ECU simulator (services 01 and 09, ISO-TP multi-frame)\n"
+        "  obd start -n 2 -d 2000            # two ECUs answering after 2 ms\n"
+        "  obd set -p 0x0C -v 2EE0           # engine speed 3000 rpm\n"
+        "  obd set -s 9 -p 2 -v 01 -a <VIN>  # VIN, one data item\n"
+        "  obd del -p 0x0C | stop | show",
+        .hint = NULL,
+        .func = &obd_cmd_handler,
+        .argtable = &obd_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&obd_cmd));
+}
@@ -0,0 +1,105 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief OBD-II ECU simulator (ISO 15765-4, 11-bit identifiers)
+ *
+ * Emulates up to OBD_SIM_MAX_ECUS ECUs answering service 01 (current data)
+ * and 09 (vehicle information) requests on the functional ID 0x7DF and the
+ * physical IDs 0x7E0+n, responding on 0x7E8+n. Values come from a PID table
+ * that the host can change while the simulator runs; the supported-PID
+ * bitmaps (PID 0x00, 0x20, ...) are derived from it.
+ *
+ * Responses longer than a single frame (VIN, multi-PID requests) use ISO-TP
+ * with the tester's flow control; consecutive frames are paced with the
+ * GPTimer scheduler of can_tx at the requested STmin. An optional response
+ * delay, measured from request reception, emulates a given ECU's P2 timing.
+ */
+
+/** @brief Maximum simulated ECUs */
+#define OBD_SIM_MAX_ECUS            8
+
+/** @brief Maximum PID table entries (all ECUs) */
+#define OBD_SIM_MAX_PIDS            64
+
+/** @brief Maximum value length of one PID */
+#define OBD_SIM_MAX_DATA            32
+
+/**
+ * @brief Simulator statistics
+ */
+typedef struct {
+    bool running;               /**< Simulator active */
+    uint8_t ecus;               /**< Simulated ECUs */
+    uint32_t delay_us;          /**< Response delay */
+    uint32_t requests;          /**< Requests addressed to a simulated ECU */
+    uint32_t responses;         /**< Responses started */
+    uint32_t multi_frame;       /**< Responses sent as ISO-TP multi-frame */
+    uint32_t unsupported;       /**< Requests for a service or PID not in the table */
+    uint32_t fc_timeouts;       /**< Multi-frame responses aborted without flow control */
+    uint32_t tx_errors;         /**< Frames that could not be queued */
+} obd_sim_status_t;
+
+/**
+ * @brief Start answering requests
+ *
+ * @param ecus Number of simulated ECUs (1..OBD_SIM_MAX_ECUS)
+ * @param delay_us Response delay after request reception (0: as fast as possible)
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if running, ESP_ERR_INVALID_ARG, ESP_ERR_NO_MEM
+ */
+esp_err_t obd_sim_start(uint8_t ecus, uint32_t delay_us);
+
+/**
+ * @brief Stop answering requests
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not running, ESP_ERR_TIMEOUT
+ */
+esp_err_t obd_sim_stop(void);
+
+/**
+ * @brief Set the value of a PID (live)
+ *
+ * @param ecu ECU index
+ * @param service 0x01 or 0x09
+ * @param pid PID (not a supported-PID bitmap PID)
+ * @param data Value bytes as sent after the PID
+ * @param len Value length (1..OBD_SIM_MAX_DATA, service 01: 1..4)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG, ESP_ERR_NO_MEM if the table is full
+ */
+esp_err_t obd_sim_set_pid(uint8_t ecu, uint8_t service, uint8_t pid, const uint8_t *data, uint8_t len);
+
+/**
+ * @brief Remove a PID
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND
+ */
+esp_err_t obd_sim_del_pid(uint8_t ecu, uint8_t service, uint8_t pid);
+
+/**
+ * @brief Get the simulator status and statistics
+ *
+ * @param out Output status
+ */
+void obd_sim_get_status(obd_sim_status_t *out);
+
+/**
+ * @brief Register the 'obd' extension command
+ */
+void obd_sim_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
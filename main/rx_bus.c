@@ -0,0 +1,348 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "rx_bus.h"
+
+static const char *TAG = "rx_bus";
+
+#define POOL_SIZE CONFIG_CAN_BRIDGE_RX_POOL_SIZE
+
+/**
+ * @brief Subscriber: single-producer/single-consumer ring of frame pointers
+ */
+struct rx_bus_sub {
+    bool in_use;
+    const char *name;
+    rx_bus_frame_t **ring;
+    uint32_t mask;
+    uint32_t share;                 // Frames the ring may hold (at most mask + 1)
+    atomic_uint head;               // Written by the publisher
+    atomic_uint tail;               // Written by the subscriber
+    SemaphoreHandle_t wake_sem;     // Given when a frame is queued
+    uint32_t delivered;
+    uint32_t dropped;
+    uint32_t high_water;
+};
+
+// Frame pool and subscriber table
+static struct {
+    rx_bus_frame_t pool[POOL_SIZE];
+    uint16_t free_stack[POOL_SIZE];
+    uint32_t free_top;
+    struct rx_bus_sub subs[RX_BUS_MAX_SUBSCRIBERS];
+    rx_bus_pool_stats_t stats;
+} s_bus;
+
+static portMUX_TYPE s_bus_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/** @brief Command line arguments for rxbus command */
+static struct {
+    struct arg_end *end;
+} rxbus_args;
+
+/**
+ * @brief Give every subscriber its share of the pool (call with s_bus_mux held)
+ *
+ * One share is left over for the frames taken out of the rings and the frame
+ * being received.
+ */
+static void update_shares(void)
+{
+    uint32_t count = 0;
+    for (int i = 0; i < RX_BUS_MAX_SUBSCRIBERS; i++) {
+        count += s_bus.subs[i].in_use ? 1 : 0;
+    }
+    uint32_t share = POOL_SIZE / (count + 1);
+    for (int i = 0; i < RX_BUS_MAX_SUBSCRIBERS; i++) {
+        struct rx_bus_sub *sub = &s_bus.subs[i];
+        sub->share = share < sub->mask + 1 ? share : sub->mask + 1;
+    }
+}
+
+esp_err_t rx_bus_init(void)
+{
+    portENTER_CRITICAL(&s_bus_mux);
+    for (int i = 0; i < POOL_SIZE; i++) {
+        s_bus.free_stack[i] = i;
+    }
+    s_bus.free_top = POOL_SIZE;
+    memset(&s_bus.stats, 0, sizeof(s_bus.stats));
+    portEXIT_CRITICAL(&s_bus_mux);
+    
+    ESP_LOGI(TAG, "RX bus ready: %d pooled frames, up to %d subscribers",
+             POOL_SIZE, RX_BUS_MAX_SUBSCRIBERS);
+    return ESP_OK;
+}
+
+esp_err_t rx_bus_subscribe(const char *name, uint32_t depth, rx_bus_sub_handle_t *out_sub)
+{
+    if (name == NULL || out_sub == NULL || depth == 0 || (depth & (depth - 1)) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // A ring never holds more than the pool
+    while (depth / 2 >= POOL_SIZE) {
+        depth /= 2;
+    }
+    
+    rx_bus_frame_t **ring = calloc(depth, sizeof(rx_bus_frame_t *));
+    SemaphoreHandle_t sem = xSemaphoreCreateBinary();
+    if (ring == NULL || sem == NULL) {
+        free(ring);
+        if (sem) vSemaphoreDelete(sem);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    struct rx_bus_sub *sub = NULL;
+    portENTER_CRITICAL(&s_bus_mux);
+    for (int i = 0; i < RX_BUS_MAX_SUBSCRIBERS; i++) {
+        if (!s_bus.subs[i].in_use) {
+            sub = &s_bus.subs[i];
+            sub->name = name;
+            sub->ring = ring;
+            sub->mask = depth - 1;
+            atomic_store(&sub->head, 0);
+            atomic_store(&sub->tail, 0);
+            sub->wake_sem = sem;
+            sub->delivered = 0;
+            sub->dropped = 0;
+            sub->high_water = 0;
+            sub->in_use = true;
+            update_shares();
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_bus_mux);
+    
+    if (sub == NULL) {
+        ESP_LOGE(TAG, "No free subscriber slot for '%s'", name);
+        free(ring);
+        vSemaphoreDelete(sem);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    ESP_LOGI(TAG, "Subscriber '%s' added (depth %lu, share %lu)", name, (unsigned long)depth,
+             (unsigned long)sub->share);
+    *out_sub = sub;
+    return ESP_OK;
+}
+
+esp_err_t rx_bus_unsubscribe(rx_bus_sub_handle_t sub)
+{
+    if (sub == NULL || !sub->in_use) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // Stop new deliveries, then give back everything still queued
+    portENTER_CRITICAL(&s_bus_mux);
+    sub->in_use = false;
+    update_shares();
+    portEXIT_CRITICAL(&s_bus_mux);
+    
+    uint32_t tail = atomic_load(&sub->tail);
+    uint32_t head = atomic_load(&sub->head);
+    while (tail != head) {
+        rx_bus_release(sub->ring[tail & sub->mask]);
+        tail++;
+    }
+    
+    ESP_LOGI(TAG, "Subscriber '%s' removed", sub->name);
+    free(sub->ring);
+    sub->ring = NULL;
+    vSemaphoreDelete(sub->wake_sem);
+    sub->wake_sem = NULL;
+    return ESP_OK;
+}
+
+IRAM_ATTR rx_bus_frame_t *rx_bus_alloc(void)
+{
+    rx_bus_frame_t *frame = NULL;
+    
+    portENTER_CRITICAL_SAFE(&s_bus_mux);
+    if (s_bus.free_top > 0) {
+        frame = &s_bus.pool[s_bus.free_stack[--s_bus.free_top]];
+        uint32_t in_use = POOL_SIZE - s_bus.free_top;
+        if (in_use > s_bus.stats.in_use_max) {
+            s_bus.stats.in_use_max = in_use;
+        }
+    } else {
+        s_bus.stats.pool_exhausted++;
+    }
+    portEXIT_CRITICAL_SAFE(&s_bus_mux);
+    
+    if (frame) {
+        memset(&frame->frame, 0, sizeof(frame->frame));
+        frame->frame.buffer = frame->data;
+        frame->frame.buffer_len = sizeof(frame->data);
+        frame->timestamp_us = 0;
+        frame->pm_state = 0;
+        frame->injected = false;
+    }
+    return frame;
+}
+
+/**
+ * @brief Return a frame buffer to the pool
+ */
+static IRAM_ATTR void rx_bus_free(rx_bus_frame_t *frame)
+{
+    portENTER_CRITICAL_SAFE(&s_bus_mux);
+    s_bus.free_stack[s_bus.free_top++] = (uint16_t)(frame - s_bus.pool);
+    portEXIT_CRITICAL_SAFE(&s_bus_mux);
+}
+
+IRAM_ATTR void rx_bus_discard(rx_bus_frame_t *frame)
+{
+    rx_bus_free(frame);
+}
+
+IRAM_ATTR void rx_bus_publish(rx_bus_frame_t *frame, BaseType_t *higher_priority_task_woken)
+{
+    SemaphoreHandle_t wake[RX_BUS_MAX_SUBSCRIBERS];
+    struct rx_bus_sub *accept[RX_BUS_MAX_SUBSCRIBERS];
+    int n_wake = 0;
+    uint32_t n_accepted = 0;
+    
+    portENTER_CRITICAL_SAFE(&s_bus_mux);
+    s_bus.stats.published++;
+    
+    // Rings are only filled under the lock, so a ring with room now still has room below
+    for (int i = 0; i < RX_BUS_MAX_SUBSCRIBERS; i++) {
+        struct rx_bus_sub *sub = &s_bus.subs[i];
+        if (!sub->in_use) {
+            continue;
+        }
+        uint32_t head = atomic_load_explicit(&sub->head, memory_order_relaxed);
+        if (head - atomic_load_explicit(&sub->tail, memory_order_acquire) >= sub->share) {
+            sub->dropped++;
+            continue;
+        }
+        accept[n_accepted++] = sub;
+    }
+    // One reference per accepted delivery, set before any subscriber can see (and release) the frame
+    atomic_store(&frame->refcount, n_accepted);
+    
+    for (uint32_t i = 0; i < n_accepted; i++) {
+        struct rx_bus_sub *sub = accept[i];
+        uint32_t head = atomic_load_explicit(&sub->head, memory_order_relaxed);
+        uint32_t fill = head - atomic_load_explicit(&sub->tail, memory_order_acquire);
+        sub->ring[head & sub->mask] = frame;
+        atomic_store_explicit(&sub->head, head + 1, memory_order_release);
+        sub->delivered++;
+        if (fill + 1 > sub->high_water) {
+            sub->high_water = fill + 1;
+        }
+        wake[n_wake++] = sub->wake_sem;
+    }
+    portEXIT_CRITICAL_SAFE(&s_bus_mux);
+    
+    // The shared refcount may already be back at 0 here: decide on the local count only
+    if (n_accepted == 0) {
+        rx_bus_free(frame);
+    }
+    
+    for (int i = 0; i < n_wake; i++) {
+        if (xPortInIsrContext()) {
+            xSemaphoreGiveFromISR(wake[i], higher_priority_task_woken);
+        } else {
+            xSemaphoreGive(wake[i]);
+        }
+    }
+}
+
+const rx_bus_frame_t *rx_bus_receive(rx_bus_sub_handle_t sub, TickType_t timeout)
+{
+    while (true) {
+        uint32_t tail = atomic_load_explicit(&sub->tail, memory_order_relaxed);
+        if (tail != atomic_load_explicit(&sub->head, memory_order_acquire)) {
+            rx_bus_frame_t *frame = sub->ring[tail & sub->mask];
+            atomic_store_explicit(&sub->tail, tail + 1, memory_order_release);
+            return frame;
+        }
+        if (xSemaphoreTake(sub->wake_sem, timeout) != pdTRUE) {
+            return NULL;
+        }
+    }
+}
+
+IRAM_ATTR void rx_bus_release(const rx_bus_frame_t *frame)
+{
+    rx_bus_frame_t *f = (rx_bus_frame_t *)frame;
+    if (atomic_fetch_sub(&f->refcount, 1) == 1) {
+        rx_bus_free(f);
+    }
+}
+
+void rx_bus_get_sub_stats(rx_bus_sub_handle_t sub, rx_bus_sub_stats_t *out)
+{
+    portENTER_CRITICAL(&s_bus_mux);
+    out->name = sub->name;
+    out->delivered = sub->delivered;
+    out->dropped = sub->dropped;
+    out->high_water = sub->high_water;
+    out->depth = sub->mask + 1;
+    out->share = sub->share;
+    portEXIT_CRITICAL(&s_bus_mux);
+}
+
+void rx_bus_get_pool_stats(rx_bus_pool_stats_t *out)
+{
+    portENTER_CRITICAL(&s_bus_mux);
+    *out = s_bus.stats;
+    out->in_use = POOL_SIZE - s_bus.free_top;
+    portEXIT_CRITICAL(&s_bus_mux);
+}
+
+/**
+ * @brief "rxbus" command handler - print pool and per-subscriber statistics
+ */
+static int rxbus_cmd_handler(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&rxbus_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, rxbus_args.end, argv[0]);
+        return 1;
+    }
+    
+    rx_bus_pool_stats_t pool;
+    rx_bus_get_pool_stats(&pool);
+    printf("pool: %d buffers, in use %lu (max %lu), published %lu, exhausted %lu\n",
+           POOL_SIZE, (unsigned long)pool.in_use, (unsigned long)pool.in_use_max,
+           (unsigned long)pool.published, (unsigned long)pool.pool_exhausted);
+    
+    for (int i = 0; i < RX_BUS_MAX_SUBSCRIBERS; i++) {
+        if (!s_bus.subs[i].in_use) {
+            continue;
+        }
+        rx_bus_sub_stats_t st;
+        rx_bus_get_sub_stats(&s_bus.subs[i], &st);
+        printf("  %-10s: delivered %lu, dropped %lu, high water %lu/%lu (depth %lu)\n", st.name,
+               (unsigned long)st.delivered, (unsigned long)st.dropped,
+               (unsigned long)st.high_water, (unsigned long)st.share, (unsigned long)st.depth);
+    }
+    return 0;
+}
+
+void rx_bus_register_commands(void)
+{
+    rxbus_args.end = arg_end(1);
+    
+    const esp_console_cmd_t rxbus_cmd = {
+        .command = "rxbus",
+        .help = "Show RX frame pool usage and per-subscriber delivery/overflow counters",
+        .hint = NULL,
+        .func = &rxbus_cmd_handler,
+        .argtable = &rxbus_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&rxbus_cmd));
+}
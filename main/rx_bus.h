@@ -0,0 +1,190 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "esp_twai.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Publish/subscribe bus for received CAN frames
+ *
+ * The RX ISR receives each frame directly into a buffer taken from a fixed
+ * pool and publishes it once. Every subscriber (transport, capture, stats, ...)
+ * gets a pointer to the same buffer in its own ring, so frames are never
+ * copied per consumer. A buffer returns to the pool when the last subscriber
+ * releases it.
+ *
+ * Each subscriber may hold a share of the pool in its ring: the pool size
+ * divided by the number of subscribers plus one, so the frames taken out of
+ * the rings and the frame being received always find a buffer. A subscriber
+ * that falls behind only loses frames beyond its share, counted as its own
+ * drops; the others are unaffected.
+ */
+
+#ifndef CONFIG_CAN_BRIDGE_RX_POOL_SIZE
+#define CONFIG_CAN_BRIDGE_RX_POOL_SIZE 128
+#endif
+
+/**
+ * @brief Maximum number of simultaneous subscribers
+ *
+ * transport, capture, profile, obd, scan, fuzz and isotp, plus xcp, canopen
+ * and n2k with the dynamic host protocol.
+ */
+#if CONFIG_CAN_BRIDGE_PROTOCOL_DYNAMIC
+#define RX_BUS_MAX_SUBSCRIBERS      10
+#else
+#define RX_BUS_MAX_SUBSCRIBERS      7
+#endif
+
+/** @brief Payload capacity of one pooled frame (classic CAN and TWAI-FD) */
+#define RX_BUS_FRAME_DATA_LEN       64
+
+/**
+ * @brief Pooled received frame, shared read-only between subscribers
+ */
+typedef struct {
+    twai_frame_t frame;                     /**< Frame; buffer points to data[] */
+    int64_t timestamp_us;                   /**< esp_timer time of the RX ISR */
+    uint8_t pm_state;                       /**< bridge_pm_state_t at reception */
+    bool injected;                          /**< Generated on the device (self-benchmark) */
+    atomic_uint refcount;                   /**< Subscribers still holding the frame */
+    uint8_t data[RX_BUS_FRAME_DATA_LEN];    /**< Payload storage */
+} rx_bus_frame_t;
+
+/**
+ * @brief Per-subscriber statistics
+ */
+typedef struct {
+    const char *name;       /**< Subscriber name */
+    uint32_t delivered;     /**< Frames queued to this subscriber */
+    uint32_t dropped;       /**< Frames lost because this subscriber held its share */
+    uint32_t high_water;    /**< Maximum ring fill level seen */
+    uint32_t depth;         /**< Ring capacity */
+    uint32_t share;         /**< Frames this subscriber may hold now (at most depth) */
+} rx_bus_sub_stats_t;
+
+/**
+ * @brief Pool statistics
+ */
+typedef struct {
+    uint32_t published;     /**< Frames published */
+    uint32_t pool_exhausted;/**< Frames dropped because no buffer was free (frames held outside the rings) */
+    uint32_t in_use;        /**< Buffers currently held */
+    uint32_t in_use_max;    /**< Maximum buffers held at once */
+} rx_bus_pool_stats_t;
+
+/** @brief Subscriber handle */
+typedef struct rx_bus_sub *rx_bus_sub_handle_t;
+
+/**
+ * @brief Initialize the frame pool
+ *
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t rx_bus_init(void);
+
+/**
+ * @brief Add a subscriber
+ *
+ * The shares of all subscribers are recalculated.
+ *
+ * @param name Subscriber name (static string, used in statistics)
+ * @param depth Ring capacity in frames (power of two; more than the pool size is reduced)
+ * @param out_sub Output: subscriber handle
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if no slot is free,
+ *         ESP_ERR_INVALID_ARG if depth is not a power of two
+ */
+esp_err_t rx_bus_subscribe(const char *name, uint32_t depth, rx_bus_sub_handle_t *out_sub);
+
+/**
+ * @brief Remove a subscriber and release all frames still in its ring
+ *
+ * @note Must not be called while another task is blocked in rx_bus_receive() on it
+ *
+ * @param sub Subscriber handle
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t rx_bus_unsubscribe(rx_bus_sub_handle_t sub);
+
+/**
+ * @brief Take a free frame buffer from the pool
+ *
+ * @note ISR-safe
+ *
+ * @return Frame buffer with frame.buffer set up, or NULL if the pool is exhausted
+ */
+rx_bus_frame_t *rx_bus_alloc(void);
+
+/**
+ * @brief Return a buffer from rx_bus_alloc() without publishing it
+ *
+ * @note ISR-safe
+ *
+ * @param frame Buffer obtained from rx_bus_alloc()
+ */
+void rx_bus_discard(rx_bus_frame_t *frame);
+
+/**
+ * @brief Publish a filled frame buffer to all subscribers
+ *
+ * Ownership of the buffer passes to the bus.
+ *
+ * @note ISR-safe
+ *
+ * @param frame Buffer obtained from rx_bus_alloc()
+ * @param higher_priority_task_woken Set to pdTRUE if a subscriber task was woken
+ */
+void rx_bus_publish(rx_bus_frame_t *frame, BaseType_t *higher_priority_task_woken);
+
+/**
+ * @brief Wait for the next frame of a subscriber
+ *
+ * @param sub Subscriber handle
+ * @param timeout Maximum time to wait
+ * @return Frame (must be passed to rx_bus_release()), or NULL on timeout
+ */
+const rx_bus_frame_t *rx_bus_receive(rx_bus_sub_handle_t sub, TickType_t timeout);
+
+/**
+ * @brief Release a frame returned by rx_bus_receive()
+ *
+ * @param frame Frame to release
+ */
+void rx_bus_release(const rx_bus_frame_t *frame);
+
+/**
+ * @brief Get statistics of a subscriber
+ *
+ * @param sub Subscriber handle
+ * @param out Output statistics
+ */
+void rx_bus_get_sub_stats(rx_bus_sub_handle_t sub, rx_bus_sub_stats_t *out);
+
+/**
+ * @brief Get pool statistics
+ *
+ * @param out Output statistics
+ */
+void rx_bus_get_pool_stats(rx_bus_pool_stats_t *out);
+
+/**
+ * @brief Register the "rxbus" extension command
+ */
+void rx_bus_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,448 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "driver/rmt_rx.h"
+#include "soc/soc_caps.h"
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "scope.h"
+#include "wave_decode.h"
+#include "clock_sync.h"
+#include "host_link.h"
+#include "slcan_protocol.h"
+
+static const char *TAG = "scope";
+
+// Sampler resolution: 20 ticks per bit at 1 Mbit/s, 12 idle bits fit the 15-bit duration down to 10 kbit/s
+#define SCOPE_TICK_HZ           20000000
+
+// Idle bits that end a capture (more than the 11 the decoder needs before a start of frame)
+#define SCOPE_IDLE_BITS         12
+
+#if SOC_RMT_SUPPORT_RX_PINGPONG
+// Long captures are handed over in parts as the channel memory fills
+#define SCOPE_MEM_SYMBOLS       SOC_RMT_MEM_WORDS_PER_CHANNEL
+#else
+// The whole capture must fit in the channel: borrow the memory of the next channels
+#define SCOPE_MEM_SYMBOLS       (4 * SOC_RMT_MEM_WORDS_PER_CHANNEL)
+#endif
+
+// Driver receive buffer: a few back-to-back frames of two symbols per bit at most
+#define SCOPE_RX_SYMBOLS        512
+
+// Symbols handed from the RX callback to the scope task (power of 2)
+#define SCOPE_RING_SYMBOLS      2048
+
+#define SCOPE_CHUNK_QUEUE_LEN   32
+
+// One record: header plus every edge of a frame in ns
+#define SCOPE_LINE_LEN          (80 + 9 * WAVE_MAX_EDGES)
+
+/**
+ * @brief Symbols received by one RX callback, queued in the ring
+ */
+typedef struct {
+    int64_t time_us;            // Time of the callback: the end of the last symbol
+    uint16_t count;
+    bool last;                  // End of the capture (idle bus)
+    bool lost;                  // Symbols were lost before these
+} scope_chunk_t;
+
+// Scope state: the ring head and lost flag are written by the RX callback, the rest by the task
+static struct {
+    volatile bool running;
+    scope_config_t cfg;
+    SemaphoreHandle_t done_sem;
+    rmt_channel_handle_t chan;
+    QueueHandle_t chunks;
+    rmt_symbol_word_t rx_buf[SCOPE_RX_SYMBOLS];
+    rmt_symbol_word_t ring[SCOPE_RING_SYMBOLS];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    bool lost_pending;
+    wave_decoder_t dec;
+    uint32_t captures;
+    uint32_t overflows;
+    uint32_t records;
+    uint32_t records_dropped;
+} s_scope;
+
+static portMUX_TYPE s_scope_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static char s_line[SCOPE_LINE_LEN];
+static wave_frame_t s_frame;
+
+/** @brief Command line arguments for scope command */
+static struct {
+    struct arg_str *action;
+    struct arg_int *bitrate;
+    struct arg_int *sample_point;
+    struct arg_lit *errors_only;
+    struct arg_end *end;
+} scope_args;
+
+/**
+ * @brief RMT RX callback: copy the symbols out of the driver buffer, which the next part overwrites
+ */
+static IRAM_ATTR bool scope_rx_done(rmt_channel_handle_t chan, const rmt_rx_done_event_data_t *edata, void *ctx)
+{
+    scope_chunk_t chunk = {
+        .time_us = esp_timer_get_time(),
+        .count = (uint16_t)edata->num_symbols,
+        .last = edata->flags.is_last,
+        .lost = s_scope.lost_pending,
+    };
+    uint32_t head = s_scope.head;
+    if (SCOPE_RING_SYMBOLS - (head - s_scope.tail) < chunk.count) {
+        s_scope.overflows++;
+        s_scope.lost_pending = true;
+        return false;
+    }
+    for (uint16_t i = 0; i < chunk.count; i++) {
+        s_scope.ring[(head + i) & (SCOPE_RING_SYMBOLS - 1)] = edata->received_symbols[i];
+    }
+    
+    BaseType_t woken = pdFALSE;
+    if (xQueueSendFromISR(s_scope.chunks, &chunk, &woken) != pdTRUE) {
+        s_scope.overflows++;
+        s_scope.lost_pending = true;
+        return false;
+    }
+    s_scope.head = head + chunk.count;
+    s_scope.lost_pending = false;
+    return woken == pdTRUE;
+}
+
+/**
+ * @brief Reset the decoder: after lost symbols it waits for an idle bus again
+ */
+static void reset_decoder(void)
+{
+    wave_timing_t timing = {
+        .tick_hz = SCOPE_TICK_HZ,
+        .bitrate = s_scope.cfg.bitrate,
+        .sample_point = s_scope.cfg.sample_point,
+    };
+    wave_decoder_init(&s_scope.dec, &timing);
+}
+
+/**
+ * @brief Send the record of a decoded or failed frame
+ */
+static void send_record(const wave_frame_t *f, int64_t time_us)
+{
+    bool good = f->status == WAVE_OK || f->status == WAVE_ACK_ERROR;
+    if (good && s_scope.cfg.errors_only) {
+        return;
+    }
+    if (!slcan_is_open() || !host_link_present()) {
+        s_scope.records_dropped++;
+        return;
+    }
+    
+    int pos = snprintf(s_line, sizeof(s_line), "%s %lld ", good ? "Wf" : "We",
+                       (long long)clock_sync_to_host(time_us));
+    // The identifier is complete once the RTR bit has been received
+    bool id_known = good || f->error_field > (f->ide ? WAVE_FIELD_RTR : WAVE_FIELD_IDE);
+    if (good) {
+        pos += snprintf(&s_line[pos], sizeof(s_line) - pos, f->ide ? "%08lX %u " : "%03lX %u ",
+                        (unsigned long)f->id, f->dlc);
+        uint8_t len = f->dlc > 8 ? 8 : f->dlc;
+        if (f->rtr) {
+            s_line[pos++] = 'R';
+        } else if (len == 0) {
+            s_line[pos++] = '-';
+        }
+        for (uint8_t i = 0; i < len && !f->rtr; i++) {
+            pos += snprintf(&s_line[pos], sizeof(s_line) - pos, "%02X", f->data[i]);
+        }
+        pos += snprintf(&s_line[pos], sizeof(s_line) - pos, " %c", f->ack ? 'a' : 'n');
+    } else {
+        pos += snprintf(&s_line[pos], sizeof(s_line) - pos, "%s %s %u ",
+                        f->error_flag ? "flag" : wave_status_name(f->status), wave_field_name(f->error_field),
+                        f->error_bit);
+        if (id_known) {
+            pos += snprintf(&s_line[pos], sizeof(s_line) - pos, f->ide ? "%08lX " : "%03lX ", (unsigned long)f->id);
+        } else {
+            pos += snprintf(&s_line[pos], sizeof(s_line) - pos, "- ");
+        }
+        for (uint16_t i = 0; i < f->edge_count; i++) {
+            pos += snprintf(&s_line[pos], sizeof(s_line) - pos, i ? ",%lu" : "%lu",
+                            (unsigned long)((uint64_t)f->edges[i] * 1000000000 / SCOPE_TICK_HZ));
+        }
+    }
+    s_line[pos++] = '\r';
+    host_link_write(s_line, pos);
+    s_scope.records++;
+}
+
+/**
+ * @brief Feed one run to the decoder and report a frame that ends in it
+ *
+ * @param left Ticks of the chunk after this run, to date the frame from the chunk time
+ */
+static void feed_run(uint8_t level, uint32_t ticks, const scope_chunk_t *chunk, uint64_t left)
+{
+    if (!wave_decoder_feed(&s_scope.dec, level, ticks, &s_frame)) {
+        return;
+    }
+    uint64_t age = left + (uint64_t)(s_scope.dec.now_q8 >> 8) - s_frame.sof_tick;
+    send_record(&s_frame, chunk->time_us - (int64_t)(age * 1000000 / SCOPE_TICK_HZ));
+}
+
+/**
+ * @brief Decode the symbols of a chunk
+ */
+static void decode_chunk(const scope_chunk_t *chunk)
+{
+    uint32_t idle_ticks = SCOPE_IDLE_BITS * (SCOPE_TICK_HZ / s_scope.cfg.bitrate);
+    uint32_t tail = s_scope.tail;
+    
+    // The end of the chunk is its callback time: count the ticks to date the frames
+    uint64_t left = chunk->last ? idle_ticks : 0;
+    for (uint16_t i = 0; i < chunk->count; i++) {
+        const rmt_symbol_word_t *sym = &s_scope.ring[(tail + i) & (SCOPE_RING_SYMBOLS - 1)];
+        left += sym->duration0 + sym->duration1;
+    }
+    
+    for (uint16_t i = 0; i < chunk->count; i++) {
+        rmt_symbol_word_t sym = s_scope.ring[(tail + i) & (SCOPE_RING_SYMBOLS - 1)];
+        // A zero duration marks the idle level that ended the capture
+        if (sym.duration0 == 0) {
+            break;
+        }
+        left -= sym.duration0;
+        feed_run(sym.level0, sym.duration0, chunk, left);
+        if (sym.duration1 == 0) {
+            break;
+        }
+        left -= sym.duration1;
+        feed_run(sym.level1, sym.duration1, chunk, left);
+    }
+    s_scope.tail = tail + chunk->count;
+    
+    // The bus was idle long enough to end the capture: let the decoder see it
+    if (chunk->last) {
+        feed_run(1, idle_ticks, chunk, 0);
+    }
+}
+
+/**
+ * @brief Scope task: keeps a reception armed and decodes what it delivers
+ */
+static void scope_task(void *arg)
+{
+    uint32_t bit_ns = 1000000000 / s_scope.cfg.bitrate;
+    rmt_receive_config_t rx_cfg = {
+        // Shorter pulses are ringing; the filter is limited to about 3 us by the hardware
+        .signal_range_min_ns = bit_ns / 8 < 3000 ? bit_ns / 8 : 3000,
+        .signal_range_max_ns = SCOPE_IDLE_BITS * bit_ns,
+#if SOC_RMT_SUPPORT_RX_PINGPONG
+        .flags.en_partial_rx = true,
+#endif
+    };
+    bool armed = false;
+    
+    while (s_scope.running) {
+        if (!armed) {
+            if (rmt_receive(s_scope.chan, s_scope.rx_buf, sizeof(s_scope.rx_buf), &rx_cfg) != ESP_OK) {
+                vTaskDelay(pdMS_TO_TICKS(10));
+                continue;
+            }
+            armed = true;
+        }
+        
+        scope_chunk_t chunk;
+        if (xQueueReceive(s_scope.chunks, &chunk, pdMS_TO_TICKS(100)) != pdTRUE) {
+            continue;
+        }
+        if (chunk.lost) {
+            reset_decoder();
+        }
+        decode_chunk(&chunk);
+        if (chunk.last) {
+            s_scope.captures++;
+            armed = false;
+        }
+    }
+    
+    rmt_disable(s_scope.chan);
+    rmt_del_channel(s_scope.chan);
+    s_scope.chan = NULL;
+    
+    xSemaphoreGive(s_scope.done_sem);
+    vTaskDelete(NULL);
+}
+
+esp_err_t scope_start(const scope_config_t *config)
+{
+    if (s_scope.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (config->bitrate < 10000 || config->bitrate > 1000000 ||
+            config->sample_point < 500 || config->sample_point > 950) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_scope.done_sem == NULL) {
+        s_scope.done_sem = xSemaphoreCreateBinary();
+        s_scope.chunks = xQueueCreate(SCOPE_CHUNK_QUEUE_LEN, sizeof(scope_chunk_t));
+        if (s_scope.done_sem == NULL || s_scope.chunks == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    xSemaphoreTake(s_scope.done_sem, 0);
+    xQueueReset(s_scope.chunks);
+    
+    // Same pin as the TWAI controller: the GPIO matrix feeds both
+    rmt_rx_channel_config_t chan_cfg = {
+        .gpio_num = CONFIG_CAN_RX_GPIO,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = SCOPE_TICK_HZ,
+        .mem_block_symbols = SCOPE_MEM_SYMBOLS,
+    };
+    esp_err_t ret = rmt_new_rx_channel(&chan_cfg, &s_scope.chan);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    const rmt_rx_event_callbacks_t cbs = {
+        .on_recv_done = scope_rx_done,
+    };
+    ret = rmt_rx_register_event_callbacks(s_scope.chan, &cbs, NULL);
+    if (ret == ESP_OK) {
+        ret = rmt_enable(s_scope.chan);
+    }
+    if (ret != ESP_OK) {
+        rmt_del_channel(s_scope.chan);
+        s_scope.chan = NULL;
+        return ret;
+    }
+    
+    portENTER_CRITICAL(&s_scope_mux);
+    s_scope.cfg = *config;
+    reset_decoder();
+    s_scope.head = 0;
+    s_scope.tail = 0;
+    s_scope.lost_pending = false;
+    s_scope.captures = 0;
+    s_scope.overflows = 0;
+    s_scope.records = 0;
+    s_scope.records_dropped = 0;
+    s_scope.running = true;
+    portEXIT_CRITICAL(&s_scope_mux);
+    
+    if (xTaskCreate(scope_task, "scope", 4096, NULL, 8, NULL) != pdPASS) {
+        s_scope.running = false;
+        rmt_disable(s_scope.chan);
+        rmt_del_channel(s_scope.chan);
+        s_scope.chan = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Sampling GPIO %d at %lu bit/s, sample point %u", CONFIG_CAN_RX_GPIO,
+             (unsigned long)config->bitrate, config->sample_point);
+    return ESP_OK;
+}
+
+esp_err_t scope_stop(void)
+{
+    if (!s_scope.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    s_scope.running = false;
+    if (xSemaphoreTake(s_scope.done_sem, pdMS_TO_TICKS(2000)) != pdTRUE) {
+        ESP_LOGE(TAG, "Scope task did not stop");
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+void scope_get_status(scope_status_t *out)
+{
+    portENTER_CRITICAL(&s_scope_mux);
+    out->running = s_scope.running;
+    out->cfg = s_scope.cfg;
+    out->captures = s_scope.captures;
+    out->frames = s_scope.dec.frames;
+    out->errors = s_scope.dec.errors;
+    out->glitches = s_scope.dec.glitches;
+    out->overflows = s_scope.overflows;
+    out->records = s_scope.records;
+    out->records_dropped = s_scope.records_dropped;
+    portEXIT_CRITICAL(&s_scope_mux);
+}
+
+/**
+ * @brief "scope" command handler
+ */
+static int scope_cmd_handler(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&scope_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, scope_args.end, argv[0]);
+        return 1;
+    }
+    
+    const char *action = scope_args.action->count ? scope_args.action->sval[0] : "show";
+    
+    if (strcmp(action, "start") == 0) {
+        scope_config_t cfg = {
+            .bitrate = scope_args.bitrate->count ? scope_args.bitrate->ival[0] : slcan_get_bitrate(),
+            .sample_point = scope_args.sample_point->count ? scope_args.sample_point->ival[0] : 875,
+            .errors_only = scope_args.errors_only->count > 0,
+        };
+        esp_err_t ret = scope_start(&cfg);
+        if (ret != ESP_OK) {
+            printf("scope start: %s\n", esp_err_to_name(ret));
+            return 1;
+        }
+    } else if (strcmp(action, "stop") == 0) {
+        if (scope_stop() != ESP_OK) {
+            printf("scope: not running\n");
+            return 1;
+        }
+    } else if (strcmp(action, "show") != 0) {
+        printf("scope: unknown action '%s'\n", action);
+        return 1;
+    }
+    
+    scope_status_t st;
+    scope_get_status(&st);
+    printf("scope: %s, %lu bit/s, sample point %u%s, %lu captures, %lu frames, %lu errors, %lu glitches, "
+           "%lu overflows, %lu records, %lu dropped\n", st.running ? "running" : "stopped",
+           (unsigned long)st.cfg.bitrate, st.cfg.sample_point, st.cfg.errors_only ? " (errors only)" : "",
+           (unsigned long)st.captures, (unsigned long)st.frames, (unsigned long)st.errors,
+           (unsigned long)st.glitches, (unsigned long)st.overflows, (unsigned long)st.records,
+           (unsigned long)st.records_dropped);
+    return 0;
+}
+
+void scope_register_commands(void)
+{
+    scope_args.action = arg_str0(NULL, NULL, "<start|stop|show>", "Action (default: show)");
+    scope_args.bitrate = arg_int0("b", "bitrate", "<bit/s>", "start: bitrate (default: the bridge bitrate)");
+    scope_args.sample_point = arg_int0("s", "sample-point", "<permille>", "start: sample point (default: 875)");
+    scope_args.errors_only = arg_lit0("e", "errors", "start: report failed frames only");
+    scope_args.end = arg_end(4);
+    
+    const esp_console_cmd_t scope_cmd = {
+        .command = "scope",
+        .help = "Logic-analyzer mode: sample the RX pin with RMT and decode frames in software\n"
+        "  scope start -e    # report failed frames with their error location and edges\n"
+        "  scope             # decoded frames, errors and lost captures",
+        .hint = NULL,
+        .func = &scope_cmd_handler,
+        .argtable = &scope_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&scope_cmd));
+}
@@ -0,0 +1,92 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Logic-analyzer mode: software decoding of the sampled RX pin
+ *
+ * The RMT peripheral samples the CAN RX pin alongside the TWAI controller
+ * and the waveform is decoded in software (see wave_decode.h), so the host
+ * sees what the controller hides: where a frame went wrong, and the bus
+ * waveform of that frame. Normal forwarding is not affected. Records:
+ *
+ *   Wf <time_us> <id> <dlc> <data> <a|n>                  decoded frame
+ *   We <time_us> <error> <field> <bit> <id> <edges>       failed frame
+ *
+ * The ID has 3 hex digits for standard frames and 8 for extended ones; the
+ * data is hex, '-' if empty or 'R' for a remote frame; a/n tells whether
+ * the frame was acknowledged. <error> is stuff, crc, form, or flag for a
+ * stuff error on six dominant bits (another node's error flag); <bit> is
+ * the bit from the start of frame (stuff bits included) where the error was
+ * detected, <id> '-' if the arbitration field was not complete, and <edges>
+ * the comma-separated times of the level changes in ns from the start of
+ * frame. The time of a record is the time of its start of frame.
+ *
+ * A capture ends after 12 idle bits and is re-armed by the scope task; a
+ * frame starting in the window before the re-arm is missed.
+ */
+
+/**
+ * @brief Scope parameters
+ */
+typedef struct {
+    uint32_t bitrate;           /**< Nominal bitrate (10000..1000000) */
+    uint16_t sample_point;      /**< Sample point, per mille of the bit */
+    bool errors_only;           /**< Report failed frames only */
+} scope_config_t;
+
+/**
+ * @brief Scope status
+ */
+typedef struct {
+    bool running;
+    scope_config_t cfg;
+    uint32_t captures;          /**< RMT receptions completed */
+    uint32_t frames;            /**< Frames decoded */
+    uint32_t errors;            /**< Failed frames */
+    uint32_t glitches;          /**< Dominant pulses too short for a start of frame */
+    uint32_t overflows;         /**< Symbols lost (decoder restarted) */
+    uint32_t records;           /**< Records sent to the host */
+    uint32_t records_dropped;   /**< Records dropped (channel closed) */
+} scope_status_t;
+
+/**
+ * @brief Start sampling the RX pin
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if running, ESP_ERR_INVALID_ARG, ESP_ERR_NO_MEM,
+ *         or the error of the RMT driver
+ */
+esp_err_t scope_start(const scope_config_t *config);
+
+/**
+ * @brief Stop sampling and release the RMT channel
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not running, ESP_ERR_TIMEOUT
+ */
+esp_err_t scope_stop(void);
+
+/**
+ * @brief Get the scope status
+ */
+void scope_get_status(scope_status_t *out);
+
+/**
+ * @brief Register the 'scope' extension command
+ */
+void scope_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -7,8 +7,17 @@
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
 #include "slcan_protocol.h"
+#include "bridge_cmd.h"
+#include "can_autodetect.h"
+#include "can_tx.h"
+#include "host_link.h"
 #include "esp_log.h"
+#if CONFIG_CAN_BRIDGE_PROTOCOL_DYNAMIC
+#include "delta_stream.h"
+#endif
 
 static const char *TAG = "slcan";
 
@@ -17,6 +26,9 @@ static struct {
     bool is_open;
     uint32_t bitrate;
     uint8_t timestamp_enabled;
+    bool timing_set;
+    bit_timing_t timing;
+    slcan_channel_cb_t channel_cb;
 } slcan_state = {
     .is_open = false,
     .bitrate = 0,
@@ -78,11 +90,115 @@ static int hex_to_byte(const char *hex)
     return (high << 4) | low;
 }
 
+/**
+ * @brief Calculate and store the bit timing requested by 'S' or 's'
+ * 
+ * @return ESP_OK if a timing within tolerance was found
+ */
+static esp_err_t slcan_set_timing(uint32_t bitrate, uint16_t sp_permill, uint8_t sjw,
+                                  bool triple_sampling, int32_t *err_ppm)
+{
+    bit_timing_t timing;
+    esp_err_t ret = can_bridge_calc_timing(bitrate, sp_permill, sjw, &timing, err_ppm);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    timing.triple_sampling = triple_sampling;
+    
+    slcan_state.timing = timing;
+    slcan_state.timing_set = true;
+    slcan_state.bitrate = bitrate;
+    return ESP_OK;
+}
+
+/**
+ * @brief Parse an unsigned decimal field of "s=..." (no sign, at least one digit)
+ *
+ * @return true if a value was parsed; *end points behind it
+ */
+static bool parse_field(const char *str, char **end, unsigned long *value)
+{
+    if (!isdigit((unsigned char)str[0])) {
+        return false;
+    }
+    errno = 0;
+    *value = strtoul(str, end, 10);
+    return errno == 0;
+}
+
+/**
+ * @brief Handle 's' - SJA1000 BTR0/BTR1 ("sxxyy") or explicit timing ("s=bitrate[,sp[,sjw]]")
+ */
+static esp_err_t slcan_process_btr(const uint8_t *data, size_t len)
+{
+    uint32_t bitrate;
+    uint16_t sp_permill = 0;
+    uint8_t sjw = 0;
+    bool triple_sampling = false;
+    bool extended = (len >= 3 && data[1] == '=');
+    
+    if (extended) {
+        // s=<bitrate>[,<sample point permille>[,<sjw>]]; ranges are checked before narrowing
+        char *end = NULL;
+        unsigned long rate_val;
+        unsigned long sp_val = 0;
+        unsigned long sjw_val = 0;
+        if (!parse_field((const char *)&data[2], &end, &rate_val) || rate_val == 0) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (*end == ',') {
+            if (!parse_field(end + 1, &end, &sp_val) || sp_val < 1 || sp_val > 999) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            if (*end == ',') {
+                if (!parse_field(end + 1, &end, &sjw_val) || sjw_val > CAN_BRIDGE_SJW_MAX) {
+                    return ESP_ERR_INVALID_ARG;
+                }
+            }
+        }
+        if (*end != '\0') {
+            return ESP_ERR_INVALID_ARG;
+        }
+        bitrate = (uint32_t)rate_val;
+        sp_permill = (uint16_t)sp_val;
+        sjw = (uint8_t)sjw_val;
+    } else if (len == 5) {
+        // sxxyy: BTR0/BTR1 of an SJA1000 clocked at 16 MHz
+        int btr0 = hex_to_byte((const char *)&data[1]);
+        int btr1 = hex_to_byte((const char *)&data[3]);
+        if (btr0 < 0 || btr1 < 0) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        bit_timing_t sja;
+        bit_timing_from_btr((uint8_t)btr0, (uint8_t)btr1, &sja);
+        bitrate = bit_timing_bitrate(BIT_TIMING_SJA1000_CLK_HZ, &sja);
+        sp_permill = bit_timing_sample_point(&sja);
+        sjw = sja.sjw;
+        triple_sampling = sja.triple_sampling;
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    int32_t err_ppm = 0;
+    esp_err_t ret = slcan_set_timing(bitrate, sp_permill, sjw, triple_sampling, &err_ppm);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    // The SLCAN reply is only CR or BELL; the achieved timing goes to the log
+    const bit_timing_t *t = &slcan_state.timing;
+    ESP_LOGI(TAG, "Bit timing for %lu bps: %lu bps, brp %lu tseg1 %u tseg2 %u sjw %u, sample point %u/1000, "
+             "error %ld ppm", bitrate, (unsigned long)bit_timing_bitrate(can_bridge_get_clock_hz(), t), t->brp,
+             t->tseg1, t->tseg2, t->sjw, bit_timing_sample_point(t), err_ppm);
+    return ESP_OK;
+}
+
 esp_err_t slcan_init(void)
 {
     slcan_state.is_open = false;
     slcan_state.bitrate = 0;
     slcan_state.timestamp_enabled = 0;
+    slcan_state.timing_set = false;
     
     ESP_LOGI(TAG, "SLCAN protocol initialized");
     return ESP_OK;
@@ -98,8 +214,8 @@ esp_err_t slcan_process_command(const uint8_t *data, size_t len)
         case 'S': // Set bitrate with standard codes (S0-S8)
             if (len >= 2) {
                 int rate_code = data[1] - '0';
-                if (rate_code >= 0 && rate_code < sizeof(slcan_bitrates)/sizeof(slcan_bitrates[0])) {
-                    slcan_state.bitrate = slcan_bitrates[rate_code];
+                if (rate_code >= 0 && rate_code < sizeof(slcan_bitrates)/sizeof(slcan_bitrates[0]) &&
+                    slcan_set_timing(slcan_bitrates[rate_code], 0, 0, false, NULL) == ESP_OK) {
                     ESP_LOGI(TAG, "Bitrate set to %lu bps (code S%d)", slcan_state.bitrate, rate_code);
                     slcan_send_response("\r");
                 } else {
@@ -108,19 +224,35 @@ esp_err_t slcan_process_command(const uint8_t *data, size_t len)
             }
             break;
             
-        case 's': // Set bitrate with BTR registers (not implemented, use S command)
-            ESP_LOGW(TAG, "BTR register setting not supported, use S command");
-            slcan_send_response("\x07");
+        case 's': // Set bitrate with BTR registers or explicit bitrate/sample point
+            if (slcan_process_btr(data, len) == ESP_OK) {
+                slcan_send_response("\r");
+            } else {
+                ESP_LOGW(TAG, "Invalid or unachievable bit timing: %.*s", (int)len, (const char *)data);
+                slcan_send_response("\x07");
+            }
             break;
             
         case 'O': // Open channel
+            if (slcan_state.channel_cb && slcan_state.channel_cb(true) != ESP_OK) {
+                ESP_LOGW(TAG, "Channel open failed");
+                slcan_send_response("\x07");
+                break;
+            }
             slcan_state.is_open = true;
+#if CONFIG_CAN_BRIDGE_PROTOCOL_DYNAMIC
+            // A new session: the host decoder starts with an empty dictionary
+            delta_stream_reset();
+#endif
             ESP_LOGI(TAG, "Channel opened");
             slcan_send_response("\r");
             break;
             
         case 'C': // Close channel
             slcan_state.is_open = false;
+            if (slcan_state.channel_cb) {
+                slcan_state.channel_cb(false);
+            }
             ESP_LOGI(TAG, "Channel closed");
             slcan_send_response("\r");
             break;
@@ -152,9 +284,28 @@ esp_err_t slcan_process_command(const uint8_t *data, size_t len)
         case 'T': // Transmit extended frame (29-bit ID)
         case 'r': // Transmit standard RTR frame
         case 'R': // Transmit extended RTR frame
-            // These will be handled by the main bridge task
-            ESP_LOGD(TAG, "TX frame command received (handled elsewhere)");
-            slcan_send_response("z\r"); // TX buffer access (success)
+        {
+            uint8_t payload[TWAI_FRAME_MAX_LEN];
+            twai_frame_t frame = {
+                .buffer = payload,
+                .buffer_len = sizeof(payload),
+            };
+            if (!slcan_state.is_open ||
+                slcan_parse_frame((const char *)data, len, &frame) != ESP_OK ||
+                can_tx_send(&frame) != ESP_OK) {
+                slcan_send_response("\x07");
+                break;
+            }
+            slcan_send_response((cmd == 't' || cmd == 'r') ? "z\r" : "Z\r");
+            break;
+        }
+            
+        case 'X': // Bridge extension command (see bridge_cmd.h)
+            if (len >= 2 && bridge_cmd_run((const char *)&data[1]) == ESP_OK) {
+                slcan_send_response("\r");
+            } else {
+                slcan_send_response("\x07");
+            }
             break;
             
         default:
@@ -166,12 +317,20 @@ esp_err_t slcan_process_command(const uint8_t *data, size_t len)
     return ESP_OK;
 }
 
-esp_err_t slcan_send_frame(const twai_frame_t *frame)
+esp_err_t slcan_send_frame(const twai_frame_t *frame, int64_t timestamp_us)
 {
-    if (!slcan_state.is_open) {
+    // Nothing is formatted while the channel is closed or nobody reads it
+    if (!slcan_state.is_open || !host_link_present()) {
         return ESP_ERR_INVALID_STATE;
     }
     
+    uint16_t timestamp = (uint16_t)((timestamp_us / 1000) % 60000);
+#if CONFIG_CAN_BRIDGE_PROTOCOL_DYNAMIC
+    if (delta_stream_is_active()) {
+        return delta_stream_send(frame, slcan_state.timestamp_enabled, timestamp);
+    }
+#endif
+    
     char buffer[64];
     int pos = 0;
     
@@ -208,18 +367,87 @@ esp_err_t slcan_send_frame(const twai_frame_t *frame)
     
     // Timestamp (if enabled) - 4 hex digits
     if (slcan_state.timestamp_enabled) {
-        uint16_t timestamp = 0; // TODO: Add real timestamp
         snprintf(&buffer[pos], 5, "%04X", timestamp);
         pos += 4;
     }
     
     // Carriage return
     buffer[pos++] = '\r';
-    buffer[pos] = '\0';
     
     // Send to PC
-    slcan_send_response(buffer);
+    return host_link_write(buffer, pos);
+}
+
+size_t slcan_frame_len(const twai_frame_t *frame)
+{
+    // Same layout as slcan_send_frame(): type, ID, DLC, data, timestamp, '\r'
+    uint8_t dlc = frame->header.dlc > 8 ? 8 : frame->header.dlc;
+    size_t len = 1 + (frame->header.id > 0x7FF ? 8 : 3) + 1 + 1;
+    if (!frame->header.rtr) {
+        len += 2 * dlc;
+    }
+    if (slcan_state.timestamp_enabled) {
+        len += 4;
+    }
+    return len;
+}
+
+esp_err_t slcan_parse_frame(const char *text, size_t len, twai_frame_t *frame)
+{
+    if (len < 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    char type = text[0];
+    bool ext = (type == 'T' || type == 'R');
+    bool rtr = (type == 'r' || type == 'R');
+    if (type != 't' && type != 'T' && type != 'r' && type != 'R') {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    size_t id_len = ext ? 8 : 3;
+    if (len < 1 + id_len + 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
     
+    uint32_t id = 0;
+    for (size_t i = 0; i < id_len; i++) {
+        int nibble = hex_to_nibble(text[1 + i]);
+        if (nibble < 0) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        id = (id << 4) | (uint32_t)nibble;
+    }
+    if (id > (ext ? TWAI_EXT_ID_MASK : TWAI_STD_ID_MASK)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    int dlc = hex_to_nibble(text[1 + id_len]);
+    if (dlc < 0 || dlc > TWAI_FRAME_MAX_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    size_t pos = 1 + id_len + 1;
+    if (!rtr) {
+        if (len < pos + (size_t)dlc * 2 || frame->buffer_len < (size_t)dlc) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        for (int i = 0; i < dlc; i++) {
+            int byte = hex_to_byte(&text[pos]);
+            if (byte < 0) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            frame->buffer[i] = (uint8_t)byte;
+            pos += 2;
+        }
+    }
+    
+    memset(&frame->header, 0, sizeof(frame->header));
+    frame->header.id = id;
+    frame->header.ide = ext;
+    frame->header.rtr = rtr;
+    frame->header.dlc = (uint16_t)dlc;
+    frame->buffer_len = rtr ? 0 : (size_t)dlc;
     return ESP_OK;
 }
 
@@ -232,3 +460,17 @@ bool slcan_is_open(void)
 {
     return slcan_state.is_open;
 }
+
+void slcan_set_channel_callback(slcan_channel_cb_t cb)
+{
+    slcan_state.channel_cb = cb;
+}
+
+bool slcan_get_bit_timing(bit_timing_t *timing)
+{
+    if (!slcan_state.timing_set) {
+        return false;
+    }
+    *timing = slcan_state.timing;
+    return true;
+}
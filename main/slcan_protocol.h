@@ -8,6 +8,7 @@
 
 #include "esp_err.h"
 #include "esp_twai.h"
+#include "bit_timing.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -19,6 +20,14 @@ extern "C" {
  * Implements Serial Line CAN protocol for communication with PC tools like SavvyCAN
  */
 
+/**
+ * @brief Channel open/close notification callback
+ * 
+ * @param open true when the channel was opened ('O'), false when closed ('C')
+ * @return ESP_OK to accept; on error an 'O' is answered with BELL and the channel stays closed
+ */
+typedef esp_err_t (*slcan_channel_cb_t)(bool open);
+
 /**
  * @brief Initialize SLCAN protocol handler
  * 
@@ -38,10 +47,34 @@ esp_err_t slcan_process_command(const uint8_t *data, size_t len);
 /**
  * @brief Send CAN frame to PC in SLCAN format
  * 
+ * With 'Xstream delta' the frame is sent as a delta-encoded record instead
+ * (delta_stream.h).
+ * 
  * @param frame CAN frame to send
- * @return ESP_OK on success, error code otherwise
+ * @param timestamp_us Frame timestamp (us), sent as milliseconds modulo 60000 when enabled with 'Z1'
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if the channel is closed or no host is
+ *         present (nothing is formatted), error code otherwise
  */
-esp_err_t slcan_send_frame(const twai_frame_t *frame);
+esp_err_t slcan_send_frame(const twai_frame_t *frame, int64_t timestamp_us);
+
+/**
+ * @brief Length of the line slcan_send_frame() writes for a frame
+ * 
+ * @param frame CAN frame
+ * @return Line length in bytes, including the '\r'
+ */
+size_t slcan_frame_len(const twai_frame_t *frame);
+
+/**
+ * @brief Parse an SLCAN frame command (tiiildd.., Tiiiiiiiildd.., riiil, Riiiiiiiil)
+ * 
+ * @param text Command text without the terminating '\r'
+ * @param len Length of text
+ * @param frame Output: frame; frame->buffer must point to at least 8 bytes
+ * 
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the text is malformed
+ */
+esp_err_t slcan_parse_frame(const char *text, size_t len, twai_frame_t *frame);
 
 /**
  * @brief Get current SLCAN bitrate setting
@@ -57,6 +90,21 @@ uint32_t slcan_get_bitrate(void);
  */
 bool slcan_is_open(void);
 
+/**
+ * @brief Get the bit timing requested by the host with 'S' or 's'
+ * 
+ * @param timing Output: register values for the TWAI controller
+ * @return true if the host has set a bitrate, false otherwise
+ */
+bool slcan_get_bit_timing(bit_timing_t *timing);
+
+/**
+ * @brief Register callback for channel open/close commands
+ * 
+ * @param cb Callback, or NULL to remove
+ */
+void slcan_set_channel_callback(slcan_channel_cb_t cb);
+
 #ifdef __cplusplus
 }
 #endif
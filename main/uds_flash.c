@@ -0,0 +1,570 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+#include "esp_partition.h"
+#include "uds_flash.h"
+#include "uds_proto.h"
+#include "isotp_send.h"
+#include "host_link.h"
+#include "bridge_config.h"
+
+static const char *TAG = "uds_flash";
+
+// Gap allowed in the host's load stream
+#define LOAD_TIMEOUT_MS         2000
+
+// Quiet time that ends a corrupted chunk
+#define LOAD_RESYNC_MS          50
+
+// Pause before repeating a request refused with busy-repeat-request
+#define BUSY_RETRY_MS           10
+
+// Responses of the download services are short
+#define RESP_MAX_LEN            64
+
+// Download state
+static struct {
+    const esp_partition_t *part;
+    uds_image_header_t image;
+    volatile bool running;
+    volatile bool stop;
+    SemaphoreHandle_t done_sem;
+    uds_flash_config_t cfg;
+    const char *stage;
+    esp_err_t result;
+    uint8_t nrc;
+    uint32_t sent;
+    uint32_t blocks;
+    uint32_t block_len;
+    uint32_t retries;
+    uint32_t pending;
+    int64_t start_us;
+    int64_t transfer_start_us;
+    int64_t transfer_end_us;
+    int64_t end_us;
+    uint32_t bus_max;
+} s_uds;
+
+static portMUX_TYPE s_uds_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Request and response buffers of the download task
+static uint8_t s_req[ISOTP_MAX_LEN];
+static uint8_t s_resp[RESP_MAX_LEN];
+
+// Load chunk buffer
+static uint8_t s_chunk[UDS_LOAD_CHUNK];
+
+/** @brief Command line arguments for uds command */
+static struct {
+    struct arg_str *action;
+    struct arg_str *params;
+    struct arg_lit *ext;
+    struct arg_str *address;
+    struct arg_int *format;
+    struct arg_int *block;
+    struct arg_int *retries;
+    struct arg_int *timeout;
+    struct arg_int *padding;
+    struct arg_end *end;
+} uds_args;
+
+esp_err_t uds_flash_init(void)
+{
+    s_uds.part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, UDS_PARTITION_SUBTYPE, UDS_PARTITION_LABEL);
+    if (s_uds.part == NULL) {
+        ESP_LOGW(TAG, "No '%s' partition, UDS download disabled", UDS_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    s_uds.done_sem = xSemaphoreCreateBinary();
+    if (s_uds.done_sem == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    if (esp_partition_read(s_uds.part, 0, &s_uds.image, sizeof(s_uds.image)) != ESP_OK ||
+        s_uds.image.magic != UDS_IMAGE_MAGIC || s_uds.image.size > s_uds.part->size - UDS_IMAGE_OFFSET) {
+        memset(&s_uds.image, 0, sizeof(s_uds.image));
+    }
+    s_uds.stage = "idle";
+    ESP_LOGI(TAG, "Image partition: %lu KB, %lu bytes staged", (unsigned long)(s_uds.part->size / 1024),
+             (unsigned long)s_uds.image.size);
+    return ESP_OK;
+}
+
+void uds_flash_default_config(uds_flash_config_t *config)
+{
+    *config = (uds_flash_config_t) {
+        .extended = false,
+        .padding = 0xAA,
+        .data_format = 0x00,
+        .max_block_len = 0,
+        .retries = 3,
+        .p2_ms = 100,
+        .p2_ext_ms = 5000,
+    };
+}
+
+/**
+ * @brief Discard the host's input until it pauses (after a corrupted chunk header)
+ */
+static void load_resync(void)
+{
+    uint8_t byte;
+    while (host_link_read(&byte, 1, LOAD_RESYNC_MS) == ESP_OK) {
+    }
+}
+
+esp_err_t uds_flash_load(uint32_t size)
+{
+    if (s_uds.part == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (s_uds.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (size == 0 || size > s_uds.part->size - UDS_IMAGE_OFFSET) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    
+    // The header is written last: an interrupted load leaves no image staged
+    memset(&s_uds.image, 0, sizeof(s_uds.image));
+    size_t erase_len = UDS_IMAGE_OFFSET + ((size + UDS_LOAD_CHUNK - 1) / UDS_LOAD_CHUNK) * UDS_LOAD_CHUNK;
+    esp_err_t ret = esp_partition_erase_range(s_uds.part, 0, erase_len);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    printf("load %lu %u\n", (unsigned long)size, UDS_LOAD_CHUNK);
+    fflush(stdout);
+    
+    int64_t start_us = esp_timer_get_time();
+    uint32_t offset = 0;
+    uint32_t crc = 0;
+    uint32_t resends = 0;
+    while (offset < size) {
+        uint32_t expected = size - offset < UDS_LOAD_CHUNK ? size - offset : UDS_LOAD_CHUNK;
+        uds_load_chunk_t hdr;
+        ret = host_link_read(&hdr, sizeof(hdr), LOAD_TIMEOUT_MS);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        if (hdr.magic != UDS_LOAD_MAGIC || hdr.offset != offset || hdr.length != expected) {
+            load_resync();
+            resends++;
+            printf("load resend %lu\n", (unsigned long)offset);
+            fflush(stdout);
+            continue;
+        }
+        ret = host_link_read(s_chunk, expected, LOAD_TIMEOUT_MS);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        if (esp_rom_crc32_le(0, s_chunk, expected) != hdr.crc32) {
+            resends++;
+            printf("load resend %lu\n", (unsigned long)offset);
+            fflush(stdout);
+            continue;
+        }
+        
+        ret = esp_partition_write(s_uds.part, UDS_IMAGE_OFFSET + offset, s_chunk, expected);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        crc = esp_rom_crc32_le(crc, s_chunk, expected);
+        offset += expected;
+        printf("load ok %lu\n", (unsigned long)offset);
+        fflush(stdout);
+    }
+    
+    uds_image_header_t image = {
+        .magic = UDS_IMAGE_MAGIC,
+        .size = size,
+        .crc32 = crc,
+    };
+    ret = esp_partition_write(s_uds.part, 0, &image, sizeof(image));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    s_uds.image = image;
+    
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+    printf("load done %lu bytes crc %08lX in %lld ms (%llu kB/s), %lu resends\n", (unsigned long)size,
+           (unsigned long)crc, (long long)(elapsed_us / 1000),
+           (unsigned long long)(elapsed_us > 0 ? (uint64_t)size * 1000 / (uint64_t)elapsed_us : 0),
+           (unsigned long)resends);
+    return ESP_OK;
+}
+
+/**
+ * @brief Send a request and wait for its final response, repeating it if the response is lost
+ *
+ * @return ESP_OK on a positive response, ESP_ERR_INVALID_RESPONSE on a negative one (s_uds.nrc),
+ *         the ISO-TP error or ESP_ERR_TIMEOUT once the retries are used up
+ */
+static esp_err_t uds_request(uint16_t len, uint16_t *resp_len)
+{
+    const uds_flash_config_t *cfg = &s_uds.cfg;
+    esp_err_t ret = ESP_FAIL;
+    
+    for (uint32_t attempt = 0; attempt <= cfg->retries && !s_uds.stop; attempt++) {
+        if (attempt > 0) {
+            s_uds.retries++;
+        }
+        ret = isotp_send_message(s_req, len);
+        if (ret != ESP_OK) {
+            continue;
+        }
+        
+        // Responses to other requests do not extend the wait: the deadline only moves on a pending response
+        int64_t deadline_us = esp_timer_get_time() + (int64_t)cfg->p2_ms * 1000;
+        bool repeat = false;
+        while (!repeat) {
+            int64_t left_us = deadline_us - esp_timer_get_time();
+            if (left_us <= 0) {
+                ret = ESP_ERR_TIMEOUT;
+                repeat = true;
+                continue;
+            }
+            ret = isotp_send_receive(s_resp, sizeof(s_resp), resp_len, (uint32_t)((left_us + 999) / 1000));
+            if (ret != ESP_OK) {
+                repeat = true;
+                continue;
+            }
+            uint8_t nrc = 0;
+            switch (uds_check_response(s_req[0], s_resp, *resp_len, &nrc)) {
+            case UDS_RESP_POSITIVE:
+                return ESP_OK;
+            case UDS_RESP_PENDING:
+                s_uds.pending++;
+                deadline_us = esp_timer_get_time() + (int64_t)cfg->p2_ext_ms * 1000;
+                break;
+            case UDS_RESP_NEGATIVE:
+                s_uds.nrc = nrc;
+                if (nrc != UDS_NRC_BUSY_REPEAT_REQUEST) {
+                    return ESP_ERR_INVALID_RESPONSE;
+                }
+                vTaskDelay(pdMS_TO_TICKS(BUSY_RETRY_MS));
+                ret = ESP_ERR_INVALID_RESPONSE;
+                repeat = true;
+                break;
+            default:
+                // Response to another request: keep waiting until the deadline
+                break;
+            }
+        }
+    }
+    return ret;
+}
+
+/**
+ * @brief Run the download services over the open ISO-TP session
+ */
+static esp_err_t flash_run(const uint8_t *image)
+{
+    const uds_flash_config_t *cfg = &s_uds.cfg;
+    uint16_t resp_len;
+    
+    s_uds.stage = "download";
+    uint16_t len = uds_build_request_download(s_req, cfg->data_format, cfg->address, s_uds.image.size);
+    esp_err_t ret = uds_request(len, &resp_len);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    uint32_t block_len;
+    if (!uds_parse_download_response(s_resp, resp_len, &block_len)) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    if (block_len > ISOTP_MAX_LEN) {
+        block_len = ISOTP_MAX_LEN;
+    }
+    if (cfg->max_block_len && block_len > cfg->max_block_len) {
+        block_len = cfg->max_block_len;
+    }
+    
+    uint32_t bitrate;
+    if (!bridge_config_get_bitrate(&bitrate) || bitrate == 0) {
+        bitrate = 500000;
+    }
+    s_uds.block_len = block_len;
+    s_uds.bus_max = uds_bus_max_rate(bitrate, cfg->extended, block_len);
+    
+    s_uds.stage = "transfer";
+    s_uds.transfer_start_us = esp_timer_get_time();
+    uint8_t counter = 1;
+    while (s_uds.sent < s_uds.image.size) {
+        if (s_uds.stop) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        uint32_t n = s_uds.image.size - s_uds.sent;
+        if (n > block_len - UDS_TRANSFER_DATA_HEADER) {
+            n = block_len - UDS_TRANSFER_DATA_HEADER;
+        }
+        s_req[0] = UDS_SID_TRANSFER_DATA;
+        s_req[1] = counter;
+        memcpy(&s_req[UDS_TRANSFER_DATA_HEADER], &image[s_uds.sent], n);
+        // A repeated block keeps its counter: the ECU acknowledges it again without writing twice
+        ret = uds_request(UDS_TRANSFER_DATA_HEADER + n, &resp_len);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        if (!uds_check_transfer_response(s_resp, resp_len, counter)) {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        portENTER_CRITICAL(&s_uds_mux);
+        s_uds.sent += n;
+        s_uds.blocks++;
+        s_uds.transfer_end_us = esp_timer_get_time();
+        portEXIT_CRITICAL(&s_uds_mux);
+        counter++;
+    }
+    
+    s_uds.stage = "exit";
+    s_req[0] = UDS_SID_REQUEST_TRANSFER_EXIT;
+    ret = uds_request(1, &resp_len);
+    if (ret == ESP_OK) {
+        s_uds.stage = "done";
+    }
+    return ret;
+}
+
+/**
+ * @brief Download task: the image is read through a memory-mapped view of the partition
+ */
+static void flash_task(void *arg)
+{
+    const uds_flash_config_t *cfg = &s_uds.cfg;
+    isotp_send_config_t tp = {
+        .tx_id = cfg->tx_id,
+        .rx_id = cfg->rx_id,
+        .extended = cfg->extended,
+        .padding = cfg->padding,
+    };
+    
+    const uint8_t *map = NULL;
+    esp_partition_mmap_handle_t map_handle;
+    esp_err_t ret = esp_partition_mmap(s_uds.part, UDS_IMAGE_OFFSET, s_uds.image.size, ESP_PARTITION_MMAP_DATA,
+                                       (const void **)&map, &map_handle);
+    if (ret == ESP_OK) {
+        ret = isotp_send_open(&tp);
+        if (ret == ESP_OK) {
+            ret = flash_run(map);
+            isotp_send_close();
+        }
+        esp_partition_munmap(map_handle);
+    }
+    
+    s_uds.result = ret;
+    s_uds.end_us = esp_timer_get_time();
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Download done: %lu bytes in %lld ms", (unsigned long)s_uds.sent,
+                 (long long)((s_uds.end_us - s_uds.start_us) / 1000));
+    } else {
+        ESP_LOGW(TAG, "Download failed in %s: %s (NRC %02X)", s_uds.stage, esp_err_to_name(ret), s_uds.nrc);
+    }
+    
+    s_uds.running = false;
+    xSemaphoreGive(s_uds.done_sem);
+    vTaskDelete(NULL);
+}
+
+esp_err_t uds_flash_start(const uds_flash_config_t *config)
+{
+    if (s_uds.running || s_uds.image.size == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (config->p2_ms == 0 || config->p2_ext_ms == 0 ||
+        (config->max_block_len != 0 && config->max_block_len <= UDS_TRANSFER_DATA_HEADER)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // A previous download that finished on its own left the semaphore given
+    xSemaphoreTake(s_uds.done_sem, 0);
+    
+    portENTER_CRITICAL(&s_uds_mux);
+    s_uds.cfg = *config;
+    s_uds.stage = "download";
+    s_uds.result = ESP_OK;
+    s_uds.nrc = 0;
+    s_uds.sent = 0;
+    s_uds.blocks = 0;
+    s_uds.block_len = 0;
+    s_uds.retries = 0;
+    s_uds.pending = 0;
+    s_uds.bus_max = 0;
+    s_uds.start_us = esp_timer_get_time();
+    s_uds.transfer_start_us = 0;
+    s_uds.transfer_end_us = 0;
+    s_uds.end_us = 0;
+    s_uds.stop = false;
+    s_uds.running = true;
+    portEXIT_CRITICAL(&s_uds_mux);
+    
+    // Above the transport task, like the scanner: the ECU's flow control is answered from here
+    if (xTaskCreate(flash_task, "uds", 4096, NULL, 11, NULL) != pdPASS) {
+        s_uds.running = false;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t uds_flash_stop(void)
+{
+    if (!s_uds.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    // The current request runs to its end (at most P2* per response pending)
+    s_uds.stop = true;
+    uint32_t wait_ms = s_uds.cfg.p2_ext_ms * (s_uds.cfg.retries + 1) + 2000;
+    if (xSemaphoreTake(s_uds.done_sem, pdMS_TO_TICKS(wait_ms)) != pdTRUE) {
+        ESP_LOGE(TAG, "Download task did not stop");
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+void uds_flash_get_status(uds_flash_status_t *out)
+{
+    portENTER_CRITICAL(&s_uds_mux);
+    out->running = s_uds.running;
+    out->staged = s_uds.image.size != 0;
+    out->image_size = s_uds.image.size;
+    out->image_crc = s_uds.image.crc32;
+    out->stage = s_uds.stage;
+    out->result = s_uds.result;
+    out->nrc = s_uds.nrc;
+    out->sent = s_uds.sent;
+    out->blocks = s_uds.blocks;
+    out->block_len = s_uds.block_len;
+    out->retries = s_uds.retries;
+    out->pending = s_uds.pending;
+    int64_t end_us = s_uds.running || s_uds.end_us == 0 ? esp_timer_get_time() : s_uds.end_us;
+    out->elapsed_ms = s_uds.start_us ? (uint32_t)((end_us - s_uds.start_us) / 1000) : 0;
+    int64_t transfer_us = s_uds.transfer_end_us - s_uds.transfer_start_us;
+    out->bytes_per_s = transfer_us > 0 ? (uint32_t)((uint64_t)s_uds.sent * 1000000 / transfer_us) : 0;
+    out->bus_max_bytes_per_s = s_uds.bus_max;
+    portEXIT_CRITICAL(&s_uds_mux);
+}
+
+/**
+ * @brief "uds" command handler
+ */
+static int uds_cmd_handler(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&uds_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, uds_args.end, argv[0]);
+        return 1;
+    }
+    
+    const char *action = uds_args.action->count ? uds_args.action->sval[0] : "show";
+    int count = uds_args.params->count;
+    const char *const *params = uds_args.params->sval;
+    
+    if (strcmp(action, "load") == 0) {
+        if (count != 1) {
+            printf("uds load: need <size>\n");
+            return 1;
+        }
+        esp_err_t ret = uds_flash_load(strtoul(params[0], NULL, 0));
+        if (ret != ESP_OK) {
+            printf("uds load: %s\n", esp_err_to_name(ret));
+            return 1;
+        }
+        return 0;
+    } else if (strcmp(action, "run") == 0) {
+        if (count != 2 || uds_args.address->count == 0) {
+            printf("uds run: need <tx_id> <rx_id> and -a <address>\n");
+            return 1;
+        }
+        uds_flash_config_t cfg;
+        uds_flash_default_config(&cfg);
+        cfg.tx_id = strtoul(params[0], NULL, 16);
+        cfg.rx_id = strtoul(params[1], NULL, 16);
+        cfg.extended = uds_args.ext->count > 0;
+        cfg.address = strtoul(uds_args.address->sval[0], NULL, 16);
+        if (uds_args.format->count) {
+            cfg.data_format = uds_args.format->ival[0];
+        }
+        if (uds_args.block->count) {
+            cfg.max_block_len = uds_args.block->ival[0];
+        }
+        if (uds_args.retries->count) {
+            cfg.retries = uds_args.retries->ival[0];
+        }
+        if (uds_args.timeout->count) {
+            cfg.p2_ms = uds_args.timeout->ival[0];
+        }
+        if (uds_args.padding->count) {
+            cfg.padding = uds_args.padding->ival[0];
+        }
+        
+        esp_err_t ret = uds_flash_start(&cfg);
+        if (ret != ESP_OK) {
+            printf("uds run: %s\n", esp_err_to_name(ret));
+            return 1;
+        }
+    } else if (strcmp(action, "stop") == 0) {
+        esp_err_t ret = uds_flash_stop();
+        if (ret != ESP_OK) {
+            printf("uds: stop: %s\n", esp_err_to_name(ret));
+            return 1;
+        }
+    } else if (strcmp(action, "show") != 0) {
+        printf("uds: unknown action '%s'\n", action);
+        return 1;
+    }
+    
+    uds_flash_status_t st;
+    uds_flash_get_status(&st);
+    printf("uds: image %lu bytes crc %08lX; %s %s (NRC %02X), %lu/%lu bytes in %lu blocks of %lu, "
+           "%lu retries, %lu pending, %lu ms\n",
+           (unsigned long)st.image_size, (unsigned long)st.image_crc, st.stage,
+           st.running ? "running" : esp_err_to_name(st.result), st.nrc, (unsigned long)st.sent,
+           (unsigned long)st.image_size, (unsigned long)st.blocks, (unsigned long)st.block_len,
+           (unsigned long)st.retries, (unsigned long)st.pending, (unsigned long)st.elapsed_ms);
+    if (st.bus_max_bytes_per_s) {
+        printf("uds: %lu bytes/s, %lu%% of the bus maximum %lu bytes/s\n", (unsigned long)st.bytes_per_s,
+               (unsigned long)((uint64_t)st.bytes_per_s * 100 / st.bus_max_bytes_per_s),
+               (unsigned long)st.bus_max_bytes_per_s);
+    }
+    return 0;
+}
+
+void uds_flash_register_commands(void)
+{
+    uds_args.action = arg_str0(NULL, NULL, "<load|run|stop|show>", "Action (default: show)");
+    uds_args.params = arg_strn(NULL, NULL, "<arg>", 0, 2, "load: <size>; run: <tx_id> <rx_id> (hex)");
+    uds_args.ext = arg_lit0("x", "extended", "run: 29-bit identifiers");
+    uds_args.address = arg_str0("a", "address", "<hex>", "run: memoryAddress of RequestDownload");
+    uds_args.format = arg_int0("d", "format", "<dfi>", "run: dataFormatIdentifier (default: 0x00)");
+    uds_args.block = arg_int0("b", "block", "<len>", "run: TransferData length limit (default: as the ECU accepts)");
+    uds_args.retries = arg_int0("r", "retries", "<n>", "run: repetitions of a request without response (default: 3)");
+    uds_args.timeout = arg_int0("t", "timeout", "<ms>", "run: response timeout P2 (default: 100)");
+    uds_args.padding = arg_int0("p", "padding", "<byte>", "run: ISO-TP padding byte (default: 0xAA)");
+    uds_args.end = arg_end(9);
+    
+    const esp_console_cmd_t uds_cmd = {
+        .command = "uds",
+        .help = "UDS download of a staged image: RequestDownload, TransferData, RequestTransferExit\n"
+        "  uds load 262144               # receive the image (use tools/bridge_tool.py flash)\n"
+        "  uds run 7E0 7E8 -a 00080000   # download it, then poll 'uds' for progress and rate",
+        .hint = NULL,
+        .func = &uds_cmd_handler,
+        .argtable = &uds_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&uds_cmd));
+}
@@ -0,0 +1,165 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief On-device UDS download (ECU reprogramming)
+ *
+ * The image is first staged in the "uds" flash partition: the host streams
+ * it in CRC-checked chunks with "uds load <size>", each chunk acknowledged
+ * before the next one is sent. The download then runs on the device without
+ * any USB round trip: RequestDownload, TransferData blocks of the length the
+ * ECU accepts, RequestTransferExit. The blocks are sent with isotp_send.h,
+ * responses are received with our own flow control; response pending (NRC
+ * 0x78) extends the timeout, a lost response or busy NRC repeats the block
+ * with the same sequence counter. The achieved data rate is reported next
+ * to the best rate the bus allows for the block length (uds_proto.h).
+ *
+ * Security access and session control are left to the host (e.g. 'tp send')
+ * before the download is started.
+ *
+ * Load transfer: "load <size> <chunk_bytes>\n", then for every
+ * uds_load_chunk_t and its payload "load ok <next_offset>\n" or
+ * "load resend <offset>\n", finally "load done ...\n" and the SLCAN
+ * acknowledge.
+ */
+
+/** @brief Label of the image partition in partitions.csv */
+#define UDS_PARTITION_LABEL         "uds"
+
+/** @brief Data partition subtype of the image partition */
+#define UDS_PARTITION_SUBTYPE       0x41
+
+/** @brief Image header magic ("UIMG"), in the first block of the partition */
+#define UDS_IMAGE_MAGIC             0x474D4955
+
+/** @brief Offset of the image in the partition (after the header block) */
+#define UDS_IMAGE_OFFSET            4096
+
+/** @brief Load chunk header magic ("ULOD") */
+#define UDS_LOAD_MAGIC              0x444F4C55
+
+/** @brief Load chunk payload size */
+#define UDS_LOAD_CHUNK              4096
+
+/**
+ * @brief Staged image header
+ */
+typedef struct {
+    uint32_t magic;             /**< UDS_IMAGE_MAGIC */
+    uint32_t size;              /**< Image bytes */
+    uint32_t crc32;             /**< CRC-32 of the image */
+} uds_image_header_t;
+
+/**
+ * @brief Load chunk header, followed by 'length' payload bytes
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;             /**< UDS_LOAD_MAGIC */
+    uint32_t offset;            /**< Image offset of the payload */
+    uint32_t length;            /**< Payload bytes (UDS_LOAD_CHUNK, less for the last chunk) */
+    uint32_t crc32;             /**< CRC-32 of the payload */
+} uds_load_chunk_t;
+
+/**
+ * @brief Download parameters
+ */
+typedef struct {
+    uint32_t tx_id;             /**< Physical request identifier */
+    uint32_t rx_id;             /**< Response identifier */
+    bool extended;              /**< 29-bit identifiers */
+    uint8_t padding;            /**< ISO-TP padding byte */
+    uint32_t address;           /**< memoryAddress of RequestDownload */
+    uint8_t data_format;        /**< dataFormatIdentifier (0x00: plain) */
+    uint32_t max_block_len;     /**< Limit of the TransferData length (0: as the ECU accepts) */
+    uint8_t retries;            /**< Repetitions of a request without response */
+    uint32_t p2_ms;             /**< Response timeout */
+    uint32_t p2_ext_ms;         /**< Response timeout after response pending */
+} uds_flash_config_t;
+
+/**
+ * @brief Download status
+ */
+typedef struct {
+    bool running;
+    bool staged;                /**< An image is staged */
+    uint32_t image_size;
+    uint32_t image_crc;
+    const char *stage;          /**< "idle", "download", "transfer", "exit", "done" (string literal) */
+    esp_err_t result;           /**< Result of the last download */
+    uint8_t nrc;                /**< Negative response code that ended it (0: none) */
+    uint32_t sent;              /**< Image bytes acknowledged */
+    uint32_t blocks;            /**< TransferData blocks acknowledged */
+    uint32_t block_len;         /**< TransferData length in use */
+    uint32_t retries;           /**< Requests repeated */
+    uint32_t pending;           /**< Response pending (0x78) received */
+    uint32_t elapsed_ms;        /**< Whole download */
+    uint32_t bytes_per_s;       /**< Image bytes per second during TransferData */
+    uint32_t bus_max_bytes_per_s; /**< Best rate on the bus for the block length */
+} uds_flash_status_t;
+
+/**
+ * @brief Find the image partition and read the staged image header
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if there is no image partition, ESP_ERR_NO_MEM
+ */
+esp_err_t uds_flash_init(void);
+
+/**
+ * @brief Fill a configuration with defaults (11-bit, P2 100 ms, P2* 5000 ms, 3 retries)
+ */
+void uds_flash_default_config(uds_flash_config_t *config);
+
+/**
+ * @brief Receive an image from the host into the partition
+ *
+ * Must be called from a command handler (see host_link_read()).
+ *
+ * @param size Image bytes
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if there is no image partition, ESP_ERR_INVALID_SIZE
+ *         if the image does not fit, ESP_ERR_INVALID_STATE while a download runs, ESP_ERR_TIMEOUT
+ *         if the host stopped sending
+ */
+esp_err_t uds_flash_load(uint32_t size);
+
+/**
+ * @brief Start downloading the staged image
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if running or no image is staged,
+ *         ESP_ERR_INVALID_ARG, ESP_ERR_NO_MEM
+ */
+esp_err_t uds_flash_start(const uds_flash_config_t *config);
+
+/**
+ * @brief Abort the download after the current request
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not running,
+ *         ESP_ERR_TIMEOUT if the download task did not stop in time
+ */
+esp_err_t uds_flash_stop(void);
+
+/**
+ * @brief Get the download status
+ */
+void uds_flash_get_status(uds_flash_status_t *out);
+
+/**
+ * @brief Register the 'uds' extension command
+ */
+void uds_flash_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
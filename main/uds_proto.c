@@ -0,0 +1,75 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "uds_proto.h"
+
+// Data frame with 8 data bytes, no stuff bits, plus interframe space
+#define UDS_STD_FRAME_BITS      111
+#define UDS_EXT_FRAME_BITS      131
+
+uint16_t uds_build_request_download(uint8_t *out, uint8_t data_format, uint32_t address, uint32_t size)
+{
+    out[0] = UDS_SID_REQUEST_DOWNLOAD;
+    out[1] = data_format;
+    out[2] = 0x44;      // 4-byte memorySize, 4-byte memoryAddress
+    for (int i = 0; i < 4; i++) {
+        out[3 + i] = (uint8_t)(address >> (24 - 8 * i));
+        out[7 + i] = (uint8_t)(size >> (24 - 8 * i));
+    }
+    return UDS_REQUEST_DOWNLOAD_LEN;
+}
+
+uds_resp_t uds_check_response(uint8_t sid, const uint8_t *resp, uint16_t len, uint8_t *nrc)
+{
+    if (len >= 1 && resp[0] == (uint8_t)(sid + UDS_POSITIVE_OFFSET)) {
+        return UDS_RESP_POSITIVE;
+    }
+    if (len >= 3 && resp[0] == UDS_SID_NEGATIVE_RESPONSE && resp[1] == sid) {
+        *nrc = resp[2];
+        return resp[2] == UDS_NRC_RESPONSE_PENDING ? UDS_RESP_PENDING : UDS_RESP_NEGATIVE;
+    }
+    return UDS_RESP_INVALID;
+}
+
+bool uds_parse_download_response(const uint8_t *resp, uint16_t len, uint32_t *max_block_len)
+{
+    if (len < 2 || resp[0] != UDS_SID_REQUEST_DOWNLOAD + UDS_POSITIVE_OFFSET) {
+        return false;
+    }
+    // lengthFormatIdentifier: high nibble = bytes of maxNumberOfBlockLength
+    uint8_t n = resp[1] >> 4;
+    if (n == 0 || n > 4 || len < 2 + n) {
+        return false;
+    }
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        value = (value << 8) | resp[2 + i];
+    }
+    // A block must carry at least one data byte
+    if (value <= UDS_TRANSFER_DATA_HEADER) {
+        return false;
+    }
+    *max_block_len = value;
+    return true;
+}
+
+bool uds_check_transfer_response(const uint8_t *resp, uint16_t len, uint8_t counter)
+{
+    return len >= 2 && resp[0] == UDS_SID_TRANSFER_DATA + UDS_POSITIVE_OFFSET && resp[1] == counter;
+}
+
+uint32_t uds_bus_max_rate(uint32_t bitrate, bool extended, uint32_t block_len)
+{
+    if (bitrate == 0 || block_len <= UDS_TRANSFER_DATA_HEADER) {
+        return 0;
+    }
+    // Request: a single frame, or a first frame (6 bytes), consecutive frames (7 bytes) and a flow control
+    uint32_t frames = block_len <= 7 ? 1 : 1 + (block_len - 6 + 6) / 7 + 1;
+    // Positive response (single frame)
+    frames++;
+    uint64_t bits = (uint64_t)frames * (extended ? UDS_EXT_FRAME_BITS : UDS_STD_FRAME_BITS);
+    return (uint32_t)((uint64_t)(block_len - UDS_TRANSFER_DATA_HEADER) * bitrate / bits);
+}
@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief UDS (ISO 14229-1) download services
+ *
+ * Pure C (no ESP-IDF dependencies) so it can be built and tested on the host.
+ * Builds RequestDownload / TransferData / RequestTransferExit requests and
+ * classifies the server responses; the caller owns ISO-TP, the timeouts and
+ * the retries. Also computes the best data rate a download can reach on the
+ * bus, for comparing the achieved rate against.
+ */
+
+/** @brief Service identifiers */
+#define UDS_SID_REQUEST_DOWNLOAD        0x34
+#define UDS_SID_TRANSFER_DATA           0x36
+#define UDS_SID_REQUEST_TRANSFER_EXIT   0x37
+#define UDS_SID_NEGATIVE_RESPONSE       0x7F
+
+/** @brief Positive response SID = request SID + 0x40 */
+#define UDS_POSITIVE_OFFSET             0x40
+
+/** @brief Negative response codes handled by the client */
+#define UDS_NRC_BUSY_REPEAT_REQUEST     0x21
+#define UDS_NRC_RESPONSE_PENDING        0x78
+
+/** @brief RequestDownload length: SID, format, address/length format, 4-byte address, 4-byte size */
+#define UDS_REQUEST_DOWNLOAD_LEN        11
+
+/** @brief TransferData header: SID and block sequence counter */
+#define UDS_TRANSFER_DATA_HEADER        2
+
+/**
+ * @brief Response classification
+ */
+typedef enum {
+    UDS_RESP_POSITIVE = 0,      /**< Positive response to the request */
+    UDS_RESP_PENDING,           /**< NRC 0x78: the final response follows later */
+    UDS_RESP_NEGATIVE,          /**< Negative response (nrc) */
+    UDS_RESP_INVALID,           /**< Not a response to the request */
+} uds_resp_t;
+
+/**
+ * @brief Build a RequestDownload with 4-byte address and size
+ *
+ * @param out Output: UDS_REQUEST_DOWNLOAD_LEN bytes
+ * @param data_format dataFormatIdentifier (compression/encryption, 0x00: none)
+ * @param address memoryAddress
+ * @param size memorySize
+ * @return Request length
+ */
+uint16_t uds_build_request_download(uint8_t *out, uint8_t data_format, uint32_t address, uint32_t size);
+
+/**
+ * @brief Classify a response
+ *
+ * @param sid Request SID
+ * @param resp Response
+ * @param len Response length
+ * @param nrc Output: negative response code (UDS_RESP_NEGATIVE and UDS_RESP_PENDING)
+ */
+uds_resp_t uds_check_response(uint8_t sid, const uint8_t *resp, uint16_t len, uint8_t *nrc);
+
+/**
+ * @brief Parse a positive RequestDownload response
+ *
+ * @param resp Response (starting with 0x74)
+ * @param len Response length
+ * @param max_block_len Output: maxNumberOfBlockLength (TransferData request length, SID and counter included)
+ * @return false if malformed
+ */
+bool uds_parse_download_response(const uint8_t *resp, uint16_t len, uint32_t *max_block_len);
+
+/**
+ * @brief Check that a positive TransferData response echoes the block sequence counter
+ */
+bool uds_check_transfer_response(const uint8_t *resp, uint16_t len, uint8_t counter);
+
+/**
+ * @brief Best image data rate of a download on the bus
+ *
+ * Counts the frames of one TransferData exchange at STmin 0 and no block
+ * limit (first frame, consecutive frames, the server's flow control and its
+ * single-frame response) as 8-byte data frames without stuff bits,
+ * including the 3-bit interframe space.
+ *
+ * @param bitrate Bitrate in bps
+ * @param extended 29-bit identifiers
+ * @param block_len TransferData request length (SID and counter included)
+ * @return Image bytes per second
+ */
+uint32_t uds_bus_max_rate(uint32_t bitrate, bool extended, uint32_t block_len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,341 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <string.h>
+#include "wave_decode.h"
+
+// CRC-15/CAN generator polynomial
+#define CRC15_POLY              0x4599
+
+// Destuffed positions of the header bits
+#define POS_SRR                 12
+#define POS_IDE                 13
+#define POS_STD_DLC_END         18
+#define POS_EXT_RTR             32
+#define POS_EXT_DLC_END         38
+
+// Recessive bits before a start of frame: after an error frame, after a good frame
+#define IDLE_BITS_AFTER_ERROR   11
+#define IDLE_BITS_AFTER_FRAME   3
+
+// Bits after the CRC sequence: CRC delimiter, ACK slot, ACK delimiter, 7 EOF
+#define POST_CRC_BITS           10
+
+static const char *const s_status_names[] = {"ok", "ack", "stuff", "crc", "form"};
+
+static const char *const s_field_names[] = {
+    "sof", "id", "srr", "ide", "idext", "rtr", "res", "dlc", "data", "crc", "crcdel", "ack", "ackdel", "eof",
+};
+
+uint16_t wave_crc15(const uint8_t *bits, uint16_t count)
+{
+    uint16_t crc = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        bool nxt = (bits[i] != 0) ^ ((crc >> 14) & 1);
+        crc = (crc << 1) & 0x7FFF;
+        if (nxt) {
+            crc ^= CRC15_POLY;
+        }
+    }
+    return crc;
+}
+
+const char *wave_status_name(wave_status_t status)
+{
+    return (unsigned)status < sizeof(s_status_names) / sizeof(s_status_names[0]) ? s_status_names[status] : "?";
+}
+
+const char *wave_field_name(wave_field_t field)
+{
+    return (unsigned)field < sizeof(s_field_names) / sizeof(s_field_names[0]) ? s_field_names[field] : "?";
+}
+
+bool wave_decoder_init(wave_decoder_t *dec, const wave_timing_t *timing)
+{
+    if (timing->bitrate == 0 || timing->sample_point < 500 || timing->sample_point > 950) {
+        return false;
+    }
+    int64_t bit_q8 = ((int64_t)timing->tick_hz << 8) / timing->bitrate;
+    if (bit_q8 < (4 << 8)) {
+        return false;
+    }
+    
+    memset(dec, 0, sizeof(*dec));
+    dec->bit_q8 = bit_q8;
+    dec->sample_q8 = bit_q8 * timing->sample_point / 1000;
+    // A controller never jumps by more than its phase segment 2
+    dec->sjw_q8 = bit_q8 / 4;
+    if (dec->sjw_q8 > bit_q8 - dec->sample_q8) {
+        dec->sjw_q8 = bit_q8 - dec->sample_q8;
+    }
+    dec->last_level = 1;
+    dec->idle_bits = IDLE_BITS_AFTER_ERROR;
+    return true;
+}
+
+/**
+ * @brief Value of destuffed bits [first, first + count), MSB first
+ */
+static uint32_t get_bits(const wave_decoder_t *dec, uint16_t first, uint16_t count)
+{
+    uint32_t v = 0;
+    for (uint16_t i = first; i < first + count; i++) {
+        v = (v << 1) | dec->bits[i];
+    }
+    return v;
+}
+
+/**
+ * @brief Field of the destuffed bit at an index
+ */
+static wave_field_t field_at(const wave_decoder_t *dec, uint16_t i)
+{
+    if (i == 0) {
+        return WAVE_FIELD_SOF;
+    }
+    if (i <= 11) {
+        return WAVE_FIELD_ID;
+    }
+    if (i == POS_SRR) {
+        return WAVE_FIELD_SRR;
+    }
+    if (i == POS_IDE) {
+        return WAVE_FIELD_IDE;
+    }
+    if (!dec->bits[POS_IDE]) {
+        if (i == 14) {
+            return WAVE_FIELD_RESERVED;
+        }
+        if (i <= POS_STD_DLC_END) {
+            return WAVE_FIELD_DLC;
+        }
+    } else {
+        if (i < POS_EXT_RTR) {
+            return WAVE_FIELD_ID_EXT;
+        }
+        if (i == POS_EXT_RTR) {
+            return WAVE_FIELD_RTR;
+        }
+        if (i <= 34) {
+            return WAVE_FIELD_RESERVED;
+        }
+        if (i <= POS_EXT_DLC_END) {
+            return WAVE_FIELD_DLC;
+        }
+    }
+    return (dec->crc_start == 0 || i < dec->crc_start) ? WAVE_FIELD_DATA : WAVE_FIELD_CRC;
+}
+
+/**
+ * @brief End the frame and make it the result of the current run
+ */
+static void finish(wave_decoder_t *dec, wave_status_t status, wave_field_t field, uint16_t raw_bit)
+{
+    dec->frame.status = status;
+    if (status == WAVE_OK || status == WAVE_ACK_ERROR) {
+        dec->frames++;
+        dec->idle_bits = IDLE_BITS_AFTER_FRAME;
+    } else {
+        dec->frame.error_field = field;
+        dec->frame.error_bit = raw_bit;
+        dec->errors++;
+        dec->idle_bits = IDLE_BITS_AFTER_ERROR;
+    }
+    dec->in_frame = false;
+    dec->done = true;
+}
+
+/**
+ * @brief Handle a destuffed bit
+ */
+static void store_bit(wave_decoder_t *dec, uint8_t bit, uint16_t raw_bit)
+{
+    wave_frame_t *f = &dec->frame;
+    uint16_t i = dec->nbits++;
+    dec->bits[i] = bit;
+    
+    if (i == POS_IDE) {
+        f->ide = bit;
+        if (!f->ide) {
+            f->id = get_bits(dec, 1, 11);
+            f->rtr = dec->bits[POS_SRR];
+        }
+    } else if (f->ide && i == POS_EXT_RTR) {
+        f->id = (get_bits(dec, 1, 11) << 18) | get_bits(dec, 14, 18);
+        f->rtr = bit;
+    }
+    
+    uint16_t dlc_end = f->ide ? POS_EXT_DLC_END : POS_STD_DLC_END;
+    if (i > POS_IDE && i == dlc_end) {
+        f->dlc = get_bits(dec, dlc_end - 3, 4);
+        uint8_t len = f->rtr ? 0 : (f->dlc > 8 ? 8 : f->dlc);
+        dec->crc_start = dlc_end + 1 + 8 * len;
+    } else if (dec->crc_start != 0 && i > dlc_end && i < dec->crc_start) {
+        uint16_t n = i - dlc_end - 1;
+        f->data[n / 8] = (f->data[n / 8] << 1) | bit;
+    } else if (dec->crc_start != 0 && i == dec->crc_start + 14) {
+        f->crc = get_bits(dec, dec->crc_start, 15);
+        f->crc_calc = wave_crc15(dec->bits, dec->crc_start);
+        if (f->crc != f->crc_calc) {
+            finish(dec, WAVE_CRC_ERROR, WAVE_FIELD_CRC, raw_bit);
+            return;
+        }
+        // The last bits of the CRC sequence may still be followed by a stuff bit
+        if (dec->run_len < 5) {
+            dec->stuffing = false;
+        }
+    }
+}
+
+/**
+ * @brief Handle a bit after the CRC sequence (not stuffed)
+ */
+static void post_crc_bit(wave_decoder_t *dec, uint8_t bit, uint16_t raw_bit)
+{
+    uint8_t k = dec->post++;
+    if (k == 1) {
+        dec->frame.ack = !bit;
+        return;
+    }
+    if (k == POST_CRC_BITS - 1) {
+        // A dominant last EOF bit starts an overload frame; the frame itself is valid
+        finish(dec, dec->frame.ack ? WAVE_OK : WAVE_ACK_ERROR, WAVE_FIELD_EOF, raw_bit);
+        if (!bit) {
+            dec->idle_bits = IDLE_BITS_AFTER_ERROR;
+        }
+        return;
+    }
+    if (!bit) {
+        wave_field_t field = k == 0 ? WAVE_FIELD_CRC_DELIM : (k == 2 ? WAVE_FIELD_ACK_DELIM : WAVE_FIELD_EOF);
+        finish(dec, WAVE_FORM_ERROR, field, raw_bit);
+    }
+}
+
+/**
+ * @brief Handle a bit sampled at the sample point
+ */
+static void sample_bit(wave_decoder_t *dec, uint8_t bit)
+{
+    uint16_t raw_bit = dec->frame.raw_bits++;
+    
+    if (raw_bit == 0 && bit) {
+        // The dominant level did not last until the sample point: not a start of frame
+        dec->glitches++;
+        dec->in_frame = false;
+        dec->idle_q8 = dec->idle_bits * dec->bit_q8;
+        return;
+    }
+    if (!dec->stuffing) {
+        post_crc_bit(dec, bit, raw_bit);
+        return;
+    }
+    
+    if (dec->run_len == 5) {
+        if (bit == dec->run_bit) {
+            dec->frame.error_flag = !bit;
+            finish(dec, WAVE_STUFF_ERROR, field_at(dec, dec->nbits), raw_bit);
+            return;
+        }
+        // Stuff bit: starts the next run of equal bits
+        dec->run_bit = bit;
+        dec->run_len = 1;
+        if (dec->crc_start != 0 && dec->nbits == dec->crc_start + 15) {
+            dec->stuffing = false;
+        }
+        return;
+    }
+    if (bit == dec->run_bit) {
+        dec->run_len++;
+    } else {
+        dec->run_bit = bit;
+        dec->run_len = 1;
+    }
+    store_bit(dec, bit, raw_bit);
+}
+
+/**
+ * @brief Hard synchronization on a start of frame
+ */
+static void start_frame(wave_decoder_t *dec, int64_t t_q8)
+{
+    memset(&dec->frame, 0, sizeof(dec->frame));
+    dec->frame.sof_tick = (uint64_t)(t_q8 >> 8);
+    dec->frame.edge_count = 1;
+    dec->sof_q8 = t_q8;
+    dec->next_sample_q8 = t_q8 + dec->sample_q8;
+    dec->nbits = 0;
+    dec->crc_start = 0;
+    dec->stuffing = true;
+    dec->run_bit = 1;
+    dec->run_len = 0;
+    dec->post = 0;
+    dec->in_frame = true;
+}
+
+/**
+ * @brief Resynchronization on a recessive-to-dominant edge inside a frame
+ */
+static void resync(wave_decoder_t *dec, int64_t edge_q8)
+{
+    // Every sample before the edge has been taken, so the edge lies after the
+    // last sample point: before the expected start of the bit it is early,
+    // after it late
+    int64_t phase = edge_q8 - (dec->next_sample_q8 - dec->sample_q8);
+    if (phase > 0) {
+        dec->next_sample_q8 += phase < dec->sjw_q8 ? phase : dec->sjw_q8;
+    } else {
+        dec->next_sample_q8 -= -phase < dec->sjw_q8 ? -phase : dec->sjw_q8;
+    }
+}
+
+bool wave_decoder_feed(wave_decoder_t *dec, uint8_t level, uint32_t ticks, wave_frame_t *out)
+{
+    level = level ? 1 : 0;
+    int64_t start = dec->now_q8;
+    int64_t end = start + ((int64_t)ticks << 8);
+    dec->now_q8 = end;
+    dec->done = false;
+    
+    if (!dec->in_frame) {
+        if (level) {
+            dec->idle_q8 += end - start;
+            dec->last_level = 1;
+            return false;
+        }
+        bool idle = dec->last_level && dec->idle_q8 >= dec->idle_bits * dec->bit_q8;
+        dec->idle_q8 = 0;
+        dec->last_level = 0;
+        if (!idle) {
+            return false;
+        }
+        start_frame(dec, start);
+    } else if (level != dec->last_level) {
+        wave_frame_t *f = &dec->frame;
+        if (f->edge_count < WAVE_MAX_EDGES) {
+            f->edges[f->edge_count++] = (uint32_t)((start - dec->sof_q8) >> 8);
+        }
+        if (!level) {
+            resync(dec, start);
+        }
+    }
+    dec->last_level = level;
+    
+    while (dec->in_frame && dec->next_sample_q8 < end) {
+        sample_bit(dec, level);
+        dec->next_sample_q8 += dec->bit_q8;
+    }
+    if (!dec->done) {
+        return false;
+    }
+    
+    // The rest of a recessive run counts towards the idle time before the next frame
+    int64_t bit_end = dec->next_sample_q8 - dec->sample_q8;
+    dec->idle_q8 = (level && end > bit_end) ? end - bit_end : 0;
+    if (out != NULL) {
+        *out = dec->frame;
+    }
+    return true;
+}
@@ -0,0 +1,173 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Software CAN frame decoder for sampled bus waveforms
+ *
+ * Pure C (no ESP-IDF dependencies) so it can be built and tested on the host.
+ * The input is the RX pin as a stream of runs (a level and how long it was
+ * held, in sampler ticks), as captured by the RMT peripheral. The decoder
+ * hard-synchronizes on the start of frame, samples every bit at the sample
+ * point, resynchronizes on recessive-to-dominant edges like a CAN controller
+ * (by at most a quarter bit, and never more than the time after the sample
+ * point), removes stuff bits and checks the CRC, the delimiters and the end
+ * of frame.
+ *
+ * Every frame, good or not, yields one result. A failed frame carries the
+ * kind of error, the field and raw bit (stuff bits included) where it was
+ * detected and the edges of the waveform from the start of frame, so the
+ * host can see what the bus looked like. After an error the decoder waits
+ * for 11 recessive bits (the end of the error frame) before the next start
+ * of frame; after a good frame, for the 3 bits of intermission.
+ */
+
+/** @brief Edges kept per frame: every bit of the longest stuffed frame */
+#define WAVE_MAX_EDGES              160
+
+/** @brief Destuffed bits of the longest frame up to the CRC sequence */
+#define WAVE_MAX_BITS               128
+
+/**
+ * @brief Outcome of a frame
+ */
+typedef enum {
+    WAVE_OK = 0,                /**< Frame received and acknowledged */
+    WAVE_ACK_ERROR,             /**< Frame received, nobody acknowledged it */
+    WAVE_STUFF_ERROR,           /**< Six equal bits (an error flag if dominant) */
+    WAVE_CRC_ERROR,             /**< CRC sequence mismatch */
+    WAVE_FORM_ERROR,            /**< Dominant delimiter or end-of-frame bit */
+} wave_status_t;
+
+/**
+ * @brief Frame fields, to locate an error
+ */
+typedef enum {
+    WAVE_FIELD_SOF = 0,
+    WAVE_FIELD_ID,              /**< Base identifier */
+    WAVE_FIELD_SRR,             /**< RTR of a standard frame, SRR of an extended one */
+    WAVE_FIELD_IDE,
+    WAVE_FIELD_ID_EXT,          /**< Identifier extension */
+    WAVE_FIELD_RTR,             /**< RTR of an extended frame */
+    WAVE_FIELD_RESERVED,
+    WAVE_FIELD_DLC,
+    WAVE_FIELD_DATA,
+    WAVE_FIELD_CRC,
+    WAVE_FIELD_CRC_DELIM,
+    WAVE_FIELD_ACK,
+    WAVE_FIELD_ACK_DELIM,
+    WAVE_FIELD_EOF,
+} wave_field_t;
+
+/**
+ * @brief Sampling parameters
+ */
+typedef struct {
+    uint32_t tick_hz;           /**< Sampler resolution (ticks per second) */
+    uint32_t bitrate;           /**< Nominal bitrate */
+    uint16_t sample_point;      /**< Sample point in per mille of the bit (e.g. 875) */
+} wave_timing_t;
+
+/**
+ * @brief Decoded frame or failure
+ *
+ * The frame fields are valid as far as the frame was received.
+ */
+typedef struct {
+    wave_status_t status;
+    uint32_t id;
+    bool ide;
+    bool rtr;
+    uint8_t dlc;
+    uint8_t data[8];
+    uint16_t crc;               /**< Received CRC sequence */
+    uint16_t crc_calc;          /**< CRC computed over the received bits */
+    bool ack;                   /**< ACK slot dominant */
+    wave_field_t error_field;   /**< Field where the error was detected */
+    uint16_t error_bit;         /**< Raw bit (from the start of frame, stuff bits included) */
+    bool error_flag;            /**< Stuff error on six dominant bits: another node's error flag */
+    uint64_t sof_tick;          /**< Start of frame, ticks since the decoder was initialized */
+    uint16_t raw_bits;          /**< Bits sampled, stuff bits included */
+    uint16_t edge_count;        /**< Edges kept (the first is the start of frame, at 0) */
+    uint32_t edges[WAVE_MAX_EDGES]; /**< Edge times, ticks from the start of frame */
+} wave_frame_t;
+
+/**
+ * @brief Decoder state
+ */
+typedef struct {
+    int64_t bit_q8;             /**< Nominal bit time, ticks << 8 */
+    int64_t sample_q8;          /**< Start of bit to sample point, ticks << 8 */
+    int64_t sjw_q8;             /**< Resynchronization jump width, ticks << 8 */
+    int64_t now_q8;             /**< End of the last run */
+    bool in_frame;
+    uint8_t last_level;
+    int64_t idle_q8;            /**< Recessive time before the next start of frame */
+    uint16_t idle_bits;         /**< Recessive bits needed for a start of frame */
+    int64_t sof_q8;
+    int64_t next_sample_q8;
+    uint8_t bits[WAVE_MAX_BITS];
+    uint16_t nbits;             /**< Destuffed bits received */
+    uint16_t crc_start;         /**< Destuffed index of the CRC sequence (0: not known yet) */
+    bool stuffing;              /**< In the stuffed part of the frame */
+    uint8_t run_bit;            /**< Value of the current run of equal bits */
+    uint8_t run_len;
+    uint8_t post;               /**< Bits received after the CRC sequence */
+    bool done;
+    wave_frame_t frame;
+    uint32_t frames;            /**< Frames decoded without error */
+    uint32_t errors;            /**< Frames with an error */
+    uint32_t glitches;          /**< Start of frame shorter than the sample point */
+} wave_decoder_t;
+
+/**
+ * @brief Initialize the decoder
+ *
+ * The bus counts as busy until 11 recessive bits have been seen.
+ *
+ * @return false if the timing is not usable (fewer than 4 ticks per bit)
+ */
+bool wave_decoder_init(wave_decoder_t *dec, const wave_timing_t *timing);
+
+/**
+ * @brief Feed one run of the RX pin
+ *
+ * A frame ends at most once per run: a new start of frame needs a dominant
+ * run after the recessive end of the previous one.
+ *
+ * @param level 1 recessive, 0 dominant
+ * @param ticks Duration of the run
+ * @param out Filled when a frame ended in this run
+ * @return true if out holds a frame
+ */
+bool wave_decoder_feed(wave_decoder_t *dec, uint8_t level, uint32_t ticks, wave_frame_t *out);
+
+/**
+ * @brief Short name of a status ("ok", "ack", "stuff", "crc", "form")
+ */
+const char *wave_status_name(wave_status_t status);
+
+/**
+ * @brief Short name of a field ("sof", "id", ..., "eof")
+ */
+const char *wave_field_name(wave_field_t field);
+
+/**
+ * @brief CAN CRC-15 over a sequence of bits (one per byte)
+ */
+uint16_t wave_crc15(const uint8_t *bits, uint16_t count);
+
+#ifdef __cplusplus
+}
+#endif
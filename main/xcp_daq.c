@@ -0,0 +1,226 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "xcp_daq.h"
+
+/**
+ * @brief Bytes of the identification field in front of the ODT data
+ */
+static uint8_t id_field_len(xcp_id_field_t id_field)
+{
+    return (uint8_t)id_field + 1;
+}
+
+/**
+ * @brief Read an unsigned value in the slave byte order
+ */
+static uint32_t get_uint(const uint8_t *p, uint8_t size, bool big_endian)
+{
+    uint32_t v = 0;
+    for (uint8_t i = 0; i < size; i++) {
+        v |= (uint32_t)p[big_endian ? size - 1 - i : i] << (8 * i);
+    }
+    return v;
+}
+
+void xcp_daq_init(xcp_daq_t *daq)
+{
+    memset(daq, 0, sizeof(*daq));
+}
+
+bool xcp_daq_add_var(xcp_daq_t *daq, const xcp_var_t *var)
+{
+    if (daq->var_count == XCP_DAQ_MAX_VARS) {
+        return false;
+    }
+    if (var->size != 1 && var->size != 2 && var->size != 4) {
+        return false;
+    }
+    if (var->type == XCP_VAR_FLOAT && var->size != 4) {
+        return false;
+    }
+    daq->vars[daq->var_count++] = *var;
+    return true;
+}
+
+bool xcp_daq_layout(xcp_daq_t *daq, const xcp_daq_format_t *fmt)
+{
+    uint8_t hdr = id_field_len(fmt->id_field);
+    if (fmt->max_dto > 8 || fmt->max_dto <= hdr + fmt->ts_size) {
+        return false;
+    }
+    
+    daq->fmt = *fmt;
+    daq->list_count = 0;
+    memset(daq->lists, 0, sizeof(daq->lists));
+    
+    // One list per event channel, in the order of the first variable
+    for (uint8_t v = 0; v < daq->var_count; v++) {
+        const xcp_var_t *var = &daq->vars[v];
+        xcp_daq_list_t *list = NULL;
+        for (uint8_t l = 0; l < daq->list_count; l++) {
+            if (daq->lists[l].event == var->event) {
+                list = &daq->lists[l];
+                break;
+            }
+        }
+        if (list == NULL) {
+            if (daq->list_count == XCP_DAQ_MAX_LISTS) {
+                return false;
+            }
+            list = &daq->lists[daq->list_count];
+            list->event = var->event;
+            list->daq = fmt->first_daq + daq->list_count;
+            daq->list_count++;
+        }
+        
+        // Variables are not split across ODTs
+        xcp_odt_t *odt = list->odt_count ? &list->odts[list->odt_count - 1] : NULL;
+        uint8_t cap = odt ? fmt->max_dto - hdr - (list->odt_count == 1 ? fmt->ts_size : 0) : 0;
+        if (odt == NULL || odt->len + var->size > cap) {
+            if (list->odt_count == XCP_DAQ_MAX_ODTS) {
+                return false;
+            }
+            uint8_t offset = odt ? odt->offset + odt->len : 0;
+            cap = fmt->max_dto - hdr - (list->odt_count == 0 ? fmt->ts_size : 0);
+            if (var->size > cap) {
+                return false;
+            }
+            odt = &list->odts[list->odt_count++];
+            odt->first_var = list->var_count;
+            odt->offset = offset;
+        }
+        odt->var_count++;
+        odt->len += var->size;
+        list->vars[list->var_count++] = v;
+    }
+    return true;
+}
+
+void xcp_daq_set_first_pid(xcp_daq_t *daq, uint8_t list, uint8_t first_pid)
+{
+    if (list < daq->list_count) {
+        daq->lists[list].first_pid = first_pid;
+    }
+}
+
+xcp_daq_result_t xcp_daq_feed(xcp_daq_t *daq, const uint8_t *data, uint8_t len, int64_t time_us, uint8_t *list)
+{
+    const xcp_daq_format_t *fmt = &daq->fmt;
+    uint8_t hdr = id_field_len(fmt->id_field);
+    if (len < hdr || data[0] >= XCP_PID_SERV) {
+        return XCP_DAQ_IGNORED;
+    }
+    
+    // Find the list and the ODT number within it
+    xcp_daq_list_t *l = NULL;
+    uint8_t odt_num = 0;
+    if (fmt->id_field == XCP_ID_ABSOLUTE) {
+        for (uint8_t i = 0; i < daq->list_count; i++) {
+            xcp_daq_list_t *c = &daq->lists[i];
+            if (data[0] >= c->first_pid && data[0] < c->first_pid + c->odt_count) {
+                l = c;
+                odt_num = data[0] - c->first_pid;
+                break;
+            }
+        }
+    } else {
+        uint16_t daq_num;
+        if (fmt->id_field == XCP_ID_REL_BYTE) {
+            daq_num = data[1];
+        } else {
+            daq_num = (uint16_t)get_uint(&data[hdr - 2], 2, fmt->big_endian);
+        }
+        for (uint8_t i = 0; i < daq->list_count; i++) {
+            if (daq->lists[i].daq == daq_num && data[0] < daq->lists[i].odt_count) {
+                l = &daq->lists[i];
+                odt_num = data[0];
+                break;
+            }
+        }
+    }
+    if (l == NULL) {
+        return XCP_DAQ_IGNORED;
+    }
+    *list = (uint8_t)(l - daq->lists);
+    
+    const xcp_odt_t *odt = &l->odts[odt_num];
+    uint8_t pos = hdr;
+    if (odt_num == 0) {
+        if (l->next_odt != 0) {
+            // Previous sample never completed
+            l->lost++;
+        }
+        if (len < pos + fmt->ts_size) {
+            l->next_odt = 0;
+            l->lost++;
+            return XCP_DAQ_DROPPED;
+        }
+        l->ts = fmt->ts_size ? get_uint(&data[pos], fmt->ts_size, fmt->big_endian) : 0;
+        l->time_us = time_us;
+        pos += fmt->ts_size;
+    } else if (odt_num != l->next_odt) {
+        if (l->next_odt != 0) {
+            l->lost++;
+        }
+        l->next_odt = 0;
+        return XCP_DAQ_DROPPED;
+    }
+    if (len < pos + odt->len) {
+        l->next_odt = 0;
+        l->lost++;
+        return XCP_DAQ_DROPPED;
+    }
+    
+    memcpy(&l->sample[odt->offset], &data[pos], odt->len);
+    if (odt_num + 1 == l->odt_count) {
+        l->next_odt = 0;
+        l->samples++;
+        return XCP_DAQ_SAMPLE;
+    }
+    l->next_odt = odt_num + 1;
+    return XCP_DAQ_PARTIAL;
+}
+
+int xcp_daq_format_sample(const xcp_daq_t *daq, uint8_t list, char *out, size_t size)
+{
+    if (size == 0) {
+        return 0;
+    }
+    out[0] = '\0';
+    if (list >= daq->list_count) {
+        return 0;
+    }
+    
+    const xcp_daq_list_t *l = &daq->lists[list];
+    size_t pos = 0;
+    uint8_t offset = 0;
+    for (uint8_t i = 0; i < l->var_count && pos < size; i++) {
+        const xcp_var_t *var = &daq->vars[l->vars[i]];
+        uint32_t raw = get_uint(&l->sample[offset], var->size, daq->fmt.big_endian);
+        offset += var->size;
+        int n;
+        if (var->type == XCP_VAR_FLOAT) {
+            float f;
+            memcpy(&f, &raw, sizeof(f));
+            n = snprintf(&out[pos], size - pos, " %g", (double)f);
+        } else if (var->type == XCP_VAR_SIGNED) {
+            // Sign-extend from the variable size
+            uint32_t sign = 1U << (8 * var->size - 1);
+            int32_t v = (int32_t)((raw ^ sign) - sign);
+            n = snprintf(&out[pos], size - pos, " %ld", (long)v);
+        } else {
+            n = snprintf(&out[pos], size - pos, " %lu", (unsigned long)raw);
+        }
+        if (n < 0) {
+            break;
+        }
+        pos += (size_t)n;
+    }
+    return (int)(pos < size ? pos : size - 1);
+}
@@ -0,0 +1,180 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief XCP DAQ list layout and ODT reassembly
+ *
+ * Pure C (no ESP-IDF dependencies) so it can be built and tested on the host.
+ * Variables are grouped into one DAQ list per event channel, in the order
+ * they were added, and packed into ODTs that fit one DTO (CAN frame). The
+ * first ODT of a list carries the slave timestamp when enabled. Received
+ * DTOs are reassembled into complete samples of all variables of a list.
+ */
+
+/** @brief Maximum variables */
+#define XCP_DAQ_MAX_VARS            64
+
+/** @brief Maximum DAQ lists (event channels) */
+#define XCP_DAQ_MAX_LISTS           8
+
+/** @brief Maximum ODTs per DAQ list */
+#define XCP_DAQ_MAX_ODTS            32
+
+/** @brief Largest sample of one list in bytes */
+#define XCP_DAQ_MAX_SAMPLE          (XCP_DAQ_MAX_ODTS * 7)
+
+/** @brief First PID of the command response/event packets (RES, ERR, EV, SERV) */
+#define XCP_PID_SERV                0xFC
+
+/**
+ * @brief Variable type
+ */
+typedef enum {
+    XCP_VAR_UNSIGNED = 0,
+    XCP_VAR_SIGNED,
+    XCP_VAR_FLOAT,              /**< IEEE 754 single (size 4) */
+} xcp_var_type_t;
+
+/**
+ * @brief Identification field type (GET_DAQ_PROCESSOR_INFO key byte, bits 6-7)
+ */
+typedef enum {
+    XCP_ID_ABSOLUTE = 0,        /**< PID = absolute ODT number */
+    XCP_ID_REL_BYTE,            /**< Relative ODT, absolute DAQ byte */
+    XCP_ID_REL_WORD,            /**< Relative ODT, absolute DAQ word */
+    XCP_ID_REL_WORD_ALIGNED,    /**< Relative ODT, fill byte, absolute DAQ word */
+} xcp_id_field_t;
+
+/**
+ * @brief Measured variable
+ */
+typedef struct {
+    uint32_t addr;              /**< Slave address */
+    uint8_t addr_ext;           /**< Address extension */
+    uint8_t size;               /**< 1, 2 or 4 bytes */
+    xcp_var_type_t type;        /**< Value type */
+    uint16_t event;             /**< Event channel */
+} xcp_var_t;
+
+/**
+ * @brief Slave DTO format, from CONNECT and the DAQ info commands
+ */
+typedef struct {
+    xcp_id_field_t id_field;    /**< Identification field type */
+    uint8_t ts_size;            /**< Timestamp bytes (0, 1, 2, 4) */
+    bool big_endian;            /**< Motorola byte order */
+    uint8_t max_dto;            /**< DTO size (8 on classic CAN) */
+    uint16_t first_daq;         /**< Number of the first dynamic DAQ list (MIN_DAQ) */
+} xcp_daq_format_t;
+
+/**
+ * @brief ODT of a DAQ list
+ */
+typedef struct {
+    uint8_t first_var;          /**< First variable (index into the list's vars) */
+    uint8_t var_count;          /**< Variables (ODT entries) */
+    uint8_t offset;             /**< Offset of the ODT data in the sample */
+    uint8_t len;                /**< ODT data bytes */
+} xcp_odt_t;
+
+/**
+ * @brief DAQ list and its reassembly state
+ */
+typedef struct {
+    uint16_t event;             /**< Event channel */
+    uint16_t daq;               /**< DAQ list number on the slave */
+    uint8_t first_pid;          /**< First PID (absolute identification) */
+    uint8_t var_count;          /**< Variables */
+    uint8_t vars[XCP_DAQ_MAX_VARS];     /**< Variable indices in sample order */
+    uint8_t odt_count;          /**< ODTs */
+    xcp_odt_t odts[XCP_DAQ_MAX_ODTS];
+    uint8_t next_odt;           /**< ODT expected next (0: waiting for a new sample) */
+    int64_t time_us;            /**< Reception time of the first ODT of the sample */
+    uint32_t ts;                /**< Slave timestamp of the sample (raw) */
+    uint8_t sample[XCP_DAQ_MAX_SAMPLE];
+    uint32_t samples;           /**< Complete samples */
+    uint32_t lost;              /**< Samples dropped (ODT missing or out of order) */
+} xcp_daq_list_t;
+
+/**
+ * @brief DAQ configuration
+ */
+typedef struct {
+    uint8_t var_count;
+    xcp_var_t vars[XCP_DAQ_MAX_VARS];
+    xcp_daq_format_t fmt;
+    uint8_t list_count;
+    xcp_daq_list_t lists[XCP_DAQ_MAX_LISTS];
+} xcp_daq_t;
+
+/**
+ * @brief Result of feeding a DTO
+ */
+typedef enum {
+    XCP_DAQ_IGNORED = 0,        /**< Not a DAQ packet of a configured list */
+    XCP_DAQ_PARTIAL,            /**< ODT stored, more expected */
+    XCP_DAQ_SAMPLE,             /**< Sample complete */
+    XCP_DAQ_DROPPED,            /**< ODT out of sequence, sample dropped */
+} xcp_daq_result_t;
+
+/**
+ * @brief Clear the variables and lists
+ */
+void xcp_daq_init(xcp_daq_t *daq);
+
+/**
+ * @brief Add a variable
+ *
+ * @return false if the table is full or the size/type is invalid
+ */
+bool xcp_daq_add_var(xcp_daq_t *daq, const xcp_var_t *var);
+
+/**
+ * @brief Build the DAQ lists and ODTs for a slave DTO format
+ *
+ * @return false if the variables need more lists or ODTs than supported
+ */
+bool xcp_daq_layout(xcp_daq_t *daq, const xcp_daq_format_t *fmt);
+
+/**
+ * @brief Set the first PID of a list (START_STOP_DAQ_LIST response)
+ */
+void xcp_daq_set_first_pid(xcp_daq_t *daq, uint8_t list, uint8_t first_pid);
+
+/**
+ * @brief Feed a DTO
+ *
+ * @param daq DAQ configuration
+ * @param data DTO payload
+ * @param len Payload length
+ * @param time_us Reception time
+ * @param list Output: list of the packet (PARTIAL, SAMPLE, DROPPED)
+ * @return Result
+ */
+xcp_daq_result_t xcp_daq_feed(xcp_daq_t *daq, const uint8_t *data, uint8_t len, int64_t time_us, uint8_t *list);
+
+/**
+ * @brief Format the values of the last complete sample of a list
+ *
+ * Each value is preceded by a space: decimal for integers, %g for floats.
+ *
+ * @return Characters written (excluding the terminator)
+ */
+int xcp_daq_format_sample(const xcp_daq_t *daq, uint8_t list, char *out, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
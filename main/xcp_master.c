@@ -0,0 +1,739 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "argtable3/argtable3.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "xcp_master.h"
+#include "can_tx.h"
+#include "rx_bus.h"
+#include "clock_sync.h"
+#include "host_link.h"
+#include "slcan_protocol.h"
+
+static const char *TAG = "xcp";
+
+// XCP commands
+#define XCP_CMD_CONNECT                 0xFF
+#define XCP_CMD_DISCONNECT              0xFE
+#define XCP_CMD_SET_DAQ_PTR             0xE2
+#define XCP_CMD_WRITE_DAQ               0xE1
+#define XCP_CMD_SET_DAQ_LIST_MODE       0xE0
+#define XCP_CMD_START_STOP_DAQ_LIST     0xDE
+#define XCP_CMD_START_STOP_SYNCH        0xDD
+#define XCP_CMD_GET_DAQ_PROCESSOR_INFO  0xDA
+#define XCP_CMD_GET_DAQ_RESOLUTION_INFO 0xD9
+#define XCP_CMD_FREE_DAQ                0xD6
+#define XCP_CMD_ALLOC_DAQ               0xD5
+#define XCP_CMD_ALLOC_ODT               0xD4
+#define XCP_CMD_ALLOC_ODT_ENTRY         0xD3
+
+// Packet IDs from the slave
+#define XCP_PID_RES                     0xFF
+#define XCP_PID_ERR                     0xFE
+#define XCP_PID_EV                      0xFD
+
+#define XCP_ERR_CMD_BUSY                0x10
+
+// CONNECT response: RESOURCE and COMM_MODE_BASIC bits
+#define XCP_RESOURCE_DAQ                0x04
+#define XCP_COMM_BYTE_ORDER             0x01
+
+// GET_DAQ_PROCESSOR_INFO: DAQ_PROPERTIES bits
+#define XCP_DAQ_PROP_DYNAMIC            0x01
+#define XCP_DAQ_PROP_TIMESTAMP          0x10
+
+// SET_DAQ_LIST_MODE: mode bits
+#define XCP_DAQ_MODE_TIMESTAMP          0x10
+
+// Retries of a command the slave reports busy
+#define XCP_BUSY_RETRIES                3
+
+// XCP subscriber ring: a burst of ODTs at the fastest event
+#define XCP_RING_DEPTH                  128
+
+// One sample record: header plus up to 14 characters per value
+#define XCP_LINE_LEN                    (48 + XCP_DAQ_MAX_VARS * 14)
+
+// Master state
+static struct {
+    volatile bool running;
+    xcp_master_state_t state;
+    xcp_master_config_t cfg;
+    rx_bus_sub_handle_t sub;
+    SemaphoreHandle_t done_sem;
+    xcp_daq_t daq;
+    bool big_endian;
+    uint8_t ts_unit;
+    uint16_t ts_ticks;
+    uint32_t ts_last[XCP_DAQ_MAX_LISTS];
+    uint64_t ts_ext[XCP_DAQ_MAX_LISTS];
+    const char *error_cmd;
+    int error_code;
+    uint32_t dtos;
+    uint32_t records;
+    uint32_t records_dropped;
+} s_xcp;
+
+static portMUX_TYPE s_xcp_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/** @brief Command line arguments for xcp command */
+static struct {
+    struct arg_str *action;
+    struct arg_str *addr;
+    struct arg_int *size;
+    struct arg_str *type;
+    struct arg_int *event;
+    struct arg_int *addr_ext;
+    struct arg_int *cro;
+    struct arg_int *dto;
+    struct arg_lit *ext;
+    struct arg_int *timeout;
+    struct arg_end *end;
+} xcp_args;
+
+static const char s_type_chars[] = "usf";
+
+/**
+ * @brief Store a 16-bit parameter in the slave byte order
+ */
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[s_xcp.big_endian ? 1 : 0] = (uint8_t)v;
+    p[s_xcp.big_endian ? 0 : 1] = (uint8_t)(v >> 8);
+}
+
+/**
+ * @brief Store a 32-bit parameter in the slave byte order
+ */
+static void put32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) {
+        p[s_xcp.big_endian ? 3 - i : i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+/**
+ * @brief Read a 16-bit parameter in the slave byte order
+ */
+static uint16_t get16(const uint8_t *p)
+{
+    return s_xcp.big_endian ? (uint16_t)((p[0] << 8) | p[1]) : (uint16_t)((p[1] << 8) | p[0]);
+}
+
+/**
+ * @brief Whether a frame comes from the slave
+ */
+static bool is_dto(const twai_frame_t *frame)
+{
+    return frame->header.id == s_xcp.cfg.dto_id && frame->header.ide == s_xcp.cfg.ext && !frame->header.rtr &&
+           frame->header.dlc > 0;
+}
+
+/**
+ * @brief Record a failed command for the status
+ */
+static esp_err_t command_failed(const char *name, int code, esp_err_t ret)
+{
+    s_xcp.error_cmd = name;
+    s_xcp.error_code = code;
+    if (code < 0) {
+        ESP_LOGW(TAG, "%s: no response", name);
+    } else {
+        ESP_LOGW(TAG, "%s: error 0x%02X", name, code);
+    }
+    return ret;
+}
+
+/**
+ * @brief Send a command (CRO) and wait for its response
+ *
+ * @param name Command name for the status
+ * @param cmd Command packet
+ * @param len Command length
+ * @param res Output: response packet (8 bytes)
+ * @return ESP_OK on a positive response, ESP_FAIL on an error packet, ESP_ERR_TIMEOUT
+ */
+static esp_err_t xcp_command(const char *name, const uint8_t *cmd, uint8_t len, uint8_t res[8])
+{
+    for (int attempt = 0; attempt <= XCP_BUSY_RETRIES; attempt++) {
+        // Setup is abandoned on stop; the stop sequence itself runs while still RUNNING
+        if (!s_xcp.running && s_xcp.state != XCP_MASTER_RUNNING) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        
+        // Padded to 8 bytes for slaves that require the maximum DLC
+        uint8_t data[8] = {0};
+        memcpy(data, cmd, len);
+        twai_frame_t frame = {
+            .header = {
+                .id = s_xcp.cfg.cro_id,
+                .ide = s_xcp.cfg.ext,
+                .dlc = 8,
+            },
+            .buffer = data,
+            .buffer_len = sizeof(data),
+        };
+        if (can_tx_send(&frame) != ESP_OK) {
+            return command_failed(name, -1, ESP_ERR_TIMEOUT);
+        }
+        
+        int64_t deadline_us = esp_timer_get_time() + (int64_t)s_xcp.cfg.timeout_ms * 1000;
+        int pid = -1;
+        int64_t now;
+        while (pid < 0 && (now = esp_timer_get_time()) < deadline_us) {
+            const rx_bus_frame_t *rx_frame = rx_bus_receive(s_xcp.sub, pdMS_TO_TICKS((deadline_us - now) / 1000) + 1);
+            if (rx_frame == NULL) {
+                continue;
+            }
+            const twai_frame_t *rx = &rx_frame->frame;
+            // Event and DAQ packets in between are not the response
+            if (is_dto(rx) && (rx->buffer[0] == XCP_PID_RES || rx->buffer[0] == XCP_PID_ERR)) {
+                uint8_t n = twaifd_dlc2len(rx->header.dlc);
+                memset(res, 0, 8);
+                memcpy(res, rx->buffer, n > 8 ? 8 : n);
+                pid = rx->buffer[0];
+            }
+            rx_bus_release(rx_frame);
+        }
+        
+        if (pid == XCP_PID_RES) {
+            return ESP_OK;
+        }
+        if (pid < 0) {
+            return command_failed(name, -1, ESP_ERR_TIMEOUT);
+        }
+        if (res[1] != XCP_ERR_CMD_BUSY) {
+            return command_failed(name, res[1], ESP_FAIL);
+        }
+    }
+    return command_failed(name, XCP_ERR_CMD_BUSY, ESP_FAIL);
+}
+
+/**
+ * @brief Connect and configure the DAQ lists, then start the measurement
+ */
+static esp_err_t xcp_setup(void)
+{
+    xcp_daq_t *daq = &s_xcp.daq;
+    xcp_daq_format_t fmt = {0};
+    uint8_t cmd[8];
+    uint8_t res[8];
+    esp_err_t ret;
+    
+    s_xcp.big_endian = false;
+    cmd[0] = XCP_CMD_CONNECT;
+    cmd[1] = 0;
+    if ((ret = xcp_command("CONNECT", cmd, 2, res)) != ESP_OK) {
+        return ret;
+    }
+    if (!(res[1] & XCP_RESOURCE_DAQ)) {
+        return command_failed("CONNECT", 0x20, ESP_ERR_NOT_SUPPORTED);
+    }
+    s_xcp.big_endian = (res[2] & XCP_COMM_BYTE_ORDER) != 0;
+    fmt.big_endian = s_xcp.big_endian;
+    fmt.max_dto = get16(&res[4]) > 8 ? 8 : (uint8_t)get16(&res[4]);
+    
+    cmd[0] = XCP_CMD_GET_DAQ_PROCESSOR_INFO;
+    if ((ret = xcp_command("GET_DAQ_PROCESSOR_INFO", cmd, 1, res)) != ESP_OK) {
+        return ret;
+    }
+    if (!(res[1] & XCP_DAQ_PROP_DYNAMIC)) {
+        ESP_LOGW(TAG, "Slave has static DAQ lists only");
+        return command_failed("GET_DAQ_PROCESSOR_INFO", 0x20, ESP_ERR_NOT_SUPPORTED);
+    }
+    bool timestamps = (res[1] & XCP_DAQ_PROP_TIMESTAMP) != 0;
+    fmt.first_daq = res[6];
+    fmt.id_field = (xcp_id_field_t)(res[7] >> 6);
+    
+    if (timestamps) {
+        cmd[0] = XCP_CMD_GET_DAQ_RESOLUTION_INFO;
+        if ((ret = xcp_command("GET_DAQ_RESOLUTION_INFO", cmd, 1, res)) != ESP_OK) {
+            return ret;
+        }
+        uint8_t ts_size = res[5] & 0x07;
+        fmt.ts_size = (ts_size == 1 || ts_size == 2 || ts_size == 4) ? ts_size : 0;
+        s_xcp.ts_unit = res[5] >> 4;
+        s_xcp.ts_ticks = get16(&res[6]);
+    }
+    
+    if (!xcp_daq_layout(daq, &fmt)) {
+        return command_failed("layout", 0x30, ESP_ERR_INVALID_SIZE);
+    }
+    memset(s_xcp.ts_last, 0, sizeof(s_xcp.ts_last));
+    memset(s_xcp.ts_ext, 0, sizeof(s_xcp.ts_ext));
+    
+    // Allocation order required by the standard: lists, then ODTs, then entries
+    cmd[0] = XCP_CMD_FREE_DAQ;
+    if ((ret = xcp_command("FREE_DAQ", cmd, 1, res)) != ESP_OK) {
+        return ret;
+    }
+    cmd[0] = XCP_CMD_ALLOC_DAQ;
+    cmd[1] = 0;
+    put16(&cmd[2], daq->list_count);
+    if ((ret = xcp_command("ALLOC_DAQ", cmd, 4, res)) != ESP_OK) {
+        return ret;
+    }
+    for (uint8_t l = 0; l < daq->list_count; l++) {
+        cmd[0] = XCP_CMD_ALLOC_ODT;
+        put16(&cmd[2], daq->lists[l].daq);
+        cmd[4] = daq->lists[l].odt_count;
+        if ((ret = xcp_command("ALLOC_ODT", cmd, 5, res)) != ESP_OK) {
+            return ret;
+        }
+    }
+    for (uint8_t l = 0; l < daq->list_count; l++) {
+        for (uint8_t o = 0; o < daq->lists[l].odt_count; o++) {
+            cmd[0] = XCP_CMD_ALLOC_ODT_ENTRY;
+            put16(&cmd[2], daq->lists[l].daq);
+            cmd[4] = o;
+            cmd[5] = daq->lists[l].odts[o].var_count;
+            if ((ret = xcp_command("ALLOC_ODT_ENTRY", cmd, 6, res)) != ESP_OK) {
+                return ret;
+            }
+        }
+    }
+    
+    // Entries: the DAQ pointer advances by itself after each WRITE_DAQ
+    for (uint8_t l = 0; l < daq->list_count; l++) {
+        const xcp_daq_list_t *list = &daq->lists[l];
+        for (uint8_t o = 0; o < list->odt_count; o++) {
+            const xcp_odt_t *odt = &list->odts[o];
+            cmd[0] = XCP_CMD_SET_DAQ_PTR;
+            cmd[1] = 0;
+            put16(&cmd[2], list->daq);
+            cmd[4] = o;
+            cmd[5] = 0;
+            if ((ret = xcp_command("SET_DAQ_PTR", cmd, 6, res)) != ESP_OK) {
+                return ret;
+            }
+            for (uint8_t e = 0; e < odt->var_count; e++) {
+                const xcp_var_t *var = &daq->vars[list->vars[odt->first_var + e]];
+                cmd[0] = XCP_CMD_WRITE_DAQ;
+                cmd[1] = 0xFF;
+                cmd[2] = var->size;
+                cmd[3] = var->addr_ext;
+                put32(&cmd[4], var->addr);
+                if ((ret = xcp_command("WRITE_DAQ", cmd, 8, res)) != ESP_OK) {
+                    return ret;
+                }
+            }
+        }
+    }
+    
+    for (uint8_t l = 0; l < daq->list_count; l++) {
+        cmd[0] = XCP_CMD_SET_DAQ_LIST_MODE;
+        cmd[1] = fmt.ts_size ? XCP_DAQ_MODE_TIMESTAMP : 0;
+        put16(&cmd[2], daq->lists[l].daq);
+        put16(&cmd[4], daq->lists[l].event);
+        cmd[6] = 1;
+        cmd[7] = 0;
+        if ((ret = xcp_command("SET_DAQ_LIST_MODE", cmd, 8, res)) != ESP_OK) {
+            return ret;
+        }
+    }
+    for (uint8_t l = 0; l < daq->list_count; l++) {
+        cmd[0] = XCP_CMD_START_STOP_DAQ_LIST;
+        cmd[1] = 2;
+        put16(&cmd[2], daq->lists[l].daq);
+        if ((ret = xcp_command("START_STOP_DAQ_LIST", cmd, 4, res)) != ESP_OK) {
+            return ret;
+        }
+        xcp_daq_set_first_pid(daq, l, res[1]);
+    }
+    
+    // Start all selected lists at once
+    cmd[0] = XCP_CMD_START_STOP_SYNCH;
+    cmd[1] = 1;
+    return xcp_command("START_STOP_SYNCH", cmd, 2, res);
+}
+
+/**
+ * @brief Slave timestamp ticks in microseconds
+ */
+static uint64_t ticks_to_us(uint64_t ticks)
+{
+    uint64_t t = ticks * s_xcp.ts_ticks;
+    // Units 0-9: 1 ns to 1 s in decades; 0xA-0xC: 1 ps to 100 ps
+    if (s_xcp.ts_unit <= 9) {
+        for (uint8_t i = 0; i < s_xcp.ts_unit; i++) {
+            t *= 10;
+        }
+        return t / 1000;
+    }
+    for (uint8_t i = 10; i < s_xcp.ts_unit; i++) {
+        t *= 10;
+    }
+    return t / 1000000;
+}
+
+/**
+ * @brief Send the column description of each list to the host
+ */
+static void send_list_records(void)
+{
+    const xcp_daq_t *daq = &s_xcp.daq;
+    char line[XCP_LINE_LEN];
+    
+    for (uint8_t l = 0; l < daq->list_count; l++) {
+        const xcp_daq_list_t *list = &daq->lists[l];
+        int pos = snprintf(line, sizeof(line), "Ql %u %u", l, list->event);
+        for (uint8_t i = 0; i < list->var_count; i++) {
+            const xcp_var_t *var = &daq->vars[list->vars[i]];
+            pos += snprintf(&line[pos], sizeof(line) - pos, " %u:%08lX:%c%u", var->addr_ext,
+                            (unsigned long)var->addr, s_type_chars[var->type], var->size);
+        }
+        line[pos++] = '\r';
+        host_link_write(line, pos);
+    }
+}
+
+/**
+ * @brief Send the record of a complete sample
+ */
+static void send_sample(uint8_t l)
+{
+    const xcp_daq_list_t *list = &s_xcp.daq.lists[l];
+    if (!slcan_is_open() || !host_link_present()) {
+        s_xcp.records_dropped++;
+        return;
+    }
+    
+    char line[XCP_LINE_LEN];
+    int pos = snprintf(line, sizeof(line), "Qd %lld %u ", (long long)clock_sync_to_host(list->time_us), l);
+    uint8_t ts_size = s_xcp.daq.fmt.ts_size;
+    if (ts_size) {
+        // Unwrap the 1, 2 or 4 byte slave counter
+        uint32_t mask = ts_size == 4 ? 0xFFFFFFFF : (1U << (8 * ts_size)) - 1;
+        if (list->samples > 1) {
+            s_xcp.ts_ext[l] += (list->ts - s_xcp.ts_last[l]) & mask;
+        } else {
+            s_xcp.ts_ext[l] = list->ts;
+        }
+        s_xcp.ts_last[l] = list->ts;
+        pos += snprintf(&line[pos], sizeof(line) - pos, "%llu", (unsigned long long)ticks_to_us(s_xcp.ts_ext[l]));
+    } else {
+        line[pos++] = '-';
+    }
+    pos += xcp_daq_format_sample(&s_xcp.daq, l, &line[pos], sizeof(line) - pos - 1);
+    line[pos++] = '\r';
+    host_link_write(line, pos);
+    s_xcp.records++;
+}
+
+/**
+ * @brief Handle a packet from the slave while measuring
+ */
+static void handle_dto(const rx_bus_frame_t *rx_frame)
+{
+    const twai_frame_t *frame = &rx_frame->frame;
+    uint8_t len = twaifd_dlc2len(frame->header.dlc);
+    if (len > 8) {
+        len = 8;
+    }
+    
+    if (frame->buffer[0] == XCP_PID_EV) {
+        ESP_LOGI(TAG, "Event 0x%02X", len > 1 ? frame->buffer[1] : 0);
+        return;
+    }
+    uint8_t l;
+    xcp_daq_result_t r = xcp_daq_feed(&s_xcp.daq, frame->buffer, len, rx_frame->timestamp_us, &l);
+    if (r != XCP_DAQ_IGNORED) {
+        s_xcp.dtos++;
+    }
+    if (r == XCP_DAQ_SAMPLE) {
+        send_sample(l);
+    }
+}
+
+/**
+ * @brief Master task: RX bus "xcp" subscriber
+ */
+static void xcp_task(void *arg)
+{
+    if (xcp_setup() == ESP_OK) {
+        s_xcp.state = XCP_MASTER_RUNNING;
+        ESP_LOGI(TAG, "DAQ running: %u list(s)", s_xcp.daq.list_count);
+        send_list_records();
+        
+        while (s_xcp.running) {
+            const rx_bus_frame_t *rx_frame = rx_bus_receive(s_xcp.sub, pdMS_TO_TICKS(100));
+            if (rx_frame == NULL) {
+                continue;
+            }
+            if (is_dto(&rx_frame->frame)) {
+                handle_dto(rx_frame);
+            }
+            rx_bus_release(rx_frame);
+        }
+        
+        // Stop all lists and leave the slave disconnected; best effort
+        uint8_t res[8];
+        uint8_t cmd[2] = {XCP_CMD_START_STOP_SYNCH, 0};
+        xcp_command("START_STOP_SYNCH", cmd, 2, res);
+        cmd[0] = XCP_CMD_DISCONNECT;
+        xcp_command("DISCONNECT", cmd, 1, res);
+        s_xcp.state = XCP_MASTER_IDLE;
+    } else {
+        s_xcp.state = s_xcp.running ? XCP_MASTER_ERROR : XCP_MASTER_IDLE;
+    }
+    
+    rx_bus_unsubscribe(s_xcp.sub);
+    s_xcp.sub = NULL;
+    
+    s_xcp.running = false;
+    xSemaphoreGive(s_xcp.done_sem);
+    vTaskDelete(NULL);
+}
+
+void xcp_master_default_config(xcp_master_config_t *config)
+{
+    *config = (xcp_master_config_t) {
+        .cro_id = 0x7F0,
+        .dto_id = 0x7F1,
+        .ext = false,
+        .timeout_ms = 100,
+    };
+}
+
+esp_err_t xcp_master_add_var(const xcp_var_t *var)
+{
+    if (s_xcp.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (var->type > XCP_VAR_FLOAT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_xcp.daq.var_count == XCP_DAQ_MAX_VARS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return xcp_daq_add_var(&s_xcp.daq, var) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t xcp_master_clear_vars(void)
+{
+    if (s_xcp.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xcp_daq_init(&s_xcp.daq);
+    return ESP_OK;
+}
+
+esp_err_t xcp_master_start(const xcp_master_config_t *config)
+{
+    if (s_xcp.running || s_xcp.daq.var_count == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    uint32_t id_mask = config->ext ? TWAI_EXT_ID_MASK : TWAI_STD_ID_MASK;
+    // The stop sequence (two commands) must fit in the stop timeout
+    if (config->cro_id > id_mask || config->dto_id > id_mask || config->cro_id == config->dto_id ||
+        config->timeout_ms == 0 || config->timeout_ms > 500) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_xcp.done_sem == NULL) {
+        s_xcp.done_sem = xSemaphoreCreateBinary();
+        if (s_xcp.done_sem == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    // A session that failed on its own left the semaphore given
+    xSemaphoreTake(s_xcp.done_sem, 0);
+    
+    esp_err_t ret = rx_bus_subscribe("xcp", XCP_RING_DEPTH, &s_xcp.sub);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    portENTER_CRITICAL(&s_xcp_mux);
+    s_xcp.cfg = *config;
+    s_xcp.state = XCP_MASTER_SETUP;
+    s_xcp.error_cmd = NULL;
+    s_xcp.error_code = 0;
+    s_xcp.dtos = 0;
+    s_xcp.records = 0;
+    s_xcp.records_dropped = 0;
+    s_xcp.running = true;
+    portEXIT_CRITICAL(&s_xcp_mux);
+    
+    // Above the transport task: DAQ bursts are decoded before the ring fills
+    if (xTaskCreate(xcp_task, "xcp", 4096 + XCP_LINE_LEN, NULL, 11, NULL) != pdPASS) {
+        s_xcp.running = false;
+        s_xcp.state = XCP_MASTER_IDLE;
+        rx_bus_unsubscribe(s_xcp.sub);
+        s_xcp.sub = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t xcp_master_stop(void)
+{
+    if (!s_xcp.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    s_xcp.running = false;
+    if (xSemaphoreTake(s_xcp.done_sem, pdMS_TO_TICKS(2000)) != pdTRUE) {
+        ESP_LOGE(TAG, "XCP task did not stop");
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+bool xcp_master_owns_frame(const twai_frame_t *frame)
+{
+    return s_xcp.state != XCP_MASTER_IDLE && s_xcp.state != XCP_MASTER_ERROR && is_dto(frame);
+}
+
+void xcp_master_get_status(xcp_master_status_t *out)
+{
+    portENTER_CRITICAL(&s_xcp_mux);
+    out->state = s_xcp.state;
+    out->error_cmd = s_xcp.error_cmd;
+    out->error_code = s_xcp.error_code;
+    out->vars = s_xcp.daq.var_count;
+    out->lists = s_xcp.daq.list_count;
+    out->odts = 0;
+    out->samples = 0;
+    out->lost = 0;
+    for (uint8_t l = 0; l < s_xcp.daq.list_count; l++) {
+        out->odts += s_xcp.daq.lists[l].odt_count;
+        out->samples += s_xcp.daq.lists[l].samples;
+        out->lost += s_xcp.daq.lists[l].lost;
+    }
+    out->ts_size = s_xcp.daq.fmt.ts_size;
+    out->dtos = s_xcp.dtos;
+    out->records = s_xcp.records;
+    out->records_dropped = s_xcp.records_dropped;
+    portEXIT_CRITICAL(&s_xcp_mux);
+}
+
+/**
+ * @brief "xcp" command handler
+ */
+static int xcp_cmd_handler(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&xcp_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, xcp_args.end, argv[0]);
+        return 1;
+    }
+    
+    const char *action = xcp_args.action->count ? xcp_args.action->sval[0] : "show";
+    
+    if (strcmp(action, "var") == 0) {
+        if (xcp_args.addr->count == 0) {
+            printf("xcp var: need an address\n");
+            return 1;
+        }
+        xcp_var_t var = {
+            .addr = strtoul(xcp_args.addr->sval[0], NULL, 0),
+            .addr_ext = xcp_args.addr_ext->count ? xcp_args.addr_ext->ival[0] : 0,
+            .size = xcp_args.size->count ? xcp_args.size->ival[0] : 4,
+            .type = XCP_VAR_UNSIGNED,
+            .event = xcp_args.event->count ? xcp_args.event->ival[0] : 0,
+        };
+        if (xcp_args.type->count) {
+            const char *t = strchr(s_type_chars, xcp_args.type->sval[0][0]);
+            if (t == NULL || *t == '\0' || xcp_args.type->sval[0][1] != '\0') {
+                printf("xcp var: unknown type '%s'\n", xcp_args.type->sval[0]);
+                return 1;
+            }
+            var.type = (xcp_var_type_t)(t - s_type_chars);
+        }
+        esp_err_t ret = xcp_master_add_var(&var);
+        if (ret != ESP_OK) {
+            printf("xcp var: %s\n", esp_err_to_name(ret));
+            return 1;
+        }
+    } else if (strcmp(action, "clear") == 0) {
+        if (xcp_master_clear_vars() != ESP_OK) {
+            printf("xcp: stop the measurement first\n");
+            return 1;
+        }
+    } else if (strcmp(action, "start") == 0) {
+        xcp_master_config_t cfg;
+        xcp_master_default_config(&cfg);
+        if (xcp_args.cro->count) {
+            cfg.cro_id = xcp_args.cro->ival[0];
+        }
+        if (xcp_args.dto->count) {
+            cfg.dto_id = xcp_args.dto->ival[0];
+        }
+        cfg.ext = xcp_args.ext->count > 0;
+        if (xcp_args.timeout->count) {
+            cfg.timeout_ms = xcp_args.timeout->ival[0];
+        }
+        esp_err_t ret = xcp_master_start(&cfg);
+        if (ret != ESP_OK) {
+            printf("xcp start: %s\n", esp_err_to_name(ret));
+            return 1;
+        }
+    } else if (strcmp(action, "stop") == 0) {
+        if (xcp_master_stop() != ESP_OK) {
+            printf("xcp: not running\n");
+            return 1;
+        }
+    } else if (strcmp(action, "show") != 0) {
+        printf("xcp: unknown action '%s'\n", action);
+        return 1;
+    }
+    
+    static const char *const state_names[] = {"idle", "setup", "running", "error"};
+    xcp_master_status_t st;
+    xcp_master_get_status(&st);
+    printf("xcp: %s", state_names[st.state]);
+    if (st.state == XCP_MASTER_ERROR && st.error_cmd != NULL) {
+        if (st.error_code < 0) {
+            printf(" (%s: no response)", st.error_cmd);
+        } else {
+            printf(" (%s: 0x%02X)", st.error_cmd, st.error_code);
+        }
+    }
+    printf(", %u var(s), %u list(s), %u ODT(s), timestamp %u byte(s), %lu DTOs, %lu samples, %lu lost, "
+           "%lu records, %lu dropped\n", st.vars, st.lists, st.odts, st.ts_size, (unsigned long)st.dtos,
+           (unsigned long)st.samples, (unsigned long)st.lost, (unsigned long)st.records,
+           (unsigned long)st.records_dropped);
+    for (uint8_t i = 0; i < s_xcp.daq.var_count; i++) {
+        const xcp_var_t *var = &s_xcp.daq.vars[i];
+        printf("  %u:%08lX %c%u event %u\n", var->addr_ext, (unsigned long)var->addr, s_type_chars[var->type],
+               var->size, var->event);
+    }
+    return 0;
+}
+
+void xcp_master_register_commands(void)
+{
+    xcp_args.action = arg_str0(NULL, NULL, "<var|clear|start|stop|show>", "Action (default: show)");
+    xcp_args.addr = arg_str0(NULL, NULL, "<addr>", "var: slave address");
+    xcp_args.size = arg_int0("s", "size", "<1|2|4>", "var: size in bytes (default: 4)");
+    xcp_args.type = arg_str0("t", "type", "<u|s|f>", "var: unsigned, signed, float (default: u)");
+    xcp_args.event = arg_int0("e", "event", "<n>", "var: event channel (default: 0)");
+    xcp_args.addr_ext = arg_int0("a", "addr-ext", "<n>", "var: address extension (default: 0)");
+    xcp_args.cro = arg_int0("c", "cro", "<id>", "start: command ID (default: 0x7F0)");
+    xcp_args.dto = arg_int0("d", "dto", "<id>", "start: response/DAQ ID (default: 0x7F1)");
+    xcp_args.ext = arg_lit0("x", "ext", "start: 29-bit IDs");
+    xcp_args.timeout = arg_int0("T", "timeout", "<ms>", "start: command timeout (default: 100)");
+    xcp_args.end = arg_end(10);
+    
+    const esp_console_cmd_t xcp_cmd = {
+        .command = "xcp",
+        .help = "XCP-on-CAN DAQ master; only decoded samples are sent to the host\n"
+        "  xcp var 0x40001000 -s 2 -t s -e 1   # add a variable to the list of event 1\n"
+        "  xcp start -c 0x7F0 -d 0x7F1         # connect, configure and start DAQ",
+        .hint = NULL,
+        .func = &xcp_cmd_handler,
+        .argtable = &xcp_args
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&xcp_cmd));
+}
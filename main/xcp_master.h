@@ -0,0 +1,123 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_twai.h"
+#include "xcp_daq.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief XCP-on-CAN DAQ master
+ *
+ * The device connects to an XCP slave, configures dynamic DAQ lists (one per
+ * event channel) with the measured variables, starts the measurement and
+ * reassembles the DTO stream. The raw CRO/DTO frames are not forwarded; the
+ * host receives one decoded record per sample instead:
+ *
+ *   Ql <list> <event> <ext>:<addr>:<type><size> ...   once per list after start
+ *   Qd <time_us> <list> <slave_time_us|-> <value> ... per complete sample
+ *
+ * time_us is the reception of the first ODT in host time, slave_time_us the
+ * unwrapped slave timestamp (when the slave provides timestamps).
+ */
+
+/**
+ * @brief Master state
+ */
+typedef enum {
+    XCP_MASTER_IDLE = 0,        /**< Not connected */
+    XCP_MASTER_SETUP,           /**< Connecting and configuring the DAQ lists */
+    XCP_MASTER_RUNNING,         /**< Measurement running */
+    XCP_MASTER_ERROR,           /**< Setup failed (see status) */
+} xcp_master_state_t;
+
+/**
+ * @brief Connection parameters
+ */
+typedef struct {
+    uint32_t cro_id;            /**< Master to slave (command) ID */
+    uint32_t dto_id;            /**< Slave to master (response, DAQ) ID */
+    bool ext;                   /**< 29-bit IDs */
+    uint32_t timeout_ms;        /**< Command response timeout (XCP t1) */
+} xcp_master_config_t;
+
+/**
+ * @brief Master status
+ */
+typedef struct {
+    xcp_master_state_t state;
+    const char *error_cmd;      /**< Command that failed (ERROR) */
+    int error_code;             /**< XCP error code, -1 for a timeout */
+    uint8_t vars;               /**< Variables configured */
+    uint8_t lists;              /**< DAQ lists */
+    uint16_t odts;              /**< ODTs over all lists */
+    uint8_t ts_size;            /**< Slave timestamp bytes (0: none) */
+    uint32_t dtos;              /**< DAQ packets received */
+    uint32_t samples;           /**< Complete samples */
+    uint32_t lost;              /**< Samples lost to missing ODTs */
+    uint32_t records;           /**< Sample records sent to the host */
+    uint32_t records_dropped;   /**< Sample records dropped (channel closed) */
+} xcp_master_status_t;
+
+/**
+ * @brief Fill a configuration with defaults (CRO 0x7F0, DTO 0x7F1, 100 ms)
+ */
+void xcp_master_default_config(xcp_master_config_t *config);
+
+/**
+ * @brief Add a measured variable
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE while running, ESP_ERR_INVALID_ARG, ESP_ERR_NO_MEM
+ */
+esp_err_t xcp_master_add_var(const xcp_var_t *var);
+
+/**
+ * @brief Remove all variables
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE while running
+ */
+esp_err_t xcp_master_clear_vars(void);
+
+/**
+ * @brief Connect, configure the DAQ lists and start the measurement in the background
+ *
+ * @return ESP_OK if the master task started, ESP_ERR_INVALID_STATE if running or without variables,
+ *         ESP_ERR_INVALID_ARG, ESP_ERR_NO_MEM
+ */
+esp_err_t xcp_master_start(const xcp_master_config_t *config);
+
+/**
+ * @brief Stop the measurement and disconnect
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not running, ESP_ERR_TIMEOUT
+ */
+esp_err_t xcp_master_stop(void);
+
+/**
+ * @brief Whether a received frame belongs to the XCP session (not forwarded to the host)
+ */
+bool xcp_master_owns_frame(const twai_frame_t *frame);
+
+/**
+ * @brief Get the master status
+ */
+void xcp_master_get_status(xcp_master_status_t *out);
+
+/**
+ * @brief Register the 'xcp' extension command
+ */
+void xcp_master_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
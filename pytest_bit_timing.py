@@ -0,0 +1,166 @@
+# SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: CC0-1.0
+"""Host tests for main/bit_timing.c (built with the host C compiler, loaded via ctypes)."""
+
+import ctypes
+from collections.abc import Callable
+from pathlib import Path
+
+import pytest
+
+SRC = Path(__file__).parent / 'main' / 'bit_timing.c'
+
+TWAI_CLK_80M = 80_000_000
+TWAI_CLK_40M = 40_000_000
+SJA1000_CLK = 16_000_000
+
+
+class BitTiming(ctypes.Structure):
+    _fields_ = [
+        ('brp', ctypes.c_uint32),
+        ('tseg1', ctypes.c_uint8),
+        ('tseg2', ctypes.c_uint8),
+        ('sjw', ctypes.c_uint8),
+        ('triple_sampling', ctypes.c_bool),
+    ]
+
+
+class Limits(ctypes.Structure):
+    _fields_ = [
+        ('brp_min', ctypes.c_uint32),
+        ('brp_max', ctypes.c_uint32),
+        ('brp_step', ctypes.c_uint32),
+        ('tseg1_min', ctypes.c_uint8),
+        ('tseg1_max', ctypes.c_uint8),
+        ('tseg2_min', ctypes.c_uint8),
+        ('tseg2_max', ctypes.c_uint8),
+        ('sjw_max', ctypes.c_uint8),
+    ]
+
+
+# Same ranges as twai_timing_limits in can_autodetect.c for the original ESP32
+ESP32_LIMITS = Limits(2, 128, 2, 1, 16, 1, 8, 4)
+WIDE_LIMITS = Limits(2, 16384, 2, 1, 16, 1, 8, 4)
+
+# Lawicel CANUSB / SJA1000 @ 16 MHz reference BTR table: (btr0, btr1, bitrate)
+LAWICEL_BTR = [
+    (0x31, 0x1C, 10000),
+    (0x18, 0x1C, 20000),
+    (0x09, 0x1C, 50000),
+    (0x04, 0x1C, 100000),
+    (0x03, 0x1C, 125000),
+    (0x01, 0x1C, 250000),
+    (0x00, 0x1C, 500000),
+    (0x00, 0x16, 800000),
+    (0x00, 0x14, 1000000),
+]
+
+# Legacy ESP-IDF TWAI_TIMING_CONFIG_* for the ESP32 (80 MHz APB, 80% sample point):
+# (bitrate, brp, tseg1, tseg2)
+IDF_ESP32_TABLE = [
+    (1000000, 4, 15, 4),
+    (500000, 8, 15, 4),
+    (250000, 16, 15, 4),
+    (125000, 32, 15, 4),
+    (100000, 40, 15, 4),
+    (50000, 80, 15, 4),
+    (25000, 128, 16, 8),
+]
+
+
+@pytest.fixture(scope='module')
+def lib(build_host_lib: Callable[[Path], ctypes.CDLL]) -> ctypes.CDLL:
+    lib = build_host_lib(SRC)
+    lib.bit_timing_calc.argtypes = [
+        ctypes.c_uint32, ctypes.c_uint32, ctypes.c_uint16, ctypes.c_uint8,
+        ctypes.POINTER(Limits), ctypes.POINTER(BitTiming), ctypes.POINTER(ctypes.c_int32),
+    ]
+    lib.bit_timing_calc.restype = ctypes.c_int
+    lib.bit_timing_bitrate.argtypes = [ctypes.c_uint32, ctypes.POINTER(BitTiming)]
+    lib.bit_timing_bitrate.restype = ctypes.c_uint32
+    lib.bit_timing_sample_point.argtypes = [ctypes.POINTER(BitTiming)]
+    lib.bit_timing_sample_point.restype = ctypes.c_uint16
+    lib.bit_timing_from_btr.argtypes = [ctypes.c_uint8, ctypes.c_uint8, ctypes.POINTER(BitTiming)]
+    lib.bit_timing_from_btr.restype = None
+    return lib
+
+
+def calc(lib: ctypes.CDLL, clk: int, bitrate: int, sp: int = 0, sjw: int = 0,
+         limits: Limits = ESP32_LIMITS) -> tuple[int, BitTiming, int]:
+    timing = BitTiming()
+    err = ctypes.c_int32()
+    ret = lib.bit_timing_calc(clk, bitrate, sp, sjw, ctypes.byref(limits), ctypes.byref(timing), ctypes.byref(err))
+    return ret, timing, err.value
+
+
+@pytest.mark.parametrize('btr0, btr1, bitrate', LAWICEL_BTR)
+def test_btr_decode_lawicel_table(lib: ctypes.CDLL, btr0: int, btr1: int, bitrate: int) -> None:
+    timing = BitTiming()
+    lib.bit_timing_from_btr(btr0, btr1, ctypes.byref(timing))
+    assert lib.bit_timing_bitrate(SJA1000_CLK, ctypes.byref(timing)) == bitrate
+    assert timing.sjw == 1
+    assert not timing.triple_sampling
+
+
+def test_btr_decode_fields(lib: ctypes.CDLL) -> None:
+    timing = BitTiming()
+    lib.bit_timing_from_btr(0xC3, 0xAF, ctypes.byref(timing))
+    assert (timing.brp, timing.sjw, timing.tseg1, timing.tseg2) == (8, 4, 16, 3)
+    assert timing.triple_sampling
+
+
+@pytest.mark.parametrize('bitrate, brp, tseg1, tseg2', IDF_ESP32_TABLE)
+def test_matches_idf_esp32_table(lib: ctypes.CDLL, bitrate: int, brp: int, tseg1: int, tseg2: int) -> None:
+    ret, timing, err = calc(lib, TWAI_CLK_80M, bitrate, sp=800)
+    assert ret == 0
+    assert err == 0
+    assert (timing.brp, timing.tseg1, timing.tseg2) == (brp, tseg1, tseg2)
+
+
+@pytest.mark.parametrize('clk', [TWAI_CLK_80M, TWAI_CLK_40M])
+@pytest.mark.parametrize('bitrate', [10000, 20000, 50000, 100000, 125000, 250000, 500000, 800000, 1000000])
+def test_standard_rates_exact(lib: ctypes.CDLL, clk: int, bitrate: int) -> None:
+    ret, timing, err = calc(lib, clk, bitrate, limits=WIDE_LIMITS)
+    assert ret == 0
+    assert err == 0
+    assert lib.bit_timing_bitrate(clk, ctypes.byref(timing)) == bitrate
+    if (clk, bitrate) != (TWAI_CLK_40M, 800000):
+        assert abs(lib.bit_timing_sample_point(ctypes.byref(timing)) - 875) <= 25
+    assert timing.brp % 2 == 0
+    assert 1 <= timing.sjw <= min(timing.tseg2, 4)
+
+
+def test_800k_on_40mhz_prefers_sample_point_over_resolution(lib: ctypes.CDLL) -> None:
+    # 50 clocks per bit: 25 quanta cannot reach 87.5% within tseg1 <= 16, 5 quanta give 80%
+    ret, timing, err = calc(lib, TWAI_CLK_40M, 800000, limits=WIDE_LIMITS)
+    assert ret == 0 and err == 0
+    assert (timing.brp, timing.tseg1, timing.tseg2) == (10, 3, 1)
+
+
+@pytest.mark.parametrize('bitrate, max_ppm', [(83333, 10), (33333, 20), (95238, 10), (47619, 10), (666666, 1)])
+def test_nonstandard_rates(lib: ctypes.CDLL, bitrate: int, max_ppm: int) -> None:
+    ret, timing, err = calc(lib, TWAI_CLK_80M, bitrate, limits=WIDE_LIMITS)
+    assert ret == 0
+    assert abs(err) <= max_ppm
+    achieved = lib.bit_timing_bitrate(TWAI_CLK_80M, ctypes.byref(timing))
+    assert abs(achieved - bitrate) * 1_000_000 // bitrate <= max_ppm
+
+
+@pytest.mark.parametrize('sp', [700, 750, 800, 875])
+def test_requested_sample_point(lib: ctypes.CDLL, sp: int) -> None:
+    ret, timing, _ = calc(lib, TWAI_CLK_80M, 500000, sp=sp)
+    assert ret == 0
+    assert lib.bit_timing_sample_point(ctypes.byref(timing)) == sp
+
+
+def test_requested_sjw_is_clamped(lib: ctypes.CDLL) -> None:
+    ret, timing, _ = calc(lib, TWAI_CLK_80M, 500000, sjw=1)
+    assert ret == 0 and timing.sjw == 1
+    ret, timing, _ = calc(lib, TWAI_CLK_80M, 500000, sjw=9)
+    assert ret == 0 and timing.sjw == min(timing.tseg2, 4)
+
+
+@pytest.mark.parametrize('bitrate', [0, 3000000, 5000])
+def test_unachievable(lib: ctypes.CDLL, bitrate: int) -> None:
+    ret, _, _ = calc(lib, TWAI_CLK_80M, bitrate)
+    assert ret == -1
@@ -0,0 +1,185 @@
+# SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: CC0-1.0
+"""Host tests for main/byte_class.c (built with the host C compiler, loaded via ctypes)."""
+
+import ctypes
+import random
+from collections.abc import Callable
+from pathlib import Path
+
+import pytest
+
+SRC = Path(__file__).parent / 'main' / 'byte_class.c'
+
+# byte_class_t / byte_class_csum_t
+UNKNOWN, CONSTANT, COUNTER, CHECKSUM, ENUM, CONTINUOUS, RANDOM = range(7)
+CSUM_XOR, CSUM_SUM, CSUM_CRC8_1D, CSUM_CRC8_2F = range(4)
+
+# Generously larger than sizeof(byte_class_state_t)
+STATE_SIZE = 4096
+
+
+class Result(ctypes.Structure):
+    _fields_ = [
+        ('cls', ctypes.c_int),
+        ('value', ctypes.c_uint8),
+        ('mask', ctypes.c_uint8),
+        ('step', ctypes.c_uint8),
+        ('period', ctypes.c_uint16),
+        ('csum', ctypes.c_uint8),
+        ('n_values', ctypes.c_uint8),
+        ('lo', ctypes.c_uint8),
+        ('hi', ctypes.c_uint8),
+        ('confidence', ctypes.c_uint8),
+    ]
+
+
+def crc8(data: bytes, poly: int, init: int = 0xFF, xorout: int = 0xFF) -> int:
+    crc = init
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ poly) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc ^ xorout
+
+
+@pytest.fixture(scope='module')
+def lib(build_host_lib: Callable[[Path], ctypes.CDLL]) -> ctypes.CDLL:
+    lib = build_host_lib(SRC)
+    lib.byte_class_reset.argtypes = [ctypes.c_void_p]
+    lib.byte_class_update.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_uint8]
+    lib.byte_class_classify.argtypes = [ctypes.c_void_p, ctypes.c_uint8, ctypes.POINTER(Result)]
+    lib.byte_class_name.argtypes = [ctypes.c_int]
+    lib.byte_class_name.restype = ctypes.c_char_p
+    return lib
+
+
+def classify(lib: ctypes.CDLL, frames: list[bytes]) -> list[Result]:
+    state = ctypes.create_string_buffer(STATE_SIZE)
+    lib.byte_class_reset(state)
+    for f in frames:
+        lib.byte_class_update(state, f, len(f))
+    results = []
+    for i in range(len(frames[-1])):
+        r = Result()
+        lib.byte_class_classify(state, i, ctypes.byref(r))
+        results.append(r)
+    return results
+
+
+def test_unknown_before_min_samples(lib: ctypes.CDLL) -> None:
+    frames = [bytes([i, 0x55]) for i in range(10)]
+    assert [r.cls for r in classify(lib, frames)] == [UNKNOWN, UNKNOWN]
+
+
+def test_constant(lib: ctypes.CDLL) -> None:
+    frames = [bytes([0x12, i & 0xFF]) for i in range(100)]
+    r = classify(lib, frames)[0]
+    assert (r.cls, r.value) == (CONSTANT, 0x12)
+
+
+@pytest.mark.parametrize('step', [1, 2, 4])
+def test_full_byte_counter(lib: ctypes.CDLL, step: int) -> None:
+    frames = [bytes([(i * step) & 0xFF, 0]) for i in range(600)]
+    r = classify(lib, frames)[0]
+    assert (r.cls, r.mask, r.step, r.period) == (COUNTER, 0xFF, step, 256 // step)
+
+
+def test_counter_period_not_power_of_two(lib: ctypes.CDLL) -> None:
+    frames = [bytes([i % 15]) for i in range(300)]
+    r = classify(lib, frames)[0]
+    assert (r.cls, r.step, r.period, r.lo, r.hi) == (COUNTER, 1, 15, 0, 14)
+
+
+def test_low_nibble_counter(lib: ctypes.CDLL) -> None:
+    rng = random.Random(1)
+    frames = [bytes([(rng.randrange(16) << 4) | (i & 0x0F)]) for i in range(300)]
+    r = classify(lib, frames)[0]
+    assert (r.cls, r.mask, r.period) == (COUNTER, 0x0F, 16)
+
+
+def test_toggling_flag_is_enum(lib: ctypes.CDLL) -> None:
+    frames = [bytes([i & 1]) for i in range(100)]
+    r = classify(lib, frames)[0]
+    assert (r.cls, r.n_values) == (ENUM, 2)
+
+
+def _payloads(n: int, seed: int) -> list[bytearray]:
+    rng = random.Random(seed)
+    return [bytearray([i & 0x0F, rng.randrange(256), rng.randrange(4), 0x40, rng.randrange(256), 0, 0, 0])
+            for i in range(n)]
+
+
+def test_xor_checksum_last_byte(lib: ctypes.CDLL) -> None:
+    frames = []
+    for p in _payloads(200, 2):
+        x = 0
+        for b in p[:7]:
+            x ^= b
+        p[7] = x
+        frames.append(bytes(p))
+    results = classify(lib, frames)
+    assert (results[7].cls, results[7].csum) == (CHECKSUM, CSUM_XOR)
+    # The other changing bytes fit the same constant XOR but are not reported as checksums
+    assert results[0].cls == COUNTER
+    assert results[1].cls == RANDOM
+    assert results[4].cls == RANDOM
+
+
+def test_sum_checksum_with_offset(lib: ctypes.CDLL) -> None:
+    frames = []
+    for p in _payloads(200, 3):
+        p[7] = (sum(p[:7]) + 0x3E9) & 0xFF
+        frames.append(bytes(p))
+    r = classify(lib, frames)[7]
+    assert (r.cls, r.csum) == (CHECKSUM, CSUM_SUM)
+
+
+def test_crc8_j1850_first_byte(lib: ctypes.CDLL) -> None:
+    frames = []
+    for p in _payloads(200, 4):
+        body = bytes(p[:7])
+        frames.append(bytes([crc8(body, 0x1D)]) + body)
+    r = classify(lib, frames)[0]
+    assert (r.cls, r.csum) == (CHECKSUM, CSUM_CRC8_1D)
+
+
+def test_crc8_autosar_with_data_id(lib: ctypes.CDLL) -> None:
+    frames = []
+    for p in _payloads(200, 5):
+        p[7] = crc8(b'\x12\x34' + bytes(p[:7]), 0x2F)
+        frames.append(bytes(p))
+    r = classify(lib, frames)[7]
+    assert (r.cls, r.csum) == (CHECKSUM, CSUM_CRC8_2F)
+
+
+def test_enum(lib: ctypes.CDLL) -> None:
+    rng = random.Random(6)
+    frames = [bytes([rng.choice([0x00, 0x20, 0x80])]) for _ in range(200)]
+    r = classify(lib, frames)[0]
+    assert (r.cls, r.n_values) == (ENUM, 3)
+
+
+def test_continuous(lib: ctypes.CDLL) -> None:
+    rng = random.Random(7)
+    v, frames = 128, []
+    for _ in range(500):
+        v = min(255, max(0, v + rng.randint(-3, 3)))
+        frames.append(bytes([v]))
+    assert classify(lib, frames)[0].cls == CONTINUOUS
+
+
+def test_random(lib: ctypes.CDLL) -> None:
+    rng = random.Random(8)
+    frames = [bytes([rng.randrange(256)]) for _ in range(200)]
+    assert classify(lib, frames)[0].cls == RANDOM
+
+
+def test_length_change_restarts(lib: ctypes.CDLL) -> None:
+    frames = [bytes([i & 0xFF, 1]) for i in range(100)] + [bytes([i & 0xFF]) for i in range(10)]
+    assert classify(lib, frames)[0].cls == UNKNOWN
+
+
+def test_class_names(lib: ctypes.CDLL) -> None:
+    assert lib.byte_class_name(COUNTER) == b'counter'
+    assert lib.byte_class_name(99) == b'unknown'
@@ -0,0 +1,417 @@
+# SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: CC0-1.0
+"""Host tests for main/canopen_proto.c (built with the host C compiler, loaded via ctypes)."""
+
+import ctypes
+import struct
+from collections.abc import Callable
+from pathlib import Path
+
+import pytest
+
+SRC = Path(__file__).parent / 'main' / 'canopen_proto.c'
+
+# canopen_sdo_state_t
+(IDLE, UPLOAD, UPLOAD_SEG, DOWNLOAD, DOWNLOAD_SEG, BLOCK_INIT, BLOCK_DATA, BLOCK_END, DONE,
+ ABORTED) = range(10)
+# canopen_sdo_result_t
+WAIT, SEND = range(2)
+
+ABORT_TOGGLE = 0x05030000
+ABORT_CS = 0x05040001
+ABORT_CRC = 0x05040004
+ABORT_MEMORY = 0x05040005
+ABORT_NO_OBJECT = 0x06020000
+
+
+class Sdo(ctypes.Structure):
+    _fields_ = [
+        ('state', ctypes.c_int),
+        ('index', ctypes.c_uint16),
+        ('sub', ctypes.c_uint8),
+        ('buf', ctypes.c_void_p),
+        ('src', ctypes.c_void_p),
+        ('size', ctypes.c_uint32),
+        ('len', ctypes.c_uint32),
+        ('expected', ctypes.c_uint32),
+        ('toggle', ctypes.c_uint8),
+        ('blksize', ctypes.c_uint8),
+        ('seqno', ctypes.c_uint8),
+        ('crc', ctypes.c_bool),
+        ('abort_code', ctypes.c_uint32),
+    ]
+
+
+class PdoEntry(ctypes.Structure):
+    _fields_ = [
+        ('index', ctypes.c_uint16),
+        ('sub', ctypes.c_uint8),
+        ('bits', ctypes.c_uint8),
+        ('is_signed', ctypes.c_bool),
+    ]
+
+
+class PdoMap(ctypes.Structure):
+    _fields_ = [
+        ('cob_id', ctypes.c_uint16),
+        ('count', ctypes.c_uint8),
+        ('entries', PdoEntry * 8),
+    ]
+
+
+@pytest.fixture(scope='module')
+def lib(build_host_lib: Callable[[Path], ctypes.CDLL]) -> ctypes.CDLL:
+    lib = build_host_lib(SRC)
+    lib.canopen_sdo_start_upload.argtypes = [ctypes.POINTER(Sdo), ctypes.c_uint16, ctypes.c_uint8, ctypes.c_void_p,
+                                             ctypes.c_uint32, ctypes.c_uint8, ctypes.c_char_p]
+    lib.canopen_sdo_start_download.argtypes = [ctypes.POINTER(Sdo), ctypes.c_uint16, ctypes.c_uint8, ctypes.c_void_p,
+                                               ctypes.c_uint32, ctypes.c_char_p]
+    lib.canopen_sdo_start_download.restype = ctypes.c_bool
+    lib.canopen_sdo_feed.argtypes = [ctypes.POINTER(Sdo), ctypes.c_char_p, ctypes.c_uint8, ctypes.c_char_p]
+    lib.canopen_sdo_abort.argtypes = [ctypes.POINTER(Sdo), ctypes.c_uint32, ctypes.c_char_p]
+    lib.canopen_crc16.argtypes = [ctypes.c_char_p, ctypes.c_uint32]
+    lib.canopen_crc16.restype = ctypes.c_uint16
+    lib.canopen_pdo_unpack.argtypes = [ctypes.POINTER(PdoMap), ctypes.c_char_p, ctypes.c_uint8,
+                                       ctypes.POINTER(ctypes.c_int64)]
+    lib.canopen_pdo_unpack.restype = ctypes.c_bool
+    return lib
+
+
+def crc16(data: bytes) -> int:
+    crc = 0
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+class Server:
+    """Minimal CiA 301 SDO server for one object."""
+
+    def __init__(self, index: int, sub: int, value: bytes = b'', block: bool = True, crc: bool = True) -> None:
+        self.index, self.sub = index, sub
+        self.value = bytearray(value)
+        self.block, self.crc = block, crc
+        self.toggle = 0
+        self.pos = 0
+        self.blksize = 0
+        self.drop_seq: set[int] = set()     # segments lost once
+        self.bad_crc = False
+
+    def mux(self) -> bytes:
+        return struct.pack('<HB', self.index, self.sub)
+
+    def abort(self, code: int) -> list[bytes]:
+        return [bytes([0x80]) + self.mux() + struct.pack('<I', code)]
+
+    def send_block(self) -> list[bytes]:
+        frames = []
+        start = self.pos
+        for seq in range(1, self.blksize + 1):
+            chunk = self.value[start + 7 * (seq - 1):start + 7 * seq]
+            last = start + 7 * seq >= len(self.value)
+            if seq in self.drop_seq:
+                self.drop_seq.discard(seq)
+            else:
+                frames.append(bytes([(0x80 if last else 0) | seq]) + bytes(chunk).ljust(7, b'\0'))
+            if last:
+                break
+        return frames
+
+    def handle(self, req: bytes) -> list[bytes]:
+        cmd = req[0]
+        ccs = cmd & 0xE0
+        if ccs == 0x40:
+            if req[1:4] != self.mux():
+                return self.abort(ABORT_NO_OBJECT)
+            if len(self.value) <= 4:
+                n = 4 - len(self.value)
+                return [bytes([0x43 | (n << 2)]) + self.mux() + bytes(self.value).ljust(4, b'\0')]
+            self.toggle = 0
+            self.pos = 0
+            return [bytes([0x41]) + self.mux() + struct.pack('<I', len(self.value))]
+        if ccs == 0x60:
+            assert (cmd >> 4) & 1 == self.toggle
+            chunk = self.value[self.pos:self.pos + 7]
+            self.pos += len(chunk)
+            last = self.pos >= len(self.value)
+            resp = bytes([(self.toggle << 4) | ((7 - len(chunk)) << 1) | int(last)]) + bytes(chunk).ljust(7, b'\0')
+            self.toggle ^= 1
+            return [resp]
+        if ccs == 0x20:
+            if cmd & 0x02:
+                n = 4 - ((cmd >> 2) & 3) if cmd & 1 else 4
+                self.value = bytearray(req[4:4 + n])
+            else:
+                self.value = bytearray()
+                self.expected = struct.unpack('<I', req[4:8])[0]
+                self.toggle = 0
+            return [bytes([0x60]) + self.mux() + bytes(4)]
+        if ccs == 0x00:
+            assert (cmd >> 4) & 1 == self.toggle
+            n = 7 - ((cmd >> 1) & 7)
+            self.value += req[1:1 + n]
+            resp = bytes([0x20 | (self.toggle << 4)]) + bytes(7)
+            self.toggle ^= 1
+            return [resp]
+        if ccs == 0xA0:
+            cs = cmd & 0x03
+            if cs == 0:
+                if not self.block:
+                    return self.abort(ABORT_CS)
+                self.blksize = req[4]
+                self.pos = 0
+                return [bytes([0xC2 | (0x04 if self.crc else 0)]) + self.mux() + struct.pack('<I', len(self.value))]
+            if cs == 3:
+                return self.send_block()
+            if cs == 2:
+                self.pos += 7 * req[1]
+                self.blksize = req[2]
+                if self.pos >= len(self.value):
+                    n = 7 - (len(self.value) % 7 or 7)
+                    crc = crc16(bytes(self.value)) ^ (1 if self.bad_crc else 0)
+                    return [bytes([0xC1 | (n << 2)]) + struct.pack('<H', crc) + bytes(5)]
+                return self.send_block()
+            if cs == 1:
+                return []
+        raise AssertionError(f'unexpected request {req.hex()}')
+
+
+class Client:
+    def __init__(self, lib: ctypes.CDLL) -> None:
+        self.lib = lib
+        self.sdo = Sdo()
+        self.req = ctypes.create_string_buffer(8)
+        self.sent: list[bytes] = []
+
+    def feed(self, resp: bytes) -> int:
+        return self.lib.canopen_sdo_feed(ctypes.byref(self.sdo), resp, len(resp), self.req)
+
+    def run(self, server: Server, first: bytes) -> None:
+        pending = [first]
+        while pending:
+            req = pending.pop(0)
+            self.sent.append(req)
+            if req[0] == 0x80:
+                return
+            for resp in server.handle(req):
+                if self.feed(resp) == SEND:
+                    pending.append(self.req.raw)
+
+    def upload(self, server: Server, size: int = 1024, blksize: int = 0) -> bytes:
+        self.buf = ctypes.create_string_buffer(size + 1)
+        self.lib.canopen_sdo_start_upload(ctypes.byref(self.sdo), server.index, server.sub, self.buf, size, blksize,
+                                          self.req)
+        self.run(server, self.req.raw)
+        return self.buf.raw[:self.sdo.len]
+
+    def download(self, server: Server, data: bytes) -> None:
+        self.src = ctypes.create_string_buffer(data, len(data))
+        assert self.lib.canopen_sdo_start_download(ctypes.byref(self.sdo), server.index, server.sub, self.src,
+                                                   len(data), self.req)
+        self.run(server, self.req.raw)
+
+
+# ---------------------------------------------------------------------------
+# Upload / download
+# ---------------------------------------------------------------------------
+
+
+@pytest.mark.parametrize('value', [b'\x01', b'\x34\x12', b'\x78\x56\x34\x12'])
+def test_expedited_upload(lib: ctypes.CDLL, value: bytes) -> None:
+    c = Client(lib)
+    assert c.upload(Server(0x1018, 1, value)) == value
+    assert c.sdo.state == DONE
+    assert c.sent[0] == bytes([0x40, 0x18, 0x10, 0x01, 0, 0, 0, 0])
+
+
+@pytest.mark.parametrize('length', [5, 7, 8, 14, 15, 100])
+def test_segmented_upload(lib: ctypes.CDLL, length: int) -> None:
+    value = bytes(range(length))
+    c = Client(lib)
+    assert c.upload(Server(0x1008, 0, value)) == value
+    assert c.sdo.state == DONE
+    assert c.sdo.expected == length
+    # Upload segment requests alternate the toggle bit
+    assert [r[0] for r in c.sent[1:4]] == [0x60, 0x70, 0x60][:len(c.sent) - 1]
+
+
+def test_segmented_upload_toggle_error(lib: ctypes.CDLL) -> None:
+    c = Client(lib)
+    buf = ctypes.create_string_buffer(64)
+    lib.canopen_sdo_start_upload(ctypes.byref(c.sdo), 0x1008, 0, buf, 64, 0, c.req)
+    assert c.feed(bytes([0x41, 0x08, 0x10, 0x00, 20, 0, 0, 0])) == SEND
+    # Segment with toggle 1 where 0 is expected
+    assert c.feed(bytes([0x10]) + bytes(7)) == SEND
+    assert c.sdo.state == ABORTED
+    assert c.req.raw == bytes([0x80, 0x08, 0x10, 0x00]) + struct.pack('<I', ABORT_TOGGLE)
+
+
+def test_upload_too_large(lib: ctypes.CDLL) -> None:
+    c = Client(lib)
+    c.upload(Server(0x1008, 0, bytes(100)), size=50)
+    assert c.sdo.state == ABORTED
+    assert c.sdo.abort_code == ABORT_MEMORY
+
+
+def test_server_abort(lib: ctypes.CDLL) -> None:
+    c = Client(lib)
+    c.upload(Server(0x2000, 0, b'\x01'), size=8)
+    c2 = Client(lib)
+    buf = ctypes.create_string_buffer(8)
+    lib.canopen_sdo_start_upload(ctypes.byref(c2.sdo), 0x2001, 0, buf, 8, 0, c2.req)
+    assert c2.feed(bytes([0x80, 0x01, 0x20, 0x00]) + struct.pack('<I', ABORT_NO_OBJECT)) == WAIT
+    assert c2.sdo.state == ABORTED
+    assert c2.sdo.abort_code == ABORT_NO_OBJECT
+
+
+def test_unexpected_response_aborts(lib: ctypes.CDLL) -> None:
+    c = Client(lib)
+    buf = ctypes.create_string_buffer(8)
+    lib.canopen_sdo_start_upload(ctypes.byref(c.sdo), 0x2000, 0, buf, 8, 0, c.req)
+    # Download response to an upload request
+    assert c.feed(bytes([0x60, 0x00, 0x20, 0x00, 0, 0, 0, 0])) == SEND
+    assert c.sdo.abort_code == ABORT_CS
+
+
+@pytest.mark.parametrize('value', [b'\x01', b'\x01\x02\x03\x04'])
+def test_expedited_download(lib: ctypes.CDLL, value: bytes) -> None:
+    server = Server(0x6040, 0)
+    c = Client(lib)
+    c.download(server, value)
+    assert c.sdo.state == DONE
+    assert bytes(server.value) == value
+    assert c.sent[0][0] == 0x23 | ((4 - len(value)) << 2)
+
+
+@pytest.mark.parametrize('length', [5, 7, 8, 21, 50])
+def test_segmented_download(lib: ctypes.CDLL, length: int) -> None:
+    value = bytes((i * 7) & 0xFF for i in range(length))
+    server = Server(0x1010, 1)
+    c = Client(lib)
+    c.download(server, value)
+    assert c.sdo.state == DONE
+    assert bytes(server.value) == value
+    assert server.expected == length
+
+
+def test_download_empty_rejected(lib: ctypes.CDLL) -> None:
+    sdo = Sdo()
+    req = ctypes.create_string_buffer(8)
+    assert not lib.canopen_sdo_start_download(ctypes.byref(sdo), 0x1010, 1, None, 0, req)
+
+
+def test_client_abort(lib: ctypes.CDLL) -> None:
+    c = Client(lib)
+    buf = ctypes.create_string_buffer(8)
+    lib.canopen_sdo_start_upload(ctypes.byref(c.sdo), 0x1000, 0, buf, 8, 0, c.req)
+    lib.canopen_sdo_abort(ctypes.byref(c.sdo), 0x05040000, c.req)
+    assert c.req.raw == bytes([0x80, 0x00, 0x10, 0x00, 0x00, 0x00, 0x04, 0x05])
+    assert c.sdo.state == ABORTED
+    # Responses after the abort are ignored
+    assert c.feed(bytes([0x4F, 0x00, 0x10, 0x00, 1, 0, 0, 0])) == WAIT
+
+
+# ---------------------------------------------------------------------------
+# Block upload
+# ---------------------------------------------------------------------------
+
+
+@pytest.mark.parametrize('length,blksize', [(7, 4), (20, 4), (28, 4), (29, 4), (300, 16), (889, 127)])
+def test_block_upload(lib: ctypes.CDLL, length: int, blksize: int) -> None:
+    value = bytes((i * 13 + 5) & 0xFF for i in range(length))
+    c = Client(lib)
+    assert c.upload(Server(0x1F50, 1, value), size=1024, blksize=blksize) == value
+    assert c.sdo.state == DONE
+    assert c.sdo.crc
+    assert c.sent[0][0] == 0xA4 and c.sent[0][4] == blksize
+    assert c.sent[-1][0] == 0xA1
+
+
+def test_block_upload_exact_buffer(lib: ctypes.CDLL) -> None:
+    value = bytes(range(30))
+    c = Client(lib)
+    assert c.upload(Server(0x1F50, 1, value, crc=False), size=30, blksize=8) == value
+    assert c.sdo.state == DONE
+
+
+def test_block_upload_lost_segment(lib: ctypes.CDLL) -> None:
+    value = bytes(range(70))
+    server = Server(0x1F50, 1, value)
+    server.drop_seq = {3}
+    c = Client(lib)
+    assert c.upload(server, blksize=5) == value
+    # The first block is acknowledged up to segment 2, the server repeats from there
+    acks = [r for r in c.sent if r[0] == 0xA2]
+    assert acks[0][1] == 2
+
+
+def test_block_upload_crc_error(lib: ctypes.CDLL) -> None:
+    server = Server(0x1F50, 1, bytes(40))
+    server.bad_crc = True
+    c = Client(lib)
+    c.upload(server, blksize=8)
+    assert c.sdo.state == ABORTED
+    assert c.sdo.abort_code == ABORT_CRC
+
+
+def test_block_upload_fallback(lib: ctypes.CDLL) -> None:
+    value = bytes(range(40))
+    c = Client(lib)
+    assert c.upload(Server(0x1F50, 1, value, block=False), blksize=16) == value
+    assert c.sdo.state == DONE
+    assert c.sent[1][0] == 0x40
+
+
+def test_block_upload_too_large(lib: ctypes.CDLL) -> None:
+    c = Client(lib)
+    c.upload(Server(0x1F50, 1, bytes(100)), size=64, blksize=8)
+    assert c.sdo.abort_code == ABORT_MEMORY
+
+
+def test_crc16(lib: ctypes.CDLL) -> None:
+    assert lib.canopen_crc16(b'123456789', 9) == 0x31C3
+    assert lib.canopen_crc16(b'', 0) == 0
+
+
+# ---------------------------------------------------------------------------
+# PDO
+# ---------------------------------------------------------------------------
+
+
+def pdo_map(*entries: tuple[int, bool]) -> PdoMap:
+    m = PdoMap(0x181, len(entries))
+    for i, (bits, signed) in enumerate(entries):
+        m.entries[i] = PdoEntry(0x6000 + i, 0, bits, signed)
+    return m
+
+
+def unpack(lib: ctypes.CDLL, m: PdoMap, data: bytes) -> list[int] | None:
+    values = (ctypes.c_int64 * 8)()
+    if not lib.canopen_pdo_unpack(ctypes.byref(m), data, len(data), values):
+        return None
+    return list(values[:m.count])
+
+
+def test_pdo_byte_aligned(lib: ctypes.CDLL) -> None:
+    m = pdo_map((16, False), (32, True), (8, False))
+    data = struct.pack('<HiB', 0x1234, -5, 200)
+    assert unpack(lib, m, data) == [0x1234, -5, 200]
+
+
+def test_pdo_bit_fields(lib: ctypes.CDLL) -> None:
+    m = pdo_map((1, False), (3, False), (4, True), (12, True))
+    # bit 0 = 1, bits 1-3 = 5, bits 4-7 = -2 (0xE), bits 8-19 = -1000
+    raw = 1 | (5 << 1) | (0xE << 4) | ((-1000 & 0xFFF) << 8)
+    assert unpack(lib, m, raw.to_bytes(3, 'little')) == [1, 5, -2, -1000]
+
+
+def test_pdo_64_bit(lib: ctypes.CDLL) -> None:
+    assert unpack(lib, pdo_map((64, True)), struct.pack('<q', -2)) == [-2]
+    assert unpack(lib, pdo_map((64, False)), struct.pack('<Q', 2**63)) == [-(2**63)]
+
+
+def test_pdo_short_payload(lib: ctypes.CDLL) -> None:
+    assert unpack(lib, pdo_map((16, False), (16, False)), b'\x01\x02\x03') is None
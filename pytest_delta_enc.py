@@ -0,0 +1,189 @@
+# SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: CC0-1.0
+"""Host tests for main/delta_enc.c (built with the host C compiler, loaded via ctypes) and the
+decoder in tools/bridge_tool.py."""
+
+import ctypes
+import importlib.util
+import random
+import sys
+import types
+from collections.abc import Callable
+from pathlib import Path
+
+import pytest
+
+ROOT = Path(__file__).parent
+SRC = ROOT / 'main' / 'delta_enc.c'
+TOOL = ROOT / 'tools' / 'bridge_tool.py'
+
+MAX_IDS = 255
+MAX_RECORD = 17
+RESET = 0xFF
+DEF = 0x40
+
+
+class Entry(ctypes.Structure):
+    _fields_ = [('key', ctypes.c_uint32), ('data', ctypes.c_uint8 * 8)]
+
+
+class Enc(ctypes.Structure):
+    _fields_ = [('entries', Entry * MAX_IDS), ('count', ctypes.c_uint16),
+                ('hash', ctypes.c_uint8 * 512), ('last_ts', ctypes.c_uint16)]
+
+
+@pytest.fixture(scope='module')
+def lib(build_host_lib: Callable[[Path], ctypes.CDLL]) -> ctypes.CDLL:
+    lib = build_host_lib(SRC)
+    lib.delta_enc_reset.argtypes = [ctypes.POINTER(Enc)]
+    lib.delta_enc_frame.argtypes = [ctypes.POINTER(Enc), ctypes.c_uint32, ctypes.c_bool, ctypes.c_bool,
+                                    ctypes.c_uint8, ctypes.c_char_p, ctypes.c_bool, ctypes.c_uint16,
+                                    ctypes.c_char_p]
+    lib.delta_enc_frame.restype = ctypes.c_size_t
+    lib.delta_enc_raw_len.argtypes = [ctypes.c_bool, ctypes.c_uint8, ctypes.c_bool]
+    lib.delta_enc_raw_len.restype = ctypes.c_size_t
+    return lib
+
+
+@pytest.fixture(scope='module')
+def tool() -> types.ModuleType:
+    # pyserial is only needed to talk to a bridge, not for the decoder
+    with pytest.MonkeyPatch.context() as mp:
+        if importlib.util.find_spec('serial') is None:
+            mp.setitem(sys.modules, 'serial', types.SimpleNamespace(Serial=object))
+        spec = importlib.util.spec_from_file_location('bridge_tool', TOOL)
+        module = importlib.util.module_from_spec(spec)
+        spec.loader.exec_module(module)
+    return module
+
+
+class Encoder:
+    def __init__(self, lib: ctypes.CDLL) -> None:
+        self.lib = lib
+        self.enc = Enc()
+        lib.delta_enc_reset(ctypes.byref(self.enc))
+
+    def frame(self, can_id: int, data: bytes, ext: bool = False, rtr: bool = False, dlc: int | None = None,
+              ts: int | None = None) -> bytes:
+        out = ctypes.create_string_buffer(MAX_RECORD)
+        n = self.lib.delta_enc_frame(ctypes.byref(self.enc), can_id, ext, rtr, len(data) if dlc is None else dlc,
+                                     bytes(data).ljust(8, b'\0'), ts is not None, ts or 0, out)
+        assert n <= MAX_RECORD
+        return out.raw[:n]
+
+
+def slcan(can_id: int, data: bytes, ext: bool = False, rtr: bool = False, dlc: int | None = None,
+          ts: int | None = None) -> bytes:
+    """The record slcan_send_frame() writes."""
+    dlc = len(data) if dlc is None else dlc
+    text = (('R' if rtr else 'T') + f'{can_id:08X}') if ext else (('r' if rtr else 't') + f'{can_id:03X}')
+    text += str(dlc) + ('' if rtr else bytes(data).hex().upper())
+    text += '' if ts is None else f'{ts:04X}'
+    return (text + '\r').encode()
+
+
+def mixed_traffic(seed: int, count: int) -> list[dict]:
+    rng = random.Random(seed)
+    ids = [(rng.randrange(0x800), False) for _ in range(20)] + [(rng.randrange(1 << 29), True) for _ in range(5)]
+    frames = []
+    ts = 59000
+    for _ in range(count):
+        can_id, ext = rng.choice(ids)
+        rtr = rng.random() < 0.05
+        dlc = rng.randrange(9)
+        data = b'' if rtr else bytes(rng.randrange(256) if rng.random() < 0.3 else 0x55 for _ in range(dlc))
+        ts = (ts + rng.choice([0, 1, 5, 200, 20000])) % 60000
+        frames.append({'can_id': can_id, 'data': data, 'ext': ext, 'rtr': rtr, 'dlc': dlc,
+                       'ts': ts if rng.random() < 0.8 else None})
+    return frames
+
+
+def test_round_trip(lib: ctypes.CDLL, tool: types.ModuleType) -> None:
+    enc = Encoder(lib)
+    frames = mixed_traffic(1, 2000)
+    stream = bytes([RESET]) + b''.join(enc.frame(**f) for f in frames)
+    decoder = tool.DeltaDecoder()
+    assert decoder.feed(stream) == b''.join(slcan(**f) for f in frames)
+    assert decoder.frames == len(frames) and decoder.errors == 0
+
+
+def test_split_records_and_text(lib: ctypes.CDLL, tool: types.ModuleType) -> None:
+    # Responses, log lines and records share the link; records arrive in arbitrary pieces
+    enc = Encoder(lib)
+    frames = mixed_traffic(2, 300)
+    stream, expected = bytearray(), bytearray()
+    for i, f in enumerate(frames):
+        if i % 50 == 0:
+            text = b'stream: delta\n\r' if i % 100 else b'\x07'
+            stream += text
+            expected += text
+        stream += enc.frame(**f)
+        expected += slcan(**f)
+    decoder = tool.DeltaDecoder()
+    out = b''.join(decoder.feed(stream[i:i + 1]) for i in range(len(stream)))
+    assert out == expected and decoder.errors == 0
+
+
+def test_unchanged_frame_is_three_bytes(lib: ctypes.CDLL) -> None:
+    enc = Encoder(lib)
+    first = enc.frame(0x123, bytes(range(1, 9)))
+    assert first[0] & DEF and len(first) == 1 + 4 + 1 + 8
+    assert enc.frame(0x123, bytes(range(1, 9))) == bytes([0x88, 0, 0])
+    # One changed byte: bitmap bit and the XOR of old and new value
+    assert enc.frame(0x123, bytes([1, 2, 3, 0x44, 5, 6, 7, 8])) == bytes([0x88, 0, 0x08, 0x44 ^ 4])
+    # Timestamp difference as a varint
+    assert enc.frame(0x123, bytes([1, 2, 3, 0x44, 5, 6, 7, 8]), ts=300)[3:] == bytes([0xAC, 0x02])
+
+
+def test_dictionary_full(lib: ctypes.CDLL, tool: types.ModuleType) -> None:
+    enc = Encoder(lib)
+    frames = [{'can_id': i, 'data': bytes([i & 0xFF, 1])} for i in range(300)] * 2
+    records = [enc.frame(**f) for f in frames]
+    assert enc.enc.count == MAX_IDS
+    # IDs beyond the dictionary are always sent in full
+    assert all(r[0] & DEF for r in records[MAX_IDS:300] + records[300 + MAX_IDS:])
+    assert not any(r[0] & DEF for r in records[300:300 + MAX_IDS])
+    decoder = tool.DeltaDecoder()
+    assert decoder.feed(b''.join(records)) == b''.join(slcan(**f) for f in frames)
+
+
+def test_reset_resynchronizes(lib: ctypes.CDLL, tool: types.ModuleType) -> None:
+    enc = Encoder(lib)
+    decoder = tool.DeltaDecoder()
+    decoder.feed(enc.frame(0x100, b'\x01\x02', ts=10))
+    # A record lost on the way: the decoder is out of step
+    enc.frame(0x200, b'\x03')
+    decoder.feed(enc.frame(0x200, b'\x04'))
+    assert decoder.errors > 0
+    # The encoder starts over after a failed write, with a reset record first
+    lib.delta_enc_reset(ctypes.byref(enc.enc))
+    stream = bytes([RESET]) + enc.frame(0x200, b'\x05', ts=20) + enc.frame(0x100, b'\x01\x03', ts=30)
+    assert decoder.feed(stream) == slcan(0x200, b'\x05', ts=20) + slcan(0x100, b'\x01\x03', ts=30)
+
+
+def test_compression_on_periodic_traffic(lib: ctypes.CDLL, tool: types.ModuleType) -> None:
+    # Vehicle-like bus: 60 periodic 8-byte messages, each with a rolling counter, a checksum,
+    # one or two slowly moving signals and constant bytes
+    rng = random.Random(3)
+    msgs = [{'id': rng.randrange(0x100, 0x700), 'period': rng.choice([10, 20, 50, 100]),
+             'data': bytearray(rng.randrange(256) for _ in range(8)), 'moving': rng.sample(range(2, 7), 2)}
+            for _ in range(60)]
+    events = sorted((t, i) for i, m in enumerate(msgs) for t in range(m['period'] * i % 7, 10000, m['period']))
+
+    enc = Encoder(lib)
+    frames = []
+    for t, i in events:
+        m = msgs[i]
+        m['data'][0] = (m['data'][0] + 1) & 0x0F
+        for b in m['moving']:
+            if rng.random() < 0.3:
+                m['data'][b] = (m['data'][b] + rng.choice([-1, 1])) & 0xFF
+        m['data'][7] = sum(m['data'][:7]) & 0xFF
+        frames.append({'can_id': m['id'], 'data': bytes(m['data']), 'ts': t % 60000})
+
+    encoded = bytes([RESET]) + b''.join(enc.frame(**f) for f in frames)
+    raw = sum(lib.delta_enc_raw_len(False, 8, True) for _ in frames)
+    text = sum(len(slcan(**f)) for f in frames)
+    assert tool.DeltaDecoder().feed(encoded) == b''.join(slcan(**f) for f in frames)
+    assert raw / len(encoded) >= 2.0
+    assert text / len(encoded) >= 3.5
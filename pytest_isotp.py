@@ -0,0 +1,198 @@
+# SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: CC0-1.0
+"""Host tests for main/isotp.c (built with the host C compiler, loaded via ctypes)."""
+
+import ctypes
+from collections.abc import Callable
+from pathlib import Path
+
+import pytest
+
+SRC = Path(__file__).parent / 'main' / 'isotp.c'
+
+# isotp_rx_result_t
+IGNORED, IN_PROGRESS, SEND_FC, COMPLETE, OVERFLOW, SEQ_ERROR = range(6)
+# isotp_tx_state_t
+TX_IDLE, TX_SEND, TX_WAIT_FC, TX_DONE, TX_ABORTED = range(5)
+
+
+class Rx(ctypes.Structure):
+    _fields_ = [
+        ('buf', ctypes.c_void_p),
+        ('size', ctypes.c_uint16),
+        ('len', ctypes.c_uint16),
+        ('pos', ctypes.c_uint16),
+        ('next_sn', ctypes.c_uint8),
+        ('bs', ctypes.c_uint8),
+        ('block_left', ctypes.c_uint8),
+        ('active', ctypes.c_bool),
+    ]
+
+
+class Tx(ctypes.Structure):
+    _fields_ = [
+        ('data', ctypes.c_void_p),
+        ('len', ctypes.c_uint16),
+        ('pos', ctypes.c_uint16),
+        ('sn', ctypes.c_uint8),
+        ('block_left', ctypes.c_uint8),
+        ('padding', ctypes.c_uint8),
+        ('stmin_us', ctypes.c_uint32),
+        ('state', ctypes.c_int),
+    ]
+
+
+@pytest.fixture(scope='module')
+def lib(build_host_lib: Callable[[Path], ctypes.CDLL]) -> ctypes.CDLL:
+    lib = build_host_lib(SRC)
+    lib.isotp_rx_init.argtypes = [ctypes.POINTER(Rx), ctypes.c_void_p, ctypes.c_uint16, ctypes.c_uint8]
+    lib.isotp_rx_feed.argtypes = [ctypes.POINTER(Rx), ctypes.c_char_p, ctypes.c_uint8]
+    lib.isotp_build_fc.argtypes = [ctypes.c_char_p, ctypes.c_uint8, ctypes.c_uint8, ctypes.c_uint8, ctypes.c_uint8]
+    lib.isotp_tx_start.argtypes = [ctypes.POINTER(Tx), ctypes.c_void_p, ctypes.c_uint16, ctypes.c_uint8]
+    lib.isotp_tx_start.restype = ctypes.c_bool
+    lib.isotp_tx_next.argtypes = [ctypes.POINTER(Tx), ctypes.c_char_p]
+    lib.isotp_tx_next.restype = ctypes.c_uint8
+    lib.isotp_tx_on_fc.argtypes = [ctypes.POINTER(Tx), ctypes.c_char_p, ctypes.c_uint8]
+    lib.isotp_tx_on_fc.restype = ctypes.c_bool
+    lib.isotp_stmin_us.argtypes = [ctypes.c_uint8]
+    lib.isotp_stmin_us.restype = ctypes.c_uint32
+    lib.isotp_stmin_encode.argtypes = [ctypes.c_uint32]
+    lib.isotp_stmin_encode.restype = ctypes.c_uint8
+    return lib
+
+
+class Sender:
+    def __init__(self, lib: ctypes.CDLL, msg: bytes, padding: int = 0xAA) -> None:
+        self.lib = lib
+        self.buf = ctypes.create_string_buffer(msg, len(msg))
+        self.tx = Tx()
+        assert lib.isotp_tx_start(ctypes.byref(self.tx), self.buf, len(msg), padding)
+
+    def next(self) -> bytes | None:
+        out = ctypes.create_string_buffer(8)
+        n = self.lib.isotp_tx_next(ctypes.byref(self.tx), out)
+        return out.raw[:n] if n else None
+
+    def fc(self, frame: bytes) -> bool:
+        return self.lib.isotp_tx_on_fc(ctypes.byref(self.tx), frame, len(frame))
+
+
+class Receiver:
+    def __init__(self, lib: ctypes.CDLL, size: int = 4095, bs: int = 0) -> None:
+        self.lib = lib
+        self.buf = ctypes.create_string_buffer(size)
+        self.rx = Rx()
+        lib.isotp_rx_init(ctypes.byref(self.rx), self.buf, size, bs)
+
+    def feed(self, frame: bytes) -> int:
+        return self.lib.isotp_rx_feed(ctypes.byref(self.rx), frame, len(frame))
+
+    def message(self) -> bytes:
+        return self.buf.raw[:self.rx.len]
+
+
+def fc(lib: ctypes.CDLL, status: int, bs: int, stmin: int) -> bytes:
+    out = ctypes.create_string_buffer(8)
+    assert lib.isotp_build_fc(out, status, bs, stmin, 0x00) == 8
+    return out.raw
+
+
+def test_single_frame_padded(lib: ctypes.CDLL) -> None:
+    s = Sender(lib, bytes([0x41, 0x0C, 0x1A, 0xF8]))
+    assert s.next() == bytes([0x04, 0x41, 0x0C, 0x1A, 0xF8, 0xAA, 0xAA, 0xAA])
+    assert s.tx.state == TX_DONE
+    assert s.next() is None
+
+
+def test_first_frame_waits_for_flow_control(lib: ctypes.CDLL) -> None:
+    msg = bytes(range(20))
+    s = Sender(lib, msg)
+    assert s.next() == bytes([0x10, 20, 0, 1, 2, 3, 4, 5])
+    assert s.tx.state == TX_WAIT_FC
+    assert s.next() is None
+    assert s.fc(fc(lib, 0, 0, 0xF3))
+    assert s.tx.stmin_us == 300
+    assert s.next() == bytes([0x21, 6, 7, 8, 9, 10, 11, 12])
+    assert s.next() == bytes([0x22, 13, 14, 15, 16, 17, 18, 19])
+    assert s.tx.state == TX_DONE
+
+
+def test_block_size_and_wait(lib: ctypes.CDLL) -> None:
+    s = Sender(lib, bytes(60))
+    s.next()
+    assert s.fc(fc(lib, 1, 0, 0))  # WAIT
+    assert s.tx.state == TX_WAIT_FC
+    assert s.fc(fc(lib, 0, 2, 5))
+    assert s.next()[0] == 0x21
+    assert s.next()[0] == 0x22
+    assert s.tx.state == TX_WAIT_FC
+    assert s.fc(fc(lib, 0, 0, 0))
+    frames = []
+    while (f := s.next()) is not None:
+        frames.append(f)
+    assert [f[0] for f in frames] == [0x23, 0x24, 0x25, 0x26, 0x27, 0x28]
+    assert s.tx.state == TX_DONE
+
+
+def test_overflow_aborts(lib: ctypes.CDLL) -> None:
+    s = Sender(lib, bytes(100))
+    s.next()
+    assert s.fc(fc(lib, 2, 0, 0))
+    assert s.tx.state == TX_ABORTED
+    assert s.next() is None
+
+
+@pytest.mark.parametrize('length', [1, 7, 8, 13, 14, 111, 112, 4095])
+def test_round_trip(lib: ctypes.CDLL, length: int) -> None:
+    msg = bytes((i * 7 + 3) & 0xFF for i in range(length))
+    s = Sender(lib, msg)
+    r = Receiver(lib, bs=4)
+    result = IGNORED
+    while (f := s.next()) is not None:
+        result = r.feed(f)
+        if result == SEND_FC:
+            assert s.fc(fc(lib, 0, r.rx.bs, 0))
+    assert result == COMPLETE
+    assert r.message() == msg
+
+
+def test_sequence_number_wraps(lib: ctypes.CDLL) -> None:
+    s = Sender(lib, bytes(6 + 7 * 20))
+    s.next()
+    s.fc(fc(lib, 0, 0, 0))
+    sns = [f[0] & 0x0F for f in iter(s.next, None)]
+    assert sns == [(i + 1) & 0x0F for i in range(20)]
+
+
+def test_receiver_sequence_error(lib: ctypes.CDLL) -> None:
+    r = Receiver(lib)
+    assert r.feed(bytes([0x10, 20, 0, 1, 2, 3, 4, 5])) == SEND_FC
+    assert r.feed(bytes([0x22, 6, 7, 8, 9, 10, 11, 12])) == SEQ_ERROR
+    assert r.feed(bytes([0x21, 6, 7, 8, 9, 10, 11, 12])) == IGNORED
+
+
+def test_receiver_overflow(lib: ctypes.CDLL) -> None:
+    r = Receiver(lib, size=64)
+    assert r.feed(bytes([0x10, 65, 0, 1, 2, 3, 4, 5])) == OVERFLOW
+    assert r.feed(bytes([0x10, 64, 0, 1, 2, 3, 4, 5])) == SEND_FC
+
+
+def test_receiver_ignores_malformed(lib: ctypes.CDLL) -> None:
+    r = Receiver(lib)
+    assert r.feed(bytes([0x00])) == IGNORED
+    assert r.feed(bytes([0x08, 1, 2, 3, 4, 5, 6, 7])) == IGNORED
+    assert r.feed(bytes([0x05, 1, 2])) == IGNORED
+    assert r.feed(bytes([0x10, 7, 0, 1, 2, 3, 4, 5])) == IGNORED
+    assert r.feed(bytes([0x30, 0, 0])) == IGNORED
+
+
+@pytest.mark.parametrize('stmin,us', [(0x00, 0), (0x01, 1000), (0x7F, 127000), (0xF1, 100), (0xF9, 900),
+                                      (0x80, 127000), (0xF0, 127000), (0xFA, 127000)])
+def test_stmin_decode(lib: ctypes.CDLL, stmin: int, us: int) -> None:
+    assert lib.isotp_stmin_us(stmin) == us
+
+
+@pytest.mark.parametrize('us,stmin', [(0, 0x00), (1, 0xF1), (100, 0xF1), (101, 0xF2), (900, 0xF9),
+                                      (901, 0x01), (1000, 0x01), (20000, 0x14), (500000, 0x7F)])
+def test_stmin_encode(lib: ctypes.CDLL, us: int, stmin: int) -> None:
+    assert lib.isotp_stmin_encode(us) == stmin
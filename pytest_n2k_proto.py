@@ -0,0 +1,376 @@
+# SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: CC0-1.0
+"""Host tests for main/n2k_proto.c (built with the host C compiler, loaded via ctypes)."""
+
+import ctypes
+import struct
+from collections.abc import Callable
+from pathlib import Path
+
+import pytest
+
+SRC = Path(__file__).parent / 'main' / 'n2k_proto.c'
+
+MAX_PAYLOAD, POOL_SIZE, MAX_FIELDS = 223, 16, 12
+# n2k_fast_result_t
+PARTIAL, COMPLETE, DROPPED = range(3)
+
+
+class Header(ctypes.Structure):
+    _fields_ = [
+        ('pgn', ctypes.c_uint32),
+        ('priority', ctypes.c_uint8),
+        ('src', ctypes.c_uint8),
+        ('dst', ctypes.c_uint8),
+    ]
+
+
+class Msg(ctypes.Structure):
+    _fields_ = [
+        ('used', ctypes.c_bool),
+        ('hdr', Header),
+        ('seq', ctypes.c_uint8),
+        ('next_frame', ctypes.c_uint8),
+        ('len', ctypes.c_uint8),
+        ('received', ctypes.c_uint8),
+        ('time_us', ctypes.c_int64),
+        ('last_us', ctypes.c_int64),
+        ('data', ctypes.c_uint8 * MAX_PAYLOAD),
+    ]
+
+
+class Fast(ctypes.Structure):
+    _fields_ = [
+        ('pool', Msg * POOL_SIZE),
+        ('messages', ctypes.c_uint32),
+        ('seq_errors', ctypes.c_uint32),
+        ('no_buffer', ctypes.c_uint32),
+        ('timeouts', ctypes.c_uint32),
+    ]
+
+
+class Field(ctypes.Structure):
+    _fields_ = [
+        ('name', ctypes.c_char_p),
+        ('offset', ctypes.c_uint16),
+        ('bits', ctypes.c_uint8),
+        ('is_signed', ctypes.c_bool),
+        ('mul', ctypes.c_uint16),
+        ('decimals', ctypes.c_uint8),
+    ]
+
+
+class Pgn(ctypes.Structure):
+    _fields_ = [
+        ('pgn', ctypes.c_uint32),
+        ('name', ctypes.c_char_p),
+        ('count', ctypes.c_uint8),
+        ('fields', Field * MAX_FIELDS),
+    ]
+
+
+@pytest.fixture(scope='module')
+def lib(build_host_lib: Callable[[Path], ctypes.CDLL]) -> ctypes.CDLL:
+    lib = build_host_lib(SRC)
+    lib.n2k_parse_id.argtypes = [ctypes.c_uint32, ctypes.POINTER(Header)]
+    lib.n2k_is_fast_packet.argtypes = [ctypes.c_uint32]
+    lib.n2k_is_fast_packet.restype = ctypes.c_bool
+    lib.n2k_fast_init.argtypes = [ctypes.POINTER(Fast)]
+    lib.n2k_fast_feed.argtypes = [ctypes.POINTER(Fast), ctypes.POINTER(Header), ctypes.c_char_p, ctypes.c_uint8,
+                                  ctypes.c_int64, ctypes.POINTER(ctypes.POINTER(Msg))]
+    lib.n2k_fast_expire.argtypes = [ctypes.POINTER(Fast), ctypes.c_int64, ctypes.c_int64]
+    lib.n2k_fast_expire.restype = ctypes.c_uint32
+    lib.n2k_find_pgn.argtypes = [ctypes.c_uint32]
+    lib.n2k_find_pgn.restype = ctypes.POINTER(Pgn)
+    lib.n2k_pgn_table.argtypes = [ctypes.POINTER(ctypes.c_size_t)]
+    lib.n2k_pgn_table.restype = ctypes.POINTER(Pgn)
+    lib.n2k_format_fields.argtypes = [ctypes.POINTER(Pgn), ctypes.c_char_p, ctypes.c_uint16, ctypes.c_char_p,
+                                      ctypes.c_size_t]
+    return lib
+
+
+def can_id(pgn: int, src: int, priority: int = 3, dst: int = 0xFF) -> int:
+    pf = (pgn >> 8) & 0xFF
+    ps = dst if pf < 240 else pgn & 0xFF
+    return (priority << 26) | ((pgn >> 16) << 24) | (pf << 16) | (ps << 8) | src
+
+
+def fast_frames(payload: bytes, seq: int = 0) -> list[bytes]:
+    """Split a payload into fast-packet frames (padded with 0xFF)."""
+    frames = [bytes([seq << 5, len(payload)]) + payload[:6]]
+    rest = payload[6:]
+    counter = 1
+    while rest:
+        frames.append(bytes([(seq << 5) | counter]) + rest[:7])
+        rest = rest[7:]
+        counter += 1
+    return [f.ljust(8, b'\xff') for f in frames]
+
+
+class Reassembler:
+    def __init__(self, lib: ctypes.CDLL) -> None:
+        self.lib = lib
+        self.fp = Fast()
+        lib.n2k_fast_init(ctypes.byref(self.fp))
+
+    def feed(self, pgn: int, src: int, frame: bytes, time_us: int = 0) -> tuple[int, bytes | None]:
+        hdr = Header(pgn, 3, src, 0xFF)
+        msg = ctypes.POINTER(Msg)()
+        r = self.lib.n2k_fast_feed(ctypes.byref(self.fp), ctypes.byref(hdr), frame, len(frame), time_us,
+                                   ctypes.byref(msg))
+        if r == COMPLETE:
+            m = msg.contents
+            assert m.hdr.pgn == pgn and m.hdr.src == src
+            return r, bytes(m.data[:m.len])
+        return r, None
+
+
+def decode(lib: ctypes.CDLL, pgn: int, payload: bytes) -> list[str]:
+    dec = lib.n2k_find_pgn(pgn)
+    assert dec
+    out = ctypes.create_string_buffer(512)
+    n = lib.n2k_format_fields(dec, payload, len(payload), out, len(out))
+    assert n == len(out.value)
+    return out.value.decode().split()
+
+
+# ---------------------------------------------------------------------------
+# CAN ID and fast-packet table
+# ---------------------------------------------------------------------------
+
+
+def test_parse_id_pdu2(lib: ctypes.CDLL) -> None:
+    hdr = Header()
+    lib.n2k_parse_id(can_id(129025, 0x23, priority=2), ctypes.byref(hdr))
+    assert (hdr.pgn, hdr.priority, hdr.src, hdr.dst) == (129025, 2, 0x23, 0xFF)
+
+
+def test_parse_id_pdu1_destination(lib: ctypes.CDLL) -> None:
+    hdr = Header()
+    # ISO Request (59904) addressed to 0x10
+    lib.n2k_parse_id(can_id(59904, 0x05, priority=6, dst=0x10), ctypes.byref(hdr))
+    assert (hdr.pgn, hdr.priority, hdr.src, hdr.dst) == (59904, 6, 0x05, 0x10)
+
+
+@pytest.mark.parametrize('pgn', [126996, 129029, 129540, 126208, 130816, 131071, 127489])
+def test_fast_packet_pgns(lib: ctypes.CDLL, pgn: int) -> None:
+    assert lib.n2k_is_fast_packet(pgn)
+
+
+@pytest.mark.parametrize('pgn', [127250, 129025, 129026, 130306, 59904, 60928, 130815])
+def test_single_frame_pgns(lib: ctypes.CDLL, pgn: int) -> None:
+    assert not lib.n2k_is_fast_packet(pgn)
+
+
+# ---------------------------------------------------------------------------
+# Fast-packet reassembly
+# ---------------------------------------------------------------------------
+
+
+def test_reassemble_message(lib: ctypes.CDLL) -> None:
+    r = Reassembler(lib)
+    payload = bytes(range(43))
+    frames = fast_frames(payload, seq=5)
+    for f in frames[:-1]:
+        assert r.feed(129029, 1, f) == (PARTIAL, None)
+    assert r.feed(129029, 1, frames[-1]) == (COMPLETE, payload)
+    assert r.fp.messages == 1
+    assert not any(m.used for m in r.fp.pool)
+
+
+def test_short_message_in_first_frame(lib: ctypes.CDLL) -> None:
+    r = Reassembler(lib)
+    assert r.feed(126720, 7, fast_frames(b'\x01\x02\x03')[0]) == (COMPLETE, b'\x01\x02\x03')
+
+
+def test_largest_message(lib: ctypes.CDLL) -> None:
+    r = Reassembler(lib)
+    payload = bytes(i & 0xFF for i in range(MAX_PAYLOAD))
+    frames = fast_frames(payload)
+    assert len(frames) == 32
+    results = [r.feed(126996, 1, f) for f in frames]
+    assert results[-1] == (COMPLETE, payload)
+
+
+def test_invalid_length_dropped(lib: ctypes.CDLL) -> None:
+    r = Reassembler(lib)
+    assert r.feed(126996, 1, bytes([0, 224, 0, 0, 0, 0, 0, 0]))[0] == DROPPED
+    assert r.feed(126996, 1, bytes([0, 0, 0, 0, 0, 0, 0, 0]))[0] == DROPPED
+
+
+def test_interleaved_sources(lib: ctypes.CDLL) -> None:
+    r = Reassembler(lib)
+    a = bytes(range(20))
+    b = bytes(range(100, 120))
+    fa = fast_frames(a, seq=1)
+    fb = fast_frames(b, seq=1)
+    out = []
+    for x, y in zip(fa, fb):
+        out.append(r.feed(129029, 1, x))
+        out.append(r.feed(129029, 2, y))
+    assert out[-2] == (COMPLETE, a)
+    assert out[-1] == (COMPLETE, b)
+
+
+def test_interleaved_pgns_same_source(lib: ctypes.CDLL) -> None:
+    r = Reassembler(lib)
+    a = bytes(range(30))
+    b = bytes(range(50, 64))
+    fa = fast_frames(a)
+    fb = fast_frames(b)
+    r.feed(129029, 1, fa[0])
+    r.feed(129540, 1, fb[0])
+    r.feed(129540, 1, fb[1])
+    assert r.feed(129540, 1, fb[2]) == (COMPLETE, b)
+    for f in fa[1:-1]:
+        assert r.feed(129029, 1, f)[0] == PARTIAL
+    assert r.feed(129029, 1, fa[-1]) == (COMPLETE, a)
+
+
+def test_lost_frame_drops_message(lib: ctypes.CDLL) -> None:
+    r = Reassembler(lib)
+    frames = fast_frames(bytes(range(30)))
+    r.feed(129029, 1, frames[0])
+    r.feed(129029, 1, frames[1])
+    assert r.feed(129029, 1, frames[3])[0] == DROPPED
+    assert r.fp.seq_errors == 1
+    # The rest of the message has no buffer any more
+    assert r.feed(129029, 1, frames[4])[0] == DROPPED
+    assert r.fp.messages == 0
+
+
+def test_sequence_mismatch_dropped(lib: ctypes.CDLL) -> None:
+    r = Reassembler(lib)
+    first = fast_frames(bytes(range(30)), seq=2)
+    other = fast_frames(bytes(range(30)), seq=3)
+    r.feed(129029, 1, first[0])
+    assert r.feed(129029, 1, other[1])[0] == DROPPED
+    assert r.fp.seq_errors == 1
+
+
+def test_new_first_frame_restarts(lib: ctypes.CDLL) -> None:
+    r = Reassembler(lib)
+    old = fast_frames(bytes(range(30)), seq=0)
+    new = fast_frames(bytes(range(40, 60)), seq=1)
+    r.feed(129029, 1, old[0])
+    r.feed(129029, 1, old[1])
+    out = [r.feed(129029, 1, f) for f in new]
+    assert out[-1] == (COMPLETE, bytes(range(40, 60)))
+    assert r.fp.seq_errors == 1
+    assert r.fp.messages == 1
+
+
+def test_orphan_frame_dropped(lib: ctypes.CDLL) -> None:
+    r = Reassembler(lib)
+    frames = fast_frames(bytes(range(30)))
+    assert r.feed(129029, 1, frames[2])[0] == DROPPED
+    assert r.fp.seq_errors == 0
+
+
+def test_pool_exhausted(lib: ctypes.CDLL) -> None:
+    r = Reassembler(lib)
+    first = fast_frames(bytes(range(30)))[0]
+    for src in range(POOL_SIZE):
+        assert r.feed(129029, src, first)[0] == PARTIAL
+    assert r.feed(129029, POOL_SIZE, first)[0] == DROPPED
+    assert r.fp.no_buffer == 1
+
+
+def test_completed_buffer_reused(lib: ctypes.CDLL) -> None:
+    r = Reassembler(lib)
+    for n in range(3 * POOL_SIZE):
+        frames = fast_frames(bytes([n]) * 10, seq=n & 7)
+        out = [r.feed(129029, n, f) for f in frames]
+        assert out[-1] == (COMPLETE, bytes([n]) * 10)
+    assert r.fp.no_buffer == 0
+
+
+def test_expire_incomplete(lib: ctypes.CDLL) -> None:
+    r = Reassembler(lib)
+    frames = fast_frames(bytes(range(30)))
+    r.feed(129029, 1, frames[0], time_us=1000)
+    r.feed(129029, 1, frames[1], time_us=2000)
+    r.feed(129029, 2, frames[0], time_us=600000)
+    assert lib.n2k_fast_expire(ctypes.byref(r.fp), 752000, 750000) == 0
+    assert lib.n2k_fast_expire(ctypes.byref(r.fp), 752001, 750000) == 1
+    assert r.fp.timeouts == 1
+    assert r.feed(129029, 1, frames[2])[0] == DROPPED
+    assert r.feed(129029, 2, frames[1])[0] == PARTIAL
+
+
+# ---------------------------------------------------------------------------
+# PGN decoding
+# ---------------------------------------------------------------------------
+
+
+def test_table_sorted_and_complete(lib: ctypes.CDLL) -> None:
+    count = ctypes.c_size_t()
+    table = lib.n2k_pgn_table(ctypes.byref(count))
+    pgns = [table[i].pgn for i in range(count.value)]
+    assert pgns == sorted(pgns)
+    for i in range(count.value):
+        dec = table[i]
+        assert 0 < dec.count <= MAX_FIELDS
+        for f in dec.fields[:dec.count]:
+            assert f.name and 0 < f.bits <= 64 and f.mul > 0
+
+
+def test_unknown_pgn(lib: ctypes.CDLL) -> None:
+    assert not lib.n2k_find_pgn(59904)
+
+
+def test_position_rapid(lib: ctypes.CDLL) -> None:
+    payload = struct.pack('<ii', 515074000, -1278000)
+    assert decode(lib, 129025, payload) == ['51.5074000', '-0.1278000']
+
+
+def test_heading(lib: ctypes.CDLL) -> None:
+    payload = struct.pack('<BHhhB', 7, 31416, -150, 0x7FFF, 0xFD)
+    # Variation not available; reference 1 (magnetic) in the low two bits
+    assert decode(lib, 127250, payload) == ['7', '3.1416', '-0.0150', '-', '1']
+
+
+def test_cog_sog(lib: ctypes.CDLL) -> None:
+    payload = struct.pack('<BBHHH', 3, 0xFC, 15708, 514, 0xFFFF)
+    assert decode(lib, 129026, payload) == ['3', '0', '1.5708', '5.14']
+
+
+def test_rate_of_turn(lib: ctypes.CDLL) -> None:
+    payload = struct.pack('<Bi', 1, -32) + b'\xff\xff\xff'
+    # 32 * 3.125e-8 rad/s
+    assert decode(lib, 127251, payload) == ['1', '-0.00000100000']
+
+
+def test_engine_rapid_scaled(lib: ctypes.CDLL) -> None:
+    payload = struct.pack('<BHHbBB', 0, 7200, 1200, -5, 0xFF, 0xFF)
+    assert decode(lib, 127488, payload) == ['0', '1800.00', '120000', '-5']
+
+
+def test_sid_not_available(lib: ctypes.CDLL) -> None:
+    payload = struct.pack('<BHHB', 0xFF, 1029, 0xFFFF, 0xFF) + b'\xff\xff'
+    assert decode(lib, 128259, payload) == ['-', '10.29', '-']
+
+
+def test_gnss_position_fast_packet(lib: ctypes.CDLL) -> None:
+    lat = 515074000 * 10 ** 9
+    lon = -1278000 * 10 ** 9
+    payload = struct.pack('<BHIqqqBBBHh', 9, 19500, 432000000, lat, lon, 12_500000, 0x23, 0xFC, 11, 90, 0x7FFF)
+    payload += b'\xff' * (43 - len(payload))
+    values = decode(lib, 129029, payload)
+    assert values[:6] == ['9', '19500', '43200.0000', '51.5074000000000000', '-0.1278000000000000', '12.500000']
+    assert values[6:10] == ['3', '2', '0', '11']
+    assert values[10:] == ['0.90', '-']
+
+
+def test_truncated_payload(lib: ctypes.CDLL) -> None:
+    # Fields beyond the payload are not available
+    assert decode(lib, 129025, struct.pack('<i', 10)) == ['0.0000010', '-']
+
+
+def test_output_truncated_to_whole_fields(lib: ctypes.CDLL) -> None:
+    dec = lib.n2k_find_pgn(129025)
+    out = ctypes.create_string_buffer(16)
+    payload = struct.pack('<ii', 515074000, -1278000)
+    n = lib.n2k_format_fields(dec, payload, len(payload), out, len(out))
+    assert out.value == b' 51.5074000'
+    assert n == len(out.value)
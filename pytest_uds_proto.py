@@ -0,0 +1,103 @@
+# SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: CC0-1.0
+"""Host tests for main/uds_proto.c (built with the host C compiler, loaded via ctypes)."""
+
+import ctypes
+from collections.abc import Callable
+from pathlib import Path
+
+import pytest
+
+SRC = Path(__file__).parent / 'main' / 'uds_proto.c'
+
+# uds_resp_t
+POSITIVE, PENDING, NEGATIVE, INVALID = range(4)
+
+
+@pytest.fixture(scope='module')
+def lib(build_host_lib: Callable[[Path], ctypes.CDLL]) -> ctypes.CDLL:
+    lib = build_host_lib(SRC)
+    lib.uds_build_request_download.argtypes = [ctypes.c_char_p, ctypes.c_uint8, ctypes.c_uint32, ctypes.c_uint32]
+    lib.uds_build_request_download.restype = ctypes.c_uint16
+    lib.uds_check_response.argtypes = [ctypes.c_uint8, ctypes.c_char_p, ctypes.c_uint16,
+                                       ctypes.POINTER(ctypes.c_uint8)]
+    lib.uds_parse_download_response.argtypes = [ctypes.c_char_p, ctypes.c_uint16, ctypes.POINTER(ctypes.c_uint32)]
+    lib.uds_parse_download_response.restype = ctypes.c_bool
+    lib.uds_check_transfer_response.argtypes = [ctypes.c_char_p, ctypes.c_uint16, ctypes.c_uint8]
+    lib.uds_check_transfer_response.restype = ctypes.c_bool
+    lib.uds_bus_max_rate.argtypes = [ctypes.c_uint32, ctypes.c_bool, ctypes.c_uint32]
+    lib.uds_bus_max_rate.restype = ctypes.c_uint32
+    return lib
+
+
+def check(lib: ctypes.CDLL, sid: int, resp: bytes) -> tuple[int, int]:
+    nrc = ctypes.c_uint8(0)
+    result = lib.uds_check_response(sid, resp, len(resp), ctypes.byref(nrc))
+    return result, nrc.value
+
+
+def max_block(lib: ctypes.CDLL, resp: bytes) -> int | None:
+    value = ctypes.c_uint32(0)
+    return value.value if lib.uds_parse_download_response(resp, len(resp), ctypes.byref(value)) else None
+
+
+def test_request_download_layout(lib: ctypes.CDLL) -> None:
+    out = ctypes.create_string_buffer(11)
+    assert lib.uds_build_request_download(out, 0x11, 0x00080000, 0x0003F000) == 11
+    assert out.raw == bytes([0x34, 0x11, 0x44, 0x00, 0x08, 0x00, 0x00, 0x00, 0x03, 0xF0, 0x00])
+
+
+def test_response_classes(lib: ctypes.CDLL) -> None:
+    assert check(lib, 0x36, bytes([0x76, 0x01])) == (POSITIVE, 0)
+    assert check(lib, 0x36, bytes([0x7F, 0x36, 0x78])) == (PENDING, 0x78)
+    assert check(lib, 0x34, bytes([0x7F, 0x34, 0x70])) == (NEGATIVE, 0x70)
+    assert check(lib, 0x37, bytes([0x7F, 0x37, 0x21]))[0] == NEGATIVE
+
+
+def test_foreign_responses_are_invalid(lib: ctypes.CDLL) -> None:
+    # Negative response to another service, positive response to another service, truncated
+    assert check(lib, 0x36, bytes([0x7F, 0x34, 0x78]))[0] == INVALID
+    assert check(lib, 0x36, bytes([0x74, 0x20, 0x0F, 0xFF]))[0] == INVALID
+    assert check(lib, 0x36, bytes([0x7F, 0x36]))[0] == INVALID
+    assert check(lib, 0x36, b'')[0] == INVALID
+
+
+@pytest.mark.parametrize('resp,value', [
+    (bytes([0x74, 0x20, 0x0F, 0xFF]), 0xFFF),
+    (bytes([0x74, 0x10, 0x82]), 0x82),
+    (bytes([0x74, 0x40, 0x00, 0x01, 0x00, 0x02]), 0x10002),
+])
+def test_download_response_block_length(lib: ctypes.CDLL, resp: bytes, value: int) -> None:
+    assert max_block(lib, resp) == value
+
+
+@pytest.mark.parametrize('resp', [
+    bytes([0x74]),                          # no lengthFormatIdentifier
+    bytes([0x74, 0x00]),                    # zero-length block length
+    bytes([0x74, 0x50, 1, 2, 3, 4, 5]),     # more than 4 bytes
+    bytes([0x74, 0x20, 0x0F]),              # truncated
+    bytes([0x74, 0x10, 0x02]),              # no room for data
+    bytes([0x76, 0x20, 0x0F, 0xFF]),        # other service
+])
+def test_download_response_malformed(lib: ctypes.CDLL, resp: bytes) -> None:
+    assert max_block(lib, resp) is None
+
+
+def test_transfer_response_counter(lib: ctypes.CDLL) -> None:
+    assert lib.uds_check_transfer_response(bytes([0x76, 0x05]), 2, 0x05)
+    assert not lib.uds_check_transfer_response(bytes([0x76, 0x04]), 2, 0x05)
+    assert not lib.uds_check_transfer_response(bytes([0x76]), 1, 0x05)
+    assert lib.uds_check_transfer_response(bytes([0x76, 0x00]), 2, 0x00)
+
+
+def test_bus_max_rate(lib: ctypes.CDLL) -> None:
+    # 4095-byte block: FF + 585 CFs + FC + response = 588 frames of 111 bits at 500 kbit/s
+    assert lib.uds_bus_max_rate(500000, False, 4095) == 4093 * 500000 // (588 * 111)
+    # Single-frame block: request and response
+    assert lib.uds_bus_max_rate(500000, False, 7) == 5 * 500000 // (2 * 111)
+    # 29-bit frames are longer
+    assert lib.uds_bus_max_rate(500000, True, 4095) < lib.uds_bus_max_rate(500000, False, 4095)
+    # Larger blocks amortize the per-block frames
+    assert lib.uds_bus_max_rate(500000, False, 258) < lib.uds_bus_max_rate(500000, False, 4095)
+    assert lib.uds_bus_max_rate(0, False, 4095) == 0
+    assert lib.uds_bus_max_rate(500000, False, 2) == 0
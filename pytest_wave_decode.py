@@ -0,0 +1,432 @@
+# SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: CC0-1.0
+"""Host tests for main/wave_decode.c (built with the host C compiler, loaded via ctypes).
+
+The waveforms are synthesized: a frame is built bit by bit (CRC, stuffing,
+delimiters), optionally corrupted, and turned into runs of RX pin levels at a
+given bit time in sampler ticks.
+"""
+
+import ctypes
+from collections.abc import Callable
+from pathlib import Path
+
+import pytest
+
+SRC = Path(__file__).parent / 'main' / 'wave_decode.c'
+
+MAX_EDGES, MAX_BITS = 160, 128
+# wave_status_t
+OK, ACK_ERROR, STUFF_ERROR, CRC_ERROR, FORM_ERROR = range(5)
+# wave_field_t
+(F_SOF, F_ID, F_SRR, F_IDE, F_ID_EXT, F_RTR, F_RESERVED, F_DLC, F_DATA, F_CRC, F_CRC_DELIM, F_ACK, F_ACK_DELIM,
+ F_EOF) = range(14)
+
+TICK_HZ = 80_000_000
+BITRATE = 500_000
+BIT = TICK_HZ // BITRATE
+
+
+class Timing(ctypes.Structure):
+    _fields_ = [
+        ('tick_hz', ctypes.c_uint32),
+        ('bitrate', ctypes.c_uint32),
+        ('sample_point', ctypes.c_uint16),
+    ]
+
+
+class Frame(ctypes.Structure):
+    _fields_ = [
+        ('status', ctypes.c_int),
+        ('id', ctypes.c_uint32),
+        ('ide', ctypes.c_bool),
+        ('rtr', ctypes.c_bool),
+        ('dlc', ctypes.c_uint8),
+        ('data', ctypes.c_uint8 * 8),
+        ('crc', ctypes.c_uint16),
+        ('crc_calc', ctypes.c_uint16),
+        ('ack', ctypes.c_bool),
+        ('error_field', ctypes.c_int),
+        ('error_bit', ctypes.c_uint16),
+        ('error_flag', ctypes.c_bool),
+        ('sof_tick', ctypes.c_uint64),
+        ('raw_bits', ctypes.c_uint16),
+        ('edge_count', ctypes.c_uint16),
+        ('edges', ctypes.c_uint32 * MAX_EDGES),
+    ]
+
+
+class Decoder(ctypes.Structure):
+    _fields_ = [
+        ('bit_q8', ctypes.c_int64),
+        ('sample_q8', ctypes.c_int64),
+        ('sjw_q8', ctypes.c_int64),
+        ('now_q8', ctypes.c_int64),
+        ('in_frame', ctypes.c_bool),
+        ('last_level', ctypes.c_uint8),
+        ('idle_q8', ctypes.c_int64),
+        ('idle_bits', ctypes.c_uint16),
+        ('sof_q8', ctypes.c_int64),
+        ('next_sample_q8', ctypes.c_int64),
+        ('bits', ctypes.c_uint8 * MAX_BITS),
+        ('nbits', ctypes.c_uint16),
+        ('crc_start', ctypes.c_uint16),
+        ('stuffing', ctypes.c_bool),
+        ('run_bit', ctypes.c_uint8),
+        ('run_len', ctypes.c_uint8),
+        ('post', ctypes.c_uint8),
+        ('done', ctypes.c_bool),
+        ('frame', Frame),
+        ('frames', ctypes.c_uint32),
+        ('errors', ctypes.c_uint32),
+        ('glitches', ctypes.c_uint32),
+    ]
+
+
+@pytest.fixture(scope='module')
+def lib(build_host_lib: Callable[[Path], ctypes.CDLL]) -> ctypes.CDLL:
+    lib = build_host_lib(SRC)
+    lib.wave_decoder_init.argtypes = [ctypes.POINTER(Decoder), ctypes.POINTER(Timing)]
+    lib.wave_decoder_init.restype = ctypes.c_bool
+    lib.wave_decoder_feed.argtypes = [ctypes.POINTER(Decoder), ctypes.c_uint8, ctypes.c_uint32,
+                                      ctypes.POINTER(Frame)]
+    lib.wave_decoder_feed.restype = ctypes.c_bool
+    lib.wave_status_name.argtypes = [ctypes.c_int]
+    lib.wave_status_name.restype = ctypes.c_char_p
+    lib.wave_field_name.argtypes = [ctypes.c_int]
+    lib.wave_field_name.restype = ctypes.c_char_p
+    lib.wave_crc15.argtypes = [ctypes.c_char_p, ctypes.c_uint16]
+    lib.wave_crc15.restype = ctypes.c_uint16
+    return lib
+
+
+def crc15(bits: list[int]) -> int:
+    """CRC-15/CAN by polynomial division (independent of the shift-register form in C)."""
+    poly = 0xC599  # x^15 + x^14 + x^10 + x^8 + x^7 + x^4 + x^3 + 1
+    rem = 0
+    for b in bits + [0] * 15:
+        rem = (rem << 1) | b
+        if rem & 0x8000:
+            rem ^= poly
+    return rem
+
+
+def bitfield(value: int, width: int) -> list[int]:
+    return [(value >> (width - 1 - i)) & 1 for i in range(width)]
+
+
+def frame_bits(can_id: int, data: bytes = b'', ext: bool = False, rtr: bool = False,
+               dlc: int | None = None) -> list[int]:
+    """Destuffed bits from the start of frame to the end of the data field."""
+    dlc = len(data) if dlc is None else dlc
+    if ext:
+        bits = [0] + bitfield(can_id >> 18, 11) + [1, 1] + bitfield(can_id & 0x3FFFF, 18) + [int(rtr), 0, 0]
+    else:
+        bits = [0] + bitfield(can_id, 11) + [int(rtr), 0, 0]
+    bits += bitfield(dlc, 4)
+    if not rtr:
+        for b in data:
+            bits += bitfield(b, 8)
+    return bits
+
+
+def stuff(bits: list[int]) -> list[int]:
+    out: list[int] = []
+    run_bit, run_len = -1, 0
+    for b in bits:
+        out.append(b)
+        if b == run_bit:
+            run_len += 1
+        else:
+            run_bit, run_len = b, 1
+        if run_len == 5:
+            out.append(1 - b)
+            run_bit, run_len = 1 - b, 1
+    return out
+
+
+def wire_bits(can_id: int, data: bytes = b'', ext: bool = False, rtr: bool = False, dlc: int | None = None,
+              ack: bool = True, crc: int | None = None) -> list[int]:
+    """Bits on the bus from the start of frame to the end of frame."""
+    bits = frame_bits(can_id, data, ext, rtr, dlc)
+    crc = crc15(bits) if crc is None else crc
+    return stuff(bits + bitfield(crc, 15)) + [1, 0 if ack else 1, 1] + [1] * 7
+
+
+def runs(bits: list[int], bit_ticks: float = BIT, idle_bits: int = 11) -> list[tuple[int, int]]:
+    """Levels and durations of the RX pin, with idle bus before and after."""
+    levels = [1] * idle_bits + bits + [1] * idle_bits
+    edges = [round(i * bit_ticks) for i in range(len(levels) + 1)]
+    out: list[tuple[int, int]] = []
+    for i, level in enumerate(levels):
+        ticks = edges[i + 1] - edges[i]
+        if out and out[-1][0] == level:
+            out[-1] = (level, out[-1][1] + ticks)
+        else:
+            out.append((level, ticks))
+    return out
+
+
+class Wave:
+    def __init__(self, lib: ctypes.CDLL, bitrate: int = BITRATE, sample_point: int = 875,
+                 tick_hz: int = TICK_HZ) -> None:
+        self.lib = lib
+        self.dec = Decoder()
+        timing = Timing(tick_hz, bitrate, sample_point)
+        assert lib.wave_decoder_init(ctypes.byref(self.dec), ctypes.byref(timing))
+
+    def feed(self, waveform: list[tuple[int, int]]) -> list[Frame]:
+        frames = []
+        for level, ticks in waveform:
+            out = Frame()
+            if self.lib.wave_decoder_feed(ctypes.byref(self.dec), level, ticks, ctypes.byref(out)):
+                frames.append(out)
+        return frames
+
+
+def decode_one(lib: ctypes.CDLL, bits: list[int], **kwargs) -> Frame:
+    frames = Wave(lib, **kwargs).feed(runs(bits))
+    assert len(frames) == 1
+    return frames[0]
+
+
+def test_crc15_matches_division(lib: ctypes.CDLL) -> None:
+    for bits in ([0] * 19, frame_bits(0x123, b'\x11\x22'), frame_bits(0x1ABCDEF0, bytes(range(8)), ext=True)):
+        assert lib.wave_crc15(bytes(bits), len(bits)) == crc15(bits)
+
+
+def test_standard_data_frame(lib: ctypes.CDLL) -> None:
+    f = decode_one(lib, wire_bits(0x123, b'\xde\xad\xbe\xef'))
+    assert f.status == OK
+    assert (f.id, f.ide, f.rtr, f.dlc) == (0x123, False, False, 4)
+    assert bytes(f.data[:4]) == b'\xde\xad\xbe\xef'
+    assert f.ack and f.crc == f.crc_calc
+
+
+def test_extended_data_frame(lib: ctypes.CDLL) -> None:
+    f = decode_one(lib, wire_bits(0x18FEF100, bytes(range(1, 9)), ext=True))
+    assert f.status == OK
+    assert (f.id, f.ide, f.rtr, f.dlc) == (0x18FEF100, True, False, 8)
+    assert bytes(f.data) == bytes(range(1, 9))
+
+
+@pytest.mark.parametrize('ext', [False, True])
+def test_remote_frame_has_no_data(lib: ctypes.CDLL, ext: bool) -> None:
+    f = decode_one(lib, wire_bits(0x7DF, ext=ext, rtr=True, dlc=8))
+    assert f.status == OK
+    assert (f.id, f.ide, f.rtr, f.dlc) == (0x7DF, ext, True, 8)
+    assert bytes(f.data) == bytes(8)
+
+
+def test_dlc_zero(lib: ctypes.CDLL) -> None:
+    f = decode_one(lib, wire_bits(0x000))
+    assert f.status == OK and (f.id, f.dlc) == (0, 0)
+
+
+def test_dlc_above_8_carries_8_bytes(lib: ctypes.CDLL) -> None:
+    f = decode_one(lib, wire_bits(0x100, bytes(range(8)), dlc=15))
+    assert f.status == OK and f.dlc == 15 and bytes(f.data) == bytes(range(8))
+
+
+@pytest.mark.parametrize('payload', [bytes(8), b'\xff' * 8, b'\x0f\xf0' * 4, b'\x1f\x07\xc1\xf0\x7c\x1f\x07\xc1'])
+def test_stuffed_payloads(lib: ctypes.CDLL, payload: bytes) -> None:
+    f = decode_one(lib, wire_bits(0x000, payload))
+    assert f.status == OK and bytes(f.data) == payload
+
+
+def test_stuff_bit_after_crc(lib: ctypes.CDLL) -> None:
+    # Find a frame whose CRC sequence ends with five equal bits
+    for can_id in range(0x800):
+        bits = frame_bits(can_id, b'\x55')
+        destuffed = bits + bitfield(crc15(bits), 15)
+        stuffed = stuff(destuffed)
+        if stuffed[-1] != destuffed[-1]:
+            break
+    else:
+        pytest.fail('no frame with a trailing stuff bit')
+    f = decode_one(lib, wire_bits(can_id, b'\x55'))
+    assert f.status == OK and f.id == can_id
+
+
+def test_raw_bits_and_edges(lib: ctypes.CDLL) -> None:
+    bits = wire_bits(0x555, b'\xaa')
+    f = decode_one(lib, bits)
+    assert f.raw_bits == len(bits)
+    assert f.sof_tick == 11 * BIT
+    expected = [i * BIT for i in range(len(bits)) if i == 0 or bits[i] != bits[i - 1]]
+    assert list(f.edges[:f.edge_count]) == expected
+
+
+def test_ack_missing(lib: ctypes.CDLL) -> None:
+    f = decode_one(lib, wire_bits(0x321, b'\x01', ack=False))
+    assert f.status == ACK_ERROR
+    assert not f.ack and f.id == 0x321 and f.data[0] == 1
+
+
+def test_crc_error(lib: ctypes.CDLL) -> None:
+    bits = frame_bits(0x123, b'\x10')
+    f = decode_one(lib, wire_bits(0x123, b'\x10', crc=crc15(bits) ^ 0x0001))
+    assert f.status == CRC_ERROR
+    assert f.error_field == F_CRC
+    assert f.crc == crc15(bits) ^ 1 and f.crc_calc == crc15(bits)
+
+
+def test_corrupted_data_bit_is_crc_error(lib: ctypes.CDLL) -> None:
+    good = frame_bits(0x123, b'\x10')
+    crc = crc15(good)
+    bad = good.copy()
+    bad[-3] ^= 1
+    wire = stuff(bad + bitfield(crc, 15)) + [1, 0, 1] + [1] * 7
+    f = decode_one(lib, wire)
+    assert f.status == CRC_ERROR and f.data[0] == 0x14
+
+
+def test_error_flag_in_data(lib: ctypes.CDLL) -> None:
+    bits = wire_bits(0x123, b'\xaa\xaa')
+    pos = 27
+    assert bits[pos - 1] == 1
+    # Another node's error flag: six dominant bits, then the delimiter
+    f = decode_one(lib, bits[:pos] + [0] * 6 + [1] * 8)
+    assert f.status == STUFF_ERROR
+    assert f.error_flag and f.error_field == F_DATA
+    # Seen at the sixth dominant bit
+    assert f.error_bit == pos + 5
+    assert f.raw_bits == pos + 6
+    assert f.edges[f.edge_count - 1] == pos * BIT
+
+
+def test_recessive_stuff_error(lib: ctypes.CDLL) -> None:
+    bits = wire_bits(0x000, b'\x00')
+    # Six recessive bits where the identifier is all dominant: after SOF plus 4 zeros comes a stuff bit
+    wire = bits[:3] + [1] * 6 + bits[9:]
+    f = Wave(lib).feed(runs(wire))[0]
+    assert f.status == STUFF_ERROR and not f.error_flag
+
+
+def test_stuff_error_locates_field(lib: ctypes.CDLL) -> None:
+    # Standard frame with ID 0: SOF and the ID are dominant, a stuff bit follows the fifth dominant bit
+    bits = wire_bits(0x000, b'\x00')
+    assert bits[5] == 1
+    wire = bits[:5] + [0] * 8 + [1] * 11
+    f = decode_one(lib, wire)
+    assert f.status == STUFF_ERROR
+    assert (f.error_field, f.error_bit) == (F_ID, 5)
+
+
+def test_form_error_crc_delimiter(lib: ctypes.CDLL) -> None:
+    bits = wire_bits(0x456, b'\x01\x02')
+    n = len(bits) - 10
+    bits[n] = 0
+    f = decode_one(lib, bits)
+    assert f.status == FORM_ERROR
+    assert (f.error_field, f.error_bit) == (F_CRC_DELIM, n)
+
+
+def test_form_error_ack_delimiter(lib: ctypes.CDLL) -> None:
+    bits = wire_bits(0x456, b'\x01\x02')
+    bits[len(bits) - 8] = 0
+    f = decode_one(lib, bits)
+    assert f.status == FORM_ERROR and f.error_field == F_ACK_DELIM
+
+
+def test_form_error_eof(lib: ctypes.CDLL) -> None:
+    bits = wire_bits(0x456, b'\x01\x02')
+    bits[len(bits) - 4] = 0
+    f = decode_one(lib, bits)
+    assert f.status == FORM_ERROR and f.error_field == F_EOF
+
+
+def test_dominant_last_eof_bit_keeps_frame(lib: ctypes.CDLL) -> None:
+    bits = wire_bits(0x456, b'\x01\x02')
+    bits[-1] = 0
+    f = decode_one(lib, bits)
+    assert f.status == OK and f.id == 0x456
+
+
+@pytest.mark.parametrize('sample_point,skew', [(875, 0.996), (875, 1.004), (875, 1.015), (750, 0.99), (750, 1.01)])
+def test_transmitter_clock_skew(lib: ctypes.CDLL, sample_point: int, skew: float) -> None:
+    # Within the tolerance of the bit timing thanks to resynchronization on every falling edge
+    payload = b'\x01\x80\x7f\xfe\x00\xff\x55\xaa'
+    wave = Wave(lib, sample_point=sample_point)
+    frames = wave.feed(runs(wire_bits(0x1FFFFFFF, payload, ext=True), bit_ticks=BIT * skew, idle_bits=12))
+    assert len(frames) == 1 and frames[0].status == OK and bytes(frames[0].data) == payload
+
+
+def test_skew_beyond_tolerance(lib: ctypes.CDLL) -> None:
+    frames = Wave(lib).feed(runs(wire_bits(0x000, bytes(8)), bit_ticks=BIT * 1.25))
+    assert not frames or frames[0].status != OK
+
+
+def test_fractional_ticks_per_bit(lib: ctypes.CDLL) -> None:
+    # 20 MHz / 83.333 kbit/s = 240.0, 10 MHz / 833.333 kbit/s is not an integer
+    wave = Wave(lib, bitrate=800_000, tick_hz=10_000_000)
+    frames = wave.feed(runs(wire_bits(0x7E8, b'\x03\x41\x0c\x1a\xf8'), bit_ticks=10_000_000 / 800_000))
+    assert len(frames) == 1 and frames[0].status == OK and frames[0].id == 0x7E8
+
+
+def test_split_runs(lib: ctypes.CDLL) -> None:
+    # The sampler may report one level as several consecutive runs
+    waveform = []
+    for level, ticks in runs(wire_bits(0x2AB, b'\x12\x34')):
+        half = ticks // 2
+        waveform += [(level, half), (level, ticks - half)]
+    frames = Wave(lib).feed(waveform)
+    assert len(frames) == 1 and frames[0].status == OK and frames[0].id == 0x2AB
+
+
+def test_back_to_back_frames(lib: ctypes.CDLL) -> None:
+    a = wire_bits(0x100, b'\x01')
+    b = wire_bits(0x200, b'\x02')
+    # Three bits of intermission only
+    frames = Wave(lib).feed(runs(a + [1] * 3 + b))
+    assert [f.id for f in frames] == [0x100, 0x200]
+    assert all(f.status == OK for f in frames)
+    assert frames[1].sof_tick - frames[0].sof_tick == (len(a) + 3) * BIT
+
+
+def test_error_needs_full_idle(lib: ctypes.CDLL) -> None:
+    bad = wire_bits(0x100, b'\x55\x55')[:30] + [0] * 6
+    good = wire_bits(0x200, b'\x02')
+    # A start of frame 3 bits after an error flag is not accepted: the bus is not idle yet
+    frames = Wave(lib).feed(runs(bad + [1] * 3 + good + [1] * 11 + good))
+    assert [(f.status, f.id) for f in frames] == [(STUFF_ERROR, 0x100), (OK, 0x200)]
+
+
+def test_mid_frame_start_ignored(lib: ctypes.CDLL) -> None:
+    bits = wire_bits(0x123, b'\x11\x22\x33')
+    # Capture starts in the middle of a frame: nothing until the bus has been idle
+    frames = Wave(lib).feed(runs(bits[20:], idle_bits=0) + runs(bits))
+    assert len(frames) == 1 and frames[0].status == OK and frames[0].id == 0x123
+
+
+def test_glitch_on_idle_bus(lib: ctypes.CDLL) -> None:
+    wave = Wave(lib)
+    waveform = [(1, 20 * BIT), (0, BIT // 4), (1, 2 * BIT)] + runs(wire_bits(0x321, b'\x99'), idle_bits=1)
+    frames = wave.feed(waveform)
+    assert wave.dec.glitches == 1
+    assert len(frames) == 1 and frames[0].status == OK and frames[0].id == 0x321
+
+
+def test_counters(lib: ctypes.CDLL) -> None:
+    wave = Wave(lib)
+    wave.feed(runs(wire_bits(0x100, b'\x01')) + runs(wire_bits(0x100, b'\x01', crc=1)))
+    assert (wave.dec.frames, wave.dec.errors) == (1, 1)
+
+
+@pytest.mark.parametrize('tick_hz,bitrate,sample_point', [
+    (1_000_000, 500_000, 875),    # 2 ticks per bit
+    (80_000_000, 0, 875),
+    (80_000_000, 500_000, 400),
+    (80_000_000, 500_000, 990),
+])
+def test_init_rejects_timing(lib: ctypes.CDLL, tick_hz: int, bitrate: int, sample_point: int) -> None:
+    dec = Decoder()
+    assert not lib.wave_decoder_init(ctypes.byref(dec), ctypes.byref(Timing(tick_hz, bitrate, sample_point)))
+
+
+def test_names(lib: ctypes.CDLL) -> None:
+    assert [lib.wave_status_name(s) for s in range(5)] == [b'ok', b'ack', b'stuff', b'crc', b'form']
+    assert lib.wave_field_name(F_SOF) == b'sof'
+    assert lib.wave_field_name(F_CRC_DELIM) == b'crcdel'
+    assert lib.wave_field_name(F_EOF) == b'eof'
+    assert lib.wave_status_name(99) == b'?' and lib.wave_field_name(99) == b'?'
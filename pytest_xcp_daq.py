@@ -0,0 +1,300 @@
+# SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: CC0-1.0
+"""Host tests for main/xcp_daq.c (built with the host C compiler, loaded via ctypes)."""
+
+import ctypes
+import struct
+from collections.abc import Callable
+from pathlib import Path
+
+import pytest
+
+SRC = Path(__file__).parent / 'main' / 'xcp_daq.c'
+
+MAX_VARS, MAX_LISTS, MAX_ODTS = 64, 8, 32
+# xcp_var_type_t
+U, S, F = range(3)
+# xcp_id_field_t
+ABSOLUTE, REL_BYTE, REL_WORD, REL_WORD_ALIGNED = range(4)
+# xcp_daq_result_t
+IGNORED, PARTIAL, SAMPLE, DROPPED = range(4)
+
+
+class Var(ctypes.Structure):
+    _fields_ = [
+        ('addr', ctypes.c_uint32),
+        ('addr_ext', ctypes.c_uint8),
+        ('size', ctypes.c_uint8),
+        ('type', ctypes.c_int),
+        ('event', ctypes.c_uint16),
+    ]
+
+
+class Format(ctypes.Structure):
+    _fields_ = [
+        ('id_field', ctypes.c_int),
+        ('ts_size', ctypes.c_uint8),
+        ('big_endian', ctypes.c_bool),
+        ('max_dto', ctypes.c_uint8),
+        ('first_daq', ctypes.c_uint16),
+    ]
+
+
+class Odt(ctypes.Structure):
+    _fields_ = [
+        ('first_var', ctypes.c_uint8),
+        ('var_count', ctypes.c_uint8),
+        ('offset', ctypes.c_uint8),
+        ('len', ctypes.c_uint8),
+    ]
+
+
+class List(ctypes.Structure):
+    _fields_ = [
+        ('event', ctypes.c_uint16),
+        ('daq', ctypes.c_uint16),
+        ('first_pid', ctypes.c_uint8),
+        ('var_count', ctypes.c_uint8),
+        ('vars', ctypes.c_uint8 * MAX_VARS),
+        ('odt_count', ctypes.c_uint8),
+        ('odts', Odt * MAX_ODTS),
+        ('next_odt', ctypes.c_uint8),
+        ('time_us', ctypes.c_int64),
+        ('ts', ctypes.c_uint32),
+        ('sample', ctypes.c_uint8 * (MAX_ODTS * 7)),
+        ('samples', ctypes.c_uint32),
+        ('lost', ctypes.c_uint32),
+    ]
+
+
+class Daq(ctypes.Structure):
+    _fields_ = [
+        ('var_count', ctypes.c_uint8),
+        ('vars', Var * MAX_VARS),
+        ('fmt', Format),
+        ('list_count', ctypes.c_uint8),
+        ('lists', List * MAX_LISTS),
+    ]
+
+
+@pytest.fixture(scope='module')
+def lib(build_host_lib: Callable[[Path], ctypes.CDLL]) -> ctypes.CDLL:
+    lib = build_host_lib(SRC)
+    lib.xcp_daq_init.argtypes = [ctypes.POINTER(Daq)]
+    lib.xcp_daq_add_var.argtypes = [ctypes.POINTER(Daq), ctypes.POINTER(Var)]
+    lib.xcp_daq_add_var.restype = ctypes.c_bool
+    lib.xcp_daq_layout.argtypes = [ctypes.POINTER(Daq), ctypes.POINTER(Format)]
+    lib.xcp_daq_layout.restype = ctypes.c_bool
+    lib.xcp_daq_set_first_pid.argtypes = [ctypes.POINTER(Daq), ctypes.c_uint8, ctypes.c_uint8]
+    lib.xcp_daq_feed.argtypes = [ctypes.POINTER(Daq), ctypes.c_char_p, ctypes.c_uint8, ctypes.c_int64,
+                                 ctypes.POINTER(ctypes.c_uint8)]
+    lib.xcp_daq_format_sample.argtypes = [ctypes.POINTER(Daq), ctypes.c_uint8, ctypes.c_char_p, ctypes.c_size_t]
+    return lib
+
+
+class Master:
+    def __init__(self, lib: ctypes.CDLL, variables: list[tuple[int, str, int]], **fmt: int) -> None:
+        """variables: (size, type, event) each"""
+        self.lib = lib
+        self.daq = Daq()
+        lib.xcp_daq_init(ctypes.byref(self.daq))
+        types = {'u': U, 's': S, 'f': F}
+        for n, (size, typ, event) in enumerate(variables):
+            var = Var(0x1000 + 4 * n, 0, size, types[typ], event)
+            assert lib.xcp_daq_add_var(ctypes.byref(self.daq), ctypes.byref(var))
+        self.fmt = Format(fmt.get('id_field', ABSOLUTE), fmt.get('ts_size', 0), bool(fmt.get('big_endian', 0)),
+                          fmt.get('max_dto', 8), fmt.get('first_daq', 0))
+
+    def layout(self) -> bool:
+        return self.lib.xcp_daq_layout(ctypes.byref(self.daq), ctypes.byref(self.fmt))
+
+    def feed(self, data: bytes, time_us: int = 0) -> tuple[int, int]:
+        list_out = ctypes.c_uint8(0xFF)
+        r = self.lib.xcp_daq_feed(ctypes.byref(self.daq), data, len(data), time_us, ctypes.byref(list_out))
+        return r, list_out.value
+
+    def values(self, list_index: int) -> str:
+        out = ctypes.create_string_buffer(256)
+        n = self.lib.xcp_daq_format_sample(ctypes.byref(self.daq), list_index, out, len(out))
+        assert n == len(out.value)
+        return out.value.decode()
+
+    def odts(self, list_index: int) -> list[tuple[int, int, int, int]]:
+        lst = self.daq.lists[list_index]
+        return [(o.first_var, o.var_count, o.offset, o.len) for o in lst.odts[:lst.odt_count]]
+
+
+# ---------------------------------------------------------------------------
+# Layout
+# ---------------------------------------------------------------------------
+
+
+def test_add_var_rejects_bad_size(lib: ctypes.CDLL) -> None:
+    daq = Daq()
+    lib.xcp_daq_init(ctypes.byref(daq))
+    assert not lib.xcp_daq_add_var(ctypes.byref(daq), ctypes.byref(Var(0, 0, 3, U, 0)))
+    assert not lib.xcp_daq_add_var(ctypes.byref(daq), ctypes.byref(Var(0, 0, 2, F, 0)))
+    assert lib.xcp_daq_add_var(ctypes.byref(daq), ctypes.byref(Var(0, 0, 4, F, 0)))
+
+
+def test_add_var_table_full(lib: ctypes.CDLL) -> None:
+    daq = Daq()
+    lib.xcp_daq_init(ctypes.byref(daq))
+    for _ in range(MAX_VARS):
+        assert lib.xcp_daq_add_var(ctypes.byref(daq), ctypes.byref(Var(0, 0, 1, U, 0)))
+    assert not lib.xcp_daq_add_var(ctypes.byref(daq), ctypes.byref(Var(0, 0, 1, U, 0)))
+
+
+def test_one_list_per_event(lib: ctypes.CDLL) -> None:
+    m = Master(lib, [(2, 'u', 1), (2, 'u', 0), (4, 'u', 1)], first_daq=3)
+    assert m.layout()
+    assert m.daq.list_count == 2
+    assert (m.daq.lists[0].event, m.daq.lists[0].daq) == (1, 3)
+    assert (m.daq.lists[1].event, m.daq.lists[1].daq) == (0, 4)
+    assert list(m.daq.lists[0].vars[:2]) == [0, 2]
+
+
+def test_packing_without_split(lib: ctypes.CDLL) -> None:
+    # 7 data bytes per ODT with a 1-byte PID: 4+2 fit, the next 4 starts a new ODT
+    m = Master(lib, [(4, 'u', 0), (2, 'u', 0), (4, 'u', 0), (1, 'u', 0), (2, 'u', 0)])
+    assert m.layout()
+    assert m.odts(0) == [(0, 2, 0, 6), (2, 3, 6, 7)]
+
+
+def test_timestamp_leaves_no_room(lib: ctypes.CDLL) -> None:
+    # PID + 4-byte timestamp leaves 3 bytes: a leading 4-byte variable would leave ODT 0 empty
+    assert not Master(lib, [(4, 'u', 0), (2, 'u', 0)], ts_size=4).layout()
+    m = Master(lib, [(2, 'u', 0), (4, 'u', 0)], ts_size=4)
+    assert m.layout()
+    assert m.odts(0) == [(0, 1, 0, 2), (1, 1, 2, 4)]
+
+
+def test_timestamp_first_odt_capacity(lib: ctypes.CDLL) -> None:
+    m = Master(lib, [(2, 'u', 0), (1, 'u', 0), (4, 'u', 0)], ts_size=2)
+    assert m.layout()
+    # 8 - PID - 2-byte timestamp = 5: 2+1 fit, 4 does not
+    assert m.odts(0) == [(0, 2, 0, 3), (2, 1, 3, 4)]
+
+
+def test_too_many_lists(lib: ctypes.CDLL) -> None:
+    m = Master(lib, [(1, 'u', e) for e in range(MAX_LISTS + 1)])
+    assert not m.layout()
+
+
+def test_too_many_odts(lib: ctypes.CDLL) -> None:
+    m = Master(lib, [(4, 'u', 0)] * (MAX_ODTS + 1))
+    assert not m.layout()
+
+
+def test_can_fd_dto_rejected(lib: ctypes.CDLL) -> None:
+    assert not Master(lib, [(1, 'u', 0)], max_dto=64).layout()
+
+
+# ---------------------------------------------------------------------------
+# Reassembly
+# ---------------------------------------------------------------------------
+
+
+def two_odt_master(lib: ctypes.CDLL, **fmt: int) -> Master:
+    m = Master(lib, [(4, 'u', 0), (2, 's', 0), (4, 'f', 0)], **fmt)
+    assert m.layout()
+    lib.xcp_daq_set_first_pid(ctypes.byref(m.daq), 0, 0x10)
+    return m
+
+
+def test_absolute_pid_sample(lib: ctypes.CDLL) -> None:
+    m = two_odt_master(lib)
+    assert m.feed(bytes([0x10]) + struct.pack('<Ih', 123456, -2), 1000) == (PARTIAL, 0)
+    assert m.feed(bytes([0x11]) + struct.pack('<f', 1.5), 1500) == (SAMPLE, 0)
+    assert m.values(0) == ' 123456 -2 1.5'
+    assert m.daq.lists[0].time_us == 1000
+    assert m.daq.lists[0].samples == 1
+
+
+def test_big_endian_values(lib: ctypes.CDLL) -> None:
+    m = two_odt_master(lib, big_endian=1)
+    m.feed(bytes([0x10]) + struct.pack('>Ih', 0x01020304, -300))
+    assert m.feed(bytes([0x11]) + struct.pack('>f', -0.25))[0] == SAMPLE
+    assert m.values(0) == f' {0x01020304} -300 -0.25'
+
+
+def test_signed_byte_extension(lib: ctypes.CDLL) -> None:
+    m = Master(lib, [(1, 's', 0), (1, 'u', 0), (4, 's', 0)])
+    assert m.layout()
+    assert m.feed(bytes([0, 0xFF, 0xFF]) + struct.pack('<i', -70000))[0] == SAMPLE
+    assert m.values(0) == ' -1 255 -70000'
+
+
+def test_timestamp_captured(lib: ctypes.CDLL) -> None:
+    m = two_odt_master(lib, ts_size=2)
+    assert m.odts(0)[0][1] == 1
+    m.feed(bytes([0x10]) + struct.pack('<HI', 0xBEEF, 7))
+    assert m.daq.lists[0].ts == 0xBEEF
+
+
+def test_missing_odt_drops_sample(lib: ctypes.CDLL) -> None:
+    m = two_odt_master(lib)
+    m.feed(bytes([0x10]) + bytes(6))
+    # ODT 0 again: the first sample is lost, the new one continues
+    assert m.feed(bytes([0x10]) + struct.pack('<Ih', 1, 1))[0] == PARTIAL
+    assert m.daq.lists[0].lost == 1
+    assert m.feed(bytes([0x11]) + struct.pack('<f', 2.0))[0] == SAMPLE
+    assert m.values(0) == ' 1 1 2'
+
+
+def test_odt_without_start_dropped(lib: ctypes.CDLL) -> None:
+    m = two_odt_master(lib)
+    assert m.feed(bytes([0x11]) + bytes(4))[0] == DROPPED
+    # Nothing was in progress, so no sample was lost
+    assert m.daq.lists[0].lost == 0
+
+
+def test_short_dto_dropped(lib: ctypes.CDLL) -> None:
+    m = two_odt_master(lib)
+    assert m.feed(bytes([0x10, 1, 2]))[0] == DROPPED
+    assert m.daq.lists[0].lost == 1
+
+
+def test_unknown_pid_and_res_ignored(lib: ctypes.CDLL) -> None:
+    m = two_odt_master(lib)
+    assert m.feed(bytes([0x20]) + bytes(7))[0] == IGNORED
+    assert m.feed(bytes([0xFF, 0x00]))[0] == IGNORED
+    assert m.feed(b'')[0] == IGNORED
+
+
+def test_two_lists_interleaved(lib: ctypes.CDLL) -> None:
+    m = Master(lib, [(4, 'u', 0), (4, 'u', 0), (2, 'u', 1)])
+    assert m.layout()
+    lib.xcp_daq_set_first_pid(ctypes.byref(m.daq), 0, 0)
+    lib.xcp_daq_set_first_pid(ctypes.byref(m.daq), 1, 2)
+    assert m.feed(bytes([0]) + struct.pack('<I', 10)) == (PARTIAL, 0)
+    assert m.feed(bytes([2]) + struct.pack('<H', 99)) == (SAMPLE, 1)
+    assert m.feed(bytes([1]) + struct.pack('<I', 20)) == (SAMPLE, 0)
+    assert m.values(0) == ' 10 20'
+    assert m.values(1) == ' 99'
+
+
+@pytest.mark.parametrize('id_field,header', [
+    (REL_BYTE, lambda odt, daq: bytes([odt, daq])),
+    (REL_WORD, lambda odt, daq: bytes([odt]) + struct.pack('<H', daq)),
+    (REL_WORD_ALIGNED, lambda odt, daq: bytes([odt, 0]) + struct.pack('<H', daq)),
+])
+def test_relative_identification(lib: ctypes.CDLL, id_field: int, header) -> None:
+    m = Master(lib, [(2, 'u', 0), (2, 'u', 5)], id_field=id_field, first_daq=2)
+    assert m.layout()
+    assert m.feed(header(0, 3) + struct.pack('<H', 77)) == (SAMPLE, 1)
+    assert m.feed(header(0, 2) + struct.pack('<H', 66)) == (SAMPLE, 0)
+    assert m.feed(header(1, 2) + struct.pack('<H', 66))[0] == IGNORED
+    assert m.feed(header(0, 4) + struct.pack('<H', 66))[0] == IGNORED
+    assert m.values(0) == ' 66'
+    assert m.values(1) == ' 77'
+
+
+def test_format_truncates(lib: ctypes.CDLL) -> None:
+    m = Master(lib, [(4, 'u', 0)])
+    assert m.layout()
+    m.feed(bytes([0]) + struct.pack('<I', 4000000000))
+    out = ctypes.create_string_buffer(6)
+    n = lib.xcp_daq_format_sample(ctypes.byref(m.daq), 0, out, len(out))
+    assert out.value == b' 4000'
+    assert n == 5
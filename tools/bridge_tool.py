@@ -0,0 +1,742 @@
+#!/usr/bin/env python3
+# SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: CC0-1.0
+"""Host-side helper for the CAN bridge extension commands.
+
+Subcommands:
+  sync    Send clock sync beacons to one or more bridges and report their fit residual
+  export  Download the flash capture (CRC-checked chunks, resumes after errors)
+  convert Convert a downloaded capture to a candump log
+  replay  Replay a candump log with device-timed transmission and report timing errors
+  discover List the IDs on the bus from first-seen records and rate summaries
+  xcp     Measure ECU variables through the on-device XCP DAQ master (CSV output)
+  bench   Run the forwarding self-benchmark and verify the frame sequence
+  flash   Stage an ECU image on the bridge and run the on-device UDS download
+  stream  Receive the delta-encoded frame stream and write it out as SLCAN text
+"""
+
+import argparse
+import re
+import struct
+import sys
+import time
+import zlib
+
+import serial
+
+# ---------------------------------------------------------------------------
+# Link helpers
+# ---------------------------------------------------------------------------
+
+ACK = b'\r'
+NACK = b'\x07'
+
+
+def host_time_us() -> int:
+    """Host clock shared by all bridges (monotonic, microseconds)."""
+    return time.monotonic_ns() // 1000
+
+
+def open_port(port: str, timeout: float = 0.5) -> serial.Serial:
+    ser = serial.Serial(port, 115200, timeout=timeout)
+    ser.reset_input_buffer()
+    return ser
+
+
+def ext_command(ser: serial.Serial, cmdline: str) -> list[str]:
+    """Run an 'X' extension command and return its text output lines."""
+    ser.write(f'X{cmdline}\r'.encode())
+    out = b''
+    deadline = time.monotonic() + 2.0
+    while time.monotonic() < deadline:
+        chunk = ser.read(1)
+        if not chunk:
+            continue
+        if chunk in (ACK, NACK) and (not out or out.endswith(b'\n')):
+            if chunk == NACK:
+                raise RuntimeError(f'{ser.port}: command failed: {cmdline}')
+            break
+        out += chunk
+    return [line.strip() for line in out.decode(errors='replace').splitlines() if line.strip()]
+
+
+# ---------------------------------------------------------------------------
+# sync
+# ---------------------------------------------------------------------------
+
+
+def cmd_sync(args: argparse.Namespace) -> int:
+    ports = [open_port(p) for p in args.port]
+    for ser in ports:
+        if args.reset:
+            ext_command(ser, 'sync -r')
+
+    next_beacon = time.monotonic()
+    beacons = 0
+    try:
+        while args.count == 0 or beacons < args.count:
+            # Stamp each beacon right before it is written to its own port
+            for ser in ports:
+                ser.write(f'Xsync {host_time_us()}\r'.encode())
+            beacons += 1
+
+            if args.status_every and beacons % args.status_every == 0:
+                for ser in ports:
+                    ser.reset_input_buffer()
+                    for line in ext_command(ser, 'sync'):
+                        print(f'{ser.port}: {line}')
+
+            next_beacon += args.interval
+            time.sleep(max(0.0, next_beacon - time.monotonic()))
+    except KeyboardInterrupt:
+        pass
+
+    # Achieved agreement: the fit residual of each bridge
+    for ser in ports:
+        ser.reset_input_buffer()
+        for line in ext_command(ser, 'sync'):
+            print(f'{ser.port}: {line}')
+    return 0
+
+
+# ---------------------------------------------------------------------------
+# export / convert (layouts from main/flash_capture.h and main/capture_export.h)
+# ---------------------------------------------------------------------------
+
+CAPTURE_BLOCK_SIZE = 4096
+CAPTURE_BLOCK_MAGIC = 0x50414343
+CAPTURE_EXPORT_MAGIC = 0x50584543
+BLOCK_HEADER = struct.Struct('<IIHHI')
+RECORD = struct.Struct('<QIBB8s2x')
+CHUNK_HEADER = struct.Struct('<IIIII')
+FLAG_EXT = 1 << 31
+FLAG_RTR = 1 << 30
+
+
+def read_exact(ser: serial.Serial, n: int) -> bytes:
+    data = ser.read(n)
+    if len(data) != n:
+        raise TimeoutError(f'short read ({len(data)}/{n} bytes)')
+    return data
+
+
+def read_line(ser: serial.Serial) -> str:
+    line = ser.read_until(b'\n')
+    if not line.endswith(b'\n'):
+        raise TimeoutError('no response line')
+    return line.decode(errors='replace').strip()
+
+
+def export_from(ser: serial.Serial, start: int, blocks: int, chunks: dict[int, bytes]) -> int:
+    """Receive chunks starting at 'start'; returns the total chunk count."""
+    ser.reset_input_buffer()
+    ser.write(f'Xexport -s {start} -b {blocks}\r'.encode())
+    line = read_line(ser)
+    while not line.startswith('export '):
+        line = read_line(ser)
+    fields = line.split()
+    if len(fields) != 4:
+        raise RuntimeError(f'export refused: {line}')
+    total = int(fields[1])
+
+    for _ in range(start, total):
+        magic, index, _, length, crc = CHUNK_HEADER.unpack(read_exact(ser, CHUNK_HEADER.size))
+        if magic != CAPTURE_EXPORT_MAGIC:
+            raise ValueError(f'bad chunk magic 0x{magic:08X}')
+        payload = read_exact(ser, length)
+        if zlib.crc32(payload) != crc:
+            raise ValueError(f'CRC mismatch in chunk {index}')
+        chunks[index] = payload
+        print(f'\rchunk {index + 1}/{total}', end='', file=sys.stderr)
+
+    print('', file=sys.stderr)
+    print(read_line(ser), file=sys.stderr)
+    return total
+
+
+def cmd_export(args: argparse.Namespace) -> int:
+    ser = open_port(args.port, timeout=2.0)
+    chunks: dict[int, bytes] = {}
+    total = None
+    retries = 0
+    while total is None or len(chunks) < total:
+        start = len(chunks)
+        try:
+            total = export_from(ser, start, args.blocks, chunks)
+        except (TimeoutError, ValueError) as err:
+            retries += 1
+            if retries > args.retries:
+                print(f'export failed: {err}', file=sys.stderr)
+                return 1
+            print(f'\n{err}, resuming at chunk {len(chunks)}', file=sys.stderr)
+            time.sleep(0.5)
+
+    with open(args.output, 'wb') as f:
+        for i in range(total):
+            f.write(chunks[i])
+    print(f'{args.output}: {sum(len(c) for c in chunks.values())} bytes', file=sys.stderr)
+    return 0
+
+
+def iter_records(raw: bytes):
+    """Yield (timestamp_us, id_flags, dlc, data) from exported capture blocks."""
+    for off in range(0, len(raw) - CAPTURE_BLOCK_SIZE + 1, CAPTURE_BLOCK_SIZE):
+        magic, _, count, rec_size, crc = BLOCK_HEADER.unpack_from(raw, off)
+        if magic != CAPTURE_BLOCK_MAGIC or rec_size != RECORD.size:
+            continue
+        body = raw[off + BLOCK_HEADER.size:off + BLOCK_HEADER.size + count * rec_size]
+        if zlib.crc32(body) != crc:
+            print(f'block at 0x{off:X}: CRC mismatch, skipped', file=sys.stderr)
+            continue
+        for i in range(count):
+            ts, id_flags, dlc, length, data = RECORD.unpack_from(body, i * rec_size)
+            yield ts, id_flags, dlc, data[:length]
+
+
+def cmd_convert(args: argparse.Namespace) -> int:
+    with open(args.input, 'rb') as f:
+        raw = f.read()
+    out = open(args.output, 'w') if args.output else sys.stdout
+    for ts, id_flags, dlc, data in iter_records(raw):
+        can_id = id_flags & 0x1FFFFFFF
+        id_str = f'{can_id:08X}' if id_flags & FLAG_EXT else f'{can_id:03X}'
+        body = f'R{dlc}' if id_flags & FLAG_RTR else data.hex().upper()
+        out.write(f'({ts // 1000000}.{ts % 1000000:06d}) {args.interface} {id_str}#{body}\n')
+    if out is not sys.stdout:
+        out.close()
+    return 0
+
+
+# ---------------------------------------------------------------------------
+# replay (time-triggered transmission, see main/can_tx.h)
+# ---------------------------------------------------------------------------
+
+CANDUMP_LINE = re.compile(r'\((\d+)\.(\d+)\)\s+\S+\s+([0-9A-Fa-f]+)#(R\d?|[0-9A-Fa-f]*)')
+SCHED_RESULT = re.compile(r'(\d+) id \S+ target -?\d+ release ([+-]\d+) us done ([+-]\d+) us (\w+)')
+
+
+def candump_to_slcan(can_id: str, data: str) -> str:
+    ext = len(can_id) > 3
+    ident = f'{int(can_id, 16):08X}' if ext else f'{int(can_id, 16):03X}'
+    if data.startswith('R'):
+        return f'{"R" if ext else "r"}{ident}{data[1:] or "0"}'
+    return f'{"T" if ext else "t"}{ident}{len(data) // 2}{data.upper()}'
+
+
+def sched_results(ser: serial.Serial, results: dict[int, tuple[int, int, bool]]) -> int:
+    """Collect per-frame results from 'Xsched'; returns the device time ('now')."""
+    now = 0
+    for line in ext_command(ser, 'sched'):
+        if line.startswith('sched: now '):
+            now = int(line.split()[2].rstrip(','))
+        m = SCHED_RESULT.match(line)
+        if m:
+            results[int(m.group(1))] = (int(m.group(2)), int(m.group(3)), m.group(4) == 'ok')
+    return now
+
+
+def cmd_replay(args: argparse.Namespace) -> int:
+    frames = []
+    with open(args.log) as f:
+        for line in f:
+            m = CANDUMP_LINE.match(line.strip())
+            if m:
+                ts = int(m.group(1)) * 1_000_000 + int(m.group(2).ljust(6, '0')[:6])
+                frames.append((ts, candump_to_slcan(m.group(3), m.group(4))))
+    if not frames:
+        print('no frames in log', file=sys.stderr)
+        return 1
+
+    ser = open_port(args.port)
+    results: dict[int, tuple[int, int, bool]] = {}
+    t0 = sched_results(ser, results) + int(args.lead * 1_000_000)
+    ts0 = frames[0][0]
+    tags = []
+    for ts, text in frames:
+        target = t0 + ts - ts0
+        while True:
+            try:
+                line = ext_command(ser, f'sched {target} {text}')
+                tags.append(int(line[-1].split()[1]))
+                break
+            except RuntimeError:
+                # Schedule full: collect results while it drains
+                time.sleep(0.01)
+                sched_results(ser, results)
+        if len(tags) % 16 == 0:
+            sched_results(ser, results)
+
+    time.sleep(args.lead + 0.1)
+    sched_results(ser, results)
+    got = [results[t] for t in tags if t in results]
+    if got:
+        release = [abs(r[0]) for r in got]
+        print(f'{len(frames)} frames, {len(got)} results: release error avg '
+              f'{sum(release) / len(release):.1f} us max {max(release)} us, '
+              f'{sum(1 for r in got if not r[2])} failed')
+    return 0
+
+
+# ---------------------------------------------------------------------------
+# discover (records from main/id_discovery.h)
+# ---------------------------------------------------------------------------
+
+def cmd_discover(args: argparse.Namespace) -> int:
+    ser = open_port(args.port)
+    ext_command(ser, f'discover start -p {int(args.period * 1000)}' + (' -r' if args.reset else ''))
+    ser.write(b'O\r')
+
+    ids: dict[str, dict] = {}
+    buf = b''
+    try:
+        while True:
+            buf += ser.read(256)
+            *lines, buf = buf.split(b'\r')
+            for raw in lines:
+                fields = raw.decode(errors='replace').strip().split()
+                if len(fields) >= 5 and fields[0] == 'Dn':
+                    t, can_id, dlc, data = int(fields[1]), fields[2], fields[3], fields[4]
+                    ids[can_id] = {'first': t, 'dlc': dlc, 'data': data, 'rate': 0.0}
+                    print(f'{t / 1e6:14.6f} new {can_id:>8} [{dlc}] {data}')
+                elif len(fields) >= 5 and fields[0] == 'Ds':
+                    period_s = max(int(fields[2]), 1) / 1000
+                    for token in fields[5:]:
+                        can_id, count = token.split(':')
+                        if can_id in ids:
+                            ids[can_id]['rate'] = int(count) / period_s
+                    print(f'{int(fields[1]) / 1e6:14.6f} {fields[3]} IDs, {int(fields[4]) / period_s:.0f} frames/s')
+    except KeyboardInterrupt:
+        pass
+    finally:
+        ser.write(b'C\r')
+        time.sleep(0.1)
+        ser.reset_input_buffer()
+        ext_command(ser, 'discover stop')
+
+    print(f'{len(ids)} IDs')
+    for can_id in sorted(ids, key=lambda i: (len(i), i)):
+        e = ids[can_id]
+        print(f'  {can_id:>8} [{e["dlc"]}] {e["rate"]:8.1f}/s  first {e["data"]}')
+    return 0
+
+
+def cmd_xcp(args: argparse.Namespace) -> int:
+    ser = open_port(args.port)
+    ext_command(ser, 'xcp clear')
+    for spec in args.var:
+        # addr:size:type[:event]
+        addr, size, typ, *event = spec.split(':')
+        ext_command(ser, f'xcp var {addr} -s {size} -t {typ} -e {event[0] if event else 0}')
+    ext_command(ser, f'xcp start -c {args.cro} -d {args.dto}' + (' -x' if args.ext else ''))
+    ser.write(b'O\r')
+
+    out = open(args.output, 'w') if args.output else sys.stdout
+    samples = 0
+    buf = b''
+    try:
+        while True:
+            buf += ser.read(256)
+            *lines, buf = buf.split(b'\r')
+            for raw in lines:
+                fields = raw.decode(errors='replace').strip().split()
+                if len(fields) >= 3 and fields[0] == 'Ql':
+                    print(f'# list {fields[1]} event {fields[2]}: host_us,slave_us,' + ','.join(fields[3:]), file=out)
+                elif len(fields) >= 4 and fields[0] == 'Qd':
+                    print(','.join([fields[2], fields[1], fields[3]] + fields[4:]), file=out)
+                    samples += 1
+    except KeyboardInterrupt:
+        pass
+    finally:
+        ser.write(b'C\r')
+        time.sleep(0.1)
+        ser.reset_input_buffer()
+        try:
+            ext_command(ser, 'xcp stop')
+        except RuntimeError:
+            pass  # setup failed: the status below says why
+        for line in ext_command(ser, 'xcp'):
+            print(line, file=sys.stderr)
+        if out is not sys.stdout:
+            out.close()
+
+    print(f'{samples} samples', file=sys.stderr)
+    return 0
+
+
+def cmd_bench(args: argparse.Namespace) -> int:
+    ser = open_port(args.port)
+    can_id = int(args.id, 0)
+    ext_command(ser, f'bench start -r {args.rate} -n {args.count} -i {can_id} -l {args.dlc}')
+    ser.write(b'O\r')
+
+    # Frames from main/bench.h: sequence number in data bytes 0-3
+    prefix = f't{can_id:03X}{args.dlc}'.encode()
+    expected = 0
+    received = lost = repeated = nbytes = 0
+    first = last = 0.0
+    buf = b''
+    try:
+        while expected < args.count:
+            chunk = ser.read(4096)
+            if not chunk:
+                if received:
+                    break  # the device stopped sending
+                continue
+            buf += chunk
+            *lines, buf = buf.split(b'\r')
+            now = time.monotonic()
+            for raw in lines:
+                if not raw.startswith(prefix):
+                    continue
+                seq = int.from_bytes(bytes.fromhex(raw[5:13].decode()), 'little')
+                if not received:
+                    first = now
+                last = now
+                received += 1
+                nbytes += len(raw) + 1
+                if seq < expected:
+                    repeated += 1
+                else:
+                    lost += seq - expected
+                    expected = seq + 1
+    except KeyboardInterrupt:
+        pass
+    finally:
+        ser.write(b'C\r')
+        time.sleep(0.1)
+        ser.reset_input_buffer()
+        try:
+            ext_command(ser, 'bench stop')
+        except RuntimeError:
+            pass  # already finished
+        for line in ext_command(ser, 'bench'):
+            print(line)
+
+    elapsed = last - first
+    print(f'host: {received} frames, {lost} missing, {repeated} repeated or out of order')
+    if elapsed > 0:
+        print(f'host: {received / elapsed:.0f} frames/s, {nbytes / elapsed:.0f} bytes/s')
+    return 0 if lost == 0 and repeated == 0 else 1
+
+
+# ---------------------------------------------------------------------------
+# flash (layouts from main/uds_flash.h)
+# ---------------------------------------------------------------------------
+
+UDS_LOAD_MAGIC = 0x444F4C55
+
+# uds_load_chunk_t: magic, offset, length, crc32
+UDS_LOAD_HEADER = struct.Struct('<IIII')
+
+
+def uds_status(ser: serial.Serial) -> tuple[str, list[str]]:
+    """Return the first 'uds:' status line and all output lines."""
+    lines = ext_command(ser, 'uds')
+    return next((line for line in lines if line.startswith('uds: image')), ''), lines
+
+
+def uds_load(ser: serial.Serial, image: bytes, retries: int) -> None:
+    ser.reset_input_buffer()
+    ser.write(f'Xuds load {len(image)}\r'.encode())
+    line = read_line(ser)  # after the partition erase
+    while not line.startswith('load ') and not line.startswith('uds load:'):
+        line = read_line(ser)
+    fields = line.split()
+    if fields[0] != 'load' or len(fields) != 3:
+        raise RuntimeError(f'load refused: {line}')
+    chunk = int(fields[2])
+
+    offset = resends = 0
+    while offset < len(image):
+        payload = image[offset:offset + chunk]
+        ser.write(UDS_LOAD_HEADER.pack(UDS_LOAD_MAGIC, offset, len(payload), zlib.crc32(payload)) + payload)
+        reply = read_line(ser).split()
+        if reply[:2] == ['load', 'ok']:
+            offset = int(reply[2])
+        elif reply[:2] == ['load', 'resend']:
+            resends += 1
+            if resends > retries:
+                raise RuntimeError(f'chunk at {offset} refused {resends} times')
+            offset = int(reply[2])
+        else:
+            raise RuntimeError(f'unexpected load reply: {" ".join(reply)}')
+        print(f'\rload {offset}/{len(image)}', end='', file=sys.stderr)
+
+    print('', file=sys.stderr)
+    print(read_line(ser), file=sys.stderr)
+    if read_exact(ser, 1) != ACK:
+        raise RuntimeError('load not acknowledged')
+
+
+def cmd_flash(args: argparse.Namespace) -> int:
+    ser = open_port(args.port, timeout=10.0)
+    with open(args.image, 'rb') as f:
+        image = f.read()
+
+    # Skip the upload if the same image is already staged
+    status, _ = uds_status(ser)
+    if f'image {len(image)} bytes crc {zlib.crc32(image):08X};' not in status:
+        uds_load(ser, image, args.retries)
+
+    opts = f' -a {args.address} -d {args.format} -r {args.retries} -t {args.timeout}'
+    opts += f' -b {args.block}' if args.block else ''
+    opts += ' -x' if args.ext else ''
+    ext_command(ser, f'uds run {args.tx} {args.rx}{opts}')
+    try:
+        while True:
+            time.sleep(0.5)
+            status, lines = uds_status(ser)
+            print(f'\r{status}', end='', file=sys.stderr)
+            if ' running ' not in status:
+                break
+    except KeyboardInterrupt:
+        ext_command(ser, 'uds stop')
+        status, lines = uds_status(ser)
+    print('', file=sys.stderr)
+    for line in lines:
+        print(line)
+    return 0 if '; done ESP_OK' in status else 1
+
+
+# ---------------------------------------------------------------------------
+# stream (records from main/delta_enc.h)
+# ---------------------------------------------------------------------------
+
+DELTA_MARK = 0x80
+DELTA_DEF = 0x40
+DELTA_TS = 0x20
+DELTA_RTR = 0x10
+DELTA_RESET = 0xFF
+DELTA_MAX_IDS = 255
+DELTA_ID_EXT = 1 << 31
+DELTA_TS_PERIOD = 60000
+# Text between records: up to a line end or NACK, or up to the next record
+TEXT_RUN = re.compile(rb'[\x00-\x7F]*?[\r\n\x07]|[\x00-\x7F]+(?=[\x80-\xFF])')
+
+
+class DeltaDecoder:
+    """Rebuild the SLCAN text stream from delta-encoded frame records; text passes through."""
+
+    def __init__(self) -> None:
+        self.buf = b''
+        self.frames = 0
+        self.errors = 0
+        self.reset()
+
+    def reset(self) -> None:
+        self.keys: list[int] = []
+        self.payloads: list[bytes] = []
+        self.last_ts = 0
+
+    def feed(self, data: bytes) -> bytes:
+        """Decode received bytes and return the SLCAN text of all complete records."""
+        self.buf += data
+        out = bytearray()
+        pos = 0
+        while pos < len(self.buf):
+            if self.buf[pos] == DELTA_RESET:
+                self.reset()
+                pos += 1
+                continue
+            if self.buf[pos] < DELTA_MARK:
+                m = TEXT_RUN.match(self.buf, pos)
+                if m is None:
+                    break
+                out += m.group()
+                pos = m.end()
+                continue
+            try:
+                record = self.decode_record(pos)
+            except (IndexError, ValueError):
+                # Out of step with the encoder until its next reset record
+                self.errors += 1
+                pos += 1
+                continue
+            if record is None:
+                break
+            text, pos = record
+            out += text
+            self.frames += 1
+        self.buf = self.buf[pos:]
+        return bytes(out)
+
+    def decode_record(self, pos: int) -> tuple[bytes, int] | None:
+        """Decode the record at pos: its SLCAN text and end, None if incomplete."""
+        buf = self.buf
+        header = buf[pos]
+        dlc = header & 0x0F
+        rtr = bool(header & DELTA_RTR)
+        if dlc > 8:
+            raise ValueError(f'invalid record header 0x{header:02X}')
+        p = pos + 1
+
+        if header & DELTA_DEF:
+            if len(buf) < p + 4:
+                return None
+            key = int.from_bytes(buf[p:p + 4], 'little')
+            index = len(self.keys) if len(self.keys) < DELTA_MAX_IDS else None
+            prev = bytes(8)
+            p += 4
+        else:
+            if len(buf) < p + 1:
+                return None
+            index = buf[p]
+            key, prev = self.keys[index], self.payloads[index]
+            p += 1
+
+        data = b''
+        if not rtr and dlc > 0:
+            if len(buf) < p + 1:
+                return None
+            bitmap = buf[p]
+            changed = bin(bitmap).count('1')
+            if len(buf) < p + 1 + changed:
+                return None
+            deltas = iter(buf[p + 1:p + 1 + changed])
+            data = bytes(prev[i] ^ next(deltas) if bitmap >> i & 1 else prev[i] for i in range(dlc))
+            p += 1 + changed
+
+        ts = None
+        if header & DELTA_TS:
+            delta = shift = 0
+            while True:
+                if p >= len(buf):
+                    return None
+                delta |= (buf[p] & 0x7F) << shift
+                shift += 7
+                p += 1
+                if not buf[p - 1] & 0x80:
+                    break
+            ts = (self.last_ts + delta) % DELTA_TS_PERIOD
+
+        # Complete: update the dictionary as the encoder did (new IDs are not stored once it is full)
+        if header & DELTA_DEF and index is not None:
+            self.keys.append(key)
+            self.payloads.append(bytes(8))
+        if not rtr and index is not None:
+            self.payloads[index] = data + bytes(8 - dlc)
+        if ts is not None:
+            self.last_ts = ts
+
+        # Same layout as slcan_send_frame()
+        can_id = key & 0x1FFFFFFF
+        if key & DELTA_ID_EXT:
+            text = f'{"R" if rtr else "T"}{can_id:08X}{dlc}'
+        else:
+            text = f'{"r" if rtr else "t"}{can_id:03X}{dlc}'
+        text += data.hex().upper()
+        if ts is not None:
+            text += f'{ts:04X}'
+        return (text + '\r').encode(), p
+
+
+def cmd_stream(args: argparse.Namespace) -> int:
+    ser = open_port(args.port)
+    ext_command(ser, 'stream delta -c')
+    ser.write(b'O\r')
+
+    decoder = DeltaDecoder()
+    out = open(args.output, 'wb') if args.output else sys.stdout.buffer
+    received = written = 0
+    try:
+        while True:
+            chunk = ser.read(4096)
+            received += len(chunk)
+            text = decoder.feed(chunk)
+            written += len(text)
+            out.write(text)
+            out.flush()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        ser.write(b'C\r')
+        time.sleep(0.1)
+        ser.reset_input_buffer()
+        for line in ext_command(ser, 'stream text'):
+            print(line, file=sys.stderr)
+        if out is not sys.stdout.buffer:
+            out.close()
+
+    print(f'host: {decoder.frames} frames, {received} bytes received, {written} bytes of SLCAN text, '
+          f'{decoder.errors} decode errors', file=sys.stderr)
+    return 0 if decoder.errors == 0 else 1
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    p_sync = sub.add_parser('sync', help='send clock sync beacons')
+    p_sync.add_argument('-p', '--port', action='append', required=True, help='bridge serial port (repeatable)')
+    p_sync.add_argument('-i', '--interval', type=float, default=0.25, help='beacon interval in seconds')
+    p_sync.add_argument('-n', '--count', type=int, default=0, help='number of beacons (0 = until Ctrl-C)')
+    p_sync.add_argument('--status-every', type=int, default=20, help='print bridge status every N beacons')
+    p_sync.add_argument('--reset', action='store_true', help='reset the bridge estimators first')
+    p_sync.set_defaults(func=cmd_sync)
+
+    p_export = sub.add_parser('export', help='download the flash capture')
+    p_export.add_argument('-p', '--port', required=True, help='bridge serial port')
+    p_export.add_argument('-o', '--output', required=True, help='raw capture output file')
+    p_export.add_argument('-b', '--blocks', type=int, default=16, help='4 KB blocks per chunk')
+    p_export.add_argument('--retries', type=int, default=10, help='resume attempts before giving up')
+    p_export.set_defaults(func=cmd_export)
+
+    p_convert = sub.add_parser('convert', help='convert a raw capture to a candump log')
+    p_convert.add_argument('input', help='raw capture file from export')
+    p_convert.add_argument('-o', '--output', help='log file (default: stdout)')
+    p_convert.add_argument('-i', '--interface', default='can0', help='interface name in the log')
+    p_convert.set_defaults(func=cmd_convert)
+
+    p_replay = sub.add_parser('replay', help='replay a candump log with device-timed transmission')
+    p_replay.add_argument('-p', '--port', required=True, help='bridge serial port')
+    p_replay.add_argument('log', help='candump log file')
+    p_replay.add_argument('--lead', type=float, default=0.5, help='seconds between scheduling and the first frame')
+    p_replay.set_defaults(func=cmd_replay)
+
+    p_discover = sub.add_parser('discover', help='list bus IDs with on-device discovery')
+    p_discover.add_argument('-p', '--port', required=True, help='bridge serial port')
+    p_discover.add_argument('-i', '--period', type=float, default=5.0, help='rate summary period in seconds')
+    p_discover.add_argument('-r', '--reset', action='store_true', help='forget IDs the bridge has already reported')
+    p_discover.set_defaults(func=cmd_discover)
+
+    p_xcp = sub.add_parser('xcp', help='measure ECU variables with the on-device XCP DAQ master')
+    p_xcp.add_argument('-p', '--port', required=True, help='bridge serial port')
+    p_xcp.add_argument('-v', '--var', action='append', required=True, help='addr:size:type[:event], type u/s/f (repeatable)')
+    p_xcp.add_argument('-c', '--cro', default='0x7F0', help='command CAN ID')
+    p_xcp.add_argument('-d', '--dto', default='0x7F1', help='response/DAQ CAN ID')
+    p_xcp.add_argument('-x', '--ext', action='store_true', help='29-bit CAN IDs')
+    p_xcp.add_argument('-o', '--output', help='CSV file (default: stdout)')
+    p_xcp.set_defaults(func=cmd_xcp)
+
+    p_bench = sub.add_parser('bench', help='forwarding self-benchmark with sequence check')
+    p_bench.add_argument('-p', '--port', required=True, help='bridge serial port')
+    p_bench.add_argument('-r', '--rate', type=int, default=0, help='frames per second (0 = as fast as possible)')
+    p_bench.add_argument('-n', '--count', type=int, default=100000, help='frames to inject')
+    p_bench.add_argument('-i', '--id', default='0x7FF', help='11-bit CAN ID of the benchmark frames')
+    p_bench.add_argument('-l', '--dlc', type=int, default=8, help='data length (4-8)')
+    p_bench.set_defaults(func=cmd_bench)
+
+    p_flash = sub.add_parser('flash', help='download an ECU image with the on-device UDS engine')
+    p_flash.add_argument('-p', '--port', required=True, help='bridge serial port')
+    p_flash.add_argument('image', help='binary image file')
+    p_flash.add_argument('-a', '--address', required=True, help='memoryAddress of RequestDownload (hex)')
+    p_flash.add_argument('--tx', default='7E0', help='request CAN ID (hex)')
+    p_flash.add_argument('--rx', default='7E8', help='response CAN ID (hex)')
+    p_flash.add_argument('-x', '--ext', action='store_true', help='29-bit CAN IDs')
+    p_flash.add_argument('-d', '--format', type=lambda v: int(v, 0), default=0, help='dataFormatIdentifier')
+    p_flash.add_argument('-b', '--block', type=int, default=0, help='TransferData length limit (0 = as the ECU accepts)')
+    p_flash.add_argument('-r', '--retries', type=int, default=3, help='request and load chunk retries')
+    p_flash.add_argument('-t', '--timeout', type=int, default=100, help='response timeout P2 in ms')
+    p_flash.set_defaults(func=cmd_flash)
+
+    p_stream = sub.add_parser('stream', help='receive the delta-encoded frame stream as SLCAN text')
+    p_stream.add_argument('-p', '--port', required=True, help='bridge serial port')
+    p_stream.add_argument('-o', '--output', help='SLCAN stream file (default: stdout)')
+    p_stream.set_defaults(func=cmd_stream)
+
+    args = parser.parse_args()
+    return int(args.func(args))
+
+
+if __name__ == '__main__':
+    sys.exit(main())